@@ -906,18 +906,38 @@ macro(CheckPTHREAD)
       check_function_exists(pthread_setname_np HAVE_PTHREAD_SETNAME_NP)
       check_function_exists(pthread_set_name_np HAVE_PTHREAD_SET_NAME_NP)
 
+      if(PTHREADS_FUTEX)
+        check_c_source_compiles("
+            #include <linux/futex.h>
+            #include <sys/syscall.h>
+            #include <unistd.h>
+            int main(int argc, char **argv) {
+                int word = 0;
+                return (int) syscall(SYS_futex, &word, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+            }" HAVE_PTHREADS_FUTEX)
+      endif()
+
       set(SOURCE_FILES ${SOURCE_FILES}
           ${SDL2_SOURCE_DIR}/src/thread/pthread/SDL_systhread.c
-          ${SDL2_SOURCE_DIR}/src/thread/pthread/SDL_sysmutex.c   # Can be faked, if necessary
-          ${SDL2_SOURCE_DIR}/src/thread/pthread/SDL_syscond.c    # Can be faked, if necessary
           ${SDL2_SOURCE_DIR}/src/thread/pthread/SDL_systls.c
           )
-      if(HAVE_PTHREADS_SEM)
+      if(HAVE_PTHREADS_FUTEX)
         set(SOURCE_FILES ${SOURCE_FILES}
-            ${SDL2_SOURCE_DIR}/src/thread/pthread/SDL_syssem.c)
+            ${SDL2_SOURCE_DIR}/src/thread/futex/SDL_sysmutex.c
+            ${SDL2_SOURCE_DIR}/src/thread/futex/SDL_syscond.c
+            ${SDL2_SOURCE_DIR}/src/thread/futex/SDL_syssem.c)
       else()
         set(SOURCE_FILES ${SOURCE_FILES}
-            ${SDL2_SOURCE_DIR}/src/thread/generic/SDL_syssem.c)
+            ${SDL2_SOURCE_DIR}/src/thread/pthread/SDL_sysmutex.c   # Can be faked, if necessary
+            ${SDL2_SOURCE_DIR}/src/thread/pthread/SDL_syscond.c    # Can be faked, if necessary
+            )
+        if(HAVE_PTHREADS_SEM)
+          set(SOURCE_FILES ${SOURCE_FILES}
+              ${SDL2_SOURCE_DIR}/src/thread/pthread/SDL_syssem.c)
+        else()
+          set(SOURCE_FILES ${SOURCE_FILES}
+              ${SDL2_SOURCE_DIR}/src/thread/generic/SDL_syssem.c)
+        endif()
       endif()
       set(HAVE_SDL_THREADS TRUE)
     endif()
@@ -925,6 +945,41 @@ macro(CheckPTHREAD)
   endif()
 endmacro()
 
+# Requires
+# - a C++11 compiler and runtime
+# Optional:
+# Sets:
+# SDL_THREAD_STDCPP
+macro(CheckSTDCPPThreads)
+  set(HAVE_THREADS_STDCPP OFF)
+  enable_language(CXX)
+  include(CheckCXXSourceCompiles)
+  set(ORIG_CMAKE_REQUIRED_FLAGS "${CMAKE_REQUIRED_FLAGS}")
+  set(CMAKE_REQUIRED_FLAGS "${CMAKE_REQUIRED_FLAGS} -std=c++11 -pthread")
+  check_cxx_source_compiles("
+      #include <condition_variable>
+      #include <mutex>
+      #include <thread>
+      static thread_local int value = 0;
+      int main(int argc, char **argv) {
+        std::thread t([] { value = 1; });
+        t.join();
+        return value;
+      }" HAVE_STDCPP_THREADS)
+  set(CMAKE_REQUIRED_FLAGS "${ORIG_CMAKE_REQUIRED_FLAGS}")
+  if(HAVE_STDCPP_THREADS)
+    set(HAVE_THREADS_STDCPP ON)
+    set(SDL_THREAD_STDCPP 1)
+    set(CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} -std=c++11")
+    list(APPEND EXTRA_LDFLAGS "-pthread")
+    list(APPEND EXTRA_LIBS stdc++)
+    list(APPEND SDL_LIBS "-pthread" "-lstdc++")
+    file(GLOB STDCPP_THREAD_SOURCES ${SDL2_SOURCE_DIR}/src/thread/stdcpp/*.cpp)
+    set(SOURCE_FILES ${SOURCE_FILES} ${STDCPP_THREAD_SOURCES})
+    set(HAVE_SDL_THREADS TRUE)
+  endif()
+endmacro()
+
 # Requires
 # - nada
 # Optional:
@@ -43,6 +43,7 @@
 #include "SDL_gamecontroller.h"
 #include "SDL_haptic.h"
 #include "SDL_hints.h"
+#include "SDL_jobs.h"
 #include "SDL_joystick.h"
 #include "SDL_loadso.h"
 #include "SDL_log.h"
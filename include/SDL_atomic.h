@@ -265,6 +265,91 @@ extern DECLSPEC void* SDLCALL SDL_AtomicSetPtr(void **a, void* v);
  */
 extern DECLSPEC void* SDLCALL SDL_AtomicGetPtr(void **a);
 
+/**
+ * \brief A bounded lock-free FIFO of pointers.
+ *
+ * The queue is a ring of a fixed number of slots, so pushing onto a full
+ * queue fails rather than allocating. By default any number of threads may
+ * push and pop at the same time; a queue created with
+ * ::SDL_ATOMICQUEUE_SPSC only allows one producer thread and one consumer
+ * thread, which makes both operations a little cheaper.
+ */
+typedef struct SDL_AtomicQueue SDL_AtomicQueue;
+
+/**
+ * \brief Only one thread pushes and only one thread pops.
+ */
+#define SDL_ATOMICQUEUE_SPSC    0x00000001
+
+/**
+ * \brief Create a lock-free queue.
+ *
+ * \param capacity The number of items the queue can hold, rounded up to a
+ *                 power of two.
+ * \param flags    0 or ::SDL_ATOMICQUEUE_SPSC.
+ *
+ * \return The new queue, or NULL if there was an error.
+ */
+extern DECLSPEC SDL_AtomicQueue * SDLCALL SDL_CreateAtomicQueue(int capacity, Uint32 flags);
+
+/**
+ * \brief Add an item to the back of a queue.
+ *
+ * \return SDL_TRUE if the item was added, SDL_FALSE if the queue was full.
+ */
+extern DECLSPEC SDL_bool SDLCALL SDL_AtomicQueuePush(SDL_AtomicQueue *queue, void *item);
+
+/**
+ * \brief Remove the item at the front of a queue.
+ *
+ * \return SDL_TRUE if an item was removed into \c item, SDL_FALSE if the
+ *         queue was empty.
+ */
+extern DECLSPEC SDL_bool SDLCALL SDL_AtomicQueuePop(SDL_AtomicQueue *queue, void **item);
+
+/**
+ * \brief Destroy a queue. No other thread may be using it.
+ */
+extern DECLSPEC void SDLCALL SDL_DestroyAtomicQueue(SDL_AtomicQueue *queue);
+
+/**
+ * \brief A bounded lock-free LIFO of pointers, usable as a freelist.
+ *
+ * Any number of threads may push and pop at the same time. The stack
+ * links preallocated nodes by index, and every change to its head also
+ * bumps a tag stored next to the index, so a node that is popped and
+ * pushed back while another thread is looking at it can't be mistaken
+ * for the old head (the ABA problem).
+ */
+typedef struct SDL_AtomicStack SDL_AtomicStack;
+
+/**
+ * \brief Create a lock-free stack that can hold \c capacity items.
+ *
+ * \return The new stack, or NULL if there was an error.
+ */
+extern DECLSPEC SDL_AtomicStack * SDLCALL SDL_CreateAtomicStack(int capacity);
+
+/**
+ * \brief Push an item onto a stack.
+ *
+ * \return SDL_TRUE if the item was pushed, SDL_FALSE if the stack was full.
+ */
+extern DECLSPEC SDL_bool SDLCALL SDL_AtomicStackPush(SDL_AtomicStack *stack, void *item);
+
+/**
+ * \brief Pop the most recently pushed item off a stack.
+ *
+ * \return SDL_TRUE if an item was popped into \c item, SDL_FALSE if the
+ *         stack was empty.
+ */
+extern DECLSPEC SDL_bool SDLCALL SDL_AtomicStackPop(SDL_AtomicStack *stack, void **item);
+
+/**
+ * \brief Destroy a stack. No other thread may be using it.
+ */
+extern DECLSPEC void SDLCALL SDL_DestroyAtomicStack(SDL_AtomicStack *stack);
+
 /* Ends C function definitions when using C++ */
 #ifdef __cplusplus
 }
@@ -613,6 +613,83 @@ extern DECLSPEC void SDLCALL SDL_AudioStreamClear(SDL_AudioStream *stream);
  */
 extern DECLSPEC void SDLCALL SDL_FreeAudioStream(SDL_AudioStream *stream);
 
+
+/**
+ *  SDL_WAVStream decodes a WAVE file a block at a time as the audio is
+ *  requested, instead of loading all of it up front like SDL_LoadWAV_RW().
+ *  Only a small window of decoded audio is kept in memory, no matter how
+ *  long the file is.
+ */
+struct _SDL_WAVStream;
+typedef struct _SDL_WAVStream SDL_WAVStream;
+
+/**
+ *  Open a WAVE file for streaming. Only the header is read here.
+ *
+ *  \param src The data source, positioned at the start of the WAVE file
+ *  \param freesrc Non-zero to close \c src when the stream is closed (or
+ *                 if this function fails)
+ *  \param spec Filled with the format of the decoded audio, exactly as
+ *              SDL_LoadWAV_RW() would report it
+ *  \return A new WAVE stream, or NULL on error
+ *
+ *  \sa SDL_WAVStreamRead
+ *  \sa SDL_WAVStreamPut
+ *  \sa SDL_WAVStreamRewind
+ *  \sa SDL_CloseWAVStream
+ */
+extern DECLSPEC SDL_WAVStream * SDLCALL SDL_OpenWAVStream_RW(SDL_RWops * src,
+                                                             int freesrc,
+                                                             SDL_AudioSpec * spec);
+
+/**
+ *  Opens a WAV file for streaming.
+ *  Convenience function.
+ */
+#define SDL_OpenWAVStream(file, spec) \
+    SDL_OpenWAVStream_RW(SDL_RWFromFile(file, "rb"), 1, spec)
+
+/**
+ *  Decode audio from a WAVE stream.
+ *
+ *  \param wav The WAVE stream to decode from
+ *  \param buf A buffer to fill with decoded audio data
+ *  \param len The maximum number of bytes to fill
+ *  \return The number of bytes written, 0 at the end of the file, or -1 on
+ *          error
+ */
+extern DECLSPEC int SDLCALL SDL_WAVStreamRead(SDL_WAVStream *wav, void *buf, int len);
+
+/**
+ *  Decode audio from a WAVE stream into an audio stream, whose source
+ *  format must match the spec returned by SDL_OpenWAVStream_RW(). The
+ *  audio stream is flushed when the end of the file is reached.
+ *
+ *  \param wav The WAVE stream to decode from
+ *  \param stream The audio stream to put the decoded audio into
+ *  \param len The maximum number of bytes to put, rounded up to whole
+ *             sample frames
+ *  \return The number of bytes put, 0 at the end of the file, or -1 on
+ *          error
+ */
+extern DECLSPEC int SDLCALL SDL_WAVStreamPut(SDL_WAVStream *wav, SDL_AudioStream *stream, int len);
+
+/**
+ *  Go back to the start of the audio data. The data source must be
+ *  seekable.
+ *
+ *  \return 0 on success, or -1 on error.
+ */
+extern DECLSPEC int SDLCALL SDL_WAVStreamRewind(SDL_WAVStream *wav);
+
+/**
+ *  Close a WAVE stream, and its data source if it was opened with
+ *  \c freesrc set.
+ *
+ *  \sa SDL_OpenWAVStream_RW
+ */
+extern DECLSPEC void SDLCALL SDL_CloseWAVStream(SDL_WAVStream *wav);
+
 #define SDL_MIX_MAXVOLUME 128
 /**
  *  This takes two audio buffers of the playing audio format and mixes
@@ -70,8 +70,12 @@ typedef unsigned long uintptr_t;
 /* Enable the stub shared object loader (src/loadso/dummy/\*.c) */
 #define SDL_LOADSO_DISABLED 1
 
+#ifdef SDL_THREAD_STDCPP
+/* Enable C++11 thread support (src/thread/stdcpp/\*.cpp) */
+#else
 /* Enable the stub thread support (src/thread/generic/\*.c) */
 #define SDL_THREADS_DISABLED    1
+#endif
 
 /* Enable the stub timer support (src/timer/dummy/\*.c) */
 #define SDL_TIMERS_DISABLED 1
@@ -124,12 +124,21 @@
 /* Enable the stub sensor driver (src/sensor/dummy/\*.c) */
 #define SDL_SENSOR_DISABLED 1
 
+#ifdef SDL_THREAD_STDCPP
+/* Enable C++11 thread support (src/thread/stdcpp/\*.cpp) */
+#else
 /* Enable the stub thread support (src/thread/generic/\*.c) */
 #define SDL_THREADS_DISABLED    1
+#endif
 
 /* Enable the stub timer support (src/timer/dummy/\*.c) */
 #define SDL_TIMERS_DISABLED 1
 
+/* Take ticks from the CPU's time stamp counter (src/timer/rdtsc/\*.c).
+   The Xbox's Pentium III always runs at 733 MHz, so skip calibrating. */
+#define SDL_TIMER_RDTSC 1
+#define SDL_TIMER_RDTSC_FREQUENCY 733333333
+
 /* Enable the dummy video driver (src/video/dummy/\*.c) */
 #define SDL_VIDEO_DRIVER_XBOX  1
 
@@ -1119,6 +1119,96 @@ extern "C" {
  */
 #define SDL_HINT_EVENT_LOGGING   "SDL_EVENT_LOGGING"
 
+/**
+ *  \brief  A variable controlling how many worker threads run jobs for SDL_RunJob() and SDL_ParallelFor().
+ *
+ *  The workers are started the first time a job is run, which is when this
+ *  variable is read. They are stopped by SDL_Quit().
+ *
+ *  This variable can be set to the following values:
+ *    "0"       - Don't start any workers, run jobs on the thread that submits them
+ *    "N"       - Start N worker threads
+ *
+ *  By default SDL starts one worker fewer than the number of CPU cores, since
+ *  threads waiting on jobs help run them.
+ */
+#define SDL_HINT_JOB_WORKERS   "SDL_JOB_WORKERS"
+
+/**
+ *  \brief  A variable controlling whether SDL recycles its small, short-lived allocations.
+ *
+ *  SDL keeps some objects it allocates all the time, like queued events, in
+ *  pools of larger blocks, and takes scratch memory from per-frame arenas.
+ *  This variable is read when a pool or arena is created.
+ *
+ *  This variable can be set to the following values:
+ *    "0"       - Allocate every object with SDL_malloc() and free it with SDL_free(), so memory debuggers see each one
+ *    "1"       - Allocate objects from pools and arenas (the default)
+ */
+#define SDL_HINT_MEMORY_POOLS   "SDL_MEMORY_POOLS"
+
+/**
+ *  \brief  A variable controlling whether YUV conversions are split across the job workers.
+ *
+ *  Conversions to and from YUV formats can be cut into horizontal bands of
+ *  whole macroblocks that are converted at the same time by the workers
+ *  started for SDL_ParallelFor(), see ::SDL_HINT_JOB_WORKERS.
+ *
+ *  This variable can be set to the following values:
+ *    "0"       - Convert every frame on the calling thread
+ *    "1"       - Split every frame that is more than one band high
+ *
+ *  By default SDL only splits frames of about 720p and larger, where the
+ *  work is worth waking the workers for.
+ */
+#define SDL_HINT_YUV_PARALLEL   "SDL_YUV_PARALLEL"
+
+/**
+ *  \brief  A variable controlling how blits to surfaces with fewer bits per channel are dithered.
+ *
+ *  This applies to plain copies, like SDL_ConvertSurface() does, from 8 bits
+ *  per channel to 16-bit, RGB332 and 8-bit paletted surfaces. The variable
+ *  is read when a blit between two surfaces is first set up.
+ *
+ *  This variable can be set to the following values:
+ *    "0" or "none"      - Truncate each pixel, or match it to the nearest palette color (the default)
+ *    "1" or "ordered"   - Ordered dithering with a 4x4 Bayer matrix, which is fast and stable between frames
+ *    "2" or "diffusion" - Floyd-Steinberg error diffusion, which looks best on still images
+ */
+#define SDL_HINT_BLIT_DITHER   "SDL_BLIT_DITHER"
+
+/**
+ *  \brief  A variable controlling whether duplicated surfaces share their pixels until written to.
+ *
+ *  SDL_DuplicateSurface() and SDL_ConvertSurface() to the same format can
+ *  give the new surface the pixels of the old one, and only copy them when
+ *  either surface is locked. Both surfaces then have SDL_SHARED_PIXELS set
+ *  and must be locked before their pixels are written to, like RLE encoded
+ *  surfaces. The variable is read every time a surface is converted.
+ *
+ *  This variable can be set to the following values:
+ *    "0"       - Always copy the pixels (the default)
+ *    "1"       - Share the pixels and copy them on write
+ */
+#define SDL_HINT_SURFACE_COPY_ON_WRITE   "SDL_SURFACE_COPY_ON_WRITE"
+
+/**
+ *  \brief  A variable controlling how much memory SDL keeps in the pixels of freed surfaces.
+ *
+ *  The pixels of a freed surface, including the textures of the software
+ *  renderer, can be kept and given to the next surface created with the same
+ *  pitch and height, so surfaces made and freed every frame don't allocate.
+ *  Pixels are freed when they haven't been picked up in two seconds, or to
+ *  make room for others. The variable can be changed at any time, pixels
+ *  are only kept between SDL_Init() and SDL_Quit(), and nothing is kept if
+ *  ::SDL_HINT_MEMORY_POOLS is "0".
+ *
+ *  This variable can be set to the following values:
+ *    "0"       - Free the pixels of every surface right away (the default)
+ *    "N"       - Keep the pixels of up to 64 surfaces, as long as they add up to N kilobytes or less
+ */
+#define SDL_HINT_SURFACE_POOL   "SDL_SURFACE_POOL"
+
 
 
 /**
@@ -0,0 +1,146 @@
+/*
+  Simple DirectMedia Layer
+  Copyright (C) 1997-2019 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef SDL_jobs_h_
+#define SDL_jobs_h_
+
+/**
+ *  \file SDL_jobs.h
+ *
+ *  A pool of worker threads for running small pieces of work in parallel.
+ */
+
+#include "SDL_stdinc.h"
+#include "SDL_error.h"
+
+#include "begin_code.h"
+/* Set up for C function definitions, even when using C++ */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ *  Jobs are run by a fixed pool of worker threads, each with its own queue.
+ *  Workers that run out of jobs steal them from the others, and threads
+ *  waiting on jobs run queued jobs while they wait, so jobs may themselves
+ *  submit and wait on other jobs.
+ *
+ *  Jobs should be short and must not block on anything but other jobs.
+ *  The pool is started the first time a job is run, see
+ *  ::SDL_HINT_JOB_WORKERS, and stopped by SDL_Quit().
+ */
+
+/**
+ *  The function type for jobs run by SDL_RunJob().
+ */
+typedef void (SDLCALL * SDL_JobFunction) (void *data);
+
+/**
+ *  The function type for SDL_ParallelFor(), called for the indices from
+ *  \c start up to, but not including, \c end.
+ */
+typedef void (SDLCALL * SDL_ParallelForFunction) (void *data, int start, int end);
+
+/* The SDL job counter structure, defined in SDL_jobs.c */
+struct SDL_JobCounter;
+typedef struct SDL_JobCounter SDL_JobCounter;
+
+/**
+ *  Get the number of worker threads running jobs, starting them if needed.
+ *
+ *  \return The number of workers, or 0 if jobs run on the submitting thread.
+ */
+extern DECLSPEC int SDLCALL SDL_GetNumJobWorkers(void);
+
+/**
+ *  Create a counter to track jobs with.
+ *
+ *  A counter counts the jobs run with it that haven't finished yet.
+ *
+ *  \return The new counter, or NULL on error.
+ */
+extern DECLSPEC SDL_JobCounter *SDLCALL SDL_CreateJobCounter(void);
+
+/**
+ *  Destroy a job counter. No jobs may be using it.
+ */
+extern DECLSPEC void SDLCALL SDL_DestroyJobCounter(SDL_JobCounter * counter);
+
+/**
+ *  Run a job on the worker pool.
+ *
+ *  \param func The function to run.
+ *  \param data A pointer passed to \c func.
+ *  \param counter A counter to add the job to until it finishes, or NULL.
+ *
+ *  \return 0, or -1 on error.
+ */
+extern DECLSPEC int SDLCALL SDL_RunJob(SDL_JobFunction func, void *data,
+                                       SDL_JobCounter * counter);
+
+/**
+ *  Run a job on the worker pool once the jobs tracked by another counter
+ *  have finished.
+ *
+ *  \param after The counter to wait for.
+ *  \param func The function to run.
+ *  \param data A pointer passed to \c func.
+ *  \param counter A counter to add the job to until it finishes, or NULL.
+ *
+ *  \return 0, or -1 on error.
+ */
+extern DECLSPEC int SDLCALL SDL_RunJobAfter(SDL_JobCounter * after,
+                                            SDL_JobFunction func, void *data,
+                                            SDL_JobCounter * counter);
+
+/**
+ *  Wait for every job tracked by a counter to finish, running queued jobs
+ *  in the meantime.
+ *
+ *  \return 0, or -1 on error.
+ */
+extern DECLSPEC int SDLCALL SDL_WaitJobCounter(SDL_JobCounter * counter);
+
+/**
+ *  Call a function for every index from 0 to \c count - 1, in batches
+ *  spread across the worker pool, and wait for them all to finish.
+ *
+ *  \param count The number of indices.
+ *  \param batch The fewest indices worth handing to another thread.
+ *  \param func The function to call for each batch.
+ *  \param data A pointer passed to \c func.
+ *
+ *  \return 0, or -1 on error.
+ */
+extern DECLSPEC int SDLCALL SDL_ParallelFor(int count, int batch,
+                                            SDL_ParallelForFunction func,
+                                            void *data);
+
+
+/* Ends C function definitions when using C++ */
+#ifdef __cplusplus
+}
+#endif
+#include "close_code.h"
+
+#endif /* SDL_jobs_h_ */
+
+/* vi: set ts=4 sw=4 expandtab: */
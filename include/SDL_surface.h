@@ -54,12 +54,13 @@ extern "C" {
 #define SDL_RLEACCEL        0x00000002  /**< Surface is RLE encoded */
 #define SDL_DONTFREE        0x00000004  /**< Surface is referenced internally */
 #define SDL_SIMD_ALIGNED    0x00000008  /**< Surface uses aligned memory */
+#define SDL_SHARED_PIXELS   0x00000010  /**< Surface shares its pixels with duplicates */
 /* @} *//* Surface flags */
 
 /**
  *  Evaluates to true if the surface needs to be locked before access.
  */
-#define SDL_MUSTLOCK(S) (((S)->flags & SDL_RLEACCEL) != 0)
+#define SDL_MUSTLOCK(S) (((S)->flags & (SDL_RLEACCEL | SDL_SHARED_PIXELS)) != 0)
 
 /**
  * \brief A collection of pixels used in software blitting.
@@ -380,6 +381,9 @@ extern DECLSPEC void SDLCALL SDL_GetClipRect(SDL_Surface * surface,
 
 /*
  * Creates a new surface identical to the existing surface
+ *
+ * With ::SDL_HINT_SURFACE_COPY_ON_WRITE enabled the two surfaces share their
+ * pixels until either of them is locked, see SDL_ConvertSurface().
  */
 extern DECLSPEC SDL_Surface *SDLCALL SDL_DuplicateSurface(SDL_Surface * surface);
 
@@ -392,6 +396,12 @@ extern DECLSPEC SDL_Surface *SDLCALL SDL_DuplicateSurface(SDL_Surface * surface)
  *  semantics.  You can also pass ::SDL_RLEACCEL in the flags parameter and
  *  SDL will try to RLE accelerate colorkey and alpha blits in the resulting
  *  surface.
+ *
+ *  If ::SDL_HINT_SURFACE_COPY_ON_WRITE is enabled and the format is the same
+ *  as the surface's, the new surface shares the pixels of the old one instead
+ *  of copying them, and both have ::SDL_SHARED_PIXELS set. SDL_MUSTLOCK() is
+ *  true for them, and SDL_LockSurface() gives a surface its own copy of the
+ *  pixels before they can be written to.
  */
 extern DECLSPEC SDL_Surface *SDLCALL SDL_ConvertSurface
     (SDL_Surface * src, const SDL_PixelFormat * fmt, Uint32 flags);
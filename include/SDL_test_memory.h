@@ -51,6 +51,24 @@ int SDLTest_TrackAllocations(void);
  */
 void SDLTest_LogAllocations(void);
 
+/**
+ * \brief Mark the end of a frame for the allocation profile
+ *
+ * \note Call this once per iteration of the main loop to get per-frame allocation statistics
+ */
+void SDLTest_MarkAllocationFrame(void);
+
+/**
+ * \brief Print a profile of all allocations since tracking started
+ *
+ * The profile has the total and peak memory use, per-frame statistics, and
+ * the call sites that allocated most often, with how long their allocations
+ * lived.
+ *
+ * \note This can be called after SDL_Quit()
+ */
+void SDLTest_LogAllocationProfile(void);
+
 
 /* Ends C function definitions when using C++ */
 #ifdef __cplusplus
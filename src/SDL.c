@@ -34,6 +34,8 @@
 #include "haptic/SDL_haptic_c.h"
 #include "joystick/SDL_joystick_c.h"
 #include "sensor/SDL_sensor_c.h"
+#include "thread/SDL_jobs_c.h"
+#include "video/SDL_pixelpool_c.h"
 
 /* Initialization/Cleanup routines */
 #if !SDL_TIMERS_DISABLED
@@ -134,6 +136,7 @@ SDL_InitSubSystem(Uint32 flags)
 #if !SDL_TIMERS_DISABLED
     SDL_TicksInit();
 #endif
+    SDL_InitPixelPool();
 
     /* Initialize the event subsystem */
     if ((flags & SDL_INIT_EVENTS)) {
@@ -380,6 +383,8 @@ SDL_Quit(void)
     SDL_HelperWindowDestroy();
 #endif
     SDL_QuitSubSystem(SDL_INIT_EVERYTHING);
+    SDL_QuitJobs();
+    SDL_QuitPixelPool();
 
 #if !SDL_TIMERS_DISABLED
     SDL_TicksQuit();
@@ -0,0 +1,579 @@
+/*
+  Simple DirectMedia Layer
+  Copyright (C) 1997-2019 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+#include "./SDL_internal.h"
+
+#include "SDL_atomic.h"
+#include "SDL_hints.h"
+#include "SDL_log.h"
+#include "SDL_thread.h"
+#include "./SDL_memorypool.h"
+
+/* Objects and arena allocations are padded to this, which is what SDL_malloc()
+   guarantees on 64-bit platforms, so pooled memory is aligned like it. */
+#define MEMORY_ALIGN            16
+#define MEMORY_ALIGN_UP(x)      (((x) + (MEMORY_ALIGN - 1)) & ~((size_t) (MEMORY_ALIGN - 1)))
+
+/* How many free objects a thread keeps per pool, and for how many pools.
+   A thread that empties (or fills) its cache moves half of it at once. */
+#define POOL_CACHE_SIZE         32
+#define POOL_MAX_CACHES         8
+
+typedef struct SDL_PoolObject
+{
+    struct SDL_PoolObject *next;
+} SDL_PoolObject;
+
+typedef struct SDL_PoolBlock
+{
+    struct SDL_PoolBlock *next;
+} SDL_PoolBlock;
+
+#define POOL_BLOCK_HEADER       MEMORY_ALIGN_UP(sizeof (SDL_PoolBlock))
+
+struct SDL_MemoryPool
+{
+    const char *name;
+    size_t objsize;
+    int objsperblock;
+    SDL_bool passthrough;
+    Uint32 serial;
+    SDL_SpinLock lock;
+    SDL_PoolObject *free;
+    SDL_PoolBlock *blocks;
+    int numblocks;
+    Uint32 refills;
+    Uint32 flushes;
+    SDL_atomic_t passthrough_allocs;
+    struct SDL_MemoryPool *next;
+};
+
+typedef struct SDL_PoolCache
+{
+    SDL_MemoryPool *pool;
+    Uint32 serial;
+    int count;
+    void *objects[POOL_CACHE_SIZE];
+} SDL_PoolCache;
+
+typedef struct SDL_PoolThreadData
+{
+    SDL_PoolCache caches[POOL_MAX_CACHES];
+} SDL_PoolThreadData;
+
+/* Every live pool is on this list, so a thread's cache can tell whether the
+   pool it belongs to still exists. The serial tells a pool apart from a
+   later one that happens to get the same address. */
+static SDL_SpinLock SDL_pools_lock;
+static SDL_MemoryPool *SDL_pools = NULL;
+static Uint32 SDL_pools_serial = 0;
+static SDL_TLSID SDL_pools_tls = 0;
+
+static SDL_bool
+SDL_ReportPoolStatistics(void)
+{
+    const char *report = SDL_GetHint("SDL_MEMORY_POOL_STATISTICS");
+    return (report && SDL_atoi(report)) ? SDL_TRUE : SDL_FALSE;
+}
+
+/* Called with SDL_pools_lock held. */
+static SDL_bool
+SDL_IsPoolAlive(const SDL_MemoryPool *pool, const Uint32 serial)
+{
+    const SDL_MemoryPool *i;
+    for (i = SDL_pools; i; i = i->next) {
+        if (i == pool) {
+            return (i->serial == serial) ? SDL_TRUE : SDL_FALSE;
+        }
+    }
+    return SDL_FALSE;
+}
+
+static void
+SDL_ReturnToPool(SDL_MemoryPool *pool, void **objects, const int count)
+{
+    int i;
+    SDL_AtomicLock(&pool->lock);
+    for (i = 0; i < count; ++i) {
+        SDL_PoolObject *obj = (SDL_PoolObject *) objects[i];
+        obj->next = pool->free;
+        pool->free = obj;
+    }
+    SDL_AtomicUnlock(&pool->lock);
+}
+
+static void SDLCALL
+SDL_FreePoolThreadData(void *data)
+{
+    SDL_PoolThreadData *threaddata = (SDL_PoolThreadData *) data;
+    int i;
+
+    SDL_AtomicLock(&SDL_pools_lock);
+    for (i = 0; i < POOL_MAX_CACHES; ++i) {
+        SDL_PoolCache *cache = &threaddata->caches[i];
+        if (cache->pool && cache->count && SDL_IsPoolAlive(cache->pool, cache->serial)) {
+            SDL_ReturnToPool(cache->pool, cache->objects, cache->count);
+        }
+    }
+    SDL_AtomicUnlock(&SDL_pools_lock);
+
+    SDL_free(threaddata);
+}
+
+/* Returns this thread's cache for the pool, or NULL if it can't have one,
+   in which case the caller goes to the pool directly. */
+static SDL_PoolCache *
+SDL_GetPoolCache(SDL_MemoryPool *pool)
+{
+    SDL_PoolThreadData *threaddata;
+    SDL_PoolCache *empty = NULL;
+    int i;
+
+    if (!SDL_pools_tls) {
+        return NULL;
+    }
+
+    threaddata = (SDL_PoolThreadData *) SDL_TLSGet(SDL_pools_tls);
+    if (!threaddata) {
+        threaddata = (SDL_PoolThreadData *) SDL_calloc(1, sizeof (*threaddata));
+        if (!threaddata) {
+            return NULL;
+        }
+        if (SDL_TLSSet(SDL_pools_tls, threaddata, SDL_FreePoolThreadData) < 0) {
+            SDL_free(threaddata);
+            return NULL;
+        }
+    }
+
+    for (i = 0; i < POOL_MAX_CACHES; ++i) {
+        SDL_PoolCache *cache = &threaddata->caches[i];
+        if (cache->pool == pool) {
+            if (cache->serial == pool->serial) {
+                return cache;
+            }
+            /* Left over from a destroyed pool at the same address. */
+            cache->pool = NULL;
+        }
+        if (!cache->pool && !empty) {
+            empty = cache;
+        }
+    }
+
+    if (!empty) {
+        /* Forget the caches of pools that were destroyed since. Their
+           objects went away with their blocks. */
+        SDL_AtomicLock(&SDL_pools_lock);
+        for (i = 0; i < POOL_MAX_CACHES; ++i) {
+            SDL_PoolCache *cache = &threaddata->caches[i];
+            if (!SDL_IsPoolAlive(cache->pool, cache->serial)) {
+                cache->pool = NULL;
+                if (!empty) {
+                    empty = cache;
+                }
+            }
+        }
+        SDL_AtomicUnlock(&SDL_pools_lock);
+        if (!empty) {
+            return NULL;  /* this thread uses too many pools, go uncached. */
+        }
+    }
+
+    empty->pool = pool;
+    empty->serial = pool->serial;
+    empty->count = 0;
+    return empty;
+}
+
+/* Takes up to (wanted) objects from the pool's free list, or carves a new
+   block if that's empty. Returns how many it got, 0 if out of memory. */
+static int
+SDL_TakeFromPool(SDL_MemoryPool *pool, void **objects, const int wanted)
+{
+    SDL_PoolObject *chain = NULL, *tail = NULL;
+    SDL_PoolBlock *block;
+    Uint8 *obj;
+    int count = 0;
+    int i;
+
+    SDL_AtomicLock(&pool->lock);
+    while ((count < wanted) && pool->free) {
+        objects[count++] = pool->free;
+        pool->free = pool->free->next;
+    }
+    if (count) {
+        pool->refills++;
+    }
+    SDL_AtomicUnlock(&pool->lock);
+
+    if (count) {
+        return count;
+    }
+
+    /* Allocate outside the lock, so other threads can keep going. */
+    block = (SDL_PoolBlock *) SDL_malloc(POOL_BLOCK_HEADER + (pool->objsize * pool->objsperblock));
+    if (!block) {
+        SDL_OutOfMemory();
+        return 0;
+    }
+
+    obj = ((Uint8 *) block) + POOL_BLOCK_HEADER;
+    for (i = 0; i < pool->objsperblock; ++i, obj += pool->objsize) {
+        if (count < wanted) {
+            objects[count++] = obj;
+        } else {
+            SDL_PoolObject *pobj = (SDL_PoolObject *) obj;
+            pobj->next = chain;
+            chain = pobj;
+            if (!tail) {
+                tail = pobj;
+            }
+        }
+    }
+
+    SDL_AtomicLock(&pool->lock);
+    block->next = pool->blocks;
+    pool->blocks = block;
+    pool->numblocks++;
+    if (chain) {
+        tail->next = pool->free;
+        pool->free = chain;
+    }
+    SDL_AtomicUnlock(&pool->lock);
+
+    return count;
+}
+
+SDL_MemoryPool *
+SDL_CreateMemoryPool(const char *name, const size_t objsize, const int objsperblock)
+{
+    SDL_MemoryPool *pool;
+
+    if (objsize == 0) {
+        SDL_InvalidParamError("objsize");
+        return NULL;
+    } else if (objsperblock <= 0) {
+        SDL_InvalidParamError("objsperblock");
+        return NULL;
+    }
+
+    pool = (SDL_MemoryPool *) SDL_calloc(1, sizeof (*pool));
+    if (!pool) {
+        SDL_OutOfMemory();
+        return NULL;
+    }
+    pool->name = name ? name : "unnamed";
+    pool->objsize = MEMORY_ALIGN_UP(SDL_max(objsize, sizeof (SDL_PoolObject)));
+    pool->objsperblock = objsperblock;
+    pool->passthrough = !SDL_GetHintBoolean(SDL_HINT_MEMORY_POOLS, SDL_TRUE);
+
+    SDL_AtomicLock(&SDL_pools_lock);
+    if (!SDL_pools_tls) {
+        SDL_pools_tls = SDL_TLSCreate();  /* stays 0 on failure: no caching. */
+    }
+    pool->serial = ++SDL_pools_serial;
+    pool->next = SDL_pools;
+    SDL_pools = pool;
+    SDL_AtomicUnlock(&SDL_pools_lock);
+
+    return pool;
+}
+
+void *
+SDL_AllocFromPool(SDL_MemoryPool *pool)
+{
+    SDL_PoolCache *cache;
+    void *obj = NULL;
+
+    if (!pool) {
+        SDL_InvalidParamError("pool");
+        return NULL;
+    }
+
+    if (pool->passthrough) {
+        SDL_AtomicIncRef(&pool->passthrough_allocs);
+        obj = SDL_malloc(pool->objsize);
+        if (!obj) {
+            SDL_OutOfMemory();
+        }
+        return obj;
+    }
+
+    cache = SDL_GetPoolCache(pool);
+    if (!cache) {
+        SDL_TakeFromPool(pool, &obj, 1);
+        return obj;
+    }
+
+    if (cache->count == 0) {
+        cache->count = SDL_TakeFromPool(pool, cache->objects, POOL_CACHE_SIZE / 2);
+        if (cache->count == 0) {
+            return NULL;
+        }
+    }
+    return cache->objects[--cache->count];
+}
+
+void
+SDL_FreeToPool(SDL_MemoryPool *pool, void *ptr)
+{
+    SDL_PoolCache *cache;
+
+    if (!pool || !ptr) {
+        return;
+    }
+
+    if (pool->passthrough) {
+        SDL_free(ptr);
+        return;
+    }
+
+    cache = SDL_GetPoolCache(pool);
+    if (!cache) {
+        SDL_ReturnToPool(pool, &ptr, 1);
+        return;
+    }
+
+    if (cache->count == POOL_CACHE_SIZE) {
+        cache->count -= POOL_CACHE_SIZE / 2;
+        SDL_ReturnToPool(pool, &cache->objects[cache->count], POOL_CACHE_SIZE / 2);
+        SDL_AtomicLock(&pool->lock);
+        pool->flushes++;
+        SDL_AtomicUnlock(&pool->lock);
+    }
+    cache->objects[cache->count++] = ptr;
+}
+
+void
+SDL_DestroyMemoryPool(SDL_MemoryPool *pool)
+{
+    SDL_MemoryPool **prev;
+    SDL_PoolBlock *block;
+
+    if (!pool) {
+        return;
+    }
+
+    /* Once it's off the list, no exiting thread will hand objects back. */
+    SDL_AtomicLock(&SDL_pools_lock);
+    for (prev = &SDL_pools; *prev; prev = &(*prev)->next) {
+        if (*prev == pool) {
+            *prev = pool->next;
+            break;
+        }
+    }
+    SDL_AtomicUnlock(&SDL_pools_lock);
+
+    if (SDL_ReportPoolStatistics()) {
+        if (pool->passthrough) {
+            SDL_Log("SDL MEMORY POOL %s: %d objects passed through to SDL_malloc()\n",
+                    pool->name, SDL_AtomicGet(&pool->passthrough_allocs));
+        } else {
+            SDL_Log("SDL MEMORY POOL %s: %d blocks of %d %d-byte objects, %u refills, %u flushes\n",
+                    pool->name, pool->numblocks, pool->objsperblock, (int) pool->objsize,
+                    (unsigned int) pool->refills, (unsigned int) pool->flushes);
+        }
+    }
+
+    for (block = pool->blocks; block; ) {
+        SDL_PoolBlock *next = block->next;
+        SDL_free(block);
+        block = next;
+    }
+    SDL_free(pool);
+}
+
+
+typedef struct SDL_ArenaBlock
+{
+    struct SDL_ArenaBlock *next;
+    size_t size;
+    size_t used;
+    Uint32 last_used;  /* the last frame anything was allocated from it. */
+} SDL_ArenaBlock;
+
+#define ARENA_BLOCK_HEADER      MEMORY_ALIGN_UP(sizeof (SDL_ArenaBlock))
+
+/* A reset frees blocks that went unused for this many frames, except the
+   first one, so a single big frame doesn't keep its memory forever. */
+#define ARENA_TRIM_FRAMES       60
+
+struct SDL_FrameArena
+{
+    const char *name;
+    size_t blocksize;
+    SDL_bool passthrough;
+    SDL_ArenaBlock *blocks;
+    SDL_ArenaBlock *current;
+    size_t frame_used;
+    size_t peak_used;
+    size_t total_size;
+    size_t peak_size;
+    Uint32 frames;
+};
+
+SDL_FrameArena *
+SDL_CreateFrameArena(const char *name, const size_t blocksize)
+{
+    SDL_FrameArena *arena;
+
+    if (blocksize == 0) {
+        SDL_InvalidParamError("blocksize");
+        return NULL;
+    }
+
+    arena = (SDL_FrameArena *) SDL_calloc(1, sizeof (*arena));
+    if (!arena) {
+        SDL_OutOfMemory();
+        return NULL;
+    }
+    arena->name = name ? name : "unnamed";
+    arena->blocksize = MEMORY_ALIGN_UP(blocksize);
+    arena->passthrough = !SDL_GetHintBoolean(SDL_HINT_MEMORY_POOLS, SDL_TRUE);
+    return arena;
+}
+
+void *
+SDL_AllocFromArena(SDL_FrameArena *arena, const size_t len)
+{
+    const size_t alignedlen = MEMORY_ALIGN_UP(SDL_max(len, 1));
+    SDL_ArenaBlock *block;
+    void *retval;
+
+    if (!arena) {
+        SDL_InvalidParamError("arena");
+        return NULL;
+    }
+
+    if (arena->passthrough) {
+        /* Every allocation gets a block of its own, freed on reset. */
+        block = (SDL_ArenaBlock *) SDL_malloc(ARENA_BLOCK_HEADER + alignedlen);
+        if (!block) {
+            SDL_OutOfMemory();
+            return NULL;
+        }
+        block->size = block->used = alignedlen;
+        block->next = arena->blocks;
+        arena->blocks = block;
+        arena->frame_used += alignedlen;
+        return ((Uint8 *) block) + ARENA_BLOCK_HEADER;
+    }
+
+    /* Blocks are used in order, each until the next allocation won't fit. */
+    for (block = arena->current; block; block = block->next) {
+        if ((block->size - block->used) >= alignedlen) {
+            break;
+        }
+        if (block->next) {
+            arena->current = block->next;
+        }
+    }
+
+    if (!block) {
+        const size_t size = SDL_max(arena->blocksize, alignedlen);
+        block = (SDL_ArenaBlock *) SDL_malloc(ARENA_BLOCK_HEADER + size);
+        if (!block) {
+            SDL_OutOfMemory();
+            return NULL;
+        }
+        block->next = NULL;
+        block->size = size;
+        block->used = 0;
+        if (arena->current) {
+            arena->current->next = block;
+        } else {
+            arena->blocks = block;
+        }
+        arena->current = block;
+        arena->total_size += size;
+        arena->peak_size = SDL_max(arena->peak_size, arena->total_size);
+    }
+
+    retval = ((Uint8 *) block) + ARENA_BLOCK_HEADER + block->used;
+    block->used += alignedlen;
+    block->last_used = arena->frames;
+    arena->frame_used += alignedlen;
+    return retval;
+}
+
+static void
+SDL_FreeArenaBlocks(SDL_ArenaBlock *block)
+{
+    while (block) {
+        SDL_ArenaBlock *next = block->next;
+        SDL_free(block);
+        block = next;
+    }
+}
+
+void
+SDL_ResetFrameArena(SDL_FrameArena *arena)
+{
+    SDL_ArenaBlock *block, **prev;
+
+    if (!arena) {
+        return;
+    }
+
+    arena->peak_used = SDL_max(arena->peak_used, arena->frame_used);
+    arena->frame_used = 0;
+    arena->frames++;
+
+    if (arena->passthrough) {
+        SDL_FreeArenaBlocks(arena->blocks);
+        arena->blocks = NULL;
+        return;
+    }
+
+    /* Blocks made for one oversized allocation go right away; the rest
+       stay until they haven't been needed for a while. */
+    prev = &arena->blocks;
+    while ((block = *prev) != NULL) {
+        if ((block->size > arena->blocksize) ||
+            ((block != arena->blocks) && ((arena->frames - block->last_used) > ARENA_TRIM_FRAMES))) {
+            *prev = block->next;
+            arena->total_size -= block->size;
+            SDL_free(block);
+        } else {
+            block->used = 0;
+            prev = &block->next;
+        }
+    }
+    arena->current = arena->blocks;
+}
+
+void
+SDL_DestroyFrameArena(SDL_FrameArena *arena)
+{
+    if (!arena) {
+        return;
+    }
+
+    if (SDL_ReportPoolStatistics()) {
+        arena->peak_used = SDL_max(arena->peak_used, arena->frame_used);
+        SDL_Log("SDL FRAME ARENA %s: at most %d KB in blocks, %d KB used in one of %u frames\n",
+                arena->name, (int) (arena->peak_size / 1024), (int) (arena->peak_used / 1024),
+                (unsigned int) arena->frames);
+    }
+
+    SDL_FreeArenaBlocks(arena->blocks);
+    SDL_free(arena);
+}
+
+/* vi: set ts=4 sw=4 expandtab: */
@@ -0,0 +1,63 @@
+/*
+  Simple DirectMedia Layer
+  Copyright (C) 1997-2019 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+#ifndef SDL_memorypool_h_
+#define SDL_memorypool_h_
+
+/* this is not (currently) a public API. */
+
+/* A pool hands out fixed-size objects carved from larger blocks, so objects
+   that come and go all the time don't churn (or fragment) the heap. Each
+   thread keeps a small cache of free objects, so most allocations and frees
+   don't touch the pool's lock. Blocks are only given back when the pool is
+   destroyed. A pool may be used from any thread, but must only be destroyed
+   once no other thread is using it.
+   Returned objects are uninitialized and aligned for any type. */
+struct SDL_MemoryPool;
+typedef struct SDL_MemoryPool SDL_MemoryPool;
+
+SDL_MemoryPool *SDL_CreateMemoryPool(const char *name, const size_t objsize, const int objsperblock);
+void *SDL_AllocFromPool(SDL_MemoryPool *pool);
+void SDL_FreeToPool(SDL_MemoryPool *pool, void *ptr);
+void SDL_DestroyMemoryPool(SDL_MemoryPool *pool);
+
+/* An arena hands out memory of any size by bumping a pointer, and takes it
+   all back at once when reset, which is meant to happen once per frame (or
+   per operation) for scratch memory that doesn't outlive it. Blocks are kept
+   across resets while they're still being used; ones bigger than blocksize
+   are freed by the next reset. There is no thread safety.
+   Returned memory is uninitialized and 16-byte aligned. */
+struct SDL_FrameArena;
+typedef struct SDL_FrameArena SDL_FrameArena;
+
+SDL_FrameArena *SDL_CreateFrameArena(const char *name, const size_t blocksize);
+void *SDL_AllocFromArena(SDL_FrameArena *arena, const size_t len);
+void SDL_ResetFrameArena(SDL_FrameArena *arena);
+void SDL_DestroyFrameArena(SDL_FrameArena *arena);
+
+/* Both of them pass every allocation straight to SDL_malloc() and SDL_free()
+   if SDL_HINT_MEMORY_POOLS was "0" when they were created, so that memory
+   debuggers and SDLTest_TrackAllocations() see each object. Setting the
+   SDL_MEMORY_POOL_STATISTICS environment variable to "1" logs how much each
+   one allocated when it's destroyed. */
+
+#endif /* SDL_memorypool_h_ */
+
+/* vi: set ts=4 sw=4 expandtab: */
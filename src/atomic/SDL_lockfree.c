@@ -0,0 +1,378 @@
+/*
+  Simple DirectMedia Layer
+  Copyright (C) 1997-2019 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+#include "../SDL_internal.h"
+
+/* Bounded lock-free containers built on the atomic operations.
+
+   The queues are rings of 2^n slots indexed by free-running 32-bit
+   positions. The multi-producer queue is Dmitry Vyukov's design: every
+   slot carries a sequence number that says whether it is ready to be
+   written or read for a given position, so producers and consumers only
+   contend on their own position counter.
+
+   The stack links a fixed array of nodes by index. Its two heads (one for
+   items, one for unused nodes) pack the top node's index together with a
+   tag into a pointer-sized word, and the tag changes on every update so a
+   compare-and-swap against a stale head always fails. */
+
+#include "SDL_atomic.h"
+#include "SDL_cpuinfo.h"
+#include "SDL_error.h"
+
+typedef struct SDL_AtomicQueueCell
+{
+    SDL_atomic_t sequence;
+    void *data;
+} SDL_AtomicQueueCell;
+
+struct SDL_AtomicQueue
+{
+    SDL_AtomicQueueCell *cells;
+    Uint32 mask;
+    Uint32 flags;
+    char pad0[SDL_CACHELINE_SIZE];
+    SDL_atomic_t enqueue_pos;
+    char pad1[SDL_CACHELINE_SIZE - sizeof (SDL_atomic_t)];
+    SDL_atomic_t dequeue_pos;
+    char pad2[SDL_CACHELINE_SIZE - sizeof (SDL_atomic_t)];
+};
+
+SDL_AtomicQueue *
+SDL_CreateAtomicQueue(int capacity, Uint32 flags)
+{
+    SDL_AtomicQueue *queue;
+    Uint32 size = 2;
+    Uint32 i;
+
+    if (capacity <= 0 || capacity > (1 << 30)) {
+        SDL_InvalidParamError("capacity");
+        return NULL;
+    }
+    while (size < (Uint32) capacity) {
+        size <<= 1;
+    }
+
+    queue = (SDL_AtomicQueue *) SDL_calloc(1, sizeof (*queue));
+    if (!queue) {
+        SDL_OutOfMemory();
+        return NULL;
+    }
+    queue->cells = (SDL_AtomicQueueCell *) SDL_calloc(size, sizeof (SDL_AtomicQueueCell));
+    if (!queue->cells) {
+        SDL_free(queue);
+        SDL_OutOfMemory();
+        return NULL;
+    }
+    queue->mask = size - 1;
+    queue->flags = flags;
+    for (i = 0; i < size; ++i) {
+        SDL_AtomicSet(&queue->cells[i].sequence, (int) i);
+    }
+    return queue;
+}
+
+static SDL_bool
+PushSPSC(SDL_AtomicQueue *queue, void *item)
+{
+    /* Only we change the tail, so it can't move under us. */
+    const Uint32 tail = (Uint32) SDL_AtomicGet(&queue->enqueue_pos);
+    const Uint32 head = (Uint32) SDL_AtomicGet(&queue->dequeue_pos);
+
+    if ((tail - head) > queue->mask) {
+        return SDL_FALSE;  /* full */
+    }
+
+    /* The consumer is done with this slot, since it moved the head past it
+       after reading. Publish the item before the new tail. */
+    queue->cells[tail & queue->mask].data = item;
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&queue->enqueue_pos, (int) (tail + 1));
+    return SDL_TRUE;
+}
+
+static SDL_bool
+PopSPSC(SDL_AtomicQueue *queue, void **item)
+{
+    const Uint32 head = (Uint32) SDL_AtomicGet(&queue->dequeue_pos);
+    const Uint32 tail = (Uint32) SDL_AtomicGet(&queue->enqueue_pos);
+
+    if (head == tail) {
+        return SDL_FALSE;  /* empty */
+    }
+
+    /* Don't read the slot before seeing the tail that covers it, and
+       finish reading it before handing it back to the producer. */
+    SDL_MemoryBarrierAcquire();
+    *item = queue->cells[head & queue->mask].data;
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&queue->dequeue_pos, (int) (head + 1));
+    return SDL_TRUE;
+}
+
+static SDL_bool
+PushMPMC(SDL_AtomicQueue *queue, void *item)
+{
+    SDL_AtomicQueueCell *cell;
+    Uint32 pos;
+
+    for ( ; ; ) {
+        int delta;
+
+        pos = (Uint32) SDL_AtomicGet(&queue->enqueue_pos);
+        cell = &queue->cells[pos & queue->mask];
+        delta = (int) ((Uint32) SDL_AtomicGet(&cell->sequence) - pos);
+        if (delta == 0) {
+            /* The slot is free for this position; claim the position. */
+            if (SDL_AtomicCAS(&queue->enqueue_pos, (int) pos, (int) (pos + 1))) {
+                break;
+            }
+        } else if (delta < 0) {
+            /* The slot still holds the item from a lap ago. */
+            return SDL_FALSE;
+        }
+        /* Otherwise another producer got this position first; retry. */
+    }
+
+    SDL_MemoryBarrierAcquire();
+    cell->data = item;
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&cell->sequence, (int) (pos + 1));
+    return SDL_TRUE;
+}
+
+static SDL_bool
+PopMPMC(SDL_AtomicQueue *queue, void **item)
+{
+    SDL_AtomicQueueCell *cell;
+    Uint32 pos;
+
+    for ( ; ; ) {
+        int delta;
+
+        pos = (Uint32) SDL_AtomicGet(&queue->dequeue_pos);
+        cell = &queue->cells[pos & queue->mask];
+        delta = (int) ((Uint32) SDL_AtomicGet(&cell->sequence) - (pos + 1));
+        if (delta == 0) {
+            if (SDL_AtomicCAS(&queue->dequeue_pos, (int) pos, (int) (pos + 1))) {
+                break;
+            }
+        } else if (delta < 0) {
+            /* Nothing has been written at this position yet. */
+            return SDL_FALSE;
+        }
+    }
+
+    SDL_MemoryBarrierAcquire();
+    *item = cell->data;
+    SDL_MemoryBarrierRelease();
+    /* Make the slot writable for the position one lap ahead. */
+    SDL_AtomicSet(&cell->sequence, (int) (pos + queue->mask + 1));
+    return SDL_TRUE;
+}
+
+SDL_bool
+SDL_AtomicQueuePush(SDL_AtomicQueue *queue, void *item)
+{
+    if (!queue) {
+        SDL_InvalidParamError("queue");
+        return SDL_FALSE;
+    }
+    if (queue->flags & SDL_ATOMICQUEUE_SPSC) {
+        return PushSPSC(queue, item);
+    }
+    return PushMPMC(queue, item);
+}
+
+SDL_bool
+SDL_AtomicQueuePop(SDL_AtomicQueue *queue, void **item)
+{
+    if (!queue) {
+        SDL_InvalidParamError("queue");
+        return SDL_FALSE;
+    } else if (!item) {
+        SDL_InvalidParamError("item");
+        return SDL_FALSE;
+    }
+    if (queue->flags & SDL_ATOMICQUEUE_SPSC) {
+        return PopSPSC(queue, item);
+    }
+    return PopMPMC(queue, item);
+}
+
+void
+SDL_DestroyAtomicQueue(SDL_AtomicQueue *queue)
+{
+    if (queue) {
+        SDL_free(queue->cells);
+        SDL_free(queue);
+    }
+}
+
+
+/* Half of a head word is the node index, the other half the tag. On 32-bit
+   platforms that leaves 16 bits of tag, so a thread would have to stall
+   through 65536 updates of the same head to be fooled. */
+#define STACK_INDEX_BITS    (sizeof (void *) * 4)
+#define STACK_INDEX_MASK    ((((uintptr_t) 1) << STACK_INDEX_BITS) - 1)
+#define STACK_EMPTY         STACK_INDEX_MASK
+
+typedef struct SDL_AtomicStackNode
+{
+    SDL_atomic_t next;  /* index of the node below, -1 for none */
+    void *item;
+} SDL_AtomicStackNode;
+
+struct SDL_AtomicStack
+{
+    SDL_AtomicStackNode *nodes;
+    char pad0[SDL_CACHELINE_SIZE];
+    void *head;         /* the pushed items */
+    char pad1[SDL_CACHELINE_SIZE - sizeof (void *)];
+    void *free;         /* the unused nodes */
+    char pad2[SDL_CACHELINE_SIZE - sizeof (void *)];
+};
+
+static int
+PopStackNode(SDL_AtomicStack *stack, void **head)
+{
+    for ( ; ; ) {
+        const uintptr_t oldval = (uintptr_t) SDL_AtomicGetPtr(head);
+        const uintptr_t index = oldval & STACK_INDEX_MASK;
+        uintptr_t newval;
+        int next;
+
+        if (index == STACK_EMPTY) {
+            return -1;
+        }
+
+        /* The node may be popped and reused before our CAS, so this can be
+           garbage; the tag makes the CAS fail if it is. */
+        SDL_MemoryBarrierAcquire();
+        next = SDL_AtomicGet(&stack->nodes[index].next);
+        newval = (((oldval >> STACK_INDEX_BITS) + 1) << STACK_INDEX_BITS) |
+                 ((next < 0) ? STACK_EMPTY : (uintptr_t) next);
+        if (SDL_AtomicCASPtr(head, (void *) oldval, (void *) newval)) {
+            return (int) index;
+        }
+    }
+}
+
+static void
+PushStackNode(SDL_AtomicStack *stack, void **head, int index)
+{
+    for ( ; ; ) {
+        const uintptr_t oldval = (uintptr_t) SDL_AtomicGetPtr(head);
+        const uintptr_t top = oldval & STACK_INDEX_MASK;
+        const uintptr_t newval = (((oldval >> STACK_INDEX_BITS) + 1) << STACK_INDEX_BITS) | (uintptr_t) index;
+
+        SDL_AtomicSet(&stack->nodes[index].next, (top == STACK_EMPTY) ? -1 : (int) top);
+        SDL_MemoryBarrierRelease();
+        if (SDL_AtomicCASPtr(head, (void *) oldval, (void *) newval)) {
+            return;
+        }
+    }
+}
+
+SDL_AtomicStack *
+SDL_CreateAtomicStack(int capacity)
+{
+    SDL_AtomicStack *stack;
+    int i;
+
+    if (capacity <= 0 || (Uint64) capacity >= (Uint64) STACK_EMPTY) {
+        SDL_InvalidParamError("capacity");
+        return NULL;
+    }
+
+    stack = (SDL_AtomicStack *) SDL_calloc(1, sizeof (*stack));
+    if (!stack) {
+        SDL_OutOfMemory();
+        return NULL;
+    }
+    stack->nodes = (SDL_AtomicStackNode *) SDL_calloc(capacity, sizeof (SDL_AtomicStackNode));
+    if (!stack->nodes) {
+        SDL_free(stack);
+        SDL_OutOfMemory();
+        return NULL;
+    }
+
+    /* Chain every node onto the freelist, node 0 on top. */
+    for (i = 0; i < capacity; ++i) {
+        SDL_AtomicSet(&stack->nodes[i].next, (i + 1 < capacity) ? (i + 1) : -1);
+    }
+    stack->head = (void *) STACK_EMPTY;
+    stack->free = (void *) (uintptr_t) 0;
+    SDL_MemoryBarrierRelease();
+    return stack;
+}
+
+SDL_bool
+SDL_AtomicStackPush(SDL_AtomicStack *stack, void *item)
+{
+    int index;
+
+    if (!stack) {
+        SDL_InvalidParamError("stack");
+        return SDL_FALSE;
+    }
+
+    index = PopStackNode(stack, &stack->free);
+    if (index < 0) {
+        return SDL_FALSE;  /* full */
+    }
+    stack->nodes[index].item = item;
+    PushStackNode(stack, &stack->head, index);
+    return SDL_TRUE;
+}
+
+SDL_bool
+SDL_AtomicStackPop(SDL_AtomicStack *stack, void **item)
+{
+    int index;
+
+    if (!stack) {
+        SDL_InvalidParamError("stack");
+        return SDL_FALSE;
+    } else if (!item) {
+        SDL_InvalidParamError("item");
+        return SDL_FALSE;
+    }
+
+    index = PopStackNode(stack, &stack->head);
+    if (index < 0) {
+        return SDL_FALSE;  /* empty */
+    }
+    SDL_MemoryBarrierAcquire();
+    *item = stack->nodes[index].item;
+    PushStackNode(stack, &stack->free, index);
+    return SDL_TRUE;
+}
+
+void
+SDL_DestroyAtomicStack(SDL_AtomicStack *stack)
+{
+    if (stack) {
+        SDL_free(stack->nodes);
+        SDL_free(stack);
+    }
+}
+
+/* vi: set ts=4 sw=4 expandtab: */
@@ -27,6 +27,11 @@
 #include "SDL_atomic.h"
 #include "SDL_mutex.h"
 #include "SDL_timer.h"
+#include "SDL_spinlock_c.h"
+
+#if SDL_THREAD_PTHREAD
+#include <sched.h>
+#endif
 
 #if !defined(HAVE_GCC_ATOMICS) && defined(__SOLARIS__)
 #include <atomic.h>
@@ -133,20 +138,106 @@ SDL_AtomicTryLock(SDL_SpinLock *lock)
     #define PAUSE_INSTRUCTION()
 #endif
 
+/* Lockers pause for twice as long after each failed try, up to this many
+   pauses, and then start giving up their timeslice instead. */
+#define SPINLOCK_MAX_BACKOFF 64
+
+/* The next ticket locker in line pauses this much per round, for at most
+   this many rounds before it starts giving up its timeslice. */
+#define TICKETLOCK_PAUSES 16
+#define TICKETLOCK_MAX_ROUNDS 8
+
+/* If a lock is held for long, its holder has probably lost its CPU, and
+   spinning only keeps it off. */
+static void
+SDL_SpinYield(void)
+{
+#if defined(__WIN32__) && !defined(__WINRT__)
+    SwitchToThread();
+#elif SDL_THREAD_PTHREAD
+    sched_yield();
+#else
+    /* !!! FIXME: this doesn't definitely give up the current timeslice, it does different things on various platforms. */
+    SDL_Delay(0);
+#endif
+}
+
 void
 SDL_AtomicLock(SDL_SpinLock *lock)
 {
-    int iterations = 0;
+    int backoff = 1;
     /* FIXME: Should we have an eventual timeout? */
     while (!SDL_AtomicTryLock(lock)) {
-        if (iterations < 32) {
-            iterations++;
-            PAUSE_INSTRUCTION();
+        /* Only try again once it looks free, so waiters aren't all
+           writing to its cache line the whole time. */
+        do {
+            if (backoff <= SPINLOCK_MAX_BACKOFF) {
+                int i;
+                for (i = 0; i < backoff; ++i) {
+                    PAUSE_INSTRUCTION();
+                }
+                backoff *= 2;
+            } else {
+                SDL_SpinYield();
+            }
+        } while (*(volatile SDL_SpinLock *) lock);
+    }
+}
+
+void
+SDL_AtomicLockTicket(SDL_TicketLock *lock)
+{
+    const Uint32 ticket = (Uint32) SDL_AtomicAdd(&lock->next, 1);
+    Uint32 ahead = ticket - (Uint32) SDL_AtomicGet(&lock->serving);
+    Uint32 rounds = 0;
+    Uint32 yields = 0;
+
+    while (ahead) {
+        /* Only the next in line spins; the rest would just be burning CPU
+           that the holder or the next in line might need. */
+        if ((ahead == 1) && (rounds < TICKETLOCK_MAX_ROUNDS)) {
+            Uint32 i;
+            for (i = 0; i < TICKETLOCK_PAUSES; ++i) {
+                PAUSE_INSTRUCTION();
+            }
+            ++rounds;
         } else {
-            /* !!! FIXME: this doesn't definitely give up the current timeslice, it does different things on various platforms. */
-            SDL_Delay(0);
+            SDL_SpinYield();
+            ++yields;
         }
+        ahead = ticket - (Uint32) SDL_AtomicGet(&lock->serving);
     }
+
+#ifdef SDL_SPINLOCK_STATS
+    ++lock->stats.locks;
+    /* Waiters behind the next in line only yield */
+    if (rounds || yields) {
+        ++lock->stats.contended;
+    }
+    lock->stats.spins += rounds;
+    lock->stats.yields += yields;
+    lock->acquired = SDL_GetPerformanceCounter();
+#else
+    (void) yields;
+#endif
+}
+
+void
+SDL_AtomicUnlockTicket(SDL_TicketLock *lock)
+{
+#ifdef SDL_SPINLOCK_STATS
+    const Uint64 held = SDL_GetPerformanceCounter() - lock->acquired;
+    if (held > lock->stats.max_hold) {
+        lock->stats.max_hold = held;
+    }
+#endif
+    SDL_AtomicAdd(&lock->serving, 1);
+}
+
+void
+SDL_GetTicketLockStats(const SDL_TicketLock *lock, SDL_TicketLockStats *stats)
+{
+    *stats = lock->stats;
 }
 
 void
@@ -0,0 +1,64 @@
+/*
+  Simple DirectMedia Layer
+  Copyright (C) 1997-2019 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+#include "../SDL_internal.h"
+
+#ifndef SDL_spinlock_c_h_
+#define SDL_spinlock_c_h_
+
+#include "SDL_atomic.h"
+
+/* Define this to have ticket locks count how often they're contended and
+   how long they're held. It costs two performance counter reads per lock,
+   so it's off by default. */
+/* #define SDL_SPINLOCK_STATS */
+
+typedef struct SDL_TicketLockStats
+{
+    Uint32 locks;      /* times the lock was taken */
+    Uint32 contended;  /* times the locker had to wait */
+    Uint32 spins;      /* rounds of pausing while waiting */
+    Uint32 yields;     /* timeslices given up while waiting */
+    Uint64 max_hold;   /* longest time held, in performance counter ticks */
+} SDL_TicketLockStats;
+
+/* A fair spinlock: lockers take a ticket and get the lock in ticket order,
+   so a thread that keeps relocking can't starve the others. The price is a
+   context switch per handoff when there are more lockers than CPUs, so use
+   it for locks where starvation is the real problem. Zero it to initialize
+   it. It isn't recursive. */
+typedef struct SDL_TicketLock
+{
+    SDL_atomic_t next;     /* the ticket the next locker gets */
+    SDL_atomic_t serving;  /* the ticket holding the lock */
+    SDL_TicketLockStats stats;  /* only updated by the holder */
+    Uint64 acquired;
+} SDL_TicketLock;
+
+extern void SDL_AtomicLockTicket(SDL_TicketLock *lock);
+extern void SDL_AtomicUnlockTicket(SDL_TicketLock *lock);
+
+/* Copies the lock's stats, which stay zero without SDL_SPINLOCK_STATS.
+   The lock must be held, or idle. */
+extern void SDL_GetTicketLockStats(const SDL_TicketLock *lock, SDL_TicketLockStats *stats);
+
+#endif /* SDL_spinlock_c_h_ */
+
+/* vi: set ts=4 sw=4 expandtab: */
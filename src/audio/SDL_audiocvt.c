@@ -36,10 +36,18 @@
 
 #define DEBUG_AUDIOSTREAM 0
 
+#ifdef __SSE__
+#define HAVE_SSE_INTRINSICS 1
+#endif
+
 #ifdef __SSE3__
 #define HAVE_SSE3_INTRINSICS 1
 #endif
 
+/* Upmixing can push samples out of range; keep them within -1.0f to 1.0f.
+   NaNs pass through, which is what the SSE versions do, too. */
+#define CLAMP_SAMPLE(x) (((x) > 1.0f) ? 1.0f : (((x) < -1.0f) ? -1.0f : (x)))
+
 #if HAVE_SSE3_INTRINSICS
 /* Convert from stereo to mono. Average left and right. */
 static void SDLCALL
@@ -247,9 +255,8 @@ SDL_ConvertStereoTo51(SDL_AudioCVT * cvt, SDL_AudioFormat format)
         lf = src[0];
         rf = src[1];
         ce = (lf + rf) * 0.5f;
-        /* !!! FIXME: FL and FR may clip */
-        dst[0] = lf + (lf - ce);  /* FL */
-        dst[1] = rf + (rf - ce);  /* FR */
+        dst[0] = CLAMP_SAMPLE(lf + (lf - ce));  /* FL */
+        dst[1] = CLAMP_SAMPLE(rf + (rf - ce));  /* FR */
         dst[2] = ce;  /* FC */
         dst[3] = 0;   /* LFE (only meant for special LFE effects) */
         dst[4] = lf;  /* BL */
@@ -284,9 +291,8 @@ SDL_ConvertQuadTo51(SDL_AudioCVT * cvt, SDL_AudioFormat format)
         lb = src[2];
         rb = src[3];
         ce = (lf + rf) * 0.5f;
-        /* !!! FIXME: FL and FR may clip */
-        dst[0] = lf + (lf - ce);  /* FL */
-        dst[1] = rf + (rf - ce);  /* FR */
+        dst[0] = CLAMP_SAMPLE(lf + (lf - ce));  /* FL */
+        dst[1] = CLAMP_SAMPLE(rf + (rf - ce));  /* FR */
         dst[2] = ce;  /* FC */
         dst[3] = 0;   /* LFE (only meant for special LFE effects) */
         dst[4] = lb;  /* BL */
@@ -352,11 +358,10 @@ SDL_Convert51To71(SDL_AudioCVT * cvt, SDL_AudioFormat format)
         rb = src[5];
         ls = (lf + lb) * 0.5f;
         rs = (rf + rb) * 0.5f;
-        /* !!! FIXME: these four may clip */
-        lf += lf - ls;
-        rf += rf - ls;
-        lb += lb - ls;
-        rb += rb - ls;
+        lf = CLAMP_SAMPLE(lf + (lf - ls));
+        rf = CLAMP_SAMPLE(rf + (rf - rs));
+        lb = CLAMP_SAMPLE(lb + (lb - ls));
+        rb = CLAMP_SAMPLE(rb + (rb - rs));
         dst[3] = src[3];  /* LFE */
         dst[2] = src[2];  /* FC */
         dst[7] = rs; /* SR */
@@ -374,6 +379,310 @@ SDL_Convert51To71(SDL_AudioCVT * cvt, SDL_AudioFormat format)
     }
 }
 
+#if HAVE_SSE_INTRINSICS
+/* SSE versions of the channel remixers. These do the same math as the scalar
+   versions, in the same order, so the output is bit-identical. Buffers may
+   not be aligned, and they're converted in place, so each loop loads a
+   block before it stores anything that might overlap it. */
+
+#define SSE_CLAMP_SAMPLE(x) _mm_max_ps(_mm_set1_ps(-1.0f), _mm_min_ps(_mm_set1_ps(1.0f), x))
+
+static void SDLCALL
+SDL_Convert51ToStereo_SSE(SDL_AudioCVT * cvt, SDL_AudioFormat format)
+{
+    float *dst = (float *) cvt->buf;
+    const float *src = dst;
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 divisor = _mm_set1_ps(2.5f);
+    int i = cvt->len_cvt / (sizeof (float) * 6);
+
+    LOG_DEBUG_CONVERT("5.1", "stereo (using SSE)");
+    SDL_assert(format == AUDIO_F32SYS);
+
+    /* two frames at a time: FL0 FR0 FC0 LFE0 | BL0 BR0 FL1 FR1 | FC1 LFE1 BL1 BR1 */
+    for (; i >= 2; i -= 2, src += 12, dst += 4) {
+        const __m128 a = _mm_loadu_ps(src);
+        const __m128 b = _mm_loadu_ps(src + 4);
+        const __m128 c = _mm_loadu_ps(src + 8);
+        const __m128 front = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 2, 1, 0));
+        const __m128 center = _mm_mul_ps(_mm_shuffle_ps(a, c, _MM_SHUFFLE(0, 0, 2, 2)), half);
+        const __m128 back = _mm_shuffle_ps(b, c, _MM_SHUFFLE(3, 2, 1, 0));
+        _mm_storeu_ps(dst, _mm_div_ps(_mm_add_ps(_mm_add_ps(front, center), back), divisor));
+    }
+
+    for (; i; --i, src += 6, dst += 2) {
+        const float front_center_distributed = src[2] * 0.5f;
+        dst[0] = (src[0] + front_center_distributed + src[4]) / 2.5f;  /* left */
+        dst[1] = (src[1] + front_center_distributed + src[5]) / 2.5f;  /* right */
+    }
+
+    cvt->len_cvt /= 3;
+    if (cvt->filters[++cvt->filter_index]) {
+        cvt->filters[cvt->filter_index] (cvt, format);
+    }
+}
+
+static void SDLCALL
+SDL_ConvertQuadToStereo_SSE(SDL_AudioCVT * cvt, SDL_AudioFormat format)
+{
+    float *dst = (float *) cvt->buf;
+    const float *src = dst;
+    const __m128 half = _mm_set1_ps(0.5f);
+    int i = cvt->len_cvt / (sizeof (float) * 4);
+
+    LOG_DEBUG_CONVERT("quad", "stereo (using SSE)");
+    SDL_assert(format == AUDIO_F32SYS);
+
+    for (; i >= 2; i -= 2, src += 8, dst += 4) {
+        const __m128 a = _mm_loadu_ps(src);
+        const __m128 b = _mm_loadu_ps(src + 4);
+        _mm_storeu_ps(dst, _mm_mul_ps(_mm_add_ps(_mm_movelh_ps(a, b), _mm_movehl_ps(b, a)), half));
+    }
+
+    for (; i; --i, src += 4, dst += 2) {
+        dst[0] = (src[0] + src[2]) * 0.5f; /* left */
+        dst[1] = (src[1] + src[3]) * 0.5f; /* right */
+    }
+
+    cvt->len_cvt /= 2;
+    if (cvt->filters[++cvt->filter_index]) {
+        cvt->filters[cvt->filter_index] (cvt, format);
+    }
+}
+
+static void SDLCALL
+SDL_Convert71To51_SSE(SDL_AudioCVT * cvt, SDL_AudioFormat format)
+{
+    float *dst = (float *) cvt->buf;
+    const float *src = dst;
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 divisor = _mm_set1_ps(1.5f);
+    int i;
+
+    LOG_DEBUG_CONVERT("7.1", "5.1 (using SSE)");
+    SDL_assert(format == AUDIO_F32SYS);
+
+    for (i = cvt->len_cvt / (sizeof (float) * 8); i; --i, src += 8, dst += 6) {
+        const __m128 a = _mm_loadu_ps(src);      /* FL FR FC LFE */
+        const __m128 b = _mm_loadu_ps(src + 4);  /* BL BR SL SR */
+        const __m128 sides = _mm_mul_ps(_mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 2, 3, 2)), half);
+        /* FC and LFE pass through as-is; adding zero would turn -0.0f into 0.0f. */
+        const __m128 front = _mm_shuffle_ps(_mm_add_ps(a, sides), a, _MM_SHUFFLE(3, 2, 1, 0));
+        _mm_storeu_ps(dst, _mm_div_ps(front, divisor));
+        _mm_storel_pi((__m64 *) (dst + 4), _mm_div_ps(_mm_add_ps(b, sides), divisor));
+    }
+
+    cvt->len_cvt /= 8;
+    cvt->len_cvt *= 6;
+    if (cvt->filters[++cvt->filter_index]) {
+        cvt->filters[cvt->filter_index] (cvt, format);
+    }
+}
+
+static void SDLCALL
+SDL_Convert51ToQuad_SSE(SDL_AudioCVT * cvt, SDL_AudioFormat format)
+{
+    float *dst = (float *) cvt->buf;
+    const float *src = dst;
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 divisor = _mm_set1_ps(1.5f);
+    int i;
+
+    LOG_DEBUG_CONVERT("5.1", "quad (using SSE)");
+    SDL_assert(format == AUDIO_F32SYS);
+
+    for (i = cvt->len_cvt / (sizeof (float) * 6); i; --i, src += 6, dst += 4) {
+        const __m128 a = _mm_loadu_ps(src);  /* FL FR FC LFE */
+        const __m128 b = _mm_loadl_pi(_mm_setzero_ps(), (const __m64 *) (src + 4));  /* BL BR */
+        const __m128 center = _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 2, 2, 2)), half);
+        _mm_storeu_ps(dst, _mm_div_ps(_mm_movelh_ps(_mm_add_ps(a, center), b), divisor));
+    }
+
+    cvt->len_cvt /= 6;
+    cvt->len_cvt *= 4;
+    if (cvt->filters[++cvt->filter_index]) {
+        cvt->filters[cvt->filter_index] (cvt, format);
+    }
+}
+
+static void SDLCALL
+SDL_ConvertMonoToStereo_SSE(SDL_AudioCVT * cvt, SDL_AudioFormat format)
+{
+    const float *src = (const float *) (cvt->buf + cvt->len_cvt);
+    float *dst = (float *) (cvt->buf + cvt->len_cvt * 2);
+    int i = cvt->len_cvt / sizeof (float);
+
+    LOG_DEBUG_CONVERT("mono", "stereo (using SSE)");
+    SDL_assert(format == AUDIO_F32SYS);
+
+    /* The buffer grows, so work backwards from the end. */
+    for (; i >= 4; i -= 4) {
+        __m128 a;
+        src -= 4;
+        dst -= 8;
+        a = _mm_loadu_ps(src);
+        _mm_storeu_ps(dst, _mm_unpacklo_ps(a, a));
+        _mm_storeu_ps(dst + 4, _mm_unpackhi_ps(a, a));
+    }
+
+    for (; i; --i) {
+        src--;
+        dst -= 2;
+        dst[0] = dst[1] = *src;
+    }
+
+    cvt->len_cvt *= 2;
+    if (cvt->filters[++cvt->filter_index]) {
+        cvt->filters[cvt->filter_index] (cvt, format);
+    }
+}
+
+static void SDLCALL
+SDL_ConvertStereoTo51_SSE(SDL_AudioCVT * cvt, SDL_AudioFormat format)
+{
+    const float *src = (const float *) (cvt->buf + cvt->len_cvt);
+    float *dst = (float *) (cvt->buf + cvt->len_cvt * 3);
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 zero = _mm_setzero_ps();
+    int i = cvt->len_cvt / (sizeof (float) * 2);
+
+    LOG_DEBUG_CONVERT("stereo", "5.1 (using SSE)");
+    SDL_assert(format == AUDIO_F32SYS);
+
+    /* two frames at a time, into FL0 FR0 FC0 LFE0 | BL0 BR0 FL1 FR1 | FC1 LFE1 BL1 BR1 */
+    for (; i >= 2; i -= 2) {
+        __m128 lr, ce, front;
+        src -= 4;
+        dst -= 12;
+        lr = _mm_loadu_ps(src);
+        ce = _mm_mul_ps(_mm_add_ps(lr, _mm_shuffle_ps(lr, lr, _MM_SHUFFLE(2, 3, 0, 1))), half);
+        front = SSE_CLAMP_SAMPLE(_mm_add_ps(lr, _mm_sub_ps(lr, ce)));
+        _mm_storeu_ps(dst, _mm_movelh_ps(front, _mm_unpacklo_ps(ce, zero)));
+        _mm_storeu_ps(dst + 4, _mm_shuffle_ps(lr, front, _MM_SHUFFLE(3, 2, 1, 0)));
+        _mm_storeu_ps(dst + 8, _mm_shuffle_ps(_mm_unpackhi_ps(ce, zero), lr, _MM_SHUFFLE(3, 2, 1, 0)));
+    }
+
+    for (; i; --i) {
+        float lf, rf, ce1;
+        dst -= 6;
+        src -= 2;
+        lf = src[0];
+        rf = src[1];
+        ce1 = (lf + rf) * 0.5f;
+        dst[0] = CLAMP_SAMPLE(lf + (lf - ce1));  /* FL */
+        dst[1] = CLAMP_SAMPLE(rf + (rf - ce1));  /* FR */
+        dst[2] = ce1;  /* FC */
+        dst[3] = 0;   /* LFE (only meant for special LFE effects) */
+        dst[4] = lf;  /* BL */
+        dst[5] = rf;  /* BR */
+    }
+
+    cvt->len_cvt *= 3;
+    if (cvt->filters[++cvt->filter_index]) {
+        cvt->filters[cvt->filter_index] (cvt, format);
+    }
+}
+
+static void SDLCALL
+SDL_ConvertQuadTo51_SSE(SDL_AudioCVT * cvt, SDL_AudioFormat format)
+{
+    const float *src = (const float *) (cvt->buf + cvt->len_cvt);
+    float *dst = (float *) (cvt->buf + cvt->len_cvt * 3 / 2);
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 zero = _mm_setzero_ps();
+    int i;
+
+    LOG_DEBUG_CONVERT("quad", "5.1 (using SSE)");
+    SDL_assert(format == AUDIO_F32SYS);
+    SDL_assert(cvt->len_cvt % (sizeof(float) * 4) == 0);
+
+    for (i = cvt->len_cvt / (sizeof(float) * 4); i; --i) {
+        __m128 a, ce, front;
+        dst -= 6;
+        src -= 4;
+        a = _mm_loadu_ps(src);  /* FL FR BL BR */
+        ce = _mm_mul_ps(_mm_add_ps(a, _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 2, 0, 1))), half);
+        front = SSE_CLAMP_SAMPLE(_mm_add_ps(a, _mm_sub_ps(a, ce)));
+        _mm_storeu_ps(dst, _mm_movelh_ps(front, _mm_unpacklo_ps(ce, zero)));
+        _mm_storeh_pi((__m64 *) (dst + 4), a);
+    }
+
+    cvt->len_cvt = cvt->len_cvt * 3 / 2;
+    if (cvt->filters[++cvt->filter_index]) {
+        cvt->filters[cvt->filter_index] (cvt, format);
+    }
+}
+
+static void SDLCALL
+SDL_ConvertStereoToQuad_SSE(SDL_AudioCVT * cvt, SDL_AudioFormat format)
+{
+    const float *src = (const float *) (cvt->buf + cvt->len_cvt);
+    float *dst = (float *) (cvt->buf + cvt->len_cvt * 2);
+    int i = cvt->len_cvt / (sizeof(float) * 2);
+
+    LOG_DEBUG_CONVERT("stereo", "quad (using SSE)");
+    SDL_assert(format == AUDIO_F32SYS);
+
+    for (; i >= 2; i -= 2) {
+        __m128 a;
+        src -= 4;
+        dst -= 8;
+        a = _mm_loadu_ps(src);
+        _mm_storeu_ps(dst, _mm_movelh_ps(a, a));
+        _mm_storeu_ps(dst + 4, _mm_movehl_ps(a, a));
+    }
+
+    for (; i; --i) {
+        dst -= 4;
+        src -= 2;
+        dst[0] = dst[2] = src[0];
+        dst[1] = dst[3] = src[1];
+    }
+
+    cvt->len_cvt *= 2;
+    if (cvt->filters[++cvt->filter_index]) {
+        cvt->filters[cvt->filter_index] (cvt, format);
+    }
+}
+
+static void SDLCALL
+SDL_Convert51To71_SSE(SDL_AudioCVT * cvt, SDL_AudioFormat format)
+{
+    const float *src = (const float *) (cvt->buf + cvt->len_cvt);
+    float *dst = (float *) (cvt->buf + cvt->len_cvt * 4 / 3);
+    const __m128 half = _mm_set1_ps(0.5f);
+    int i;
+
+    LOG_DEBUG_CONVERT("5.1", "7.1 (using SSE)");
+    SDL_assert(format == AUDIO_F32SYS);
+    SDL_assert(cvt->len_cvt % (sizeof(float) * 6) == 0);
+
+    for (i = cvt->len_cvt / (sizeof(float) * 6); i; --i) {
+        __m128 a, b, corners, sides, out;
+        dst -= 8;
+        src -= 6;
+        a = _mm_loadu_ps(src);  /* FL FR FC LFE */
+        b = _mm_loadl_pi(_mm_setzero_ps(), (const __m64 *) (src + 4));  /* BL BR */
+        corners = _mm_movelh_ps(a, b);  /* FL FR BL BR */
+        sides = _mm_mul_ps(_mm_add_ps(_mm_movelh_ps(a, a), _mm_movelh_ps(b, b)), half);  /* SL SR SL SR */
+        out = SSE_CLAMP_SAMPLE(_mm_add_ps(corners, _mm_sub_ps(corners, sides)));
+        _mm_storeu_ps(dst, _mm_movelh_ps(out, _mm_movehl_ps(a, a)));
+        _mm_storeu_ps(dst + 4, _mm_shuffle_ps(out, sides, _MM_SHUFFLE(1, 0, 3, 2)));
+    }
+
+    cvt->len_cvt = cvt->len_cvt * 4 / 3;
+
+    if (cvt->filters[++cvt->filter_index]) {
+        cvt->filters[cvt->filter_index] (cvt, format);
+    }
+}
+
+/* Use the SSE version of a remixer if the CPU has it. */
+#define CHOOSE_REMIX_FILTER(fn) (SDL_HasSSE() ? fn##_SSE : fn)
+#else
+#define CHOOSE_REMIX_FILTER(fn) (fn)
+#endif
+
 /* SDL's resampler uses a "bandlimited interpolation" algorithm:
      https://ccrma.stanford.edu/~jos/resample/ */
 
@@ -953,7 +1262,7 @@ SDL_BuildAudioCVT(SDL_AudioCVT * cvt,
         /* Upmixing */
         /* Mono -> Stereo [-> ...] */
         if ((src_channels == 1) && (dst_channels > 1)) {
-            if (SDL_AddAudioCVTFilter(cvt, SDL_ConvertMonoToStereo) < 0) {
+            if (SDL_AddAudioCVTFilter(cvt, CHOOSE_REMIX_FILTER(SDL_ConvertMonoToStereo)) < 0) {
                 return -1;
             }
             cvt->len_mult *= 2;
@@ -962,7 +1271,7 @@ SDL_BuildAudioCVT(SDL_AudioCVT * cvt,
         }
         /* [Mono ->] Stereo -> 5.1 [-> 7.1] */
         if ((src_channels == 2) && (dst_channels >= 6)) {
-            if (SDL_AddAudioCVTFilter(cvt, SDL_ConvertStereoTo51) < 0) {
+            if (SDL_AddAudioCVTFilter(cvt, CHOOSE_REMIX_FILTER(SDL_ConvertStereoTo51)) < 0) {
                 return -1;
             }
             src_channels = 6;
@@ -971,7 +1280,7 @@ SDL_BuildAudioCVT(SDL_AudioCVT * cvt,
         }
         /* Quad -> 5.1 [-> 7.1] */
         if ((src_channels == 4) && (dst_channels >= 6)) {
-            if (SDL_AddAudioCVTFilter(cvt, SDL_ConvertQuadTo51) < 0) {
+            if (SDL_AddAudioCVTFilter(cvt, CHOOSE_REMIX_FILTER(SDL_ConvertQuadTo51)) < 0) {
                 return -1;
             }
             src_channels = 6;
@@ -980,7 +1289,7 @@ SDL_BuildAudioCVT(SDL_AudioCVT * cvt,
         }
         /* [[Mono ->] Stereo ->] 5.1 -> 7.1 */
         if ((src_channels == 6) && (dst_channels == 8)) {
-            if (SDL_AddAudioCVTFilter(cvt, SDL_Convert51To71) < 0) {
+            if (SDL_AddAudioCVTFilter(cvt, CHOOSE_REMIX_FILTER(SDL_Convert51To71)) < 0) {
                 return -1;
             }
             src_channels = 8;
@@ -991,7 +1300,7 @@ SDL_BuildAudioCVT(SDL_AudioCVT * cvt,
         }
         /* [Mono ->] Stereo -> Quad */
         if ((src_channels == 2) && (dst_channels == 4)) {
-            if (SDL_AddAudioCVTFilter(cvt, SDL_ConvertStereoToQuad) < 0) {
+            if (SDL_AddAudioCVTFilter(cvt, CHOOSE_REMIX_FILTER(SDL_ConvertStereoToQuad)) < 0) {
                 return -1;
             }
             src_channels = 4;
@@ -1003,7 +1312,7 @@ SDL_BuildAudioCVT(SDL_AudioCVT * cvt,
         /* 7.1 -> 5.1 [-> Stereo [-> Mono]] */
         /* 7.1 -> 5.1 [-> Quad] */
         if ((src_channels == 8) && (dst_channels <= 6)) {
-            if (SDL_AddAudioCVTFilter(cvt, SDL_Convert71To51) < 0) {
+            if (SDL_AddAudioCVTFilter(cvt, CHOOSE_REMIX_FILTER(SDL_Convert71To51)) < 0) {
                 return -1;
             }
             src_channels = 6;
@@ -1011,7 +1320,7 @@ SDL_BuildAudioCVT(SDL_AudioCVT * cvt,
         }
         /* [7.1 ->] 5.1 -> Stereo [-> Mono] */
         if ((src_channels == 6) && (dst_channels <= 2)) {
-            if (SDL_AddAudioCVTFilter(cvt, SDL_Convert51ToStereo) < 0) {
+            if (SDL_AddAudioCVTFilter(cvt, CHOOSE_REMIX_FILTER(SDL_Convert51ToStereo)) < 0) {
                 return -1;
             }
             src_channels = 2;
@@ -1019,7 +1328,7 @@ SDL_BuildAudioCVT(SDL_AudioCVT * cvt,
         }
         /* 5.1 -> Quad */
         if ((src_channels == 6) && (dst_channels == 4)) {
-            if (SDL_AddAudioCVTFilter(cvt, SDL_Convert51ToQuad) < 0) {
+            if (SDL_AddAudioCVTFilter(cvt, CHOOSE_REMIX_FILTER(SDL_Convert51ToQuad)) < 0) {
                 return -1;
             }
             src_channels = 4;
@@ -1027,7 +1336,7 @@ SDL_BuildAudioCVT(SDL_AudioCVT * cvt,
         }
         /* Quad -> Stereo [-> Mono] */
         if ((src_channels == 4) && (dst_channels <= 2)) {
-            if (SDL_AddAudioCVTFilter(cvt, SDL_ConvertQuadToStereo) < 0) {
+            if (SDL_AddAudioCVTFilter(cvt, CHOOSE_REMIX_FILTER(SDL_ConvertQuadToStereo)) < 0) {
                 return -1;
             }
             src_channels = 2;
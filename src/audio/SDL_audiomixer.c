@@ -0,0 +1,385 @@
+/*
+  Simple DirectMedia Layer
+  Copyright (C) 1997-2019 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+#include "../SDL_internal.h"
+
+/* A software mixer for any number of voices. Each voice is converted to
+   float (at its own sample rate) when it's added, so mixing is just a
+   resample-and-accumulate pass into a float bus per voice, followed by one
+   conversion of the bus to the output format. */
+
+#include "SDL_audio.h"
+#include "SDL_assert.h"
+#include "SDL_audio_c.h"
+#include "SDL_audiomixer_c.h"
+
+/* Voice positions are 32.32 fixed point sample frames. */
+#define MIXER_FRAC_BITS 32
+
+typedef struct
+{
+    SDL_bool used;
+    SDL_bool playing;
+    float *samples;        /* AUDIO_F32SYS, mixer->channels interleaved. */
+    int frames;
+    int loop_start;        /* in frames, -1 if not looping. */
+    int loop_end;
+    Uint64 position;
+    Uint64 step;
+    float gain;
+    float pan;
+} SDL_AudioMixerVoice;
+
+struct _SDL_AudioMixer
+{
+    SDL_AudioFormat format;
+    Uint8 channels;
+    int rate;
+    int sample_frame_size;
+    SDL_AudioCVT cvt;      /* bus (AUDIO_F32SYS) to output format. */
+    SDL_AudioMixerVoice *voices;
+    int num_voices;
+    float *bus;
+    int bus_frames;
+};
+
+SDL_AudioMixer *
+SDL_NewAudioMixer(const SDL_AudioFormat format, const Uint8 channels, const int rate)
+{
+    SDL_AudioMixer *retval;
+
+    if (channels == 0) {
+        SDL_InvalidParamError("channels");
+        return NULL;
+    } else if (rate <= 0) {
+        SDL_InvalidParamError("rate");
+        return NULL;
+    }
+
+    retval = (SDL_AudioMixer *) SDL_calloc(1, sizeof (SDL_AudioMixer));
+    if (!retval) {
+        SDL_OutOfMemory();
+        return NULL;
+    }
+
+    retval->format = format;
+    retval->channels = channels;
+    retval->rate = rate;
+    retval->sample_frame_size = (SDL_AUDIO_BITSIZE(format) / 8) * channels;
+
+    if (SDL_BuildAudioCVT(&retval->cvt, AUDIO_F32SYS, channels, rate, format, channels, rate) < 0) {
+        SDL_free(retval);
+        return NULL;  /* SDL_BuildAudioCVT should have called SDL_SetError. */
+    }
+
+    return retval;
+}
+
+static SDL_AudioMixerVoice *
+GetMixerVoice(SDL_AudioMixer *mixer, const int voice)
+{
+    if (!mixer) {
+        SDL_InvalidParamError("mixer");
+        return NULL;
+    } else if ((voice < 0) || (voice >= mixer->num_voices) || !mixer->voices[voice].used) {
+        SDL_SetError("Invalid mixer voice");
+        return NULL;
+    }
+    return &mixer->voices[voice];
+}
+
+int
+SDL_AudioMixerAddVoice(SDL_AudioMixer *mixer, const SDL_AudioFormat format,
+                       const Uint8 channels, const int rate,
+                       const void *buf, int len)
+{
+    const int src_frame_size = (SDL_AUDIO_BITSIZE(format) / 8) * channels;
+    SDL_AudioMixerVoice *voice = NULL;
+    SDL_AudioCVT cvt;
+    int i;
+
+    if (!mixer) {
+        return SDL_InvalidParamError("mixer");
+    } else if (!buf) {
+        return SDL_InvalidParamError("buf");
+    } else if (channels == 0) {
+        return SDL_InvalidParamError("channels");
+    } else if (rate <= 0) {
+        return SDL_InvalidParamError("rate");
+    } else if ((len <= 0) || ((len % src_frame_size) != 0)) {
+        return SDL_SetError("Voice data must be a whole number of sample frames");
+    }
+
+    /* Convert to float and to our channel layout now, so mixing doesn't
+       have to. Resampling happens while mixing, so we keep the source rate. */
+    if (SDL_BuildAudioCVT(&cvt, format, channels, rate, AUDIO_F32SYS, mixer->channels, rate) < 0) {
+        return -1;  /* SDL_BuildAudioCVT should have called SDL_SetError. */
+    }
+
+    for (i = 0; i < mixer->num_voices; i++) {
+        if (!mixer->voices[i].used) {
+            voice = &mixer->voices[i];
+            break;
+        }
+    }
+
+    if (!voice) {
+        const int num_voices = mixer->num_voices ? (mixer->num_voices * 2) : 16;
+        void *ptr = SDL_realloc(mixer->voices, num_voices * sizeof (SDL_AudioMixerVoice));
+        if (!ptr) {
+            return SDL_OutOfMemory();
+        }
+        mixer->voices = (SDL_AudioMixerVoice *) ptr;
+        SDL_memset(&mixer->voices[mixer->num_voices], '\0', (num_voices - mixer->num_voices) * sizeof (SDL_AudioMixerVoice));
+        i = mixer->num_voices;
+        voice = &mixer->voices[i];
+        mixer->num_voices = num_voices;
+    }
+
+    cvt.len = len;
+    cvt.buf = (Uint8 *) SDL_malloc(len * cvt.len_mult);
+    if (!cvt.buf) {
+        return SDL_OutOfMemory();
+    }
+    SDL_memcpy(cvt.buf, buf, len);
+    if (SDL_ConvertAudio(&cvt) < 0) {
+        SDL_free(cvt.buf);
+        return -1;
+    }
+
+    SDL_zerop(voice);
+    voice->used = SDL_TRUE;
+    voice->playing = SDL_TRUE;
+    voice->samples = (float *) cvt.buf;
+    voice->frames = len / src_frame_size;
+    voice->loop_start = -1;
+    voice->loop_end = voice->frames;
+    voice->step = (((Uint64) rate) << MIXER_FRAC_BITS) / ((Uint64) mixer->rate);
+    voice->gain = 1.0f;
+    voice->pan = 0.0f;
+
+    return i;
+}
+
+int
+SDL_AudioMixerSetVoiceGain(SDL_AudioMixer *mixer, const int voice, const float gain, const float pan)
+{
+    SDL_AudioMixerVoice *v = GetMixerVoice(mixer, voice);
+    if (!v) {
+        return -1;
+    }
+    v->gain = SDL_max(gain, 0.0f);
+    v->pan = SDL_max(SDL_min(pan, 1.0f), -1.0f);
+    return 0;
+}
+
+int
+SDL_AudioMixerSetVoiceLoop(SDL_AudioMixer *mixer, const int voice, const int loop_start, const int loop_end)
+{
+    SDL_AudioMixerVoice *v = GetMixerVoice(mixer, voice);
+    if (!v) {
+        return -1;
+    }
+
+    if (loop_start < 0) {
+        v->loop_start = -1;
+        v->loop_end = v->frames;
+        return 0;
+    }
+
+    v->loop_end = (loop_end <= 0) ? v->frames : loop_end;
+    if ((loop_start >= v->loop_end) || (v->loop_end > v->frames)) {
+        v->loop_start = -1;
+        v->loop_end = v->frames;
+        return SDL_SetError("Invalid loop points");
+    }
+    v->loop_start = loop_start;
+    return 0;
+}
+
+int
+SDL_AudioMixerVoicePlaying(SDL_AudioMixer *mixer, const int voice)
+{
+    SDL_AudioMixerVoice *v = GetMixerVoice(mixer, voice);
+    if (!v) {
+        return -1;
+    }
+    return v->playing ? 1 : 0;
+}
+
+int
+SDL_AudioMixerRemoveVoice(SDL_AudioMixer *mixer, const int voice)
+{
+    SDL_AudioMixerVoice *v = GetMixerVoice(mixer, voice);
+    if (!v) {
+        return -1;
+    }
+    SDL_free(v->samples);
+    SDL_zerop(v);
+    return 0;
+}
+
+/* Resample one voice with linear interpolation and add it to the bus. */
+static void
+MixVoice(SDL_AudioMixer *mixer, SDL_AudioMixerVoice *voice, float *bus, int frames)
+{
+    const int channels = mixer->channels;
+    const float *samples = voice->samples;
+    const Uint64 end = ((Uint64) voice->loop_end) << MIXER_FRAC_BITS;
+    const Uint64 looplen = ((Uint64) (voice->loop_end - voice->loop_start)) << MIXER_FRAC_BITS;
+    const SDL_bool looping = (voice->loop_start >= 0);
+    float gains[2];
+    Uint64 position = voice->position;
+    int c;
+
+    /* Constant-gain balance; pan only means something on a stereo bus. */
+    gains[0] = gains[1] = voice->gain;
+    if (channels == 2) {
+        if (voice->pan > 0.0f) {
+            gains[0] *= 1.0f - voice->pan;
+        } else if (voice->pan < 0.0f) {
+            gains[1] *= 1.0f + voice->pan;
+        }
+    }
+
+    while (frames--) {
+        const int index = (int) (position >> MIXER_FRAC_BITS);
+        const float frac = (float) ((Uint32) position) * (1.0f / 4294967296.0f);
+        const float *cur = samples + (index * channels);
+        const float *next;
+
+        if ((index + 1) < voice->loop_end) {
+            next = cur + channels;
+        } else if (looping) {
+            next = samples + (voice->loop_start * channels);
+        } else {
+            next = NULL;  /* ramp out to silence past the last frame. */
+        }
+
+        for (c = 0; c < channels; c++) {
+            const float a = cur[c];
+            const float b = next ? next[c] : 0.0f;
+            bus[c] += (a + ((b - a) * frac)) * gains[c & 1];
+        }
+        bus += channels;
+
+        position += voice->step;
+        if (position >= end) {
+            if (!looping) {
+                voice->playing = SDL_FALSE;
+                break;
+            }
+            while (position >= end) {
+                position -= looplen;
+            }
+        }
+    }
+
+    voice->position = position;
+}
+
+/* Move a voice along as if it had been mixed, for voices that can't be
+   heard, so they are still in the right place once they can be. */
+static void
+SkipVoice(SDL_AudioMixerVoice *voice, int frames)
+{
+    const Uint64 end = ((Uint64) voice->loop_end) << MIXER_FRAC_BITS;
+    Uint64 position = voice->position + (voice->step * (Uint64) frames);
+
+    if (position >= end) {
+        if (voice->loop_start < 0) {
+            voice->playing = SDL_FALSE;
+        } else {
+            const Uint64 start = ((Uint64) voice->loop_start) << MIXER_FRAC_BITS;
+            position = start + ((position - end) % (end - start));
+        }
+    }
+
+    voice->position = position;
+}
+
+int
+SDL_AudioMixerGet(SDL_AudioMixer *mixer, void *buf, int len)
+{
+    int frames;
+    int i;
+
+    if (!mixer) {
+        return SDL_InvalidParamError("mixer");
+    } else if (!buf) {
+        return SDL_InvalidParamError("buf");
+    } else if (len <= 0) {
+        return 0;  /* nothing to do. */
+    } else if ((len % mixer->sample_frame_size) != 0) {
+        return SDL_SetError("Can't request partial sample frames");
+    }
+
+    frames = len / mixer->sample_frame_size;
+    if (frames > mixer->bus_frames) {
+        /* the bus doubles as the conversion buffer, so leave room for that. */
+        const int buslen = frames * mixer->channels * sizeof (float) * SDL_max(mixer->cvt.len_mult, 1);
+        void *ptr = SDL_realloc(mixer->bus, buslen);
+        if (!ptr) {
+            return SDL_OutOfMemory();
+        }
+        mixer->bus = (float *) ptr;
+        mixer->bus_frames = frames;
+    }
+
+    SDL_memset(mixer->bus, '\0', frames * mixer->channels * sizeof (float));
+    for (i = 0; i < mixer->num_voices; i++) {
+        SDL_AudioMixerVoice *voice = &mixer->voices[i];
+        if (!voice->used || !voice->playing) {
+            continue;
+        } else if (voice->gain > 0.0f) {
+            MixVoice(mixer, voice, mixer->bus, frames);
+        } else {
+            SkipVoice(voice, frames);
+        }
+    }
+
+    if (mixer->cvt.needed) {
+        mixer->cvt.buf = (Uint8 *) mixer->bus;
+        mixer->cvt.len = frames * mixer->channels * sizeof (float);
+        if (SDL_ConvertAudio(&mixer->cvt) < 0) {
+            return -1;
+        }
+        SDL_assert(mixer->cvt.len_cvt == len);
+    }
+
+    SDL_memcpy(buf, mixer->bus, len);
+    return len;
+}
+
+void
+SDL_FreeAudioMixer(SDL_AudioMixer *mixer)
+{
+    if (mixer) {
+        int i;
+        for (i = 0; i < mixer->num_voices; i++) {
+            SDL_free(mixer->voices[i].samples);
+        }
+        SDL_free(mixer->voices);
+        SDL_free(mixer->bus);
+        SDL_free(mixer);
+    }
+}
+
+/* vi: set ts=4 sw=4 expandtab: */
@@ -0,0 +1,130 @@
+/*
+  Simple DirectMedia Layer
+  Copyright (C) 1997-2019 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+#ifndef SDL_audiomixer_c_h_
+#define SDL_audiomixer_c_h_
+
+#include "SDL_audio.h"
+
+/* SDL_AudioMixer mixes any number of sounds ("voices") into one output
+   format. Each voice has its own format, rate, gain, pan and loop points;
+   the mixer resamples and mixes them all into a float bus and converts
+   that to the output format once, so an audio callback can just call
+   SDL_AudioMixerGet().
+
+   An SDL_AudioMixer is not thread safe. If you use one from an audio
+   callback, wrap changes to it in SDL_LockAudioDevice() and
+   SDL_UnlockAudioDevice(). */
+struct _SDL_AudioMixer;
+typedef struct _SDL_AudioMixer SDL_AudioMixer;
+
+/**
+ *  Create a new audio mixer.
+ *
+ *  \param format The format of the mixed output data
+ *  \param channels The number of channels of the mixed output data
+ *  \param rate The sampling rate of the mixed output data
+ *  \return A new audio mixer, or NULL on error
+ *
+ *  \sa SDL_AudioMixerAddVoice
+ *  \sa SDL_AudioMixerGet
+ *  \sa SDL_FreeAudioMixer
+ */
+extern SDL_AudioMixer * SDL_NewAudioMixer(const SDL_AudioFormat format,
+                                          const Uint8 channels,
+                                          const int rate);
+
+/**
+ *  Add a voice to the mixer. The data is copied, and starts playing
+ *  immediately at full gain, centered, and without looping.
+ *
+ *  \param mixer The mixer to add the voice to
+ *  \param format The format of the voice's audio data
+ *  \param channels The number of channels of the voice's audio data
+ *  \param rate The sampling rate of the voice's audio data
+ *  \param buf A pointer to the voice's audio data
+ *  \param len The number of bytes of audio data
+ *  \return A voice ID (>= 0) on success, or -1 on error.
+ *
+ *  \sa SDL_AudioMixerSetVoiceGain
+ *  \sa SDL_AudioMixerSetVoiceLoop
+ *  \sa SDL_AudioMixerRemoveVoice
+ */
+extern int SDL_AudioMixerAddVoice(SDL_AudioMixer *mixer,
+                                  const SDL_AudioFormat format,
+                                  const Uint8 channels,
+                                  const int rate,
+                                  const void *buf, int len);
+
+/**
+ *  Set a voice's gain (1.0f is unchanged) and stereo pan (-1.0f is full
+ *  left, 0.0f is centered, 1.0f is full right). Pan is ignored unless the
+ *  mixer outputs stereo.
+ *
+ *  \return 0 on success, or -1 on error.
+ */
+extern int SDL_AudioMixerSetVoiceGain(SDL_AudioMixer *mixer, const int voice,
+                                      const float gain, const float pan);
+
+/**
+ *  Set a voice's loop points, in sample frames of the voice's data. When
+ *  playback reaches loop_end, it continues from loop_start. A loop_end of 0
+ *  means the end of the data, and a negative loop_start turns looping off.
+ *
+ *  \return 0 on success, or -1 on error.
+ */
+extern int SDL_AudioMixerSetVoiceLoop(SDL_AudioMixer *mixer, const int voice,
+                                      const int loop_start, const int loop_end);
+
+/**
+ *  Query whether a voice is still playing. Voices that aren't looping
+ *  stop when they run out of data, but stay in the mixer until removed.
+ *
+ *  \return 1 if playing, 0 if finished, or -1 on error.
+ */
+extern int SDL_AudioMixerVoicePlaying(SDL_AudioMixer *mixer, const int voice);
+
+/**
+ *  Remove a voice from the mixer. Its ID may be reused by later voices.
+ *
+ *  \return 0 on success, or -1 on error.
+ */
+extern int SDL_AudioMixerRemoveVoice(SDL_AudioMixer *mixer, const int voice);
+
+/**
+ *  Mix all playing voices and advance them.
+ *
+ *  \param mixer The mixer to get audio from
+ *  \param buf A buffer to fill with mixed audio data
+ *  \param len The number of bytes to fill, a whole number of sample frames
+ *  \return The number of bytes written, or -1 on error
+ */
+extern int SDL_AudioMixerGet(SDL_AudioMixer *mixer, void *buf, int len);
+
+/**
+ *  Free an audio mixer and all of its voices.
+ *
+ *  \sa SDL_NewAudioMixer
+ */
+extern void SDL_FreeAudioMixer(SDL_AudioMixer *mixer);
+
+#endif /* SDL_audiomixer_c_h_ */
+
+/* vi: set ts=4 sw=4 expandtab: */
@@ -85,6 +85,283 @@ static const Uint8 mix8[] = {
 #define ADJUST_VOLUME(s, v) (s = (s*v)/SDL_MIX_MAXVOLUME)
 #define ADJUST_VOLUME_U8(s, v)  (s = (((s-128)*v)/SDL_MIX_MAXVOLUME)+128)
 
+#ifdef __SSE2__
+#define HAVE_SSE2_INTRINSICS 1
+#endif
+
+#if defined(__AVX2__) && defined(HAVE_IMMINTRIN_H)
+#define HAVE_AVX2_INTRINSICS 1
+#endif
+
+#if HAVE_SSE2_INTRINSICS || HAVE_AVX2_INTRINSICS
+/* The SIMD mixers below process as many whole vectors as they can and return
+   the number of bytes they consumed; the scalar loops finish off the rest.
+   They produce bit-identical results to the scalar code, as long as the
+   volume is within 0 - SDL_MIX_MAXVOLUME (the scalar code wraps instead of
+   saturating when it's not, so we leave that to the scalar path). */
+#define SIMD_VOLUME_OK(v) (((v) > 0) && ((v) <= SDL_MIX_MAXVOLUME))
+#endif
+
+#if HAVE_SSE2_INTRINSICS
+#define SSE2_BSWAP16(x) _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8))
+#define SSE2_BSWAP32(x) SSE2_BSWAP16(_mm_shufflehi_epi16(_mm_shufflelo_epi16(x, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1)))
+
+/* Multiply eight Sint16 by volume and divide by 128, rounding towards zero
+   like the scalar ADJUST_VOLUME does. */
+static SDL_INLINE __m128i
+SDL_AdjustVolume_S16_SSE2(const __m128i s, const __m128i vol)
+{
+    const __m128i bias = _mm_set1_epi32(SDL_MIX_MAXVOLUME - 1);
+    const __m128i lo = _mm_mullo_epi16(s, vol);
+    const __m128i hi = _mm_mulhi_epi16(s, vol);
+    __m128i a = _mm_unpacklo_epi16(lo, hi);
+    __m128i b = _mm_unpackhi_epi16(lo, hi);
+    a = _mm_srai_epi32(_mm_add_epi32(a, _mm_and_si128(_mm_srai_epi32(a, 31), bias)), 7);
+    b = _mm_srai_epi32(_mm_add_epi32(b, _mm_and_si128(_mm_srai_epi32(b, 31), bias)), 7);
+    return _mm_packs_epi32(a, b);
+}
+
+static Uint32
+SDL_MixAudio_S16_SSE2(Uint8 * dst, const Uint8 * src, Uint32 len, int volume, const SDL_bool swap)
+{
+    const __m128i vol = _mm_set1_epi16((Sint16) volume);
+    Uint32 i;
+
+    for (i = 0; (i + 16) <= len; i += 16) {
+        __m128i s = _mm_loadu_si128((const __m128i *) (src + i));
+        __m128i d = _mm_loadu_si128((const __m128i *) (dst + i));
+        if (swap) {
+            s = SSE2_BSWAP16(s);
+            d = SSE2_BSWAP16(d);
+        }
+        if (volume != SDL_MIX_MAXVOLUME) {
+            s = SDL_AdjustVolume_S16_SSE2(s, vol);
+        }
+        d = _mm_adds_epi16(d, s);
+        if (swap) {
+            d = SSE2_BSWAP16(d);
+        }
+        _mm_storeu_si128((__m128i *) (dst + i), d);
+    }
+    return i;
+}
+
+/* SSE2 has no 32-bit saturating add (or a signed 32x32 multiply), so widen
+   to double, where everything we do here is exact, and clamp there. */
+static Uint32
+SDL_MixAudio_S32_SSE2(Uint8 * dst, const Uint8 * src, Uint32 len, int volume, const SDL_bool swap)
+{
+    const __m128d fvolume = _mm_set1_pd(((double) volume) / ((double) SDL_MIX_MAXVOLUME));
+    const __m128d max_audioval = _mm_set1_pd(2147483647.0);
+    const __m128d min_audioval = _mm_set1_pd(-2147483648.0);
+    Uint32 i;
+
+    for (i = 0; (i + 16) <= len; i += 16) {
+        __m128i s = _mm_loadu_si128((const __m128i *) (src + i));
+        __m128i d = _mm_loadu_si128((const __m128i *) (dst + i));
+        __m128d s0, s1, d0, d1;
+        if (swap) {
+            s = SSE2_BSWAP32(s);
+            d = SSE2_BSWAP32(d);
+        }
+        if (volume != SDL_MIX_MAXVOLUME) {
+            /* truncate towards zero, like the scalar path. */
+            const __m128i a = _mm_cvttpd_epi32(_mm_mul_pd(_mm_cvtepi32_pd(s), fvolume));
+            const __m128i b = _mm_cvttpd_epi32(_mm_mul_pd(_mm_cvtepi32_pd(_mm_srli_si128(s, 8)), fvolume));
+            s = _mm_unpacklo_epi64(a, b);
+        }
+        s0 = _mm_cvtepi32_pd(s);
+        s1 = _mm_cvtepi32_pd(_mm_srli_si128(s, 8));
+        d0 = _mm_cvtepi32_pd(d);
+        d1 = _mm_cvtepi32_pd(_mm_srli_si128(d, 8));
+        d0 = _mm_max_pd(_mm_min_pd(_mm_add_pd(d0, s0), max_audioval), min_audioval);
+        d1 = _mm_max_pd(_mm_min_pd(_mm_add_pd(d1, s1), max_audioval), min_audioval);
+        d = _mm_unpacklo_epi64(_mm_cvtpd_epi32(d0), _mm_cvtpd_epi32(d1));
+        if (swap) {
+            d = SSE2_BSWAP32(d);
+        }
+        _mm_storeu_si128((__m128i *) (dst + i), d);
+    }
+    return i;
+}
+
+static Uint32
+SDL_MixAudio_F32_SSE2(Uint8 * dst, const Uint8 * src, Uint32 len, int volume, const SDL_bool swap)
+{
+    const __m128 fmaxvolume = _mm_set1_ps(1.0f / ((float) SDL_MIX_MAXVOLUME));
+    const __m128 fvolume = _mm_set1_ps((float) volume);
+    const __m128 max_audioval = _mm_set1_ps(3.402823466e+38F);
+    const __m128 min_audioval = _mm_set1_ps(-3.402823466e+38F);
+    Uint32 i;
+
+    for (i = 0; (i + 16) <= len; i += 16) {
+        __m128i si = _mm_loadu_si128((const __m128i *) (src + i));
+        __m128i di = _mm_loadu_si128((const __m128i *) (dst + i));
+        __m128 s, d;
+        if (swap) {
+            si = SSE2_BSWAP32(si);
+            di = SSE2_BSWAP32(di);
+        }
+        s = _mm_mul_ps(_mm_mul_ps(_mm_castsi128_ps(si), fvolume), fmaxvolume);
+        /* Adding in single precision rounds the same as adding in double and
+           narrowing; overflow to infinity is caught by the clamp. The limit
+           goes first so NaNs pass through untouched, as in the scalar path. */
+        d = _mm_add_ps(_mm_castsi128_ps(di), s);
+        d = _mm_max_ps(min_audioval, _mm_min_ps(max_audioval, d));
+        di = _mm_castps_si128(d);
+        if (swap) {
+            di = SSE2_BSWAP32(di);
+        }
+        _mm_storeu_si128((__m128i *) (dst + i), di);
+    }
+    return i;
+}
+#endif
+
+#if HAVE_AVX2_INTRINSICS
+#define AVX2_BSWAP16(x) _mm256_or_si256(_mm256_slli_epi16(x, 8), _mm256_srli_epi16(x, 8))
+#define AVX2_BSWAP32(x) _mm256_shuffle_epi8(x, _mm256_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3, 12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3))
+
+static Uint32
+SDL_MixAudio_S16_AVX2(Uint8 * dst, const Uint8 * src, Uint32 len, int volume, const SDL_bool swap)
+{
+    const __m256i vol = _mm256_set1_epi16((Sint16) volume);
+    const __m256i bias = _mm256_set1_epi32(SDL_MIX_MAXVOLUME - 1);
+    Uint32 i;
+
+    for (i = 0; (i + 32) <= len; i += 32) {
+        __m256i s = _mm256_loadu_si256((const __m256i *) (src + i));
+        __m256i d = _mm256_loadu_si256((const __m256i *) (dst + i));
+        if (swap) {
+            s = AVX2_BSWAP16(s);
+            d = AVX2_BSWAP16(d);
+        }
+        if (volume != SDL_MIX_MAXVOLUME) {
+            /* unpack and pack both work per 128-bit lane, so order is kept. */
+            const __m256i lo = _mm256_mullo_epi16(s, vol);
+            const __m256i hi = _mm256_mulhi_epi16(s, vol);
+            __m256i a = _mm256_unpacklo_epi16(lo, hi);
+            __m256i b = _mm256_unpackhi_epi16(lo, hi);
+            a = _mm256_srai_epi32(_mm256_add_epi32(a, _mm256_and_si256(_mm256_srai_epi32(a, 31), bias)), 7);
+            b = _mm256_srai_epi32(_mm256_add_epi32(b, _mm256_and_si256(_mm256_srai_epi32(b, 31), bias)), 7);
+            s = _mm256_packs_epi32(a, b);
+        }
+        d = _mm256_adds_epi16(d, s);
+        if (swap) {
+            d = AVX2_BSWAP16(d);
+        }
+        _mm256_storeu_si256((__m256i *) (dst + i), d);
+    }
+    return i;
+}
+
+static Uint32
+SDL_MixAudio_S32_AVX2(Uint8 * dst, const Uint8 * src, Uint32 len, int volume, const SDL_bool swap)
+{
+    const __m256d fvolume = _mm256_set1_pd(((double) volume) / ((double) SDL_MIX_MAXVOLUME));
+    const __m256d max_audioval = _mm256_set1_pd(2147483647.0);
+    const __m256d min_audioval = _mm256_set1_pd(-2147483648.0);
+    Uint32 i;
+
+    for (i = 0; (i + 32) <= len; i += 32) {
+        __m256i s = _mm256_loadu_si256((const __m256i *) (src + i));
+        __m256i d = _mm256_loadu_si256((const __m256i *) (dst + i));
+        __m128i s0, s1;
+        __m256d d0, d1;
+        if (swap) {
+            s = AVX2_BSWAP32(s);
+            d = AVX2_BSWAP32(d);
+        }
+        s0 = _mm256_castsi256_si128(s);
+        s1 = _mm256_extracti128_si256(s, 1);
+        if (volume != SDL_MIX_MAXVOLUME) {
+            s0 = _mm256_cvttpd_epi32(_mm256_mul_pd(_mm256_cvtepi32_pd(s0), fvolume));
+            s1 = _mm256_cvttpd_epi32(_mm256_mul_pd(_mm256_cvtepi32_pd(s1), fvolume));
+        }
+        d0 = _mm256_add_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(d)), _mm256_cvtepi32_pd(s0));
+        d1 = _mm256_add_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(d, 1)), _mm256_cvtepi32_pd(s1));
+        d0 = _mm256_max_pd(_mm256_min_pd(d0, max_audioval), min_audioval);
+        d1 = _mm256_max_pd(_mm256_min_pd(d1, max_audioval), min_audioval);
+        d = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm256_cvtpd_epi32(d0)), _mm256_cvtpd_epi32(d1), 1);
+        if (swap) {
+            d = AVX2_BSWAP32(d);
+        }
+        _mm256_storeu_si256((__m256i *) (dst + i), d);
+    }
+    return i;
+}
+
+static Uint32
+SDL_MixAudio_F32_AVX2(Uint8 * dst, const Uint8 * src, Uint32 len, int volume, const SDL_bool swap)
+{
+    const __m256 fmaxvolume = _mm256_set1_ps(1.0f / ((float) SDL_MIX_MAXVOLUME));
+    const __m256 fvolume = _mm256_set1_ps((float) volume);
+    const __m256 max_audioval = _mm256_set1_ps(3.402823466e+38F);
+    const __m256 min_audioval = _mm256_set1_ps(-3.402823466e+38F);
+    Uint32 i;
+
+    for (i = 0; (i + 32) <= len; i += 32) {
+        __m256i si = _mm256_loadu_si256((const __m256i *) (src + i));
+        __m256i di = _mm256_loadu_si256((const __m256i *) (dst + i));
+        __m256 s, d;
+        if (swap) {
+            si = AVX2_BSWAP32(si);
+            di = AVX2_BSWAP32(di);
+        }
+        /* no FMA here, it would round differently than the scalar path. */
+        s = _mm256_mul_ps(_mm256_mul_ps(_mm256_castsi256_ps(si), fvolume), fmaxvolume);
+        d = _mm256_add_ps(_mm256_castsi256_ps(di), s);
+        d = _mm256_max_ps(min_audioval, _mm256_min_ps(max_audioval, d));
+        di = _mm256_castps_si256(d);
+        if (swap) {
+            di = AVX2_BSWAP32(di);
+        }
+        _mm256_storeu_si256((__m256i *) (dst + i), di);
+    }
+    return i;
+}
+#endif
+
+/* Run the widest SIMD mixer we have for this format over the front of the
+   buffer, advancing dst, src and len past whatever it handled. */
+#if HAVE_AVX2_INTRINSICS
+#define MIX_AVX2(fmt, swap) \
+    if (SDL_HasAVX2()) { \
+        const Uint32 done = SDL_MixAudio_##fmt##_AVX2(dst, src, len, volume, swap); \
+        dst += done; src += done; len -= done; \
+    }
+#else
+#define MIX_AVX2(fmt, swap)
+#endif
+
+#if HAVE_SSE2_INTRINSICS
+#define MIX_SSE2(fmt, swap) \
+    if (SDL_HasSSE2()) { \
+        const Uint32 done = SDL_MixAudio_##fmt##_SSE2(dst, src, len, volume, swap); \
+        dst += done; src += done; len -= done; \
+    }
+#else
+#define MIX_SSE2(fmt, swap)
+#endif
+
+#if HAVE_SSE2_INTRINSICS || HAVE_AVX2_INTRINSICS
+#define MIX_SIMD(fmt, swap) \
+    if (SIMD_VOLUME_OK(volume)) { \
+        MIX_AVX2(fmt, swap) \
+        MIX_SSE2(fmt, swap) \
+    }
+#else
+#define MIX_SIMD(fmt, swap)
+#endif
+
+#if SDL_BYTEORDER == SDL_LIL_ENDIAN
+#define SWAP_LSB SDL_FALSE
+#define SWAP_MSB SDL_TRUE
+#else
+#define SWAP_LSB SDL_TRUE
+#define SWAP_MSB SDL_FALSE
+#endif
+
 
 void
 SDL_MixAudioFormat(Uint8 * dst, const Uint8 * src, SDL_AudioFormat format,
@@ -150,6 +427,8 @@ SDL_MixAudioFormat(Uint8 * dst, const Uint8 * src, SDL_AudioFormat format,
             const int max_audioval = ((1 << (16 - 1)) - 1);
             const int min_audioval = -(1 << (16 - 1));
 
+            MIX_SIMD(S16, SWAP_LSB);
+
             len /= 2;
             while (len--) {
                 src1 = ((src[1]) << 8 | src[0]);
@@ -181,6 +460,8 @@ SDL_MixAudioFormat(Uint8 * dst, const Uint8 * src, SDL_AudioFormat format,
             const int max_audioval = ((1 << (16 - 1)) - 1);
             const int min_audioval = -(1 << (16 - 1));
 
+            MIX_SIMD(S16, SWAP_MSB);
+
             len /= 2;
             while (len--) {
                 src1 = ((src[0]) << 8 | src[1]);
@@ -252,13 +533,17 @@ SDL_MixAudioFormat(Uint8 * dst, const Uint8 * src, SDL_AudioFormat format,
 
     case AUDIO_S32LSB:
         {
-            const Uint32 *src32 = (Uint32 *) src;
-            Uint32 *dst32 = (Uint32 *) dst;
+            const Uint32 *src32;
+            Uint32 *dst32;
             Sint64 src1, src2;
             Sint64 dst_sample;
             const Sint64 max_audioval = ((((Sint64) 1) << (32 - 1)) - 1);
             const Sint64 min_audioval = -(((Sint64) 1) << (32 - 1));
 
+            MIX_SIMD(S32, SWAP_LSB);
+
+            src32 = (const Uint32 *) src;
+            dst32 = (Uint32 *) dst;
             len /= 4;
             while (len--) {
                 src1 = (Sint64) ((Sint32) SDL_SwapLE32(*src32));
@@ -278,13 +563,17 @@ SDL_MixAudioFormat(Uint8 * dst, const Uint8 * src, SDL_AudioFormat format,
 
     case AUDIO_S32MSB:
         {
-            const Uint32 *src32 = (Uint32 *) src;
-            Uint32 *dst32 = (Uint32 *) dst;
+            const Uint32 *src32;
+            Uint32 *dst32;
             Sint64 src1, src2;
             Sint64 dst_sample;
             const Sint64 max_audioval = ((((Sint64) 1) << (32 - 1)) - 1);
             const Sint64 min_audioval = -(((Sint64) 1) << (32 - 1));
 
+            MIX_SIMD(S32, SWAP_MSB);
+
+            src32 = (const Uint32 *) src;
+            dst32 = (Uint32 *) dst;
             len /= 4;
             while (len--) {
                 src1 = (Sint64) ((Sint32) SDL_SwapBE32(*src32));
@@ -306,14 +595,18 @@ SDL_MixAudioFormat(Uint8 * dst, const Uint8 * src, SDL_AudioFormat format,
         {
             const float fmaxvolume = 1.0f / ((float) SDL_MIX_MAXVOLUME);
             const float fvolume = (float) volume;
-            const float *src32 = (float *) src;
-            float *dst32 = (float *) dst;
+            const float *src32;
+            float *dst32;
             float src1, src2;
             double dst_sample;
             /* !!! FIXME: are these right? */
             const double max_audioval = 3.402823466e+38F;
             const double min_audioval = -3.402823466e+38F;
 
+            MIX_SIMD(F32, SWAP_LSB);
+
+            src32 = (const float *) src;
+            dst32 = (float *) dst;
             len /= 4;
             while (len--) {
                 src1 = ((SDL_SwapFloatLE(*src32) * fvolume) * fmaxvolume);
@@ -335,14 +628,18 @@ SDL_MixAudioFormat(Uint8 * dst, const Uint8 * src, SDL_AudioFormat format,
         {
             const float fmaxvolume = 1.0f / ((float) SDL_MIX_MAXVOLUME);
             const float fvolume = (float) volume;
-            const float *src32 = (float *) src;
-            float *dst32 = (float *) dst;
+            const float *src32;
+            float *dst32;
             float src1, src2;
             double dst_sample;
             /* !!! FIXME: are these right? */
             const double max_audioval = 3.402823466e+38F;
             const double min_audioval = -3.402823466e+38F;
 
+            MIX_SIMD(F32, SWAP_MSB);
+
+            src32 = (const float *) src;
+            dst32 = (float *) dst;
             len /= 4;
             while (len--) {
                 src1 = ((SDL_SwapFloatBE(*src32) * fvolume) * fmaxvolume);
@@ -23,409 +23,522 @@
 /* Microsoft WAVE file loading routines */
 
 #include "SDL_audio.h"
+#include "SDL_atomic.h"
+#include "SDL_jobs.h"
 #include "SDL_wave.h"
 
 
+static int ReadChunkHeader(SDL_RWops * src, Chunk * chunk);
 static int ReadChunk(SDL_RWops * src, Chunk * chunk);
+static int SkipChunk(SDL_RWops * src, Chunk * chunk);
+
+/* Sample frames decoded at a time when streaming uncompressed data */
+#define WAVSTREAM_PCM_FRAMES 4096
 
 struct MS_ADPCM_decodestate
 {
-    Uint8 hPredictor;
-    Uint16 iDelta;
-    Sint16 iSamp1;
-    Sint16 iSamp2;
+    Sint32 iCoef1;
+    Sint32 iCoef2;
+    Sint32 iDelta;
+    Sint32 iSamp1;
+    Sint32 iSamp2;
 };
-static struct MS_ADPCM_decoder
+struct MS_ADPCM_decoder
 {
     WaveFMT wavefmt;
     Uint16 wSamplesPerBlock;
     Uint16 wNumCoef;
     Sint16 aCoeff[7][2];
-    /* * * */
-    struct MS_ADPCM_decodestate state[2];
-} MS_ADPCM_state;
+};
+
+struct IMA_ADPCM_decodestate
+{
+    Sint32 sample;
+    int index;
+};
+struct IMA_ADPCM_decoder
+{
+    WaveFMT wavefmt;
+    Uint16 wSamplesPerBlock;
+};
+
+
+/* Everything needed to decode a file's audio data once its header is read.
+   The ADPCM decoders keep their state here too, so any number of files can
+   be decoded at once. */
+typedef struct WaveDecoder
+{
+    Uint16 encoding;            /* PCM_CODE, IEEE_FLOAT_CODE, MS_ADPCM_CODE or IMA_ADPCM_CODE */
+    Uint16 bitspersample;
+    Uint32 blocksize;           /* Bytes per encoded ADPCM block */
+    Uint32 decodedsize;         /* Bytes per decoded ADPCM block */
+    struct MS_ADPCM_decoder ms_adpcm;
+    struct IMA_ADPCM_decoder ima_adpcm;
+} WaveDecoder;
+
+struct _SDL_WAVStream
+{
+    SDL_RWops *src;
+    int freesrc;
+    SDL_AudioSpec spec;
+    WaveDecoder decoder;
+    Sint64 datastart;           /* Where the audio data starts in src */
+    Uint32 datalen;             /* Encoded bytes in the data chunk */
+    Uint32 datapos;             /* Encoded bytes consumed so far */
+    Uint32 blocksize;           /* Encoded bytes decoded at a time */
+    int framesize;              /* Decoded bytes per sample frame */
+    Uint8 *block;               /* Encoded data, for ADPCM only */
+    Uint8 *partial;             /* A partly read frame, for PCM only */
+    Uint32 partiallen;
+    Uint8 *window;              /* Decoded data */
+    Uint32 windowlen;
+    Uint32 windowpos;
+};
 
 static int
-InitMS_ADPCM(WaveFMT * format)
+InitMS_ADPCM(struct MS_ADPCM_decoder *decoder, WaveFMT * format, Uint32 fmtlen)
 {
     Uint8 *rogue_feel;
+    Uint32 channels;
     int i;
 
+    /* The coefficient table follows the format, after the extra size field */
+    if (fmtlen < (sizeof(*format) + 3 * sizeof(Uint16) + 7 * 2 * sizeof(Sint16))) {
+        return SDL_SetError("Invalid MS_ADPCM format chunk");
+    }
+
     /* Set the rogue pointer to the MS_ADPCM specific data */
-    MS_ADPCM_state.wavefmt.encoding = SDL_SwapLE16(format->encoding);
-    MS_ADPCM_state.wavefmt.channels = SDL_SwapLE16(format->channels);
-    MS_ADPCM_state.wavefmt.frequency = SDL_SwapLE32(format->frequency);
-    MS_ADPCM_state.wavefmt.byterate = SDL_SwapLE32(format->byterate);
-    MS_ADPCM_state.wavefmt.blockalign = SDL_SwapLE16(format->blockalign);
-    MS_ADPCM_state.wavefmt.bitspersample =
-        SDL_SwapLE16(format->bitspersample);
+    decoder->wavefmt.encoding = SDL_SwapLE16(format->encoding);
+    decoder->wavefmt.channels = SDL_SwapLE16(format->channels);
+    decoder->wavefmt.frequency = SDL_SwapLE32(format->frequency);
+    decoder->wavefmt.byterate = SDL_SwapLE32(format->byterate);
+    decoder->wavefmt.blockalign = SDL_SwapLE16(format->blockalign);
+    decoder->wavefmt.bitspersample = SDL_SwapLE16(format->bitspersample);
     rogue_feel = (Uint8 *) format + sizeof(*format);
     if (sizeof(*format) == 16) {
         /* const Uint16 extra_info = ((rogue_feel[1] << 8) | rogue_feel[0]); */
         rogue_feel += sizeof(Uint16);
     }
-    MS_ADPCM_state.wSamplesPerBlock = ((rogue_feel[1] << 8) | rogue_feel[0]);
+    decoder->wSamplesPerBlock = ((rogue_feel[1] << 8) | rogue_feel[0]);
     rogue_feel += sizeof(Uint16);
-    MS_ADPCM_state.wNumCoef = ((rogue_feel[1] << 8) | rogue_feel[0]);
+    decoder->wNumCoef = ((rogue_feel[1] << 8) | rogue_feel[0]);
     rogue_feel += sizeof(Uint16);
-    if (MS_ADPCM_state.wNumCoef != 7) {
+    if (decoder->wNumCoef != 7) {
         SDL_SetError("Unknown set of MS_ADPCM coefficients");
         return (-1);
     }
-    for (i = 0; i < MS_ADPCM_state.wNumCoef; ++i) {
-        MS_ADPCM_state.aCoeff[i][0] = ((rogue_feel[1] << 8) | rogue_feel[0]);
+    for (i = 0; i < decoder->wNumCoef; ++i) {
+        decoder->aCoeff[i][0] = ((rogue_feel[1] << 8) | rogue_feel[0]);
         rogue_feel += sizeof(Uint16);
-        MS_ADPCM_state.aCoeff[i][1] = ((rogue_feel[1] << 8) | rogue_feel[0]);
+        decoder->aCoeff[i][1] = ((rogue_feel[1] << 8) | rogue_feel[0]);
         rogue_feel += sizeof(Uint16);
     }
+
+    /* Make sure a block holds as many samples as it claims to, since
+       the decoder trusts that: a 7 byte header per channel holding the
+       first two samples, then two samples per byte. */
+    channels = decoder->wavefmt.channels;
+    if ((channels < 1) || (channels > 2)) {
+        return SDL_SetError("MS_ADPCM decoder can only handle 2 channels");
+    }
+    if ((decoder->wSamplesPerBlock < 2) ||
+        ((((decoder->wSamplesPerBlock - 2) * channels) % 2) != 0) ||
+        ((7 * channels + (decoder->wSamplesPerBlock - 2) * channels / 2) >
+         decoder->wavefmt.blockalign)) {
+        return SDL_SetError("Invalid MS_ADPCM block size");
+    }
     return (0);
 }
 
-static Sint32
-MS_ADPCM_nibble(struct MS_ADPCM_decodestate *state,
-                Uint8 nybble, Sint16 * coeff)
+/* Adaptation of the quantizer step size for each nybble, in 1/256ths */
+static const Sint32 MS_ADPCM_adaptive[16] = {
+    230, 230, 230, 230, 307, 409, 512, 614,
+    768, 614, 512, 409, 307, 230, 230, 230
+};
+
+/* Unlike IMA ADPCM, there's no table of deltas to precompute here: the
+   step size is any 16-bit value scaled by the previous nybble, not one of
+   a few dozen indices, so a table would need an entry for each of them. */
+static SDL_INLINE Sint16
+MS_ADPCM_nibble(struct MS_ADPCM_decodestate *state, const Uint8 nybble)
 {
     const Sint32 max_audioval = ((1 << (16 - 1)) - 1);
     const Sint32 min_audioval = -(1 << (16 - 1));
-    const Sint32 adaptive[] = {
-        230, 230, 230, 230, 307, 409, 512, 614,
-        768, 614, 512, 409, 307, 230, 230, 230
-    };
+    const Sint32 signednybble = (nybble & 0x08) ? (nybble - 0x10) : nybble;
     Sint32 new_sample, delta;
 
-    new_sample = ((state->iSamp1 * coeff[0]) +
-                  (state->iSamp2 * coeff[1])) / 256;
-    if (nybble & 0x08) {
-        new_sample += state->iDelta * (nybble - 0x10);
-    } else {
-        new_sample += state->iDelta * nybble;
-    }
+    new_sample = ((state->iSamp1 * state->iCoef1) +
+                  (state->iSamp2 * state->iCoef2)) / 256;
+    new_sample += state->iDelta * signednybble;
     if (new_sample < min_audioval) {
         new_sample = min_audioval;
     } else if (new_sample > max_audioval) {
         new_sample = max_audioval;
     }
-    delta = ((Sint32) state->iDelta * adaptive[nybble]) / 256;
+    delta = (state->iDelta * MS_ADPCM_adaptive[nybble]) / 256;
     if (delta < 16) {
         delta = 16;
     }
     state->iDelta = (Uint16) delta;
     state->iSamp2 = state->iSamp1;
-    state->iSamp1 = (Sint16) new_sample;
-    return (new_sample);
+    state->iSamp1 = new_sample;
+    return (Sint16) new_sample;
 }
 
+/* Decode one block of wavefmt.blockalign bytes into wSamplesPerBlock
+   sample frames of little-endian 16-bit audio. Every block starts over
+   from the state in its header, so blocks can be decoded in any order. */
 static int
-MS_ADPCM_decode(Uint8 ** audio_buf, Uint32 * audio_len)
+MS_ADPCM_decode_block(const struct MS_ADPCM_decoder *decoder,
+                      const Uint8 * encoded, Uint8 * decoded)
 {
-    struct MS_ADPCM_decodestate *state[2];
-    Uint8 *freeable, *encoded, *decoded;
-    Sint32 encoded_len, samplesleft;
-    Sint8 nybble;
-    Uint8 stereo;
-    Sint16 *coeff[2];
-    Sint32 new_sample;
+    const int channels = decoder->wavefmt.channels;
+    const int bytes = ((decoder->wSamplesPerBlock - 2) * channels) / 2;
+    struct MS_ADPCM_decodestate state[2];
+    Sint16 *out = (Sint16 *) decoded;
+    int c, i;
 
-    /* Allocate the proper sized output buffer */
-    encoded_len = *audio_len;
-    encoded = *audio_buf;
-    freeable = *audio_buf;
-    *audio_len = (encoded_len / MS_ADPCM_state.wavefmt.blockalign) *
-        MS_ADPCM_state.wSamplesPerBlock *
-        MS_ADPCM_state.wavefmt.channels * sizeof(Sint16);
-    *audio_buf = (Uint8 *) SDL_malloc(*audio_len);
-    if (*audio_buf == NULL) {
-        return SDL_OutOfMemory();
-    }
-    decoded = *audio_buf;
-
-    /* Get ready... Go! */
-    stereo = (MS_ADPCM_state.wavefmt.channels == 2);
-    state[0] = &MS_ADPCM_state.state[0];
-    state[1] = &MS_ADPCM_state.state[stereo];
-    while (encoded_len >= MS_ADPCM_state.wavefmt.blockalign) {
-        /* Grab the initial information for this block */
-        state[0]->hPredictor = *encoded++;
-        if (stereo) {
-            state[1]->hPredictor = *encoded++;
-        }
-        state[0]->iDelta = ((encoded[1] << 8) | encoded[0]);
-        encoded += sizeof(Sint16);
-        if (stereo) {
-            state[1]->iDelta = ((encoded[1] << 8) | encoded[0]);
-            encoded += sizeof(Sint16);
-        }
-        state[0]->iSamp1 = ((encoded[1] << 8) | encoded[0]);
-        encoded += sizeof(Sint16);
-        if (stereo) {
-            state[1]->iSamp1 = ((encoded[1] << 8) | encoded[0]);
-            encoded += sizeof(Sint16);
-        }
-        state[0]->iSamp2 = ((encoded[1] << 8) | encoded[0]);
-        encoded += sizeof(Sint16);
-        if (stereo) {
-            state[1]->iSamp2 = ((encoded[1] << 8) | encoded[0]);
-            encoded += sizeof(Sint16);
-        }
-        coeff[0] = MS_ADPCM_state.aCoeff[state[0]->hPredictor];
-        coeff[1] = MS_ADPCM_state.aCoeff[state[1]->hPredictor];
-
-        /* Store the two initial samples we start with */
-        decoded[0] = state[0]->iSamp2 & 0xFF;
-        decoded[1] = state[0]->iSamp2 >> 8;
-        decoded += 2;
-        if (stereo) {
-            decoded[0] = state[1]->iSamp2 & 0xFF;
-            decoded[1] = state[1]->iSamp2 >> 8;
-            decoded += 2;
-        }
-        decoded[0] = state[0]->iSamp1 & 0xFF;
-        decoded[1] = state[0]->iSamp1 >> 8;
-        decoded += 2;
-        if (stereo) {
-            decoded[0] = state[1]->iSamp1 & 0xFF;
-            decoded[1] = state[1]->iSamp1 >> 8;
-            decoded += 2;
+    /* The header has each field for every channel before the next field */
+    for (c = 0; c < channels; ++c) {
+        const Uint8 predictor = encoded[c];
+        const Uint8 *delta = encoded + channels + 2 * c;
+        const Uint8 *samp1 = encoded + 3 * channels + 2 * c;
+        const Uint8 *samp2 = encoded + 5 * channels + 2 * c;
+        if (predictor >= decoder->wNumCoef) {
+            return (-1);
         }
+        state[c].iCoef1 = decoder->aCoeff[predictor][0];
+        state[c].iCoef2 = decoder->aCoeff[predictor][1];
+        state[c].iDelta = (Uint16) ((delta[1] << 8) | delta[0]);
+        state[c].iSamp1 = (Sint16) ((samp1[1] << 8) | samp1[0]);
+        state[c].iSamp2 = (Sint16) ((samp2[1] << 8) | samp2[0]);
 
-        /* Decode and store the other samples in this block */
-        samplesleft = (MS_ADPCM_state.wSamplesPerBlock - 2) *
-            MS_ADPCM_state.wavefmt.channels;
-        while (samplesleft > 0) {
-            nybble = (*encoded) >> 4;
-            new_sample = MS_ADPCM_nibble(state[0], nybble, coeff[0]);
-            decoded[0] = new_sample & 0xFF;
-            new_sample >>= 8;
-            decoded[1] = new_sample & 0xFF;
-            decoded += 2;
-
-            nybble = (*encoded) & 0x0F;
-            new_sample = MS_ADPCM_nibble(state[1], nybble, coeff[1]);
-            decoded[0] = new_sample & 0xFF;
-            new_sample >>= 8;
-            decoded[1] = new_sample & 0xFF;
-            decoded += 2;
-
-            ++encoded;
-            samplesleft -= 2;
-        }
-        encoded_len -= MS_ADPCM_state.wavefmt.blockalign;
+        /* Store the two initial samples we start with, oldest first */
+        out[c] = (Sint16) SDL_SwapLE16((Uint16) state[c].iSamp2);
+        out[channels + c] = (Sint16) SDL_SwapLE16((Uint16) state[c].iSamp1);
+    }
+    encoded += 7 * channels;
+    out += 2 * channels;
+
+    /* Then two nybbles per byte, high one first. In stereo, the high one
+       is the left channel and the low one the right. */
+    for (i = 0; i < bytes; ++i) {
+        out[0] = (Sint16) SDL_SwapLE16((Uint16) MS_ADPCM_nibble(&state[0], encoded[i] >> 4));
+        out[1] = (Sint16) SDL_SwapLE16((Uint16) MS_ADPCM_nibble(&state[channels - 1], encoded[i] & 0x0F));
+        out += 2;
     }
-    SDL_free(freeable);
     return (0);
 }
 
-struct IMA_ADPCM_decodestate
-{
-    Sint32 sample;
-    Sint8 index;
-};
-static struct IMA_ADPCM_decoder
-{
-    WaveFMT wavefmt;
-    Uint16 wSamplesPerBlock;
-    /* * * */
-    struct IMA_ADPCM_decodestate state[2];
-} IMA_ADPCM_state;
-
 static int
-InitIMA_ADPCM(WaveFMT * format)
+InitIMA_ADPCM(struct IMA_ADPCM_decoder *decoder, WaveFMT * format, Uint32 fmtlen)
 {
     Uint8 *rogue_feel;
+    Uint32 channels;
+
+    /* The samples per block follow the format, after the extra size field */
+    if (fmtlen < (sizeof(*format) + 2 * sizeof(Uint16))) {
+        return SDL_SetError("Invalid IMA_ADPCM format chunk");
+    }
 
     /* Set the rogue pointer to the IMA_ADPCM specific data */
-    IMA_ADPCM_state.wavefmt.encoding = SDL_SwapLE16(format->encoding);
-    IMA_ADPCM_state.wavefmt.channels = SDL_SwapLE16(format->channels);
-    IMA_ADPCM_state.wavefmt.frequency = SDL_SwapLE32(format->frequency);
-    IMA_ADPCM_state.wavefmt.byterate = SDL_SwapLE32(format->byterate);
-    IMA_ADPCM_state.wavefmt.blockalign = SDL_SwapLE16(format->blockalign);
-    IMA_ADPCM_state.wavefmt.bitspersample =
-        SDL_SwapLE16(format->bitspersample);
+    decoder->wavefmt.encoding = SDL_SwapLE16(format->encoding);
+    decoder->wavefmt.channels = SDL_SwapLE16(format->channels);
+    decoder->wavefmt.frequency = SDL_SwapLE32(format->frequency);
+    decoder->wavefmt.byterate = SDL_SwapLE32(format->byterate);
+    decoder->wavefmt.blockalign = SDL_SwapLE16(format->blockalign);
+    decoder->wavefmt.bitspersample = SDL_SwapLE16(format->bitspersample);
     rogue_feel = (Uint8 *) format + sizeof(*format);
     if (sizeof(*format) == 16) {
         /* const Uint16 extra_info = ((rogue_feel[1] << 8) | rogue_feel[0]); */
         rogue_feel += sizeof(Uint16);
     }
-    IMA_ADPCM_state.wSamplesPerBlock = ((rogue_feel[1] << 8) | rogue_feel[0]);
+    decoder->wSamplesPerBlock = ((rogue_feel[1] << 8) | rogue_feel[0]);
+
+    /* Each channel is decoded on its own, so any number of them is fine */
+    channels = decoder->wavefmt.channels;
+    if (channels < 1) {
+        return SDL_SetError("Invalid number of IMA ADPCM channels");
+    }
+
+    /* A block is a 4 byte header per channel holding the first sample,
+       then runs of 8 samples per channel, packed in 4 bytes. */
+    if ((decoder->wSamplesPerBlock < 1) ||
+        (((decoder->wSamplesPerBlock - 1) % 8) != 0) ||
+        ((4 * channels + (decoder->wSamplesPerBlock - 1) * channels / 2) >
+         decoder->wavefmt.blockalign)) {
+        return SDL_SetError("Invalid IMA ADPCM block size");
+    }
     return (0);
 }
 
-static Sint32
-IMA_ADPCM_nibble(struct IMA_ADPCM_decodestate *state, Uint8 nybble)
+/* How far each nybble moves the index into IMA_ADPCM_deltas */
+static const Sint8 IMA_ADPCM_index_table[16] = {
+    -1, -1, -1, -1,
+    2, 4, 6, 8,
+    -1, -1, -1, -1,
+    2, 4, 6, 8
+};
+
+/* The difference each nybble's magnitude (its low 3 bits) adds to the
+   sample, for each of the 89 quantizer step sizes. */
+static const Uint16 IMA_ADPCM_deltas[89][8] = {
+    { 0, 1, 3, 4, 7, 8, 10, 11 },
+    { 1, 3, 5, 7, 9, 11, 13, 15 },
+    { 1, 3, 5, 7, 10, 12, 14, 16 },
+    { 1, 3, 6, 8, 11, 13, 16, 18 },
+    { 1, 3, 6, 8, 12, 14, 17, 19 },
+    { 1, 4, 7, 10, 13, 16, 19, 22 },
+    { 1, 4, 7, 10, 14, 17, 20, 23 },
+    { 1, 4, 8, 11, 15, 18, 22, 25 },
+    { 2, 6, 10, 14, 18, 22, 26, 30 },
+    { 2, 6, 10, 14, 19, 23, 27, 31 },
+    { 2, 6, 11, 15, 21, 25, 30, 34 },
+    { 2, 7, 12, 17, 23, 28, 33, 38 },
+    { 2, 7, 13, 18, 25, 30, 36, 41 },
+    { 3, 9, 15, 21, 28, 34, 40, 46 },
+    { 3, 10, 17, 24, 31, 38, 45, 52 },
+    { 3, 10, 18, 25, 34, 41, 49, 56 },
+    { 4, 12, 21, 29, 38, 46, 55, 63 },
+    { 4, 13, 22, 31, 41, 50, 59, 68 },
+    { 5, 15, 25, 35, 46, 56, 66, 76 },
+    { 5, 16, 27, 38, 50, 61, 72, 83 },
+    { 6, 18, 31, 43, 56, 68, 81, 93 },
+    { 6, 19, 33, 46, 61, 74, 88, 101 },
+    { 7, 22, 37, 52, 67, 82, 97, 112 },
+    { 8, 24, 41, 57, 74, 90, 107, 123 },
+    { 9, 27, 45, 63, 82, 100, 118, 136 },
+    { 10, 30, 50, 70, 90, 110, 130, 150 },
+    { 11, 33, 55, 77, 99, 121, 143, 165 },
+    { 12, 36, 60, 84, 109, 133, 157, 181 },
+    { 13, 39, 66, 92, 120, 146, 173, 199 },
+    { 14, 43, 73, 102, 132, 161, 191, 220 },
+    { 16, 48, 81, 113, 146, 178, 211, 243 },
+    { 17, 52, 88, 123, 160, 195, 231, 266 },
+    { 19, 58, 97, 136, 176, 215, 254, 293 },
+    { 21, 64, 107, 150, 194, 237, 280, 323 },
+    { 23, 70, 118, 165, 213, 260, 308, 355 },
+    { 26, 78, 130, 182, 235, 287, 339, 391 },
+    { 28, 85, 143, 200, 258, 315, 373, 430 },
+    { 31, 94, 157, 220, 284, 347, 410, 473 },
+    { 34, 103, 173, 242, 313, 382, 452, 521 },
+    { 38, 114, 191, 267, 345, 421, 498, 574 },
+    { 42, 126, 210, 294, 379, 463, 547, 631 },
+    { 46, 138, 231, 323, 417, 509, 602, 694 },
+    { 51, 153, 255, 357, 459, 561, 663, 765 },
+    { 56, 168, 280, 392, 505, 617, 729, 841 },
+    { 61, 184, 308, 431, 555, 678, 802, 925 },
+    { 68, 204, 340, 476, 612, 748, 884, 1020 },
+    { 74, 223, 373, 522, 672, 821, 971, 1120 },
+    { 82, 246, 411, 575, 740, 904, 1069, 1233 },
+    { 90, 271, 452, 633, 814, 995, 1176, 1357 },
+    { 99, 298, 497, 696, 895, 1094, 1293, 1492 },
+    { 109, 328, 547, 766, 985, 1204, 1423, 1642 },
+    { 120, 360, 601, 841, 1083, 1323, 1564, 1804 },
+    { 132, 397, 662, 927, 1192, 1457, 1722, 1987 },
+    { 145, 436, 728, 1019, 1311, 1602, 1894, 2185 },
+    { 160, 480, 801, 1121, 1442, 1762, 2083, 2403 },
+    { 176, 528, 881, 1233, 1587, 1939, 2292, 2644 },
+    { 194, 582, 970, 1358, 1746, 2134, 2522, 2910 },
+    { 213, 639, 1066, 1492, 1920, 2346, 2773, 3199 },
+    { 234, 703, 1173, 1642, 2112, 2581, 3051, 3520 },
+    { 258, 774, 1291, 1807, 2324, 2840, 3357, 3873 },
+    { 284, 852, 1420, 1988, 2556, 3124, 3692, 4260 },
+    { 312, 936, 1561, 2185, 2811, 3435, 4060, 4684 },
+    { 343, 1030, 1717, 2404, 3092, 3779, 4466, 5153 },
+    { 378, 1134, 1890, 2646, 3402, 4158, 4914, 5670 },
+    { 415, 1246, 2078, 2909, 3742, 4573, 5405, 6236 },
+    { 457, 1372, 2287, 3202, 4117, 5032, 5947, 6862 },
+    { 503, 1509, 2516, 3522, 4529, 5535, 6542, 7548 },
+    { 553, 1660, 2767, 3874, 4981, 6088, 7195, 8302 },
+    { 608, 1825, 3043, 4260, 5479, 6696, 7914, 9131 },
+    { 669, 2008, 3348, 4687, 6027, 7366, 8706, 10045 },
+    { 736, 2209, 3683, 5156, 6630, 8103, 9577, 11050 },
+    { 810, 2431, 4052, 5673, 7294, 8915, 10536, 12157 },
+    { 891, 2674, 4457, 6240, 8023, 9806, 11589, 13372 },
+    { 980, 2941, 4902, 6863, 8825, 10786, 12747, 14708 },
+    { 1078, 3235, 5393, 7550, 9708, 11865, 14023, 16180 },
+    { 1186, 3559, 5932, 8305, 10679, 13052, 15425, 17798 },
+    { 1305, 3915, 6526, 9136, 11747, 14357, 16968, 19578 },
+    { 1435, 4306, 7178, 10049, 12922, 15793, 18665, 21536 },
+    { 1579, 4737, 7896, 11054, 14214, 17372, 20531, 23689 },
+    { 1737, 5211, 8686, 12160, 15636, 19110, 22585, 26059 },
+    { 1911, 5733, 9555, 13377, 17200, 21022, 24844, 28666 },
+    { 2102, 6306, 10511, 14715, 18920, 23124, 27329, 31533 },
+    { 2312, 6937, 11562, 16187, 20812, 25437, 30062, 34687 },
+    { 2543, 7630, 12718, 17805, 22893, 27980, 33068, 38155 },
+    { 2798, 8394, 13990, 19586, 25183, 30779, 36375, 41971 },
+    { 3077, 9232, 15388, 21543, 27700, 33855, 40011, 46166 },
+    { 3385, 10156, 16928, 23699, 30471, 37242, 44014, 50785 },
+    { 3724, 11172, 18621, 26069, 33518, 40966, 48415, 55863 },
+    { 4095, 12286, 20478, 28669, 36862, 45053, 53245, 61436 }
+};
+
+static SDL_INLINE Sint16
+IMA_ADPCM_nibble(struct IMA_ADPCM_decodestate *state, const Uint8 nybble)
 {
     const Sint32 max_audioval = ((1 << (16 - 1)) - 1);
     const Sint32 min_audioval = -(1 << (16 - 1));
-    const int index_table[16] = {
-        -1, -1, -1, -1,
-        2, 4, 6, 8,
-        -1, -1, -1, -1,
-        2, 4, 6, 8
-    };
-    const Sint32 step_table[89] = {
-        7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31,
-        34, 37, 41, 45, 50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130,
-        143, 157, 173, 190, 209, 230, 253, 279, 307, 337, 371, 408,
-        449, 494, 544, 598, 658, 724, 796, 876, 963, 1060, 1166, 1282,
-        1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327,
-        3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630,
-        9493, 10442, 11487, 12635, 13899, 15289, 16818, 18500, 20350,
-        22385, 24623, 27086, 29794, 32767
-    };
-    Sint32 delta, step;
-
-    /* Compute difference and new sample value */
+    const Sint32 delta = IMA_ADPCM_deltas[state->index][nybble & 0x07];
+    Sint32 sample;
+
+    /* Compute the new sample value, and clamp it */
+    sample = (nybble & 0x08) ? (state->sample - delta) : (state->sample + delta);
+    if (sample > max_audioval) {
+        sample = max_audioval;
+    } else if (sample < min_audioval) {
+        sample = min_audioval;
+    }
+    state->sample = sample;
+
+    /* Update index value */
+    state->index += IMA_ADPCM_index_table[nybble];
     if (state->index > 88) {
         state->index = 88;
     } else if (state->index < 0) {
         state->index = 0;
     }
-    /* explicit cast to avoid gcc warning about using 'char' as array index */
-    step = step_table[(int)state->index];
-    delta = step >> 3;
-    if (nybble & 0x04)
-        delta += step;
-    if (nybble & 0x02)
-        delta += (step >> 1);
-    if (nybble & 0x01)
-        delta += (step >> 2);
-    if (nybble & 0x08)
-        delta = -delta;
-    state->sample += delta;
+    return (Sint16) sample;
+}
 
-    /* Update index value */
-    state->index += index_table[nybble];
+/* Decode one block of wavefmt.blockalign bytes into wSamplesPerBlock
+   sample frames of little-endian 16-bit audio. Every block starts over
+   from the state in its header, so blocks can be decoded in any order. */
+static int
+IMA_ADPCM_decode_block(const struct IMA_ADPCM_decoder *decoder,
+                       const Uint8 * encoded, Uint8 * decoded)
+{
+    const int channels = decoder->wavefmt.channels;
+    const int runs = (decoder->wSamplesPerBlock - 1) / 8;
+    int c, r, i;
+
+    /* The channels don't depend on each other, so decode one at a time,
+       straight into its slots in the interleaved output. After a 4 byte
+       header per channel, each channel gets 4 bytes (8 samples, low
+       nybble first) in turn. */
+    for (c = 0; c < channels; ++c) {
+        const Uint8 *header = encoded + 4 * c;
+        const Uint8 *src = encoded + 4 * channels + 4 * c;
+        Sint16 *out = ((Sint16 *) decoded) + c;
+        struct IMA_ADPCM_decodestate state;
 
-    /* Clamp output sample */
-    if (state->sample > max_audioval) {
-        state->sample = max_audioval;
-    } else if (state->sample < min_audioval) {
-        state->sample = min_audioval;
+        state.sample = (Sint16) ((header[1] << 8) | header[0]);
+        state.index = (Sint8) header[2];
+        if (state.index > 88) {
+            state.index = 88;
+        } else if (state.index < 0) {
+            state.index = 0;
+        }
+        /* header[3] is reserved, and should be 0 */
+
+        /* Store the initial sample we start with */
+        *out = (Sint16) SDL_SwapLE16((Uint16) state.sample);
+        out += channels;
+
+        for (r = 0; r < runs; ++r) {
+            for (i = 0; i < 4; ++i) {
+                out[0] = (Sint16) SDL_SwapLE16((Uint16) IMA_ADPCM_nibble(&state, src[i] & 0x0F));
+                out[channels] = (Sint16) SDL_SwapLE16((Uint16) IMA_ADPCM_nibble(&state, src[i] >> 4));
+                out += 2 * channels;
+            }
+            src += 4 * channels;
+        }
     }
-    return (state->sample);
+    return (0);
 }
 
-/* Fill the decode buffer with a channel block of data (8 samples) */
-static void
-Fill_IMA_ADPCM_block(Uint8 * decoded, Uint8 * encoded,
-                     int channel, int numchannels,
-                     struct IMA_ADPCM_decodestate *state)
+static int
+WaveDecodeBlock(const WaveDecoder * decoder, const Uint8 * encoded, Uint8 * decoded)
+{
+    switch (decoder->encoding) {
+    case MS_ADPCM_CODE:
+        return MS_ADPCM_decode_block(&decoder->ms_adpcm, encoded, decoded);
+    case IMA_ADPCM_CODE:
+        return IMA_ADPCM_decode_block(&decoder->ima_adpcm, encoded, decoded);
+    default:
+        break;
+    }
+    return (-1);
+}
+
+/* Each job decodes at least this much, so small files stay on one thread */
+#define ADPCM_PARALLEL_BYTES (1024 * 1024)
+
+typedef struct ADPCM_DecodeJob
 {
+    const WaveDecoder *decoder;
+    const Uint8 *encoded;
+    Uint8 *decoded;
+    SDL_atomic_t failed;
+} ADPCM_DecodeJob;
+
+static void SDLCALL
+ADPCM_DecodeBlocks(void *data, int start, int end)
+{
+    ADPCM_DecodeJob *job = (ADPCM_DecodeJob *) data;
+    const WaveDecoder *decoder = job->decoder;
     int i;
-    Sint8 nybble;
-    Sint32 new_sample;
-
-    decoded += (channel * 2);
-    for (i = 0; i < 4; ++i) {
-        nybble = (*encoded) & 0x0F;
-        new_sample = IMA_ADPCM_nibble(state, nybble);
-        decoded[0] = new_sample & 0xFF;
-        new_sample >>= 8;
-        decoded[1] = new_sample & 0xFF;
-        decoded += 2 * numchannels;
-
-        nybble = (*encoded) >> 4;
-        new_sample = IMA_ADPCM_nibble(state, nybble);
-        decoded[0] = new_sample & 0xFF;
-        new_sample >>= 8;
-        decoded[1] = new_sample & 0xFF;
-        decoded += 2 * numchannels;
-
-        ++encoded;
+
+    for (i = start; i < end; ++i) {
+        if (WaveDecodeBlock(decoder, job->encoded + i * decoder->blocksize,
+                            job->decoded + i * decoder->decodedsize) < 0) {
+            SDL_AtomicSet(&job->failed, 1);
+            break;
+        }
     }
 }
 
+/* Decode all the whole blocks in the buffer, replacing it with the result */
 static int
-IMA_ADPCM_decode(Uint8 ** audio_buf, Uint32 * audio_len)
+ADPCM_decode(const WaveDecoder * decoder, Uint8 ** audio_buf, Uint32 * audio_len)
 {
-    struct IMA_ADPCM_decodestate *state;
-    Uint8 *freeable, *encoded, *decoded;
-    Sint32 encoded_len, samplesleft;
-    unsigned int c, channels;
-
-    /* Check to make sure we have enough variables in the state array */
-    channels = IMA_ADPCM_state.wavefmt.channels;
-    if (channels > SDL_arraysize(IMA_ADPCM_state.state)) {
-        SDL_SetError("IMA ADPCM decoder can only handle %u channels",
-                     (unsigned int)SDL_arraysize(IMA_ADPCM_state.state));
-        return (-1);
+    const Uint32 blocks = *audio_len / decoder->blocksize;
+    ADPCM_DecodeJob job;
+    Uint8 *decoded;
+
+    if (blocks > (SDL_MAX_UINT32 / decoder->decodedsize)) {
+        return SDL_SetError("WAVE file too big to decode");
     }
-    state = IMA_ADPCM_state.state;
 
     /* Allocate the proper sized output buffer */
-    encoded_len = *audio_len;
-    encoded = *audio_buf;
-    freeable = *audio_buf;
-    *audio_len = (encoded_len / IMA_ADPCM_state.wavefmt.blockalign) *
-        IMA_ADPCM_state.wSamplesPerBlock *
-        IMA_ADPCM_state.wavefmt.channels * sizeof(Sint16);
-    *audio_buf = (Uint8 *) SDL_malloc(*audio_len);
-    if (*audio_buf == NULL) {
+    decoded = (Uint8 *) SDL_malloc(blocks * decoder->decodedsize);
+    if (decoded == NULL) {
         return SDL_OutOfMemory();
     }
-    decoded = *audio_buf;
-
-    /* Get ready... Go! */
-    while (encoded_len >= IMA_ADPCM_state.wavefmt.blockalign) {
-        /* Grab the initial information for this block */
-        for (c = 0; c < channels; ++c) {
-            /* Fill the state information for this block */
-            state[c].sample = ((encoded[1] << 8) | encoded[0]);
-            encoded += 2;
-            if (state[c].sample & 0x8000) {
-                state[c].sample -= 0x10000;
-            }
-            state[c].index = *encoded++;
-            /* Reserved byte in buffer header, should be 0 */
-            if (*encoded++ != 0) {
-                /* Uh oh, corrupt data?  Buggy code? */ ;
-            }
 
-            /* Store the initial sample we start with */
-            decoded[0] = (Uint8) (state[c].sample & 0xFF);
-            decoded[1] = (Uint8) (state[c].sample >> 8);
-            decoded += 2;
-        }
+    /* Blocks decode independently, so hand them out to the job system */
+    job.decoder = decoder;
+    job.encoded = *audio_buf;
+    job.decoded = decoded;
+    SDL_AtomicSet(&job.failed, 0);
+    SDL_ParallelFor((int) blocks, (int) SDL_max(ADPCM_PARALLEL_BYTES / decoder->decodedsize, 1),
+                    ADPCM_DecodeBlocks, &job);
 
-        /* Decode and store the other samples in this block */
-        samplesleft = (IMA_ADPCM_state.wSamplesPerBlock - 1) * channels;
-        while (samplesleft > 0) {
-            for (c = 0; c < channels; ++c) {
-                Fill_IMA_ADPCM_block(decoded, encoded,
-                                     c, channels, &state[c]);
-                encoded += 4;
-                samplesleft -= 8;
-            }
-            decoded += (channels * 8 * 2);
-        }
-        encoded_len -= IMA_ADPCM_state.wavefmt.blockalign;
+    if (SDL_AtomicGet(&job.failed)) {
+        SDL_free(decoded);
+        return SDL_SetError("Corrupt ADPCM data");
     }
-    SDL_free(freeable);
+
+    SDL_free(*audio_buf);
+    *audio_buf = decoded;
+    *audio_len = blocks * decoder->decodedsize;
     return (0);
 }
 
 
-static int
-ConvertSint24ToSint32(Uint8 ** audio_buf, Uint32 * audio_len)
+/* Expand packed 24-bit samples to 32 bits in place. The buffer must have
+   room for the expanded samples. */
+static void
+ConvertSint24ToSint32(Uint8 * buf, Uint32 samples)
 {
     const double DIVBY8388608 = 0.00000011920928955078125;
-    const Uint32 original_len = *audio_len;
-    const Uint32 samples = original_len / 3;
-    const Uint32 expanded_len = samples * sizeof (Uint32);
-    Uint8 *ptr = (Uint8 *) SDL_realloc(*audio_buf, expanded_len);
     const Uint8 *src;
     Uint32 *dst;
     Uint32 i;
 
-    if (!ptr) {
-        return SDL_OutOfMemory();
-    }
-
-    *audio_buf = ptr;
-    *audio_len = expanded_len;
-
     /* work from end to start, since we're expanding in-place. */
-    src = (ptr + original_len) - 3;
-    dst = ((Uint32 *) (ptr + expanded_len)) - 1;
+    src = (buf + samples * 3) - 3;
+    dst = ((Uint32 *) (buf + samples * sizeof (Uint32))) - 1;
     for (i = 0; i < samples; i++) {
         /* There's probably a faster way to do all this. */
         const Sint32 converted = ((Sint32) ( (((Uint32) src[2]) << 24) |
@@ -435,8 +548,6 @@ ConvertSint24ToSint32(Uint8 ** audio_buf, Uint32 * audio_len)
         src -= 3;
         *(dst--) = (Sint32) (scaled * 2147483647.0);
     }
-
-    return 0;
 }
 
 
@@ -444,41 +555,39 @@ ConvertSint24ToSint32(Uint8 ** audio_buf, Uint32 * audio_len)
 static const Uint8 extensible_pcm_guid[16] = { 1, 0, 0, 0, 0, 0, 16, 0, 128, 0, 0, 170, 0, 56, 155, 113 };
 static const Uint8 extensible_ieee_guid[16] = { 3, 0, 0, 0, 0, 0, 16, 0, 128, 0, 0, 170, 0, 56, 155, 113 };
 
-SDL_AudioSpec *
-SDL_LoadWAV_RW(SDL_RWops * src, int freesrc,
-               SDL_AudioSpec * spec, Uint8 ** audio_buf, Uint32 * audio_len)
+/* Read everything in front of the audio data: the RIFF header, the format
+   chunk, and any chunks we don't care about. This leaves src at the first
+   byte of the data chunk's contents. */
+static int
+ReadWaveHeader(SDL_RWops * src, SDL_AudioSpec * spec, WaveDecoder * decoder,
+               Uint32 * wavelen, Uint32 * datalen, Uint32 * headerDiff)
 {
     int was_error;
     Chunk chunk;
     int lenread;
     int IEEE_float_encoded, MS_ADPCM_encoded, IMA_ADPCM_encoded;
-    int samplesize;
 
     /* WAV magic header */
     Uint32 RIFFchunk;
-    Uint32 wavelen = 0;
     Uint32 WAVEmagic;
-    Uint32 headerDiff = 0;
 
     /* FMT chunk */
     WaveFMT *format = NULL;
     WaveExtensibleFMT *ext = NULL;
 
     SDL_zero(chunk);
-
-    /* Make sure we are passed a valid data source */
+    SDL_zerop(decoder);
+    *wavelen = 0;
+    *datalen = 0;
+    *headerDiff = 0;
     was_error = 0;
-    if (src == NULL) {
-        was_error = 1;
-        goto done;
-    }
 
     /* Check the magic header */
     RIFFchunk = SDL_ReadLE32(src);
-    wavelen = SDL_ReadLE32(src);
-    if (wavelen == WAVE) {      /* The RIFFchunk has already been read */
-        WAVEmagic = wavelen;
-        wavelen = RIFFchunk;
+    *wavelen = SDL_ReadLE32(src);
+    if (*wavelen == WAVE) {     /* The RIFFchunk has already been read */
+        WAVEmagic = *wavelen;
+        *wavelen = RIFFchunk;
         RIFFchunk = RIFF;
     } else {
         WAVEmagic = SDL_ReadLE32(src);
@@ -488,7 +597,7 @@ SDL_LoadWAV_RW(SDL_RWops * src, int freesrc,
         was_error = 1;
         goto done;
     }
-    headerDiff += sizeof(Uint32);       /* for WAVE */
+    *headerDiff += sizeof(Uint32);      /* for WAVE */
 
     /* Read the audio data format chunk */
     chunk.data = NULL;
@@ -501,7 +610,7 @@ SDL_LoadWAV_RW(SDL_RWops * src, int freesrc,
             goto done;
         }
         /* 2 Uint32's for chunk header+len, plus the lenread */
-        headerDiff += lenread + 2 * sizeof(Uint32);
+        *headerDiff += lenread + 2 * sizeof(Uint32);
     } while ((chunk.magic == FACT) || (chunk.magic == LIST) || (chunk.magic == BEXT) || (chunk.magic == JUNK));
 
     /* Decode the audio data format */
@@ -511,6 +620,11 @@ SDL_LoadWAV_RW(SDL_RWops * src, int freesrc,
         was_error = 1;
         goto done;
     }
+    if (chunk.length < sizeof(*format)) {
+        SDL_SetError("Invalid WAVE format chunk");
+        was_error = 1;
+        goto done;
+    }
     IEEE_float_encoded = MS_ADPCM_encoded = IMA_ADPCM_encoded = 0;
     switch (SDL_SwapLE16(format->encoding)) {
     case PCM_CODE:
@@ -522,7 +636,7 @@ SDL_LoadWAV_RW(SDL_RWops * src, int freesrc,
         break;
     case MS_ADPCM_CODE:
         /* Try to understand this */
-        if (InitMS_ADPCM(format) < 0) {
+        if (InitMS_ADPCM(&decoder->ms_adpcm, format, chunk.length) < 0) {
             was_error = 1;
             goto done;
         }
@@ -530,7 +644,7 @@ SDL_LoadWAV_RW(SDL_RWops * src, int freesrc,
         break;
     case IMA_ADPCM_CODE:
         /* Try to understand this */
-        if (InitIMA_ADPCM(format) < 0) {
+        if (InitIMA_ADPCM(&decoder->ima_adpcm, format, chunk.length) < 0) {
             was_error = 1;
             goto done;
         }
@@ -542,7 +656,7 @@ SDL_LoadWAV_RW(SDL_RWops * src, int freesrc,
            to get things that didn't really _need_ WAVE_FORMAT_EXTENSIBLE
            to be useful working when they use this format flag. */
         ext = (WaveExtensibleFMT *) format;
-        if (SDL_SwapLE16(ext->size) < 22) {
+        if ((chunk.length < sizeof(*ext)) || (SDL_SwapLE16(ext->size) < 22)) {
             SDL_SetError("bogus extended .wav header");
             was_error = 1;
             goto done;
@@ -607,59 +721,122 @@ SDL_LoadWAV_RW(SDL_RWops * src, int freesrc,
     }
     spec->channels = (Uint8) SDL_SwapLE16(format->channels);
     spec->samples = 4096;       /* Good default buffer size */
+    if (spec->channels == 0) {
+        SDL_SetError("Invalid number of WAVE channels");
+        was_error = 1;
+        goto done;
+    }
 
-    /* Read the audio data chunk */
-    *audio_buf = NULL;
-    do {
-        SDL_free(*audio_buf);
-        *audio_buf = NULL;
-        lenread = ReadChunk(src, &chunk);
-        if (lenread < 0) {
+    if (MS_ADPCM_encoded) {
+        decoder->encoding = MS_ADPCM_CODE;
+        decoder->blocksize = decoder->ms_adpcm.wavefmt.blockalign;
+        decoder->decodedsize = decoder->ms_adpcm.wSamplesPerBlock *
+            decoder->ms_adpcm.wavefmt.channels * sizeof(Sint16);
+    } else if (IMA_ADPCM_encoded) {
+        decoder->encoding = IMA_ADPCM_CODE;
+        decoder->blocksize = decoder->ima_adpcm.wavefmt.blockalign;
+        decoder->decodedsize = decoder->ima_adpcm.wSamplesPerBlock *
+            decoder->ima_adpcm.wavefmt.channels * sizeof(Sint16);
+    } else {
+        decoder->encoding = IEEE_float_encoded ? IEEE_FLOAT_CODE : PCM_CODE;
+    }
+    decoder->bitspersample = SDL_SwapLE16(format->bitspersample);
+
+    /* Find the audio data chunk, skipping anything else on the way */
+    for (;;) {
+        if (ReadChunkHeader(src, &chunk) < 0) {
             was_error = 1;
             goto done;
         }
-        *audio_len = lenread;
-        *audio_buf = chunk.data;
-        if (chunk.magic != DATA)
-            headerDiff += lenread + 2 * sizeof(Uint32);
-    } while (chunk.magic != DATA);
-    headerDiff += 2 * sizeof(Uint32);   /* for the data chunk and len */
-
-    if (MS_ADPCM_encoded) {
-        if (MS_ADPCM_decode(audio_buf, audio_len) < 0) {
+        *headerDiff += 2 * sizeof(Uint32);      /* for the chunk and len */
+        if (chunk.magic == DATA) {
+            break;
+        }
+        if (SkipChunk(src, &chunk) < 0) {
             was_error = 1;
             goto done;
         }
+        *headerDiff += chunk.length;
+    }
+    *datalen = chunk.length;
+
+  done:
+    SDL_free(format);
+    return was_error ? -1 : 0;
+}
+
+SDL_AudioSpec *
+SDL_LoadWAV_RW(SDL_RWops * src, int freesrc,
+               SDL_AudioSpec * spec, Uint8 ** audio_buf, Uint32 * audio_len)
+{
+    int was_error;
+    WaveDecoder decoder;
+    Uint32 wavelen = 0;
+    Uint32 datalen = 0;
+    Uint32 headerDiff = 0;
+    Uint32 samplesize;
+
+    /* Make sure we are passed a valid data source */
+    was_error = 0;
+    *audio_buf = NULL;
+    if (src == NULL) {
+        was_error = 1;
+        goto done;
+    }
+
+    if (ReadWaveHeader(src, spec, &decoder, &wavelen, &datalen, &headerDiff) < 0) {
+        was_error = 1;
+        goto done;
+    }
+
+    /* Read the audio data chunk */
+    *audio_len = datalen;
+    *audio_buf = (Uint8 *) SDL_malloc(datalen);
+    if (*audio_buf == NULL) {
+        SDL_OutOfMemory();
+        was_error = 1;
+        goto done;
     }
-    if (IMA_ADPCM_encoded) {
-        if (IMA_ADPCM_decode(audio_buf, audio_len) < 0) {
+    if (datalen && (SDL_RWread(src, *audio_buf, datalen, 1) != 1)) {
+        SDL_Error(SDL_EFREAD);
+        was_error = 1;
+        goto done;
+    }
+
+    if ((decoder.encoding == MS_ADPCM_CODE) || (decoder.encoding == IMA_ADPCM_CODE)) {
+        if (ADPCM_decode(&decoder, audio_buf, audio_len) < 0) {
             was_error = 1;
             goto done;
         }
-    }
-
-    if (SDL_SwapLE16(format->bitspersample) == 24) {
-        if (ConvertSint24ToSint32(audio_buf, audio_len) < 0) {
+    } else if (decoder.bitspersample == 24) {
+        const Uint32 samples = *audio_len / 3;
+        Uint8 *ptr = (Uint8 *) SDL_realloc(*audio_buf, samples * sizeof (Uint32));
+        if (ptr == NULL) {
+            SDL_OutOfMemory();
             was_error = 1;
             goto done;
         }
+        ConvertSint24ToSint32(ptr, samples);
+        *audio_buf = ptr;
+        *audio_len = samples * sizeof (Uint32);
     }
 
     /* Don't return a buffer that isn't a multiple of samplesize */
     samplesize = ((SDL_AUDIO_BITSIZE(spec->format)) / 8) * spec->channels;
-    *audio_len &= ~(samplesize - 1);
+    *audio_len -= *audio_len % samplesize;
 
   done:
-    SDL_free(format);
     if (src) {
         if (freesrc) {
             SDL_RWclose(src);
         } else {
             /* seek to the end of the file (given by the RIFF chunk) */
-            SDL_RWseek(src, wavelen - chunk.length - headerDiff, RW_SEEK_CUR);
+            SDL_RWseek(src, wavelen - datalen - headerDiff, RW_SEEK_CUR);
         }
     }
     if (was_error) {
+        SDL_free(*audio_buf);
+        *audio_buf = NULL;
         spec = NULL;
     }
     return (spec);
@@ -674,11 +851,265 @@ SDL_FreeWAV(Uint8 * audio_buf)
     SDL_free(audio_buf);
 }
 
+SDL_WAVStream *
+SDL_OpenWAVStream_RW(SDL_RWops * src, int freesrc, SDL_AudioSpec * spec)
+{
+    SDL_WAVStream *wav = NULL;
+    Uint32 wavelen, headerDiff;
+
+    if (src == NULL) {
+        SDL_InvalidParamError("src");
+        return NULL;
+    } else if (spec == NULL) {
+        SDL_InvalidParamError("spec");
+        goto failed;
+    }
+
+    wav = (SDL_WAVStream *) SDL_calloc(1, sizeof (SDL_WAVStream));
+    if (wav == NULL) {
+        SDL_OutOfMemory();
+        goto failed;
+    }
+
+    if (ReadWaveHeader(src, &wav->spec, &wav->decoder, &wavelen, &wav->datalen, &headerDiff) < 0) {
+        goto failed;
+    }
+    wav->datastart = SDL_RWtell(src);
+    wav->framesize = (SDL_AUDIO_BITSIZE(wav->spec.format) / 8) * wav->spec.channels;
+
+    /* ADPCM decodes a block at a time into the window, everything else
+       reads straight into it (24-bit samples get expanded there, too). */
+    if ((wav->decoder.encoding == MS_ADPCM_CODE) || (wav->decoder.encoding == IMA_ADPCM_CODE)) {
+        wav->blocksize = wav->decoder.blocksize;
+        wav->block = (Uint8 *) SDL_malloc(wav->blocksize);
+        wav->window = (Uint8 *) SDL_malloc(wav->decoder.decodedsize);
+    } else {
+        wav->blocksize = WAVSTREAM_PCM_FRAMES * (wav->decoder.bitspersample / 8) * wav->spec.channels;
+        wav->window = (Uint8 *) SDL_malloc(WAVSTREAM_PCM_FRAMES * wav->framesize);
+        wav->partial = (Uint8 *) SDL_malloc(wav->blocksize / WAVSTREAM_PCM_FRAMES);
+    }
+    if ((wav->window == NULL) || (wav->decoder.blocksize ? (wav->block == NULL) : (wav->partial == NULL))) {
+        SDL_OutOfMemory();
+        goto failed;
+    }
+
+    wav->src = src;
+    wav->freesrc = freesrc;
+    SDL_memcpy(spec, &wav->spec, sizeof (*spec));
+    return wav;
+
+  failed:
+    if (wav) {
+        SDL_free(wav->block);
+        SDL_free(wav->partial);
+        SDL_free(wav->window);
+        SDL_free(wav);
+    }
+    if (freesrc) {
+        SDL_RWclose(src);
+    }
+    return NULL;
+}
+
+/* Decode the next piece of the file into the window. Returns the number of
+   bytes decoded, 0 at the end of the data, or -1 on error. */
+static int
+WAVStreamDecode(SDL_WAVStream * wav)
+{
+    const Uint32 remaining = wav->datalen - wav->datapos;
+    Uint32 len;
+
+    wav->windowlen = wav->windowpos = 0;
+
+    if (wav->block) {
+        /* Partial blocks are dropped, as SDL_LoadWAV_RW() does. */
+        if (remaining < wav->blocksize) {
+            return 0;
+        }
+        for (len = 0; len < wav->blocksize; ) {
+            const Uint32 got = (Uint32) SDL_RWread(wav->src, wav->block + len, 1, wav->blocksize - len);
+            if (got == 0) {
+                wav->datapos = wav->datalen;  /* truncated file, stop here. */
+                return 0;
+            }
+            len += got;  /* streams like pipes can come up short. */
+        }
+        wav->datapos += wav->blocksize;
+        if (WaveDecodeBlock(&wav->decoder, wav->block, wav->window) < 0) {
+            return SDL_SetError("Corrupt ADPCM data");
+        }
+        len = wav->decoder.decodedsize;
+    } else {
+        /* Streams like pipes can come up short in the middle of a frame,
+           so the rest of it is kept for the next read to finish. */
+        const Uint32 srcframesize = (wav->decoder.bitspersample / 8) * wav->spec.channels;
+        do {
+            Uint32 got;
+            len = wav->partiallen;
+            SDL_memcpy(wav->window, wav->partial, len);
+            got = (Uint32) SDL_RWread(wav->src, wav->window + len, 1,
+                                      SDL_min(wav->datalen - wav->datapos, wav->blocksize - len));
+            if (got == 0) {
+                wav->datapos = wav->datalen;  /* a trailing partial frame is dropped. */
+                wav->partiallen = 0;
+                return 0;
+            }
+            wav->datapos += got;
+            len += got;
+            wav->partiallen = len % srcframesize;
+            len -= wav->partiallen;
+            SDL_memcpy(wav->partial, wav->window + len, wav->partiallen);
+        } while (len == 0);
+
+        if (wav->decoder.bitspersample == 24) {
+            ConvertSint24ToSint32(wav->window, len / 3);
+            len = (len / 3) * sizeof (Uint32);
+        }
+    }
+
+    wav->windowlen = len;
+    return (int) len;
+}
+
+int
+SDL_WAVStreamRead(SDL_WAVStream * wav, void *buf, int len)
+{
+    Uint8 *dst = (Uint8 *) buf;
+    int total = 0;
+
+    if (!wav) {
+        return SDL_InvalidParamError("wav");
+    } else if (!buf) {
+        return SDL_InvalidParamError("buf");
+    }
+
+    while (len > 0) {
+        const Uint32 avail = wav->windowlen - wav->windowpos;
+        Uint32 cpy;
+
+        if (avail == 0) {
+            const int rc = WAVStreamDecode(wav);
+            if (rc < 0) {
+                return -1;
+            } else if (rc == 0) {
+                break;  /* end of file. */
+            }
+            continue;
+        }
+
+        cpy = SDL_min(avail, (Uint32) len);
+        SDL_memcpy(dst, wav->window + wav->windowpos, cpy);
+        wav->windowpos += cpy;
+        dst += cpy;
+        total += (int) cpy;
+        len -= (int) cpy;
+    }
+
+    return total;
+}
+
+int
+SDL_WAVStreamPut(SDL_WAVStream * wav, SDL_AudioStream * stream, int len)
+{
+    int total = 0;
+
+    if (!wav) {
+        return SDL_InvalidParamError("wav");
+    } else if (!stream) {
+        return SDL_InvalidParamError("stream");
+    } else if (len <= 0) {
+        return 0;  /* nothing to do. */
+    }
+
+    /* The window always holds whole sample frames, so this keeps every
+       put a whole number of them, as the audio stream requires. Round down
+       instead where rounding up would overflow. */
+    if ((len % wav->framesize) != 0) {
+        if (len > (SDL_MAX_SINT32 - wav->framesize)) {
+            len -= len % wav->framesize;
+        } else {
+            len += wav->framesize - (len % wav->framesize);
+        }
+    }
+
+    while (total < len) {
+        const Uint32 avail = wav->windowlen - wav->windowpos;
+        Uint32 cpy;
+
+        if (avail == 0) {
+            const int rc = WAVStreamDecode(wav);
+            if (rc < 0) {
+                return -1;
+            } else if (rc == 0) {
+                if (SDL_AudioStreamFlush(stream) < 0) {
+                    return -1;
+                }
+                break;  /* end of file. */
+            }
+            continue;
+        }
+
+        cpy = SDL_min(avail, (Uint32) (len - total));
+        if (SDL_AudioStreamPut(stream, wav->window + wav->windowpos, (int) cpy) < 0) {
+            return -1;
+        }
+        wav->windowpos += cpy;
+        total += (int) cpy;
+    }
+
+    return total;
+}
+
+int
+SDL_WAVStreamRewind(SDL_WAVStream * wav)
+{
+    if (!wav) {
+        return SDL_InvalidParamError("wav");
+    } else if (wav->datastart < 0) {
+        return SDL_SetError("Can't rewind a WAVE stream that can't seek");
+    } else if (SDL_RWseek(wav->src, wav->datastart, RW_SEEK_SET) < 0) {
+        return -1;
+    }
+    wav->datapos = 0;
+    wav->partiallen = 0;
+    wav->windowlen = wav->windowpos = 0;
+    return 0;
+}
+
+void
+SDL_CloseWAVStream(SDL_WAVStream * wav)
+{
+    if (wav) {
+        if (wav->freesrc) {
+            SDL_RWclose(wav->src);
+        }
+        SDL_free(wav->block);
+        SDL_free(wav->partial);
+        SDL_free(wav->window);
+        SDL_free(wav);
+    }
+}
+
+static int
+ReadChunkHeader(SDL_RWops * src, Chunk * chunk)
+{
+    Uint32 header[2];
+
+    if (SDL_RWread(src, header, sizeof (header), 1) != 1) {
+        return SDL_Error(SDL_EFREAD);
+    }
+    chunk->magic = SDL_SwapLE32(header[0]);
+    chunk->length = SDL_SwapLE32(header[1]);
+    chunk->data = NULL;
+    return 0;
+}
+
 static int
 ReadChunk(SDL_RWops * src, Chunk * chunk)
 {
-    chunk->magic = SDL_ReadLE32(src);
-    chunk->length = SDL_ReadLE32(src);
+    if (ReadChunkHeader(src, chunk) < 0) {
+        return -1;
+    }
     chunk->data = (Uint8 *) SDL_malloc(chunk->length);
     if (chunk->data == NULL) {
         return SDL_OutOfMemory();
@@ -691,4 +1122,24 @@ ReadChunk(SDL_RWops * src, Chunk * chunk)
     return (chunk->length);
 }
 
+/* Skip over a chunk's contents, reading through them if src can't seek. */
+static int
+SkipChunk(SDL_RWops * src, Chunk * chunk)
+{
+    Uint8 scratch[512];
+    Uint32 left = chunk->length;
+
+    if (SDL_RWseek(src, left, RW_SEEK_CUR) >= 0) {
+        return 0;
+    }
+    while (left > 0) {
+        const size_t amount = SDL_min(left, sizeof (scratch));
+        if (SDL_RWread(src, scratch, amount, 1) != 1) {
+            return SDL_Error(SDL_EFREAD);
+        }
+        left -= (Uint32) amount;
+    }
+    return 0;
+}
+
 /* vi: set ts=4 sw=4 expandtab: */
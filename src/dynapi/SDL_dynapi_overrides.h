@@ -714,3 +714,23 @@
 #define SDL_RenderCopyExF SDL_RenderCopyExF_REAL
 #define SDL_GetTouchDeviceType SDL_GetTouchDeviceType_REAL
 #define SDL_UIKitRunApp SDL_UIKitRunApp_REAL
+#define SDL_OpenWAVStream_RW SDL_OpenWAVStream_RW_REAL
+#define SDL_WAVStreamRead SDL_WAVStreamRead_REAL
+#define SDL_WAVStreamPut SDL_WAVStreamPut_REAL
+#define SDL_WAVStreamRewind SDL_WAVStreamRewind_REAL
+#define SDL_CloseWAVStream SDL_CloseWAVStream_REAL
+#define SDL_GetNumJobWorkers SDL_GetNumJobWorkers_REAL
+#define SDL_CreateJobCounter SDL_CreateJobCounter_REAL
+#define SDL_DestroyJobCounter SDL_DestroyJobCounter_REAL
+#define SDL_RunJob SDL_RunJob_REAL
+#define SDL_RunJobAfter SDL_RunJobAfter_REAL
+#define SDL_WaitJobCounter SDL_WaitJobCounter_REAL
+#define SDL_ParallelFor SDL_ParallelFor_REAL
+#define SDL_CreateAtomicQueue SDL_CreateAtomicQueue_REAL
+#define SDL_AtomicQueuePush SDL_AtomicQueuePush_REAL
+#define SDL_AtomicQueuePop SDL_AtomicQueuePop_REAL
+#define SDL_DestroyAtomicQueue SDL_DestroyAtomicQueue_REAL
+#define SDL_CreateAtomicStack SDL_CreateAtomicStack_REAL
+#define SDL_AtomicStackPush SDL_AtomicStackPush_REAL
+#define SDL_AtomicStackPop SDL_AtomicStackPop_REAL
+#define SDL_DestroyAtomicStack SDL_DestroyAtomicStack_REAL
@@ -770,3 +770,23 @@ SDL_DYNAPI_PROC(SDL_TouchDeviceType,SDL_GetTouchDeviceType,(SDL_TouchID a),(a),r
 #ifdef __IPHONEOS__
 SDL_DYNAPI_PROC(int,SDL_UIKitRunApp,(int a, char *b, SDL_main_func c),(a,b,c),return)
 #endif
+SDL_DYNAPI_PROC(SDL_WAVStream*,SDL_OpenWAVStream_RW,(SDL_RWops *a, int b, SDL_AudioSpec *c),(a,b,c),return)
+SDL_DYNAPI_PROC(int,SDL_WAVStreamRead,(SDL_WAVStream *a, void *b, int c),(a,b,c),return)
+SDL_DYNAPI_PROC(int,SDL_WAVStreamPut,(SDL_WAVStream *a, SDL_AudioStream *b, int c),(a,b,c),return)
+SDL_DYNAPI_PROC(int,SDL_WAVStreamRewind,(SDL_WAVStream *a),(a),return)
+SDL_DYNAPI_PROC(void,SDL_CloseWAVStream,(SDL_WAVStream *a),(a),)
+SDL_DYNAPI_PROC(int,SDL_GetNumJobWorkers,(void),(),return)
+SDL_DYNAPI_PROC(SDL_JobCounter*,SDL_CreateJobCounter,(void),(),return)
+SDL_DYNAPI_PROC(void,SDL_DestroyJobCounter,(SDL_JobCounter *a),(a),)
+SDL_DYNAPI_PROC(int,SDL_RunJob,(SDL_JobFunction a, void *b, SDL_JobCounter *c),(a,b,c),return)
+SDL_DYNAPI_PROC(int,SDL_RunJobAfter,(SDL_JobCounter *a, SDL_JobFunction b, void *c, SDL_JobCounter *d),(a,b,c,d),return)
+SDL_DYNAPI_PROC(int,SDL_WaitJobCounter,(SDL_JobCounter *a),(a),return)
+SDL_DYNAPI_PROC(int,SDL_ParallelFor,(int a, int b, SDL_ParallelForFunction c, void *d),(a,b,c,d),return)
+SDL_DYNAPI_PROC(SDL_AtomicQueue*,SDL_CreateAtomicQueue,(int a, Uint32 b),(a,b),return)
+SDL_DYNAPI_PROC(SDL_bool,SDL_AtomicQueuePush,(SDL_AtomicQueue *a, void *b),(a,b),return)
+SDL_DYNAPI_PROC(SDL_bool,SDL_AtomicQueuePop,(SDL_AtomicQueue *a, void **b),(a,b),return)
+SDL_DYNAPI_PROC(void,SDL_DestroyAtomicQueue,(SDL_AtomicQueue *a),(a),)
+SDL_DYNAPI_PROC(SDL_AtomicStack*,SDL_CreateAtomicStack,(int a),(a),return)
+SDL_DYNAPI_PROC(SDL_bool,SDL_AtomicStackPush,(SDL_AtomicStack *a, void *b),(a,b),return)
+SDL_DYNAPI_PROC(SDL_bool,SDL_AtomicStackPop,(SDL_AtomicStack *a, void **b),(a,b),return)
+SDL_DYNAPI_PROC(void,SDL_DestroyAtomicStack,(SDL_AtomicStack *a),(a),)
@@ -27,6 +27,7 @@
 #include "SDL_thread.h"
 #include "SDL_events_c.h"
 #include "../timer/SDL_timer_c.h"
+#include "../SDL_memorypool.h"
 #if !SDL_JOYSTICK_DISABLED
 #include "../joystick/SDL_joystick_c.h"
 #endif
@@ -36,6 +37,9 @@
 /* An arbitrary limit so we don't have unbounded growth */
 #define SDL_MAX_QUEUED_EVENTS   65535
 
+/* Queue entries are allocated this many at a time */
+#define SDL_EVENT_POOL_BLOCK    64
+
 typedef struct SDL_EventWatcher {
     SDL_EventFilter callback;
     void *userdata;
@@ -79,7 +83,7 @@ static struct
     int max_events_seen;
     SDL_EventEntry *head;
     SDL_EventEntry *tail;
-    SDL_EventEntry *free;
+    SDL_MemoryPool *pool;
     SDL_SysWMEntry *wmmsg_used;
     SDL_SysWMEntry *wmmsg_free;
 } SDL_EventQ = { NULL, { 1 }, { 0 }, 0, NULL, NULL, NULL, NULL, NULL };
@@ -358,14 +362,10 @@ SDL_StopEventLoop(void)
     /* Clean out EventQ */
     for (entry = SDL_EventQ.head; entry; ) {
         SDL_EventEntry *next = entry->next;
-        SDL_free(entry);
-        entry = next;
-    }
-    for (entry = SDL_EventQ.free; entry; ) {
-        SDL_EventEntry *next = entry->next;
-        SDL_free(entry);
+        SDL_FreeToPool(SDL_EventQ.pool, entry);
         entry = next;
     }
+    SDL_DestroyMemoryPool(SDL_EventQ.pool);
     for (wmmsg = SDL_EventQ.wmmsg_used; wmmsg; ) {
         SDL_SysWMEntry *next = wmmsg->next;
         SDL_free(wmmsg);
@@ -381,7 +381,7 @@ SDL_StopEventLoop(void)
     SDL_EventQ.max_events_seen = 0;
     SDL_EventQ.head = NULL;
     SDL_EventQ.tail = NULL;
-    SDL_EventQ.free = NULL;
+    SDL_EventQ.pool = NULL;
     SDL_EventQ.wmmsg_used = NULL;
     SDL_EventQ.wmmsg_free = NULL;
 
@@ -464,14 +464,17 @@ SDL_AddEvent(SDL_Event * event)
         return 0;
     }
 
-    if (SDL_EventQ.free == NULL) {
-        entry = (SDL_EventEntry *)SDL_malloc(sizeof(*entry));
-        if (!entry) {
+    /* Events can be queued before SDL_StartEventLoop(), so make the pool here */
+    if (!SDL_EventQ.pool) {
+        SDL_EventQ.pool = SDL_CreateMemoryPool("events", sizeof(SDL_EventEntry), SDL_EVENT_POOL_BLOCK);
+        if (!SDL_EventQ.pool) {
             return 0;
         }
-    } else {
-        entry = SDL_EventQ.free;
-        SDL_EventQ.free = entry->next;
+    }
+
+    entry = (SDL_EventEntry *)SDL_AllocFromPool(SDL_EventQ.pool);
+    if (!entry) {
+        return 0;
     }
 
     if (SDL_DoEventLogging) {
@@ -525,8 +528,7 @@ SDL_CutEvent(SDL_EventEntry *entry)
         SDL_EventQ.tail = entry->prev;
     }
 
-    entry->next = SDL_EventQ.free;
-    SDL_EventQ.free = entry;
+    SDL_FreeToPool(SDL_EventQ.pool, entry);
     SDL_assert(SDL_AtomicGet(&SDL_EventQ.count) > 0);
     SDL_AtomicAdd(&SDL_EventQ.count, -1);
 }
@@ -28,6 +28,7 @@
 #include "SDL_render.h"
 #include "SDL_sysrender.h"
 #include "software/SDL_render_sw_c.h"
+#include "../video/SDL_blit.h"
 
 
 #define SDL_WINDOWRENDERDATA    "_SDL_WindowRenderData"
@@ -1248,7 +1249,7 @@ SDL_CreateTextureFromSurface(SDL_Renderer * renderer, SDL_Surface * surface)
     }
 
     if (direct_update) {
-        if (SDL_MUSTLOCK(surface)) {
+        if (SDL_MUSTLOCK_READ(surface)) {
             SDL_LockSurface(surface);
             SDL_UpdateTexture(texture, NULL, surface->pixels, surface->pitch);
             SDL_UnlockSurface(surface);
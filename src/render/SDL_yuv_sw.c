@@ -25,6 +25,7 @@
 #include "SDL_assert.h"
 
 #include "SDL_yuv_sw_c.h"
+#include "../video/SDL_yuv_c.h"
 
 
 SDL_SW_YUVTexture *
@@ -358,6 +359,15 @@ SDL_SW_CopyYUVToRGB(SDL_SW_YUVTexture * swdata, const SDL_Rect * srcrect,
         int bpp;
         Uint32 Rmask, Gmask, Bmask, Amask;
 
+        /* Convert just the source rectangle, scaling it as we go */
+        int ret = SDL_ConvertPixels_YUV_to_RGB_Scaled(swdata->w, swdata->h, swdata->format,
+                                                      swdata->planes[0], swdata->pitches[0], srcrect,
+                                                      target_format, pixels, w, h, pitch);
+        if (ret <= 0) {
+            return ret;
+        }
+
+        /* Otherwise convert it all and stretch that */
         if (swdata->display) {
             swdata->display->w = w;
             swdata->display->h = h;
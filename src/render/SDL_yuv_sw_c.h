@@ -39,7 +39,8 @@ struct SDL_SW_YUVTexture
     Uint16 pitches[3];
     Uint8 *planes[3];
 
-    /* This is a temporary surface in case we have to stretch copy */
+    /* This is a temporary surface in case we have to stretch copy a format
+       that can't be converted and scaled in one pass */
     SDL_Surface *stretch;
     SDL_Surface *display;
 };
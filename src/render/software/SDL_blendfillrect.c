@@ -207,6 +207,10 @@ SDL_BlendFillRect(SDL_Surface * dst, const SDL_Rect * rect,
         return SDL_SetError("SDL_BlendFillRect(): Unsupported surface format");
     }
 
+    if (SDL_UnshareSurfacePixels(dst) < 0) {
+        return -1;
+    }
+
     /* If 'rect' == NULL, then fill the whole surface */
     if (rect) {
         /* Perform clipping */
@@ -278,6 +282,10 @@ SDL_BlendFillRects(SDL_Surface * dst, const SDL_Rect * rects, int count,
         return SDL_SetError("SDL_BlendFillRects(): Unsupported surface format");
     }
 
+    if (SDL_UnshareSurfacePixels(dst) < 0) {
+        return -1;
+    }
+
     if (blendMode == SDL_BLENDMODE_BLEND || blendMode == SDL_BLENDMODE_ADD) {
         r = DRAW_MUL(r, a);
         g = DRAW_MUL(g, a);
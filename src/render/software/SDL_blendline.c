@@ -719,6 +719,10 @@ SDL_BlendLine(SDL_Surface * dst, int x1, int y1, int x2, int y2,
         return SDL_SetError("SDL_BlendLine(): Unsupported surface format");
     }
 
+    if (SDL_UnshareSurfacePixels(dst) < 0) {
+        return -1;
+    }
+
     /* Perform clipping */
     /* FIXME: We don't actually want to clip, as it may change line slope */
     if (!SDL_IntersectRectAndLine(&dst->clip_rect, &x1, &y1, &x2, &y2)) {
@@ -748,6 +752,10 @@ SDL_BlendLines(SDL_Surface * dst, const SDL_Point * points, int count,
         return SDL_SetError("SDL_BlendLines(): Unsupported surface format");
     }
 
+    if (SDL_UnshareSurfacePixels(dst) < 0) {
+        return -1;
+    }
+
     for (i = 1; i < count; ++i) {
         x1 = points[i-1].x;
         y1 = points[i-1].y;
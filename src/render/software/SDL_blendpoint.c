@@ -205,6 +205,10 @@ SDL_BlendPoint(SDL_Surface * dst, int x, int y, SDL_BlendMode blendMode, Uint8 r
         return SDL_SetError("SDL_BlendPoint(): Unsupported surface format");
     }
 
+    if (SDL_UnshareSurfacePixels(dst) < 0) {
+        return -1;
+    }
+
     /* Perform clipping */
     if (x < dst->clip_rect.x || y < dst->clip_rect.y ||
         x >= (dst->clip_rect.x + dst->clip_rect.w) ||
@@ -274,6 +278,10 @@ SDL_BlendPoints(SDL_Surface * dst, const SDL_Point * points, int count,
         return SDL_SetError("SDL_BlendPoints(): Unsupported surface format");
     }
 
+    if (SDL_UnshareSurfacePixels(dst) < 0) {
+        return -1;
+    }
+
     if (blendMode == SDL_BLENDMODE_BLEND || blendMode == SDL_BLENDMODE_ADD) {
         r = DRAW_MUL(r, a);
         g = DRAW_MUL(g, a);
@@ -152,6 +152,10 @@ SDL_DrawLine(SDL_Surface * dst, int x1, int y1, int x2, int y2, Uint32 color)
         return SDL_SetError("SDL_DrawLine(): Unsupported surface format");
     }
 
+    if (SDL_UnshareSurfacePixels(dst) < 0) {
+        return -1;
+    }
+
     /* Perform clipping */
     /* FIXME: We don't actually want to clip, as it may change line slope */
     if (!SDL_IntersectRectAndLine(&dst->clip_rect, &x1, &y1, &x2, &y2)) {
@@ -181,6 +185,10 @@ SDL_DrawLines(SDL_Surface * dst, const SDL_Point * points, int count,
         return SDL_SetError("SDL_DrawLines(): Unsupported surface format");
     }
 
+    if (SDL_UnshareSurfacePixels(dst) < 0) {
+        return -1;
+    }
+
     for (i = 1; i < count; ++i) {
         x1 = points[i-1].x;
         y1 = points[i-1].y;
@@ -38,6 +38,10 @@ SDL_DrawPoint(SDL_Surface * dst, int x, int y, Uint32 color)
         return SDL_SetError("SDL_DrawPoint(): Unsupported surface format");
     }
 
+    if (SDL_UnshareSurfacePixels(dst) < 0) {
+        return -1;
+    }
+
     /* Perform clipping */
     if (x < dst->clip_rect.x || y < dst->clip_rect.y ||
         x >= (dst->clip_rect.x + dst->clip_rect.w) ||
@@ -79,6 +83,10 @@ SDL_DrawPoints(SDL_Surface * dst, const SDL_Point * points, int count,
         return SDL_SetError("SDL_DrawPoints(): Unsupported surface format");
     }
 
+    if (SDL_UnshareSurfacePixels(dst) < 0) {
+        return -1;
+    }
+
     minx = dst->clip_rect.x;
     maxx = dst->clip_rect.x + dst->clip_rect.w - 1;
     miny = dst->clip_rect.y;
@@ -26,6 +26,7 @@
 #include "SDL_render_sw_c.h"
 #include "SDL_hints.h"
 #include "SDL_assert.h"
+#include "../../SDL_memorypool.h"
 
 #include "SDL_draw.h"
 #include "SDL_blendfillrect.h"
@@ -37,10 +38,14 @@
 
 /* SDL surface based renderer implementation */
 
+/* Scratch surfaces for rotated copies come out of an arena in blocks of this size */
+#define SW_SCRATCH_BLOCK_SIZE   (256 * 1024)
+
 typedef struct
 {
     SDL_Surface *surface;
     SDL_Surface *window;
+    SDL_FrameArena *scratch;
 } SW_RenderData;
 
 
@@ -317,11 +322,35 @@ SW_QueueCopyEx(SDL_Renderer * renderer, SDL_RenderCommand *cmd, SDL_Texture * te
     return 0;
 }
 
+/* A zeroed ARGB8888 surface whose pixels live until the scratch arena is reset */
+static SDL_Surface *
+SW_CreateScratchSurface(SW_RenderData *data, int w, int h)
+{
+    const size_t len = (size_t) w * h * 4;
+    void *pixels;
+
+    if (!data->scratch) {
+        data->scratch = SDL_CreateFrameArena("software renderer", SW_SCRATCH_BLOCK_SIZE);
+        if (!data->scratch) {
+            return NULL;
+        }
+    }
+
+    pixels = SDL_AllocFromArena(data->scratch, len);
+    if (!pixels) {
+        return NULL;
+    }
+    SDL_memset(pixels, 0, len);
+    return SDL_CreateRGBSurfaceFrom(pixels, w, h, 32, w * 4,
+                                    0x00ff0000, 0x0000ff00, 0x000000ff, 0xff000000);
+}
+
 static int
 SW_RenderCopyEx(SDL_Renderer * renderer, SDL_Surface *surface, SDL_Texture * texture,
                 const SDL_Rect * srcrect, const SDL_Rect * final_rect,
                 const double angle, const SDL_FPoint * center, const SDL_RendererFlip flip)
 {
+    SW_RenderData *data = (SW_RenderData *) renderer->driverdata;
     SDL_Surface *src = (SDL_Surface *) texture->driverdata;
     SDL_Rect tmp_rect;
     SDL_Surface *src_clone, *src_rotated, *src_scaled;
@@ -398,8 +427,7 @@ SW_RenderCopyEx(SDL_Renderer * renderer, SDL_Surface *surface, SDL_Texture * tex
      * to clear the pixels in the destination surface. The other steps are explained below.
      */
     if (blendmode == SDL_BLENDMODE_NONE && !isOpaque) {
-        mask = SDL_CreateRGBSurface(0, final_rect->w, final_rect->h, 32,
-                                    0x00ff0000, 0x0000ff00, 0x000000ff, 0xff000000);
+        mask = SW_CreateScratchSurface(data, final_rect->w, final_rect->h);
         if (mask == NULL) {
             retval = -1;
         } else {
@@ -412,8 +440,7 @@ SW_RenderCopyEx(SDL_Renderer * renderer, SDL_Surface *surface, SDL_Texture * tex
      */
     if (!retval && (blitRequired || applyModulation)) {
         SDL_Rect scale_rect = tmp_rect;
-        src_scaled = SDL_CreateRGBSurface(0, final_rect->w, final_rect->h, 32,
-                                          0x00ff0000, 0x0000ff00, 0x000000ff, 0xff000000);
+        src_scaled = SW_CreateScratchSurface(data, final_rect->w, final_rect->h);
         if (src_scaled == NULL) {
             retval = -1;
         } else {
@@ -541,6 +568,8 @@ SW_RenderCopyEx(SDL_Renderer * renderer, SDL_Surface *surface, SDL_Texture * tex
     if (src_clone != NULL) {
         SDL_FreeSurface(src_clone);
     }
+    /* Nothing points into the scratch surfaces anymore. */
+    SDL_ResetFrameArena(data->scratch);
     return retval;
 }
 
@@ -682,10 +711,6 @@ SW_RunCommandQueue(SDL_Renderer * renderer, SDL_RenderCommand *cmd, void *vertic
                 if ( srcrect->w == dstrect->w && srcrect->h == dstrect->h ) {
                     SDL_BlitSurface(src, srcrect, surface, dstrect);
                 } else {
-                    /* If scaling is ever done, permanently disable RLE (which doesn't support scaling)
-                     * to avoid potentially frequent RLE encoding/decoding.
-                     */
-                    SDL_SetSurfaceRLE(surface, 0);
                     SDL_BlitScaled(src, srcrect, surface, dstrect);
                 }
                 break;
@@ -763,6 +788,9 @@ SW_DestroyRenderer(SDL_Renderer * renderer)
 {
     SW_RenderData *data = (SW_RenderData *) renderer->driverdata;
 
+    if (data) {
+        SDL_DestroyFrameArena(data->scratch);
+    }
     SDL_free(data);
     SDL_free(renderer);
 }
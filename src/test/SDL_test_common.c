@@ -1821,6 +1821,7 @@ SDLTest_CommonQuit(SDLTest_CommonState * state)
     SDL_free(state);
     SDL_Quit();
     SDLTest_LogAllocations();
+    SDLTest_LogAllocationProfile();
 }
 
 /* vi: set ts=4 sw=4 expandtab: */
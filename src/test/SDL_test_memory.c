@@ -20,13 +20,19 @@
 */
 #include "SDL_config.h"
 #include "SDL_assert.h"
+#include "SDL_atomic.h"
 #include "SDL_stdinc.h"
+#include "SDL_hints.h"
 #include "SDL_log.h"
+#include "SDL_timer.h"
 #include "SDL_test_crc32.h"
 #include "SDL_test_memory.h"
 
 #ifdef HAVE_LIBUNWIND_H
 #include <libunwind.h>
+#elif defined(__GLIBC__) || defined(__APPLE__)
+#include <execinfo.h>
+#define HAVE_BACKTRACE 1
 #endif
 
 /* This is a simple tracking allocator to demonstrate the use of SDL's
@@ -34,14 +40,41 @@
 
    It gets slow with large numbers of allocations and shouldn't be used
    for production code.
+
+   Besides the live allocations, it profiles where allocations come from:
+   allocations are grouped by call site (the first few frames of their
+   stack) with counts, volume and a histogram of how long they lived.
 */
 
+/* How many frames of the stack (after our own) tell call sites apart.
+   The first few are always SDL_malloc() and friends. */
+#define SITE_DEPTH 6
+
+/* Lifetime histogram buckets, in microseconds */
+static const Uint64 s_lifetime_limits[] = { 10, 1000, 16667, 1000000 };
+static const char *s_lifetime_names = "<10us/<1ms/<1 frame/<1s/longer";
+#define NUM_LIFETIMES (SDL_arraysize(s_lifetime_limits) + 1)
+
+/* How many call sites SDLTest_LogAllocationProfile() lists */
+#define TOP_SITES 10
+
+typedef struct SDL_allocation_site
+{
+    Uint64 stack[10];
+    char stack_names[10][256];
+    Uint32 count;
+    Uint64 bytes;
+    Uint32 live;
+    Uint32 lifetimes[5];
+    struct SDL_allocation_site *next;
+} SDL_allocation_site;
+
 typedef struct SDL_tracked_allocation
 {
     void *mem;
     size_t size;
-    Uint64 stack[10];
-    char stack_names[10][256];
+    Uint64 start;
+    SDL_allocation_site *site;
     struct SDL_tracked_allocation *next;
 } SDL_tracked_allocation;
 
@@ -52,6 +85,27 @@ static SDL_realloc_func SDL_realloc_orig = NULL;
 static SDL_free_func SDL_free_orig = NULL;
 static int s_previous_allocations = 0;
 static SDL_tracked_allocation *s_tracked_allocations[256];
+static SDL_allocation_site *s_allocation_sites[256];
+static SDL_SpinLock s_lock;
+static Uint64 s_frequency;
+
+static struct
+{
+    Uint32 count;
+    Uint64 bytes;
+    Uint32 frees;
+    Uint32 live;
+    Uint64 live_bytes;
+    Uint32 peak;
+    Uint64 peak_bytes;
+    Uint32 frames;
+    Uint32 frame_count;
+    Uint64 frame_bytes;
+    Uint32 max_frame_count;
+    Uint64 max_frame_bytes;
+} s_profile;
+
+SDL_COMPILE_TIME_ASSERT(lifetimes, NUM_LIFETIMES == 5);
 
 static unsigned int get_allocation_bucket(void *mem)
 {
@@ -61,22 +115,104 @@ static unsigned int get_allocation_bucket(void *mem)
     index = (crc_value & (SDL_arraysize(s_tracked_allocations) - 1));
     return index;
 }
- 
-static SDL_bool SDL_IsAllocationTracked(void *mem)
+
+/* Called with s_lock held, like everything that touches the tables. */
+static SDL_tracked_allocation *SDL_FindAllocation(void *mem)
 {
     SDL_tracked_allocation *entry;
     int index = get_allocation_bucket(mem);
     for (entry = s_tracked_allocations[index]; entry; entry = entry->next) {
         if (mem == entry->mem) {
-            return SDL_TRUE;
+            return entry;
         }
     }
-    return SDL_FALSE;
+    return NULL;
+}
+
+static SDL_bool SDL_IsAllocationTracked(void *mem)
+{
+    SDL_bool tracked;
+    SDL_AtomicLock(&s_lock);
+    tracked = SDL_FindAllocation(mem) ? SDL_TRUE : SDL_FALSE;
+    SDL_AtomicUnlock(&s_lock);
+    return tracked;
+}
+
+/* Fills in the stack of whoever called the tracked allocator: stack[0] is
+   SDLTest_TrackedMalloc() or its siblings. */
+static void SDL_GetAllocationStack(Uint64 *stack, char (*stack_names)[256])
+{
+#ifdef HAVE_LIBUNWIND_H
+    int stack_index;
+    unw_cursor_t cursor;
+    unw_context_t context;
+
+    unw_getcontext(&context);
+    unw_init_local(&cursor, &context);
+
+    /* Skip ourselves */
+    unw_step(&cursor);
+
+    stack_index = 0;
+    while (unw_step(&cursor) > 0) {
+        unw_word_t offset, pc;
+        char sym[256];
+
+        unw_get_reg(&cursor, UNW_REG_IP, &pc);
+        stack[stack_index] = pc;
+
+        if (unw_get_proc_name(&cursor, sym, sizeof(sym), &offset) == 0) {
+            snprintf(stack_names[stack_index], sizeof(stack_names[stack_index]), "%s+0x%llx", sym, (unsigned long long)offset);
+        }
+        ++stack_index;
+
+        if (stack_index == 10) {
+            break;
+        }
+    }
+#elif defined(HAVE_BACKTRACE)
+    void *frames[12];
+    int count = backtrace(frames, SDL_arraysize(frames));
+    int i;
+
+    /* Skip ourselves and SDL_TrackAllocation() */
+    for (i = 2; i < count; ++i) {
+        stack[i - 2] = (Uint64)(uintptr_t)frames[i];
+    }
+#endif
+}
+
+static SDL_allocation_site *SDL_GetAllocationSite(const Uint64 *stack, char (*stack_names)[256])
+{
+    SDL_allocation_site *site;
+    CrcUint32 crc_value;
+    int index;
+
+    SDLTest_Crc32Calc(&s_crc32_context, (CrcUint8 *)&stack[1], SITE_DEPTH * sizeof(stack[0]), &crc_value);
+    index = (crc_value & (SDL_arraysize(s_allocation_sites) - 1));
+
+    for (site = s_allocation_sites[index]; site; site = site->next) {
+        if (SDL_memcmp(&site->stack[1], &stack[1], SITE_DEPTH * sizeof(stack[0])) == 0) {
+            return site;
+        }
+    }
+
+    site = (SDL_allocation_site *)SDL_calloc_orig(1, sizeof(*site));
+    if (!site) {
+        return NULL;
+    }
+    SDL_memcpy(site->stack, stack, sizeof(site->stack));
+    SDL_memcpy(site->stack_names, stack_names, sizeof(site->stack_names));
+    site->next = s_allocation_sites[index];
+    s_allocation_sites[index] = site;
+    return site;
 }
 
 static void SDL_TrackAllocation(void *mem, size_t size)
 {
     SDL_tracked_allocation *entry;
+    Uint64 stack[10];
+    char stack_names[10][256];
     int index = get_allocation_bucket(mem);
 
     if (SDL_IsAllocationTracked(mem)) {
@@ -88,47 +224,42 @@ static void SDL_TrackAllocation(void *mem, size_t size)
     }
     entry->mem = mem;
     entry->size = size;
+    entry->start = SDL_GetPerformanceCounter();
 
     /* Generate the stack trace for the allocation */
-    SDL_zero(entry->stack);
-#ifdef HAVE_LIBUNWIND_H
-    {
-        int stack_index;
-        unw_cursor_t cursor;
-        unw_context_t context;
-
-        unw_getcontext(&context);
-        unw_init_local(&cursor, &context);
-
-        stack_index = 0;
-        while (unw_step(&cursor) > 0) {
-            unw_word_t offset, pc;
-            char sym[256];
-
-            unw_get_reg(&cursor, UNW_REG_IP, &pc);
-            entry->stack[stack_index] = pc;
-
-            if (unw_get_proc_name(&cursor, sym, sizeof(sym), &offset) == 0) {
-                snprintf(entry->stack_names[stack_index], sizeof(entry->stack_names[stack_index]), "%s+0x%llx", sym, (unsigned long long)offset);
-            }
-            ++stack_index;
-
-            if (stack_index == SDL_arraysize(entry->stack)) {
-                break;
-            }
-        }
+    SDL_zero(stack);
+    SDL_zero(stack_names);
+    SDL_GetAllocationStack(stack, stack_names);
+
+    SDL_AtomicLock(&s_lock);
+    entry->site = SDL_GetAllocationSite(stack, stack_names);
+    if (entry->site) {
+        entry->site->count++;
+        entry->site->bytes += size;
+        entry->site->live++;
     }
-#endif /* HAVE_LIBUNWIND_H */
+
+    s_profile.count++;
+    s_profile.bytes += size;
+    s_profile.live++;
+    s_profile.live_bytes += size;
+    s_profile.peak = SDL_max(s_profile.peak, s_profile.live);
+    s_profile.peak_bytes = SDL_max(s_profile.peak_bytes, s_profile.live_bytes);
+    s_profile.frame_count++;
+    s_profile.frame_bytes += size;
 
     entry->next = s_tracked_allocations[index];
     s_tracked_allocations[index] = entry;
+    SDL_AtomicUnlock(&s_lock);
 }
 
 static void SDL_UntrackAllocation(void *mem)
 {
     SDL_tracked_allocation *entry, *prev;
     int index = get_allocation_bucket(mem);
+    Uint64 now = SDL_GetPerformanceCounter();
 
+    SDL_AtomicLock(&s_lock);
     prev = NULL;
     for (entry = s_tracked_allocations[index]; entry; entry = entry->next) {
         if (mem == entry->mem) {
@@ -137,11 +268,42 @@ static void SDL_UntrackAllocation(void *mem)
             } else {
                 s_tracked_allocations[index] = entry->next;
             }
+
+            if (entry->site) {
+                const Uint64 lifetime = ((now - entry->start) * 1000000) / s_frequency;
+                int bucket = 0;
+                while (bucket < SDL_arraysize(s_lifetime_limits) && lifetime >= s_lifetime_limits[bucket]) {
+                    ++bucket;
+                }
+                entry->site->lifetimes[bucket]++;
+                entry->site->live--;
+            }
+            s_profile.frees++;
+            s_profile.live--;
+            s_profile.live_bytes -= entry->size;
+
+            SDL_AtomicUnlock(&s_lock);
             SDL_free_orig(entry);
             return;
         }
         prev = entry;
     }
+    SDL_AtomicUnlock(&s_lock);
+}
+
+static void SDL_ResizeAllocation(void *mem, size_t size)
+{
+    SDL_tracked_allocation *entry;
+
+    SDL_AtomicLock(&s_lock);
+    entry = SDL_FindAllocation(mem);
+    if (entry) {
+        s_profile.live_bytes += size;
+        s_profile.live_bytes -= entry->size;
+        s_profile.peak_bytes = SDL_max(s_profile.peak_bytes, s_profile.live_bytes);
+        entry->size = size;
+    }
+    SDL_AtomicUnlock(&s_lock);
 }
 
 static void * SDLCALL SDLTest_TrackedMalloc(size_t size)
@@ -177,6 +339,8 @@ static void * SDLCALL SDLTest_TrackedRealloc(void *ptr, size_t size)
             SDL_UntrackAllocation(ptr);
         }
         SDL_TrackAllocation(mem, size);
+    } else if (mem) {
+        SDL_ResizeAllocation(mem, size);
     }
     return mem;
 }
@@ -201,6 +365,7 @@ int SDLTest_TrackAllocations()
     }
 
     SDLTest_Crc32Init(&s_crc32_context);
+    s_frequency = SDL_GetPerformanceFrequency();
 
     s_previous_allocations = SDL_GetNumAllocations();
     if (s_previous_allocations != 0) {
@@ -216,16 +381,110 @@ int SDLTest_TrackAllocations()
                            SDLTest_TrackedCalloc,
                            SDLTest_TrackedRealloc,
                            SDLTest_TrackedFree);
+
+    /* Have SDL's internal pools and arenas allocate each object separately,
+       so leaked objects show up with the stack that allocated them. */
+    SDL_SetHint(SDL_HINT_MEMORY_POOLS, "0");
     return 0;
 }
 
+void SDLTest_MarkAllocationFrame()
+{
+    if (!SDL_malloc_orig) {
+        return;
+    }
+
+    SDL_AtomicLock(&s_lock);
+    s_profile.frames++;
+    s_profile.max_frame_count = SDL_max(s_profile.max_frame_count, s_profile.frame_count);
+    s_profile.max_frame_bytes = SDL_max(s_profile.max_frame_bytes, s_profile.frame_bytes);
+    s_profile.frame_count = 0;
+    s_profile.frame_bytes = 0;
+    SDL_AtomicUnlock(&s_lock);
+}
+
+static SDL_bool SDL_AddLine(char **message, size_t *message_size, const char *line)
+{
+    char *tmp = (char *)SDL_realloc_orig(*message, *message_size + SDL_strlen(line) + 1);
+    if (!tmp) {
+        return SDL_FALSE;
+    }
+    if (!*message) {
+        *tmp = '\0';
+    }
+    *message = tmp;
+    *message_size += SDL_strlen(line) + 1;
+    SDL_strlcat(*message, line, *message_size);
+    return SDL_TRUE;
+}
+
+/* SDL_Log() truncates long messages, so log them a few lines at a time */
+static void SDL_LogLines(char *message)
+{
+    while (*message) {
+        char *end = message;
+        char *next;
+        char saved;
+
+        while ((next = SDL_strchr(end, '\n')) != NULL && (next + 1 - message) < (SDL_MAX_LOG_MESSAGE - 1)) {
+            end = next + 1;
+        }
+        if (end == message) {
+            end = message + SDL_min(SDL_strlen(message), SDL_MAX_LOG_MESSAGE - 2);
+        }
+        saved = *end;
+        *end = '\0';
+        SDL_Log("%s", message);
+        *end = saved;
+        message = end;
+    }
+}
+
+static void SDL_AddStackLines(char **message, size_t *message_size, const Uint64 *stack, char (*stack_names)[256])
+{
+    char line[320];
+    int stack_index;
+#ifdef HAVE_BACKTRACE
+    char **symbols;
+    void *frames[10];
+    int count = 0;
+
+    while (count < 10 && stack[count]) {
+        frames[count] = (void *)(uintptr_t)stack[count];
+        ++count;
+    }
+    symbols = backtrace_symbols(frames, count);
+#endif
+
+    /* Start at stack index 1 to skip our tracking functions */
+    for (stack_index = 1; stack_index < 10; ++stack_index) {
+        const char *name = stack_names[stack_index];
+        if (!stack[stack_index]) {
+            break;
+        }
+#ifdef HAVE_BACKTRACE
+        if (symbols) {
+            name = symbols[stack_index];
+        }
+#endif
+        SDL_snprintf(line, sizeof(line), "\t0x%"SDL_PRIx64": %s\n", stack[stack_index], name);
+        if (!SDL_AddLine(message, message_size, line)) {
+            break;
+        }
+    }
+
+#ifdef HAVE_BACKTRACE
+    free(symbols);
+#endif
+}
+
 void SDLTest_LogAllocations()
 {
     char *message = NULL;
     size_t message_size = 0;
-    char line[128], *tmp;
+    char line[128];
     SDL_tracked_allocation *entry;
-    int index, count, stack_index;
+    int index, count;
     Uint64 total_allocated;
 
     if (!SDL_malloc_orig) {
@@ -233,13 +492,13 @@ void SDLTest_LogAllocations()
     }
 
 #define ADD_LINE() \
-    message_size += (SDL_strlen(line) + 1); \
-    tmp = (char *)SDL_realloc_orig(message, message_size); \
-    if (!tmp) { \
+    if (!SDL_AddLine(&message, &message_size, line)) { \
+        SDL_AtomicUnlock(&s_lock); \
+        SDL_free_orig(message); \
         return; \
-    } \
-    message = tmp; \
-    SDL_strlcat(message, line, message_size)
+    }
+
+    SDL_AtomicLock(&s_lock);
 
     SDL_strlcpy(line, "Memory allocations:\n", sizeof(line));
     ADD_LINE();
@@ -252,13 +511,8 @@ void SDLTest_LogAllocations()
         for (entry = s_tracked_allocations[index]; entry; entry = entry->next) {
             SDL_snprintf(line, sizeof(line), "Allocation %d: %d bytes\n", count, (int)entry->size);
             ADD_LINE();
-            /* Start at stack index 1 to skip our tracking functions */
-            for (stack_index = 1; stack_index < SDL_arraysize(entry->stack); ++stack_index) {
-                if (!entry->stack[stack_index]) {
-                    break;
-                }
-                SDL_snprintf(line, sizeof(line), "\t0x%"SDL_PRIx64": %s\n", entry->stack[stack_index], entry->stack_names[stack_index]);
-                ADD_LINE();
+            if (entry->site) {
+                SDL_AddStackLines(&message, &message_size, entry->site->stack, entry->site->stack_names);
             }
             total_allocated += entry->size;
             ++count;
@@ -268,7 +522,88 @@ void SDLTest_LogAllocations()
     ADD_LINE();
 #undef ADD_LINE
 
-    SDL_Log("%s", message);
+    SDL_AtomicUnlock(&s_lock);
+
+    /* Logging may allocate, so it can't happen with the lock held */
+    SDL_LogLines(message);
+    SDL_free_orig(message);
+}
+
+static int SDLCALL SDL_CompareSites(const void *a, const void *b)
+{
+    const SDL_allocation_site *site_a = *(const SDL_allocation_site **)a;
+    const SDL_allocation_site *site_b = *(const SDL_allocation_site **)b;
+    if (site_a->count != site_b->count) {
+        return (site_a->count > site_b->count) ? -1 : 1;
+    }
+    return (site_a->bytes > site_b->bytes) ? -1 : (site_a->bytes < site_b->bytes);
+}
+
+void SDLTest_LogAllocationProfile()
+{
+    SDL_allocation_site **sites;
+    SDL_allocation_site *site;
+    char *message = NULL;
+    size_t message_size = 0;
+    char line[256];
+    int index, num_sites = 0;
+
+    if (!SDL_malloc_orig) {
+        return;
+    }
+
+    SDL_AtomicLock(&s_lock);
+
+    for (index = 0; index < SDL_arraysize(s_allocation_sites); ++index) {
+        for (site = s_allocation_sites[index]; site; site = site->next) {
+            ++num_sites;
+        }
+    }
+    sites = (SDL_allocation_site **)SDL_malloc_orig(SDL_max(num_sites, 1) * sizeof(*sites));
+    if (!sites) {
+        SDL_AtomicUnlock(&s_lock);
+        return;
+    }
+    num_sites = 0;
+    for (index = 0; index < SDL_arraysize(s_allocation_sites); ++index) {
+        for (site = s_allocation_sites[index]; site; site = site->next) {
+            sites[num_sites++] = site;
+        }
+    }
+    SDL_qsort(sites, num_sites, sizeof(*sites), SDL_CompareSites);
+
+    SDL_snprintf(line, sizeof(line), "Allocation profile:\n"
+                 "%u allocations (%.2f Kb), %u freed, peak %.2f Kb in %u allocations, %d call sites\n",
+                 (unsigned int)s_profile.count, (double)s_profile.bytes / 1024, (unsigned int)s_profile.frees,
+                 (double)s_profile.peak_bytes / 1024, (unsigned int)s_profile.peak, num_sites);
+    SDL_AddLine(&message, &message_size, line);
+
+    if (s_profile.frames) {
+        SDL_snprintf(line, sizeof(line), "%u frames: %.1f allocations (%.2f Kb) per frame, at most %u (%.2f Kb)\n",
+                     (unsigned int)s_profile.frames,
+                     (double)s_profile.count / s_profile.frames, (double)s_profile.bytes / (1024.0 * s_profile.frames),
+                     (unsigned int)s_profile.max_frame_count, (double)s_profile.max_frame_bytes / 1024);
+        SDL_AddLine(&message, &message_size, line);
+    }
+
+    for (index = 0; index < num_sites && index < TOP_SITES; ++index) {
+        site = sites[index];
+        SDL_snprintf(line, sizeof(line), "Site %d: %u allocations (%.2f Kb), %u live, lifetimes %s: %u/%u/%u/%u/%u\n",
+                     index, (unsigned int)site->count, (double)site->bytes / 1024, (unsigned int)site->live,
+                     s_lifetime_names,
+                     (unsigned int)site->lifetimes[0], (unsigned int)site->lifetimes[1], (unsigned int)site->lifetimes[2],
+                     (unsigned int)site->lifetimes[3], (unsigned int)site->lifetimes[4]);
+        SDL_AddLine(&message, &message_size, line);
+        SDL_AddStackLines(&message, &message_size, site->stack, site->stack_names);
+    }
+
+    SDL_AtomicUnlock(&s_lock);
+    SDL_free_orig(sites);
+
+    if (message) {
+        SDL_LogLines(message);
+        SDL_free_orig(message);
+    }
 }
 
 /* vi: set ts=4 sw=4 expandtab: */
@@ -0,0 +1,646 @@
+/*
+  Simple DirectMedia Layer
+  Copyright (C) 1997-2019 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+#include "../SDL_internal.h"
+
+/* A work-stealing job system.
+
+   Each worker thread owns a Chase-Lev deque: it pushes and pops jobs at
+   the bottom, while workers that run dry steal from the top. Jobs
+   submitted from threads that aren't workers go into a shared queue that
+   every worker also checks. Workers with nothing to do sleep on a
+   semaphore that submitters post to when they see sleepers, and threads
+   waiting on a counter sleep on a condition variable that is signaled
+   when a counter reaches zero or new work shows up.
+
+   The deques are the algorithm from "Dynamic Circular Work-Stealing
+   Deque" (Chase and Lev, 2005) with a fixed size. It needs a full
+   barrier between the owner's store to 'bottom' and its load of 'top',
+   and the sleep/wake handshakes need the same between publishing and
+   checking. SDL_AtomicSet() is only an acquire barrier on some
+   platforms, but SDL's read-modify-write operations are full barriers
+   everywhere, so those stores are all done with SDL_AtomicAdd().
+ */
+
+#include "SDL_atomic.h"
+#include "SDL_cpuinfo.h"
+#include "SDL_hints.h"
+#include "SDL_jobs.h"
+#include "SDL_mutex.h"
+#include "SDL_timer.h"
+#include "SDL_jobs_c.h"
+#include "SDL_systhread.h"
+
+/* Slots in each worker's deque. This must be a power of two. */
+#define SDL_JOB_DEQUE_SIZE 1024
+#define SDL_MAX_JOB_WORKERS 64
+
+typedef struct SDL_Job
+{
+    SDL_JobFunction func;
+    SDL_ParallelForFunction range_func;
+    void *data;
+    int start;
+    int end;
+    SDL_JobCounter *counter;
+    SDL_bool allocated;
+    struct SDL_Job *next;
+} SDL_Job;
+
+struct SDL_JobCounter
+{
+    SDL_atomic_t pending;
+    SDL_SpinLock lock;  /* held while finishing a job and for 'waiting' */
+    SDL_Job *waiting;   /* jobs to submit once pending reaches zero */
+};
+
+typedef struct
+{
+    SDL_atomic_t top;
+    SDL_atomic_t bottom;
+    SDL_Job *slots[SDL_JOB_DEQUE_SIZE];
+} SDL_JobDeque;
+
+typedef struct
+{
+    SDL_JobDeque deque;
+    SDL_Thread *thread;
+    SDL_threadID threadid;
+} SDL_JobWorker;
+
+static SDL_SpinLock SDL_jobs_lock;  /* held while starting and stopping */
+static SDL_atomic_t SDL_jobs_started;
+static SDL_atomic_t SDL_jobs_quit;
+static SDL_JobWorker *SDL_job_workers;
+static int SDL_num_job_workers;
+static SDL_sem *SDL_jobs_wakeup;
+static SDL_atomic_t SDL_jobs_sleeping;
+
+/* Threads blocked in SDL_WaitJobCounter() */
+static SDL_mutex *SDL_jobs_signal_lock;
+static SDL_cond *SDL_jobs_signal;
+static SDL_atomic_t SDL_jobs_waiting;
+
+/* Jobs from threads that aren't workers */
+static SDL_SpinLock SDL_jobs_queue_lock;
+static SDL_Job *SDL_jobs_queue_head;
+static SDL_Job *SDL_jobs_queue_tail;
+static SDL_atomic_t SDL_jobs_queued;
+
+/* Reads with a full barrier in front, for the far side of a handshake. */
+static int
+SDL_AtomicGetFenced(SDL_atomic_t *a)
+{
+    return SDL_AtomicAdd(a, 0);
+}
+
+/* Deque indices only ever grow, and are compared by difference, so they
+   are free to wrap around. */
+static SDL_bool
+SDL_PushDequeJob(SDL_JobDeque *deque, SDL_Job *job)
+{
+    const Uint32 bottom = (Uint32) SDL_AtomicGet(&deque->bottom);
+    const Uint32 top = (Uint32) SDL_AtomicGet(&deque->top);
+
+    if ((bottom - top) >= SDL_JOB_DEQUE_SIZE) {
+        return SDL_FALSE;  /* full. */
+    }
+    SDL_AtomicSetPtr((void **) &deque->slots[bottom & (SDL_JOB_DEQUE_SIZE - 1)], job);
+    SDL_AtomicAdd(&deque->bottom, 1);  /* publishes the slot to thieves. */
+    return SDL_TRUE;
+}
+
+/* Only the deque's owner may pop. */
+static SDL_Job *
+SDL_PopDequeJob(SDL_JobDeque *deque)
+{
+    const Uint32 bottom = ((Uint32) SDL_AtomicGet(&deque->bottom)) - 1;
+    Uint32 top;
+    SDL_Job *job;
+
+    /* Claim the bottom slot before looking at what the thieves are up to.
+       This has to be a full barrier, or we could read a stale 'top' while
+       a thief reads a stale 'bottom' and both of us take the same job. */
+    SDL_AtomicAdd(&deque->bottom, -1);
+    top = (Uint32) SDL_AtomicGet(&deque->top);
+    if (((int) (bottom - top)) < 0) {
+        SDL_AtomicAdd(&deque->bottom, 1);
+        return NULL;  /* empty. */
+    }
+
+    job = (SDL_Job *) SDL_AtomicGetPtr((void **) &deque->slots[bottom & (SDL_JOB_DEQUE_SIZE - 1)]);
+    if (bottom != top) {
+        return job;  /* no thief can reach this one. */
+    }
+
+    /* This is the last job, so race the thieves for it. */
+    if (!SDL_AtomicCAS(&deque->top, (int) top, (int) (top + 1))) {
+        job = NULL;
+    }
+    SDL_AtomicAdd(&deque->bottom, 1);
+    return job;
+}
+
+static SDL_Job *
+SDL_StealDequeJob(SDL_JobDeque *deque)
+{
+    const Uint32 top = (Uint32) SDL_AtomicGet(&deque->top);
+    const Uint32 bottom = (Uint32) SDL_AtomicGet(&deque->bottom);
+    SDL_Job *job;
+
+    if (((int) (bottom - top)) <= 0) {
+        return NULL;  /* empty. */
+    }
+
+    job = (SDL_Job *) SDL_AtomicGetPtr((void **) &deque->slots[top & (SDL_JOB_DEQUE_SIZE - 1)]);
+    if (!SDL_AtomicCAS(&deque->top, (int) top, (int) (top + 1))) {
+        return NULL;  /* somebody else got it. */
+    }
+    return job;
+}
+
+static void
+SDL_PushSharedJob(SDL_Job *job)
+{
+    job->next = NULL;
+    SDL_AtomicLock(&SDL_jobs_queue_lock);
+    if (SDL_jobs_queue_tail) {
+        SDL_jobs_queue_tail->next = job;
+    } else {
+        SDL_jobs_queue_head = job;
+    }
+    SDL_jobs_queue_tail = job;
+    SDL_AtomicIncRef(&SDL_jobs_queued);
+    SDL_AtomicUnlock(&SDL_jobs_queue_lock);
+}
+
+static SDL_Job *
+SDL_PopSharedJob(void)
+{
+    SDL_Job *job;
+
+    if (!SDL_AtomicGet(&SDL_jobs_queued)) {
+        return NULL;
+    }
+
+    SDL_AtomicLock(&SDL_jobs_queue_lock);
+    job = SDL_jobs_queue_head;
+    if (job) {
+        SDL_jobs_queue_head = job->next;
+        if (!SDL_jobs_queue_head) {
+            SDL_jobs_queue_tail = NULL;
+        }
+        SDL_AtomicAdd(&SDL_jobs_queued, -1);
+    }
+    SDL_AtomicUnlock(&SDL_jobs_queue_lock);
+    return job;
+}
+
+static SDL_JobWorker *
+SDL_GetCurrentJobWorker(void)
+{
+    const SDL_threadID threadid = SDL_ThreadID();
+    int i;
+
+    for (i = 0; i < SDL_num_job_workers; ++i) {
+        if (SDL_job_workers[i].threadid == threadid) {
+            return &SDL_job_workers[i];
+        }
+    }
+    return NULL;
+}
+
+static SDL_Job *
+SDL_FindJob(SDL_JobWorker *self)
+{
+    const int first = self ? (int) (self - SDL_job_workers) + 1 : 0;
+    SDL_Job *job;
+    int i;
+
+    if (self) {
+        job = SDL_PopDequeJob(&self->deque);
+        if (job) {
+            return job;
+        }
+    }
+
+    job = SDL_PopSharedJob();
+    if (job) {
+        return job;
+    }
+
+    /* Start with our neighbor, so thieves don't all mob the same worker */
+    for (i = 0; i < SDL_num_job_workers; ++i) {
+        SDL_JobWorker *victim = &SDL_job_workers[(first + i) % SDL_num_job_workers];
+        if (victim != self) {
+            job = SDL_StealDequeJob(&victim->deque);
+            if (job) {
+                return job;
+            }
+        }
+    }
+    return NULL;
+}
+
+static SDL_bool
+SDL_JobsAvailable(void)
+{
+    int i;
+
+    if (SDL_AtomicGet(&SDL_jobs_queued)) {
+        return SDL_TRUE;
+    }
+    for (i = 0; i < SDL_num_job_workers; ++i) {
+        SDL_JobDeque *deque = &SDL_job_workers[i].deque;
+        if ((SDL_AtomicGet(&deque->bottom) - SDL_AtomicGet(&deque->top)) > 0) {
+            return SDL_TRUE;
+        }
+    }
+    return SDL_FALSE;
+}
+
+/* Call after a full barrier, once whatever a waiter is waiting for has
+   been published. */
+static void
+SDL_WakeJobWaiters(void)
+{
+    if (SDL_AtomicGetFenced(&SDL_jobs_waiting) > 0) {
+        SDL_LockMutex(SDL_jobs_signal_lock);
+        SDL_CondBroadcast(SDL_jobs_signal);
+        SDL_UnlockMutex(SDL_jobs_signal_lock);
+    }
+}
+
+static void SDL_ExecuteJob(SDL_Job *job);
+
+static void
+SDL_SubmitJob(SDL_Job *job)
+{
+    SDL_JobWorker *self;
+
+    if (!SDL_num_job_workers) {
+        SDL_ExecuteJob(job);
+        return;
+    }
+
+    self = SDL_GetCurrentJobWorker();
+    if (!self || !SDL_PushDequeJob(&self->deque, job)) {
+        SDL_PushSharedJob(job);
+    }
+
+    /* The push ended in a full barrier, and so does a sleeper announcing
+       itself, so either we see it here or it sees this job. */
+    if (SDL_AtomicGetFenced(&SDL_jobs_sleeping) > 0) {
+        SDL_SemPost(SDL_jobs_wakeup);
+    }
+    SDL_WakeJobWaiters();  /* they help out while they wait. */
+}
+
+static void
+SDL_FinishJob(SDL_JobCounter *counter)
+{
+    SDL_Job *ready = NULL;
+    SDL_bool done;
+
+    /* This is done under the lock so that once a waiter has seen the count
+       reach zero and taken the lock, we're done touching the counter. */
+    SDL_AtomicLock(&counter->lock);
+    done = SDL_AtomicDecRef(&counter->pending);
+    if (done) {
+        ready = counter->waiting;
+        counter->waiting = NULL;
+    }
+    SDL_AtomicUnlock(&counter->lock);
+
+    if (done) {
+        SDL_WakeJobWaiters();
+    }
+
+    while (ready) {
+        SDL_Job *next = ready->next;
+        SDL_SubmitJob(ready);
+        ready = next;
+    }
+}
+
+static void
+SDL_ExecuteJob(SDL_Job *job)
+{
+    SDL_JobCounter *counter = job->counter;
+
+    if (job->range_func) {
+        job->range_func(job->data, job->start, job->end);
+    } else {
+        job->func(job->data);
+    }
+    if (job->allocated) {
+        SDL_free(job);
+    }
+    if (counter) {
+        SDL_FinishJob(counter);
+    }
+}
+
+static int SDLCALL
+SDL_JobWorkerThread(void *data)
+{
+    SDL_JobWorker *self = (SDL_JobWorker *) data;
+
+    self->threadid = SDL_ThreadID();
+
+    for ( ; ; ) {
+        SDL_Job *job = SDL_FindJob(self);
+        if (job) {
+            SDL_ExecuteJob(job);
+            continue;
+        }
+
+        if (SDL_AtomicGet(&SDL_jobs_quit)) {
+            break;
+        }
+
+        /* Submitters check for sleepers after queueing, so either we see
+           their job here or they see us and post. The increment is a full
+           barrier, so our checks below can't be hoisted above it. */
+        SDL_AtomicIncRef(&SDL_jobs_sleeping);
+        if (!SDL_JobsAvailable() && !SDL_AtomicGet(&SDL_jobs_quit)) {
+            SDL_SemWait(SDL_jobs_wakeup);
+        }
+        SDL_AtomicAdd(&SDL_jobs_sleeping, -1);
+    }
+    return 0;
+}
+
+static void
+SDL_DestroyJobSignals(void)
+{
+    if (SDL_jobs_wakeup) {
+        SDL_DestroySemaphore(SDL_jobs_wakeup);
+        SDL_jobs_wakeup = NULL;
+    }
+    if (SDL_jobs_signal) {
+        SDL_DestroyCond(SDL_jobs_signal);
+        SDL_jobs_signal = NULL;
+    }
+    if (SDL_jobs_signal_lock) {
+        SDL_DestroyMutex(SDL_jobs_signal_lock);
+        SDL_jobs_signal_lock = NULL;
+    }
+}
+
+static int
+SDL_StartJobWorkers(void)
+{
+    if (SDL_AtomicGet(&SDL_jobs_started)) {
+        return SDL_num_job_workers;
+    }
+
+    SDL_AtomicLock(&SDL_jobs_lock);
+    if (!SDL_AtomicGet(&SDL_jobs_started)) {
+#if !SDL_THREADS_DISABLED
+        const char *hint = SDL_GetHint(SDL_HINT_JOB_WORKERS);
+        int num_workers = hint ? SDL_atoi(hint) : (SDL_GetCPUCount() - 1);
+        int i;
+
+        num_workers = SDL_max(SDL_min(num_workers, SDL_MAX_JOB_WORKERS), 0);
+        if (num_workers > 0) {
+            SDL_jobs_wakeup = SDL_CreateSemaphore(0);
+            SDL_jobs_signal_lock = SDL_CreateMutex();
+            SDL_jobs_signal = SDL_CreateCond();
+            SDL_job_workers = (SDL_JobWorker *) SDL_calloc(num_workers, sizeof (SDL_JobWorker));
+            if (!SDL_jobs_wakeup || !SDL_jobs_signal_lock || !SDL_jobs_signal || !SDL_job_workers) {
+                num_workers = 0;
+            }
+        }
+
+        /* Make do with however many workers we manage to start */
+        for (i = 0; i < num_workers; ++i) {
+            SDL_JobWorker *worker = &SDL_job_workers[i];
+            worker->thread = SDL_CreateThreadInternal(SDL_JobWorkerThread, "SDLJobWorker", 0, worker);
+            if (!worker->thread) {
+                break;
+            }
+            /* Set this here too, so it's right before any job can run */
+            worker->threadid = SDL_GetThreadID(worker->thread);
+            SDL_num_job_workers = i + 1;
+        }
+        if (!SDL_num_job_workers) {
+            SDL_DestroyJobSignals();
+            SDL_free(SDL_job_workers);
+            SDL_job_workers = NULL;
+        }
+#endif
+        SDL_AtomicSet(&SDL_jobs_started, 1);
+    }
+    SDL_AtomicUnlock(&SDL_jobs_lock);
+
+    return SDL_num_job_workers;
+}
+
+void
+SDL_QuitJobs(void)
+{
+    int i;
+
+    SDL_AtomicLock(&SDL_jobs_lock);
+    if (SDL_AtomicGet(&SDL_jobs_started)) {
+        /* Workers finish whatever is queued before they notice. */
+        SDL_AtomicSet(&SDL_jobs_quit, 1);
+        for (i = 0; i < SDL_num_job_workers; ++i) {
+            SDL_SemPost(SDL_jobs_wakeup);
+        }
+        for (i = 0; i < SDL_num_job_workers; ++i) {
+            SDL_WaitThread(SDL_job_workers[i].thread, NULL);
+        }
+        SDL_DestroyJobSignals();
+        SDL_free(SDL_job_workers);
+        SDL_job_workers = NULL;
+        SDL_num_job_workers = 0;
+        SDL_AtomicSet(&SDL_jobs_sleeping, 0);
+        SDL_AtomicSet(&SDL_jobs_waiting, 0);
+        SDL_AtomicSet(&SDL_jobs_quit, 0);
+        SDL_AtomicSet(&SDL_jobs_started, 0);
+    }
+    SDL_AtomicUnlock(&SDL_jobs_lock);
+}
+
+int
+SDL_GetNumJobWorkers(void)
+{
+    return SDL_StartJobWorkers();
+}
+
+SDL_JobCounter *
+SDL_CreateJobCounter(void)
+{
+    SDL_JobCounter *counter = (SDL_JobCounter *) SDL_calloc(1, sizeof (SDL_JobCounter));
+    if (!counter) {
+        SDL_OutOfMemory();
+        return NULL;
+    }
+    return counter;
+}
+
+void
+SDL_DestroyJobCounter(SDL_JobCounter * counter)
+{
+    SDL_free(counter);
+}
+
+int
+SDL_RunJob(SDL_JobFunction func, void *data, SDL_JobCounter * counter)
+{
+    return SDL_RunJobAfter(NULL, func, data, counter);
+}
+
+int
+SDL_RunJobAfter(SDL_JobCounter * after, SDL_JobFunction func, void *data,
+                SDL_JobCounter * counter)
+{
+    SDL_Job *job;
+
+    if (!func) {
+        return SDL_InvalidParamError("func");
+    }
+
+    /* Without workers there's no point queueing anything we can run now */
+    if (!SDL_StartJobWorkers() && (!after || !SDL_AtomicGet(&after->pending))) {
+        func(data);
+        return 0;
+    }
+
+    job = (SDL_Job *) SDL_calloc(1, sizeof (SDL_Job));
+    if (!job) {
+        return SDL_OutOfMemory();
+    }
+    job->func = func;
+    job->data = data;
+    job->counter = counter;
+    job->allocated = SDL_TRUE;
+    if (counter) {
+        SDL_AtomicIncRef(&counter->pending);
+    }
+
+    if (after) {
+        SDL_AtomicLock(&after->lock);
+        if (SDL_AtomicGet(&after->pending)) {
+            job->next = after->waiting;
+            after->waiting = job;
+            SDL_AtomicUnlock(&after->lock);
+            return 0;
+        }
+        SDL_AtomicUnlock(&after->lock);
+    }
+
+    SDL_SubmitJob(job);
+    return 0;
+}
+
+int
+SDL_WaitJobCounter(SDL_JobCounter * counter)
+{
+    SDL_JobWorker *self;
+
+    if (!counter) {
+        return SDL_InvalidParamError("counter");
+    }
+
+    self = SDL_GetCurrentJobWorker();
+    while (SDL_AtomicGet(&counter->pending)) {
+        SDL_Job *job = SDL_FindJob(self);
+        if (job) {
+            SDL_ExecuteJob(job);
+            continue;
+        }
+
+        /* The last jobs are running elsewhere. Without workers that can
+           only be another thread of the app's, which has nothing to wake
+           us with, so just give it the CPU. */
+        if (!SDL_jobs_signal) {
+            SDL_Delay(1);
+            continue;
+        }
+
+        /* Same handshake as the workers: announce ourselves, then check.
+           Whoever finishes the counter or queues more work checks for us
+           after it's done, and has to take the lock to signal, which it
+           can't do until we're really waiting. */
+        SDL_LockMutex(SDL_jobs_signal_lock);
+        SDL_AtomicIncRef(&SDL_jobs_waiting);
+        if (SDL_AtomicGet(&counter->pending) && !SDL_JobsAvailable()) {
+            SDL_CondWait(SDL_jobs_signal, SDL_jobs_signal_lock);
+        }
+        SDL_AtomicAdd(&SDL_jobs_waiting, -1);
+        SDL_UnlockMutex(SDL_jobs_signal_lock);
+    }
+
+    /* Wait for the last job to finish with the counter. */
+    SDL_AtomicLock(&counter->lock);
+    SDL_AtomicUnlock(&counter->lock);
+    return 0;
+}
+
+int
+SDL_ParallelFor(int count, int batch, SDL_ParallelForFunction func, void *data)
+{
+    SDL_JobCounter counter;
+    SDL_Job *jobs;
+    int num_jobs, i;
+
+    if (!func) {
+        return SDL_InvalidParamError("func");
+    } else if (count <= 0) {
+        return 0;
+    }
+
+    /* A few batches per thread lets stealing even out uneven work. */
+    batch = SDL_max(batch, 1);
+    num_jobs = ((count - 1) / batch) + 1;
+    num_jobs = SDL_min(num_jobs, (SDL_StartJobWorkers() + 1) * 4);
+    if (num_jobs <= 1 || !SDL_num_job_workers) {
+        func(data, 0, count);
+        return 0;
+    }
+
+    jobs = (SDL_Job *) SDL_calloc(num_jobs, sizeof (SDL_Job));
+    if (!jobs) {
+        func(data, 0, count);  /* no memory to spread it out, just do it. */
+        return 0;
+    }
+
+    SDL_zero(counter);
+    SDL_AtomicSet(&counter.pending, num_jobs - 1);
+    for (i = 1; i < num_jobs; ++i) {
+        SDL_Job *job = &jobs[i];
+        job->range_func = func;
+        job->data = data;
+        job->start = (int) (((Sint64) count * i) / num_jobs);
+        job->end = (int) (((Sint64) count * (i + 1)) / num_jobs);
+        job->counter = &counter;
+        SDL_SubmitJob(job);
+    }
+
+    func(data, 0, (int) (((Sint64) count) / num_jobs));
+    SDL_WaitJobCounter(&counter);
+    SDL_free(jobs);
+    return 0;
+}
+
+/* vi: set ts=4 sw=4 expandtab: */
@@ -105,102 +105,127 @@ SDL_TLSCleanup()
 /* This is a generic implementation of thread-local storage which doesn't
    require additional OS support.
 
-   It is not especially efficient and doesn't clean up thread-local storage
-   as threads exit.  If there is a real OS that doesn't support thread-local
-   storage this implementation should be improved to be production quality.
+   If the compiler can give us thread-local variables, that's all it takes.
+   Otherwise threads are hashed by ID into a table of entries that are
+   claimed and released with atomics, so lookups never take a lock. Entries
+   are recycled rather than freed, so there are only ever as many of them
+   as threads that have had storage at the same time.
 */
 
+#ifdef SDL_THREAD_LOCAL
+
+static SDL_THREAD_LOCAL SDL_TLSData *SDL_generic_TLS;
+
+SDL_TLSData *
+SDL_Generic_GetTLSData(void)
+{
+    return SDL_generic_TLS;
+}
+
+int
+SDL_Generic_SetTLSData(SDL_TLSData *storage)
+{
+    SDL_generic_TLS = storage;
+    return 0;
+}
+
+#else
+
+/* This must be a power of two */
+#define SDL_GENERIC_TLS_BUCKETS 64
+
 typedef struct SDL_TLSEntry {
-    SDL_threadID thread;
+    SDL_atomic_t in_use;
+    SDL_threadID thread;  /* 0 while the entry is unowned */
     SDL_TLSData *storage;
     struct SDL_TLSEntry *next;
 } SDL_TLSEntry;
 
-static SDL_mutex *SDL_generic_TLS_mutex;
-static SDL_TLSEntry *SDL_generic_TLS;
+static SDL_TLSEntry *SDL_generic_TLS[SDL_GENERIC_TLS_BUCKETS];
 
+static SDL_TLSEntry **
+SDL_Generic_TLSBucket(SDL_threadID thread)
+{
+    /* Thread IDs are often aligned pointers, so mix in the high bits. */
+    const Uint64 hash = ((Uint64) thread) * 0x9E3779B97F4A7C15ULL;
+    return &SDL_generic_TLS[(hash >> 32) & (SDL_GENERIC_TLS_BUCKETS - 1)];
+}
 
-SDL_TLSData *
-SDL_Generic_GetTLSData(void)
+static SDL_TLSEntry *
+SDL_Generic_FindTLSEntry(SDL_TLSEntry **bucket, SDL_threadID thread)
 {
-    SDL_threadID thread = SDL_ThreadID();
     SDL_TLSEntry *entry;
-    SDL_TLSData *storage = NULL;
 
-#if !SDL_THREADS_DISABLED
-    if (!SDL_generic_TLS_mutex) {
-        static SDL_SpinLock tls_lock;
-        SDL_AtomicLock(&tls_lock);
-        if (!SDL_generic_TLS_mutex) {
-            SDL_mutex *mutex = SDL_CreateMutex();
-            SDL_MemoryBarrierRelease();
-            SDL_generic_TLS_mutex = mutex;
-            if (!SDL_generic_TLS_mutex) {
-                SDL_AtomicUnlock(&tls_lock);
-                return NULL;
-            }
+    /* Only this thread ever sets an entry's thread to its ID, so a match
+       can't be a stale read of somebody else's entry. */
+    for (entry = (SDL_TLSEntry *) SDL_AtomicGetPtr((void **) bucket); entry; entry = entry->next) {
+        if (SDL_AtomicGet(&entry->in_use) && entry->thread == thread) {
+            return entry;
         }
-        SDL_AtomicUnlock(&tls_lock);
     }
-#endif /* SDL_THREADS_DISABLED */
+    return NULL;
+}
 
-    SDL_MemoryBarrierAcquire();
-    SDL_LockMutex(SDL_generic_TLS_mutex);
-    for (entry = SDL_generic_TLS; entry; entry = entry->next) {
-        if (entry->thread == thread) {
-            storage = entry->storage;
-            break;
-        }
-    }
-#if !SDL_THREADS_DISABLED
-    SDL_UnlockMutex(SDL_generic_TLS_mutex);
-#endif
+SDL_TLSData *
+SDL_Generic_GetTLSData(void)
+{
+    const SDL_threadID thread = SDL_ThreadID();
+    SDL_TLSEntry *entry = SDL_Generic_FindTLSEntry(SDL_Generic_TLSBucket(thread), thread);
 
-    return storage;
+    return entry ? entry->storage : NULL;
 }
 
 int
 SDL_Generic_SetTLSData(SDL_TLSData *storage)
 {
-    SDL_threadID thread = SDL_ThreadID();
-    SDL_TLSEntry *prev, *entry;
-
-    /* SDL_Generic_GetTLSData() is always called first, so we can assume SDL_generic_TLS_mutex */
-    SDL_LockMutex(SDL_generic_TLS_mutex);
-    prev = NULL;
-    for (entry = SDL_generic_TLS; entry; entry = entry->next) {
-        if (entry->thread == thread) {
-            if (storage) {
-                entry->storage = storage;
-            } else {
-                if (prev) {
-                    prev->next = entry->next;
-                } else {
-                    SDL_generic_TLS = entry->next;
-                }
-                SDL_free(entry);
-            }
-            break;
+    const SDL_threadID thread = SDL_ThreadID();
+    SDL_TLSEntry **bucket = SDL_Generic_TLSBucket(thread);
+    SDL_TLSEntry *entry = SDL_Generic_FindTLSEntry(bucket, thread);
+    SDL_TLSEntry *head;
+
+    if (entry) {
+        if (storage) {
+            entry->storage = storage;
+        } else {
+            /* Give the entry up for another thread to claim. */
+            entry->storage = NULL;
+            entry->thread = 0;
+            SDL_MemoryBarrierRelease();
+            SDL_AtomicSet(&entry->in_use, 0);
         }
-        prev = entry;
+        return 0;
     }
-    if (!entry) {
-        entry = (SDL_TLSEntry *)SDL_malloc(sizeof(*entry));
-        if (entry) {
-            entry->thread = thread;
+
+    if (!storage) {
+        return 0;  /* nothing to forget. */
+    }
+
+    /* Reuse an entry some finished thread left behind, if we can. */
+    head = (SDL_TLSEntry *) SDL_AtomicGetPtr((void **) bucket);
+    for (entry = head; entry; entry = entry->next) {
+        if (SDL_AtomicCAS(&entry->in_use, 0, 1)) {
             entry->storage = storage;
-            entry->next = SDL_generic_TLS;
-            SDL_generic_TLS = entry;
+            entry->thread = thread;
+            return 0;
         }
     }
-    SDL_UnlockMutex(SDL_generic_TLS_mutex);
 
+    entry = (SDL_TLSEntry *) SDL_malloc(sizeof(*entry));
     if (!entry) {
         return SDL_OutOfMemory();
     }
+    SDL_AtomicSet(&entry->in_use, 1);
+    entry->thread = thread;
+    entry->storage = storage;
+    do {
+        head = (SDL_TLSEntry *) SDL_AtomicGetPtr((void **) bucket);
+        entry->next = head;
+    } while (!SDL_AtomicCASPtr((void **) bucket, head, entry));
     return 0;
 }
 
+#endif /* SDL_THREAD_LOCAL */
+
 /* Routine to get the thread-specific error variable */
 SDL_error *
 SDL_GetErrBuf(void)
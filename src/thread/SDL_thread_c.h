@@ -78,6 +78,15 @@ typedef struct {
 /* This is how many TLS entries we allocate at once */
 #define TLS_ALLOC_CHUNKSIZE 4
 
+/* Compiler support for thread-local variables, if we trust it here.
+   Without threads there's only one thread, so a plain variable will do.
+ */
+#if SDL_THREADS_DISABLED
+#define SDL_THREAD_LOCAL
+#elif defined(__GNUC__) && !defined(__APPLE__) && !defined(__EMSCRIPTEN__) && !defined(__PSP__)
+#define SDL_THREAD_LOCAL __thread
+#endif
+
 /* Get cross-platform, slow, thread local storage for this thread.
    This is only intended as a fallback if getting real thread-local
    storage fails or isn't supported on this platform.
@@ -0,0 +1,85 @@
+/*
+  Simple DirectMedia Layer
+  Copyright (C) 1997-2019 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+#include "../../SDL_internal.h"
+
+#ifndef SDL_futex_c_h_
+#define SDL_futex_c_h_
+
+/* The Linux futex system call: sleep in the kernel until an address is
+   woken, if it still holds the value we expected. Everything built on it
+   only makes the call when it really has to wait or wake someone. */
+
+#include <errno.h>
+#include <limits.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "SDL_atomic.h"
+#include "SDL_mutex.h"
+
+/* The mutex fast paths are a single atomic operation, so they're worth
+   inlining. Only GCC and Clang build these files anyway. */
+static SDL_INLINE SDL_bool
+SDL_FutexCAS(SDL_atomic_t *word, int oldval, int newval)
+{
+    return (SDL_bool) __sync_bool_compare_and_swap(&word->value, oldval, newval);
+}
+
+static SDL_INLINE int
+SDL_FutexExchange(SDL_atomic_t *word, int value)
+{
+    return __atomic_exchange_n(&word->value, value, __ATOMIC_SEQ_CST);
+}
+
+/* Waits for a wake while *word is value. Returns 0 when woken or when
+   *word didn't hold value (or a signal got in the way), and
+   SDL_MUTEX_TIMEDOUT if timeout milliseconds passed first. */
+static int
+SDL_FutexWait(SDL_atomic_t *word, int value, Uint32 timeout)
+{
+    struct timespec ts;
+    struct timespec *pts = NULL;
+
+    if (timeout != SDL_MUTEX_MAXWAIT) {
+        ts.tv_sec = timeout / 1000;
+        ts.tv_nsec = (timeout % 1000) * 1000000;
+        pts = &ts;
+    }
+    if (syscall(SYS_futex, &word->value, FUTEX_WAIT_PRIVATE, value, pts, NULL, 0) < 0) {
+        if (errno == ETIMEDOUT) {
+            return SDL_MUTEX_TIMEDOUT;
+        }
+    }
+    return 0;
+}
+
+/* Wakes up to count threads waiting on word */
+static void
+SDL_FutexWake(SDL_atomic_t *word, int count)
+{
+    syscall(SYS_futex, &word->value, FUTEX_WAKE_PRIVATE, count, NULL, NULL, 0);
+}
+
+#endif /* SDL_futex_c_h_ */
+
+/* vi: set ts=4 sw=4 expandtab: */
@@ -0,0 +1,120 @@
+/*
+  Simple DirectMedia Layer
+  Copyright (C) 1997-2019 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+#include "../../SDL_internal.h"
+
+/* Condition variables on Linux futexes. Waiters sleep on a sequence
+   number that every signal bumps, so a signal that lands between
+   unlocking the mutex and going to sleep isn't lost. Signals with nobody
+   waiting don't make a system call at all. */
+
+#include "SDL_thread.h"
+#include "SDL_futex_c.h"
+
+struct SDL_cond
+{
+    SDL_atomic_t sequence;
+    SDL_atomic_t waiters;
+};
+
+/* Create a condition variable */
+SDL_cond *
+SDL_CreateCond(void)
+{
+    SDL_cond *cond = (SDL_cond *) SDL_calloc(1, sizeof(SDL_cond));
+    if (!cond) {
+        SDL_OutOfMemory();
+    }
+    return cond;
+}
+
+/* Destroy a condition variable */
+void
+SDL_DestroyCond(SDL_cond * cond)
+{
+    SDL_free(cond);
+}
+
+/* Restart one of the threads that are waiting on the condition variable */
+int
+SDL_CondSignal(SDL_cond * cond)
+{
+    if (!cond) {
+        return SDL_SetError("Passed a NULL condition variable");
+    }
+
+    if (SDL_AtomicGet(&cond->waiters)) {
+        SDL_AtomicIncRef(&cond->sequence);
+        SDL_FutexWake(&cond->sequence, 1);
+    }
+    return 0;
+}
+
+/* Restart all threads that are waiting on the condition variable */
+int
+SDL_CondBroadcast(SDL_cond * cond)
+{
+    if (!cond) {
+        return SDL_SetError("Passed a NULL condition variable");
+    }
+
+    if (SDL_AtomicGet(&cond->waiters)) {
+        SDL_AtomicIncRef(&cond->sequence);
+        SDL_FutexWake(&cond->sequence, INT_MAX);
+    }
+    return 0;
+}
+
+int
+SDL_CondWaitTimeout(SDL_cond * cond, SDL_mutex * mutex, Uint32 ms)
+{
+    int sequence;
+    int retval;
+
+    if (!cond) {
+        return SDL_SetError("Passed a NULL condition variable");
+    } else if (!mutex) {
+        return SDL_SetError("Passed a NULL mutex");
+    }
+
+    /* Signalers normally hold the mutex, so they can't bump the sequence
+       before we've read it and counted ourselves in. */
+    sequence = SDL_AtomicGet(&cond->sequence);
+    SDL_AtomicIncRef(&cond->waiters);
+    if (SDL_UnlockMutex(mutex) < 0) {
+        SDL_AtomicAdd(&cond->waiters, -1);
+        return -1;
+    }
+
+    retval = SDL_FutexWait(&cond->sequence, sequence, ms);
+
+    SDL_AtomicAdd(&cond->waiters, -1);
+    SDL_LockMutex(mutex);
+    return retval;
+}
+
+/* Wait on the condition variable forever */
+int
+SDL_CondWait(SDL_cond * cond, SDL_mutex * mutex)
+{
+    return SDL_CondWaitTimeout(cond, mutex, SDL_MUTEX_MAXWAIT);
+}
+
+/* vi: set ts=4 sw=4 expandtab: */
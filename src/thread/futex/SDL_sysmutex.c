@@ -0,0 +1,151 @@
+/*
+  Simple DirectMedia Layer
+  Copyright (C) 1997-2019 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+#include "../../SDL_internal.h"
+
+/* Recursive mutexes on Linux futexes, after "Futexes Are Tricky" by Ulrich
+   Drepper: locking and unlocking an uncontended mutex is one atomic
+   operation each, and only a contended mutex makes system calls. */
+
+#include <pthread.h>
+
+#include "SDL_thread.h"
+#include "SDL_futex_c.h"
+
+/* How many times a locker checks a held mutex before going to sleep */
+#define FUTEX_MUTEX_SPINS 100
+
+struct SDL_mutex
+{
+    SDL_atomic_t state;  /* 0 unlocked, 1 locked, 2 locked with waiters */
+    pthread_t owner;
+    int recursive;
+};
+
+SDL_mutex *
+SDL_CreateMutex(void)
+{
+    SDL_mutex *mutex = (SDL_mutex *) SDL_calloc(1, sizeof(*mutex));
+    if (!mutex) {
+        SDL_OutOfMemory();
+    }
+    return mutex;
+}
+
+void
+SDL_DestroyMutex(SDL_mutex * mutex)
+{
+    SDL_free(mutex);
+}
+
+/* Lock the mutex */
+int
+SDL_LockMutex(SDL_mutex * mutex)
+{
+    pthread_t this_thread;
+    int i;
+
+    if (mutex == NULL) {
+        return SDL_SetError("Passed a NULL mutex");
+    }
+
+    this_thread = pthread_self();
+    if (mutex->owner == this_thread) {
+        ++mutex->recursive;
+        return 0;
+    }
+
+    if (!SDL_FutexCAS(&mutex->state, 0, 1)) {
+        /* Short holds are common, so give it a moment before sleeping */
+        for (i = 0; i < FUTEX_MUTEX_SPINS; ++i) {
+            if (!SDL_AtomicGet(&mutex->state) && SDL_FutexCAS(&mutex->state, 0, 1)) {
+                break;
+            }
+        }
+
+        if (i == FUTEX_MUTEX_SPINS) {
+            /* Mark it contended, so the unlock wakes somebody. We can't
+               know that we were the only waiter, so it stays marked
+               contended once we get it. */
+            while (SDL_FutexExchange(&mutex->state, 2) != 0) {
+                SDL_FutexWait(&mutex->state, 2, SDL_MUTEX_MAXWAIT);
+            }
+        }
+    }
+
+    /* The order of operations is important.
+       We set the locking thread id after we obtain the lock
+       so unlocks from other threads will fail.
+     */
+    mutex->owner = this_thread;
+    mutex->recursive = 0;
+    return 0;
+}
+
+int
+SDL_TryLockMutex(SDL_mutex * mutex)
+{
+    pthread_t this_thread;
+
+    if (mutex == NULL) {
+        return SDL_SetError("Passed a NULL mutex");
+    }
+
+    this_thread = pthread_self();
+    if (mutex->owner == this_thread) {
+        ++mutex->recursive;
+    } else if (SDL_FutexCAS(&mutex->state, 0, 1)) {
+        mutex->owner = this_thread;
+        mutex->recursive = 0;
+    } else {
+        return SDL_MUTEX_TIMEDOUT;
+    }
+    return 0;
+}
+
+int
+SDL_UnlockMutex(SDL_mutex * mutex)
+{
+    if (mutex == NULL) {
+        return SDL_SetError("Passed a NULL mutex");
+    }
+
+    /* We can only unlock the mutex if we own it */
+    if (mutex->owner != pthread_self()) {
+        return SDL_SetError("mutex not owned by this thread");
+    }
+
+    if (mutex->recursive) {
+        --mutex->recursive;
+    } else {
+        /* The order of operations is important.
+           First reset the owner so another thread doesn't lock
+           the mutex and set the ownership before we reset it,
+           then release the lock.
+         */
+        mutex->owner = 0;
+        if (SDL_FutexExchange(&mutex->state, 0) == 2) {
+            SDL_FutexWake(&mutex->state, 1);
+        }
+    }
+    return 0;
+}
+
+/* vi: set ts=4 sw=4 expandtab: */
@@ -0,0 +1,151 @@
+/*
+  Simple DirectMedia Layer
+  Copyright (C) 1997-2019 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+#include "../../SDL_internal.h"
+
+/* Semaphores on Linux futexes. The count lives in the futex word itself;
+   posting only makes a system call when somebody is waiting, and waiting
+   only makes one when the count is zero. */
+
+#include "SDL_thread.h"
+#include "SDL_timer.h"
+#include "SDL_futex_c.h"
+
+struct SDL_semaphore
+{
+    SDL_atomic_t count;
+    SDL_atomic_t waiters;
+};
+
+/* Create a semaphore, initialized with value */
+SDL_sem *
+SDL_CreateSemaphore(Uint32 initial_value)
+{
+    SDL_sem *sem = (SDL_sem *) SDL_calloc(1, sizeof(SDL_sem));
+    if (!sem) {
+        SDL_OutOfMemory();
+        return NULL;
+    }
+    SDL_AtomicSet(&sem->count, (int) initial_value);
+    return sem;
+}
+
+void
+SDL_DestroySemaphore(SDL_sem * sem)
+{
+    SDL_free(sem);
+}
+
+static SDL_bool
+SDL_SemTryDecrement(SDL_sem * sem)
+{
+    int count;
+
+    do {
+        count = SDL_AtomicGet(&sem->count);
+        if (count <= 0) {
+            return SDL_FALSE;
+        }
+    } while (!SDL_AtomicCAS(&sem->count, count, count - 1));
+    return SDL_TRUE;
+}
+
+int
+SDL_SemTryWait(SDL_sem * sem)
+{
+    if (!sem) {
+        return SDL_SetError("Passed a NULL semaphore");
+    }
+    return SDL_SemTryDecrement(sem) ? 0 : SDL_MUTEX_TIMEDOUT;
+}
+
+int
+SDL_SemWaitTimeout(SDL_sem * sem, Uint32 timeout)
+{
+    Uint32 start;
+    int retval;
+
+    if (!sem) {
+        return SDL_SetError("Passed a NULL semaphore");
+    }
+
+    /* Try the easy cases first */
+    if (SDL_SemTryDecrement(sem)) {
+        return 0;
+    } else if (timeout == 0) {
+        return SDL_MUTEX_TIMEDOUT;
+    }
+
+    /* Posters check for waiters after they add to the count, so either we
+       see what they added or they see us and wake us. */
+    start = SDL_GetTicks();
+    SDL_AtomicIncRef(&sem->waiters);
+    for ( ; ; ) {
+        Uint32 remaining = SDL_MUTEX_MAXWAIT;
+
+        if (SDL_SemTryDecrement(sem)) {
+            retval = 0;
+            break;
+        }
+        if (timeout != SDL_MUTEX_MAXWAIT) {
+            const Uint32 elapsed = SDL_GetTicks() - start;
+            if (elapsed >= timeout) {
+                retval = SDL_MUTEX_TIMEDOUT;
+                break;
+            }
+            remaining = timeout - elapsed;
+        }
+        SDL_FutexWait(&sem->count, 0, remaining);
+    }
+    SDL_AtomicAdd(&sem->waiters, -1);
+    return retval;
+}
+
+int
+SDL_SemWait(SDL_sem * sem)
+{
+    return SDL_SemWaitTimeout(sem, SDL_MUTEX_MAXWAIT);
+}
+
+Uint32
+SDL_SemValue(SDL_sem * sem)
+{
+    int count = 0;
+    if (sem) {
+        count = SDL_AtomicGet(&sem->count);
+    }
+    return (Uint32) SDL_max(count, 0);
+}
+
+int
+SDL_SemPost(SDL_sem * sem)
+{
+    if (!sem) {
+        return SDL_SetError("Passed a NULL semaphore");
+    }
+
+    SDL_AtomicIncRef(&sem->count);
+    if (SDL_AtomicGet(&sem->waiters)) {
+        SDL_FutexWake(&sem->count, 1);
+    }
+    return 0;
+}
+
+/* vi: set ts=4 sw=4 expandtab: */
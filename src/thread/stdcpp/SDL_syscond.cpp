@@ -46,7 +46,7 @@ SDL_CreateCond(void)
         SDL_cond * cond = new SDL_cond;
         return cond;
     } catch (std::system_error & ex) {
-        SDL_SetError("unable to create a C++ condition variable: code=%d; %s", ex.code(), ex.what());
+        SDL_SetError("unable to create a C++ condition variable: code=%d; %s", ex.code().value(), ex.what());
         return NULL;
     } catch (std::bad_alloc &) {
         SDL_OutOfMemory();
@@ -148,7 +148,7 @@ SDL_CondWaitTimeout(SDL_cond * cond, SDL_mutex * mutex, Uint32 ms)
             }
         }
     } catch (std::system_error & ex) {
-        SDL_SetError("unable to wait on a C++ condition variable: code=%d; %s", ex.code(), ex.what());
+        SDL_SetError("unable to wait on a C++ condition variable: code=%d; %s", ex.code().value(), ex.what());
         return -1;
     }
 }
@@ -29,7 +29,6 @@ extern "C" {
 #include <system_error>
 
 #include "SDL_sysmutex_c.h"
-#include <Windows.h>
 
 
 /* Create a mutex */
@@ -42,7 +41,7 @@ SDL_CreateMutex(void)
         SDL_mutex * mutex = new SDL_mutex;
         return mutex;
     } catch (std::system_error & ex) {
-        SDL_SetError("unable to create a C++ mutex: code=%d; %s", ex.code(), ex.what());
+        SDL_SetError("unable to create a C++ mutex: code=%d; %s", ex.code().value(), ex.what());
         return NULL;
     } catch (std::bad_alloc &) {
         SDL_OutOfMemory();
@@ -74,7 +73,7 @@ SDL_mutexP(SDL_mutex * mutex)
         mutex->cpp_mutex.lock();
         return 0;
     } catch (std::system_error & ex) {
-        SDL_SetError("unable to lock a C++ mutex: code=%d; %s", ex.code(), ex.what());
+        SDL_SetError("unable to lock a C++ mutex: code=%d; %s", ex.code().value(), ex.what());
         return -1;
     }
 }
@@ -0,0 +1,162 @@
+/*
+  Simple DirectMedia Layer
+  Copyright (C) 1997-2019 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+#include "../../SDL_internal.h"
+
+/* An implementation of semaphores using C++11 mutexes and condition variables */
+
+extern "C" {
+#include "SDL_thread.h"
+}
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <system_error>
+
+struct SDL_semaphore
+{
+    std::mutex cpp_mutex;
+    std::condition_variable cpp_cond;
+    Uint32 count;
+};
+
+/* Create a semaphore */
+extern "C"
+SDL_sem *
+SDL_CreateSemaphore(Uint32 initial_value)
+{
+    try {
+        SDL_sem * sem = new SDL_sem;
+        sem->count = initial_value;
+        return sem;
+    } catch (std::system_error & ex) {
+        SDL_SetError("unable to create a C++ semaphore: code=%d; %s", ex.code().value(), ex.what());
+        return NULL;
+    } catch (std::bad_alloc &) {
+        SDL_OutOfMemory();
+        return NULL;
+    }
+}
+
+/* Free the semaphore */
+extern "C"
+void
+SDL_DestroySemaphore(SDL_sem * sem)
+{
+    if (sem) {
+        delete sem;
+    }
+}
+
+extern "C"
+int
+SDL_SemTryWait(SDL_sem * sem)
+{
+    if (!sem) {
+        return SDL_SetError("Passed a NULL semaphore");
+    }
+
+    try {
+        std::lock_guard<std::mutex> cpp_lock(sem->cpp_mutex);
+        if (sem->count == 0) {
+            return SDL_MUTEX_TIMEDOUT;
+        }
+        --sem->count;
+        return 0;
+    } catch (std::system_error & ex) {
+        return SDL_SetError("unable to lock a C++ semaphore: code=%d; %s", ex.code().value(), ex.what());
+    }
+}
+
+extern "C"
+int
+SDL_SemWaitTimeout(SDL_sem * sem, Uint32 timeout)
+{
+    if (!sem) {
+        return SDL_SetError("Passed a NULL semaphore");
+    }
+
+    /* Try the easy cases first */
+    if (timeout == 0) {
+        return SDL_SemTryWait(sem);
+    }
+
+    try {
+        std::unique_lock<std::mutex> cpp_lock(sem->cpp_mutex);
+        if (timeout == SDL_MUTEX_MAXWAIT) {
+            sem->cpp_cond.wait(cpp_lock, [sem] { return sem->count > 0; });
+        } else if (!sem->cpp_cond.wait_for(cpp_lock, std::chrono::milliseconds(timeout),
+                                           [sem] { return sem->count > 0; })) {
+            return SDL_MUTEX_TIMEDOUT;
+        }
+        --sem->count;
+        return 0;
+    } catch (std::system_error & ex) {
+        return SDL_SetError("unable to wait on a C++ semaphore: code=%d; %s", ex.code().value(), ex.what());
+    }
+}
+
+extern "C"
+int
+SDL_SemWait(SDL_sem * sem)
+{
+    return SDL_SemWaitTimeout(sem, SDL_MUTEX_MAXWAIT);
+}
+
+/* Returns the current count of the semaphore */
+extern "C"
+Uint32
+SDL_SemValue(SDL_sem * sem)
+{
+    if (!sem) {
+        SDL_SetError("Passed a NULL semaphore");
+        return 0;
+    }
+
+    try {
+        std::lock_guard<std::mutex> cpp_lock(sem->cpp_mutex);
+        return sem->count;
+    } catch (std::system_error &) {
+        return 0;
+    }
+}
+
+extern "C"
+int
+SDL_SemPost(SDL_sem * sem)
+{
+    if (!sem) {
+        return SDL_SetError("Passed a NULL semaphore");
+    }
+
+    try {
+        {
+            std::lock_guard<std::mutex> cpp_lock(sem->cpp_mutex);
+            ++sem->count;
+        }
+        sem->cpp_cond.notify_one();
+        return 0;
+    } catch (std::system_error & ex) {
+        return SDL_SetError("unable to post a C++ semaphore: code=%d; %s", ex.code().value(), ex.what());
+    }
+}
+
+/* vi: set ts=4 sw=4 expandtab: */
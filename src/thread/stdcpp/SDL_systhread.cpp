@@ -33,8 +33,15 @@ extern "C" {
 #include <thread>
 #include <system_error>
 
-#ifdef __WINRT__
-#include <Windows.h>
+#if defined(_WIN32)
+#include <windows.h>
+#elif defined(__LINUX__)
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#elif defined(__unix__) || defined(__APPLE__)
+#include <pthread.h>
+#include <sched.h>
 #endif
 
 static void
@@ -53,7 +60,7 @@ SDL_SYS_CreateThread(SDL_Thread * thread, void *args)
         thread->handle = (void *) new std::thread(std::move(cpp_thread));
         return 0;
     } catch (std::system_error & ex) {
-        SDL_SetError("unable to start a C++ thread: code=%d; %s", ex.code(), ex.what());
+        SDL_SetError("unable to start a C++ thread: code=%d; %s", ex.code().value(), ex.what());
         return -1;
     } catch (std::bad_alloc &) {
         SDL_OutOfMemory();
@@ -74,7 +81,7 @@ extern "C"
 SDL_threadID
 SDL_ThreadID(void)
 {
-#ifdef __WINRT__
+#ifdef _WIN32
     return GetCurrentThreadId();
 #else
     // HACK: Mimick a thread ID, if one isn't otherwise available.
@@ -96,19 +103,80 @@ extern "C"
 int
 SDL_SYS_SetThreadPriority(SDL_ThreadPriority priority)
 {
-    // Thread priorities do not look to be settable via C++11's thread
-    // interface, at least as of this writing (Nov 2012).  std::thread does
-    // provide access to the OS' native handle, however, and some form of
-    // priority-setting could, in theory, be done through this interface.
-    //
-    // WinRT: UPDATE (Aug 20, 2013): thread priorities cannot be changed
-    // on WinRT, at least not for any thread that's already been created.
-    // WinRT threads appear to be based off of the WinRT class,
-    // ThreadPool, more info on which can be found at:
+    // C++11's thread interface has no notion of priorities, but the calling
+    // thread is an OS thread all the same, so ask the OS directly.
+#if defined(__WINRT__)
+    // WinRT: thread priorities cannot be changed on WinRT, at least not for
+    // any thread that's already been created.  WinRT threads appear to be
+    // based off of the WinRT class, ThreadPool, more info on which can be
+    // found at:
     // http://msdn.microsoft.com/en-us/library/windows/apps/windows.system.threading.threadpool.aspx
     //
     // For compatibility sake, 0 will be returned here.
-    return (0);
+    return 0;
+#elif defined(_WIN32)
+    int value;
+
+    if (priority == SDL_THREAD_PRIORITY_LOW) {
+        value = THREAD_PRIORITY_LOWEST;
+    } else if (priority == SDL_THREAD_PRIORITY_HIGH) {
+        value = THREAD_PRIORITY_HIGHEST;
+    } else if (priority == SDL_THREAD_PRIORITY_TIME_CRITICAL) {
+        value = THREAD_PRIORITY_TIME_CRITICAL;
+    } else {
+        value = THREAD_PRIORITY_NORMAL;
+    }
+    if (!SetThreadPriority(GetCurrentThread(), value)) {
+        return SDL_SetError("SetThreadPriority() failed");
+    }
+    return 0;
+#elif defined(__LINUX__)
+    int value;
+    pid_t thread = syscall(SYS_gettid);
+
+    if (priority == SDL_THREAD_PRIORITY_LOW) {
+        value = 19;
+    } else if (priority == SDL_THREAD_PRIORITY_HIGH) {
+        value = -10;
+    } else if (priority == SDL_THREAD_PRIORITY_TIME_CRITICAL) {
+        value = -20;
+    } else {
+        value = 0;
+    }
+    // Linux gives each thread its own nice value.
+    if (setpriority(PRIO_PROCESS, thread, value) < 0) {
+        return SDL_SetError("setpriority() failed");
+    }
+    return 0;
+#elif defined(__unix__) || defined(__APPLE__)
+    struct sched_param sched;
+    int policy;
+    pthread_t thread = pthread_self();
+
+    if (pthread_getschedparam(thread, &policy, &sched) != 0) {
+        return SDL_SetError("pthread_getschedparam() failed");
+    }
+    if (priority == SDL_THREAD_PRIORITY_LOW) {
+        sched.sched_priority = sched_get_priority_min(policy);
+    } else if (priority == SDL_THREAD_PRIORITY_TIME_CRITICAL) {
+        sched.sched_priority = sched_get_priority_max(policy);
+    } else {
+        int min_priority = sched_get_priority_min(policy);
+        int max_priority = sched_get_priority_max(policy);
+        sched.sched_priority = (min_priority + (max_priority - min_priority) / 2);
+        if (priority == SDL_THREAD_PRIORITY_HIGH) {
+            sched.sched_priority += ((max_priority - min_priority) / 4);
+        }
+    }
+    if (pthread_setschedparam(thread, policy, &sched) != 0) {
+        return SDL_SetError("pthread_setschedparam() failed");
+    }
+    return 0;
+#else
+    // No way to reach the OS thread from here, so for compatibility's
+    // sake pretend it worked.
+    return 0;
+#endif
 }
 
 extern "C"
@@ -124,6 +192,8 @@ SDL_SYS_WaitThread(SDL_Thread * thread)
         if (cpp_thread->joinable()) {
             cpp_thread->join();
         }
+        delete cpp_thread;
+        thread->handle = NULL;
     } catch (std::system_error &) {
         // An error occurred when joining the thread.  SDL_WaitThread does not,
         // however, seem to provide a means to report errors to its callers
@@ -144,6 +214,8 @@ SDL_SYS_DetachThread(SDL_Thread * thread)
         if (cpp_thread->joinable()) {
             cpp_thread->detach();
         }
+        delete cpp_thread;
+        thread->handle = NULL;
     } catch (std::system_error &) {
         // An error occurred when detaching the thread.  SDL_DetachThread does not,
         // however, seem to provide a means to report errors to its callers
@@ -151,18 +223,4 @@ SDL_SYS_DetachThread(SDL_Thread * thread)
     }
 }
 
-extern "C"
-SDL_TLSData *
-SDL_SYS_GetTLSData(void)
-{
-    return SDL_Generic_GetTLSData();
-}
-
-extern "C"
-int
-SDL_SYS_SetTLSData(SDL_TLSData *data)
-{
-    return SDL_Generic_SetTLSData(data);
-}
-
 /* vi: set ts=4 sw=4 expandtab: */
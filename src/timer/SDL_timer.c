@@ -24,7 +24,9 @@
 #include "SDL_timer_c.h"
 #include "SDL_atomic.h"
 #include "SDL_cpuinfo.h"
+#include "SDL_log.h"
 #include "../thread/SDL_systhread.h"
+#include "../atomic/SDL_spinlock_c.h"
 
 /* #define DEBUG_TIMERS */
 
@@ -36,7 +38,7 @@ typedef struct _SDL_Timer
     Uint32 interval;
     Uint32 scheduled;
     SDL_atomic_t canceled;
-    struct _SDL_Timer *next;
+    struct _SDL_Timer *next;    /* for the pending list and the freelist */
 } SDL_Timer;
 
 typedef struct _SDL_TimerMap
@@ -46,26 +48,35 @@ typedef struct _SDL_TimerMap
     struct _SDL_TimerMap *next;
 } SDL_TimerMap;
 
-/* The timers are kept in a sorted list */
+/* Timer IDs are handed out in order, so masking off the low bits of the ID
+   spreads them evenly over the hash buckets. */
+#define SDL_TIMERMAP_MIN_SIZE 64
+
+/* The timers are kept in a binary heap, ordered by scheduling time */
 typedef struct {
     /* Data used by the main thread */
     SDL_Thread *thread;
     SDL_atomic_t nextID;
-    SDL_TimerMap *timermap;
+    SDL_TimerMap **timermap;
+    int timermap_size;
+    int timermap_count;
     SDL_mutex *timermap_lock;
 
     /* Padding to separate cache lines between threads */
     char cache_pad[SDL_CACHELINE_SIZE];
 
-    /* Data used to communicate with the timer thread */
-    SDL_SpinLock lock;
+    /* Data used to communicate with the timer thread. The lock is fair, so
+       busy threads adding timers can't keep the timer thread out. */
+    SDL_TicketLock lock;
     SDL_sem *sem;
     SDL_Timer *pending;
     SDL_Timer *freelist;
     SDL_atomic_t active;
 
-    /* List of timers - this is only touched by the timer thread */
-    SDL_Timer *timers;
+    /* Heap of timers - this is only touched by the timer thread */
+    SDL_Timer **timers;
+    int num_timers;
+    int max_timers;
 } SDL_TimerData;
 
 static SDL_TimerData SDL_timer_data;
@@ -76,25 +87,65 @@ static SDL_TimerData SDL_timer_data;
  * Timers are removed by simply setting a canceled flag
  */
 
-static void
+#define SDL_TIMER_BEFORE(a, b) ((Sint32)((a)->scheduled - (b)->scheduled) < 0)
+
+static int
 SDL_AddTimerInternal(SDL_TimerData *data, SDL_Timer *timer)
 {
-    SDL_Timer *prev, *curr;
+    SDL_Timer **timers;
+    int i;
 
-    prev = NULL;
-    for (curr = data->timers; curr; prev = curr, curr = curr->next) {
-        if ((Sint32)(timer->scheduled-curr->scheduled) < 0) {
+    if (data->num_timers == data->max_timers) {
+        const int max_timers = data->max_timers ? (data->max_timers * 2) : 64;
+        timers = (SDL_Timer **)SDL_realloc(data->timers, max_timers * sizeof(*timers));
+        if (!timers) {
+            return -1;
+        }
+        data->timers = timers;
+        data->max_timers = max_timers;
+    }
+
+    /* Sift the new timer up from the bottom of the heap */
+    timers = data->timers;
+    i = data->num_timers++;
+    while (i > 0) {
+        const int parent = (i - 1) / 2;
+        if (!SDL_TIMER_BEFORE(timer, timers[parent])) {
             break;
         }
+        timers[i] = timers[parent];
+        i = parent;
     }
+    timers[i] = timer;
+    return 0;
+}
 
-    /* Insert the timer here! */
-    if (prev) {
-        prev->next = timer;
-    } else {
-        data->timers = timer;
+static SDL_Timer *
+SDL_RemoveFirstTimer(SDL_TimerData *data)
+{
+    SDL_Timer **timers = data->timers;
+    SDL_Timer *first = timers[0];
+    SDL_Timer *last = timers[--data->num_timers];
+    const int num_timers = data->num_timers;
+    int i = 0;
+
+    /* Sift the last timer down from the top of the heap */
+    for ( ; ; ) {
+        int child = (i * 2) + 1;
+        if (child >= num_timers) {
+            break;
+        }
+        if ((child + 1 < num_timers) && SDL_TIMER_BEFORE(timers[child + 1], timers[child])) {
+            ++child;
+        }
+        if (!SDL_TIMER_BEFORE(timers[child], last)) {
+            break;
+        }
+        timers[i] = timers[child];
+        i = child;
     }
-    timer->next = curr;
+    timers[i] = last;
+    return first;
 }
 
 static int SDLCALL
@@ -114,7 +165,7 @@ SDL_TimerThread(void *_data)
      */
     for ( ; ; ) {
         /* Pending and freelist maintenance */
-        SDL_AtomicLock(&data->lock);
+        SDL_AtomicLockTicket(&data->lock);
         {
             /* Get any timers ready to be queued */
             pending = data->pending;
@@ -126,13 +177,28 @@ SDL_TimerThread(void *_data)
                 data->freelist = freelist_head;
             }
         }
-        SDL_AtomicUnlock(&data->lock);
+        SDL_AtomicUnlockTicket(&data->lock);
 
-        /* Sort the pending timers into our list */
+        /* Sort the pending timers into our heap */
         while (pending) {
             current = pending;
             pending = pending->next;
-            SDL_AddTimerInternal(data, current);
+            if (SDL_AddTimerInternal(data, current) < 0) {
+                /* Out of memory, hand them back and try again later */
+                current->next = pending;
+                pending = current;
+                break;
+            }
+        }
+        if (pending) {
+            current = pending;
+            while (current->next) {
+                current = current->next;
+            }
+            SDL_AtomicLockTicket(&data->lock);
+            current->next = data->pending;
+            data->pending = pending;
+            SDL_AtomicUnlockTicket(&data->lock);
         }
         freelist_head = NULL;
         freelist_tail = NULL;
@@ -143,22 +209,22 @@ SDL_TimerThread(void *_data)
         }
 
         /* Initial delay if there are no timers */
-        delay = SDL_MUTEX_MAXWAIT;
+        delay = pending ? 1 : SDL_MUTEX_MAXWAIT;
 
         tick = SDL_GetTicks();
 
         /* Process all the pending timers for this tick */
-        while (data->timers) {
-            current = data->timers;
+        while (data->num_timers) {
+            current = data->timers[0];
 
             if ((Sint32)(tick-current->scheduled) < 0) {
                 /* Scheduled for the future, wait a bit */
-                delay = (current->scheduled - tick);
+                delay = SDL_min(delay, current->scheduled - tick);
                 break;
             }
 
             /* We're going to do something with this timer */
-            data->timers = current->next;
+            SDL_RemoveFirstTimer(data);
 
             if (SDL_AtomicGet(&current->canceled)) {
                 interval = 0;
@@ -167,7 +233,8 @@ SDL_TimerThread(void *_data)
             }
 
             if (interval > 0) {
-                /* Reschedule this timer */
+                /* Reschedule this timer, there's always room for it since
+                   it was just taken out of the heap */
                 current->interval = interval;
                 current->scheduled = tick + interval;
                 SDL_AddTimerInternal(data, current);
@@ -241,6 +308,7 @@ SDL_TimerQuit(void)
     SDL_TimerData *data = &SDL_timer_data;
     SDL_Timer *timer;
     SDL_TimerMap *entry;
+    int i;
 
     if (SDL_AtomicCAS(&data->active, 1, 0)) {  /* active? Move to inactive. */
         /* Shutdown the timer thread */
@@ -253,10 +321,26 @@ SDL_TimerQuit(void)
         SDL_DestroySemaphore(data->sem);
         data->sem = NULL;
 
+#ifdef SDL_SPINLOCK_STATS
+        {
+            SDL_TicketLockStats stats;
+            SDL_GetTicketLockStats(&data->lock, &stats);
+            SDL_Log("Timer lock: %u locks, %u contended, %u spins, %u yields, held at most %u us",
+                    stats.locks, stats.contended, stats.spins, stats.yields,
+                    (unsigned int) ((stats.max_hold * 1000000) / SDL_GetPerformanceFrequency()));
+        }
+#endif
+
         /* Clean up the timer entries */
-        while (data->timers) {
-            timer = data->timers;
-            data->timers = timer->next;
+        for (i = 0; i < data->num_timers; ++i) {
+            SDL_free(data->timers[i]);
+        }
+        SDL_free(data->timers);
+        data->timers = NULL;
+        data->num_timers = data->max_timers = 0;
+        while (data->pending) {
+            timer = data->pending;
+            data->pending = timer->next;
             SDL_free(timer);
         }
         while (data->freelist) {
@@ -264,28 +348,59 @@ SDL_TimerQuit(void)
             data->freelist = timer->next;
             SDL_free(timer);
         }
-        while (data->timermap) {
-            entry = data->timermap;
-            data->timermap = entry->next;
-            SDL_free(entry);
+        for (i = 0; i < data->timermap_size; ++i) {
+            while (data->timermap[i]) {
+                entry = data->timermap[i];
+                data->timermap[i] = entry->next;
+                SDL_free(entry);
+            }
         }
+        SDL_free(data->timermap);
+        data->timermap = NULL;
+        data->timermap_size = data->timermap_count = 0;
 
         SDL_DestroyMutex(data->timermap_lock);
         data->timermap_lock = NULL;
     }
 }
 
+/* Double the number of hash buckets, called with the timermap lock held.
+   If that fails the old buckets are kept, they just get longer chains. */
+static void
+SDL_GrowTimerMap(SDL_TimerData *data)
+{
+    const int size = data->timermap_size ? (data->timermap_size * 2) : SDL_TIMERMAP_MIN_SIZE;
+    SDL_TimerMap **timermap = (SDL_TimerMap **)SDL_calloc(size, sizeof(*timermap));
+    int i;
+
+    if (!timermap) {
+        return;
+    }
+
+    for (i = 0; i < data->timermap_size; ++i) {
+        while (data->timermap[i]) {
+            SDL_TimerMap *entry = data->timermap[i];
+            data->timermap[i] = entry->next;
+            entry->next = timermap[entry->timerID & (size - 1)];
+            timermap[entry->timerID & (size - 1)] = entry;
+        }
+    }
+    SDL_free(data->timermap);
+    data->timermap = timermap;
+    data->timermap_size = size;
+}
+
 SDL_TimerID
 SDL_AddTimer(Uint32 interval, SDL_TimerCallback callback, void *param)
 {
     SDL_TimerData *data = &SDL_timer_data;
     SDL_Timer *timer;
-    SDL_TimerMap *entry;
+    SDL_TimerMap *entry, **bucket;
 
-    SDL_AtomicLock(&data->lock);
+    SDL_AtomicLockTicket(&data->lock);
     if (!SDL_AtomicGet(&data->active)) {
         if (SDL_TimerInit() < 0) {
-            SDL_AtomicUnlock(&data->lock);
+            SDL_AtomicUnlockTicket(&data->lock);
             return 0;
         }
     }
@@ -294,7 +409,7 @@ SDL_AddTimer(Uint32 interval, SDL_TimerCallback callback, void *param)
     if (timer) {
         data->freelist = timer->next;
     }
-    SDL_AtomicUnlock(&data->lock);
+    SDL_AtomicUnlockTicket(&data->lock);
 
     if (timer) {
         SDL_RemoveTimer(timer->timerID);
@@ -322,15 +437,27 @@ SDL_AddTimer(Uint32 interval, SDL_TimerCallback callback, void *param)
     entry->timerID = timer->timerID;
 
     SDL_LockMutex(data->timermap_lock);
-    entry->next = data->timermap;
-    data->timermap = entry;
+    if (data->timermap_count >= data->timermap_size) {
+        SDL_GrowTimerMap(data);
+    }
+    if (!data->timermap) {
+        SDL_UnlockMutex(data->timermap_lock);
+        SDL_free(entry);
+        SDL_free(timer);
+        SDL_OutOfMemory();
+        return 0;
+    }
+    bucket = &data->timermap[entry->timerID & (data->timermap_size - 1)];
+    entry->next = *bucket;
+    *bucket = entry;
+    ++data->timermap_count;
     SDL_UnlockMutex(data->timermap_lock);
 
     /* Add the timer to the pending list for the timer thread */
-    SDL_AtomicLock(&data->lock);
+    SDL_AtomicLockTicket(&data->lock);
     timer->next = data->pending;
     data->pending = timer;
-    SDL_AtomicUnlock(&data->lock);
+    SDL_AtomicUnlockTicket(&data->lock);
 
     /* Wake up the timer thread if necessary */
     SDL_SemPost(data->sem);
@@ -348,14 +475,19 @@ SDL_RemoveTimer(SDL_TimerID id)
     /* Find the timer */
     SDL_LockMutex(data->timermap_lock);
     prev = NULL;
-    for (entry = data->timermap; entry; prev = entry, entry = entry->next) {
-        if (entry->timerID == id) {
-            if (prev) {
-                prev->next = entry->next;
-            } else {
-                data->timermap = entry->next;
+    entry = NULL;
+    if (data->timermap) {
+        SDL_TimerMap **bucket = &data->timermap[id & (data->timermap_size - 1)];
+        for (entry = *bucket; entry; prev = entry, entry = entry->next) {
+            if (entry->timerID == id) {
+                if (prev) {
+                    prev->next = entry->next;
+                } else {
+                    *bucket = entry->next;
+                }
+                --data->timermap_count;
+                break;
             }
-            break;
         }
     }
     SDL_UnlockMutex(data->timermap_lock);
@@ -0,0 +1,230 @@
+/*
+  Simple DirectMedia Layer
+  Copyright (C) 1997-2019 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+#include "../../SDL_internal.h"
+
+#ifdef SDL_TIMER_RDTSC
+
+/* Ticks for targets without an OS clock, taken from the CPU's time stamp
+   counter. Its rate is either given at build time with
+   SDL_TIMER_RDTSC_FREQUENCY (in Hz) or measured against the C library's
+   clock when ticks start. Nothing here needs threads, so this works with
+   SDL_TIMERS_DISABLED and SDL_THREADS_DISABLED. */
+
+#include "SDL_timer.h"
+#include "SDL_cpuinfo.h"
+
+#if HAVE_LIBC
+#include <time.h>
+#endif
+#if HAVE_NANOSLEEP
+#include <errno.h>
+#elif defined(XBOX)
+#include <xboxkrnl/xboxkrnl.h>
+#elif defined(_WIN32)
+#include "../../core/windows/SDL_windows.h"
+#endif
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+static SDL_INLINE Uint64
+ReadTSC(void)
+{
+    Uint32 lo, hi;
+    __asm__ __volatile__ ("rdtsc" : "=a" (lo), "=d" (hi));
+    return (((Uint64) hi) << 32) | lo;
+}
+#define PauseCPU() __asm__ __volatile__ ("rep; nop")
+#elif defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#include <intrin.h>
+#define ReadTSC() __rdtsc()
+#define PauseCPU() _mm_pause()
+#else
+#error SDL_TIMER_RDTSC needs an x86 compiler
+#endif
+
+/* How long to measure the counter for when its rate isn't known. */
+#define RDTSC_CALIBRATE_MS 50
+
+static SDL_bool ticks_started = SDL_FALSE;
+static Uint64 start_tsc;
+static Uint64 tsc_freq;  /* 0 if we have no usable counter. */
+
+#if defined(SDL_TIMER_RDTSC_FREQUENCY)
+static Uint64
+CalibrateTSC(void)
+{
+    return SDL_TIMER_RDTSC_FREQUENCY;
+}
+#elif HAVE_CLOCK_GETTIME
+static Uint64
+CalibrateTSC(void)
+{
+    struct timespec now;
+    Uint64 start_ns, ns, tsc;
+
+    if (clock_gettime(CLOCK_MONOTONIC, &now) != 0) {
+        return 0;
+    }
+    tsc = ReadTSC();
+    start_ns = (((Uint64) now.tv_sec) * 1000000000) + now.tv_nsec;
+    do {
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        ns = (((Uint64) now.tv_sec) * 1000000000) + now.tv_nsec;
+    } while ((ns - start_ns) < (RDTSC_CALIBRATE_MS * 1000000));
+
+    return ((ReadTSC() - tsc) * 1000000000) / (ns - start_ns);
+}
+#elif HAVE_LIBC
+static Uint64
+CalibrateTSC(void)
+{
+    const clock_t duration = (CLOCKS_PER_SEC * RDTSC_CALIBRATE_MS) / 1000;
+    clock_t start, now;
+    Uint64 tsc;
+
+    start = clock();
+    if (start == (clock_t) -1) {
+        return 0;
+    }
+
+    /* clock() can be coarse, so measure from one of its edges to another. */
+    while ((now = clock()) == start) {
+        /* spin. */
+    }
+    start = now;
+    tsc = ReadTSC();
+    do {
+        now = clock();
+    } while ((now - start) < duration);
+
+    return ((ReadTSC() - tsc) * CLOCKS_PER_SEC) / (Uint64) (now - start);
+}
+#else
+static Uint64
+CalibrateTSC(void)
+{
+    return 0;  /* nothing to measure against. */
+}
+#endif
+
+void
+SDL_TicksInit(void)
+{
+    if (ticks_started) {
+        return;
+    }
+    ticks_started = SDL_TRUE;
+
+    /* Executing RDTSC on a CPU without it would fault, so ask first. */
+    tsc_freq = SDL_HasRDTSC() ? CalibrateTSC() : 0;
+    start_tsc = tsc_freq ? ReadTSC() : 0;
+}
+
+void
+SDL_TicksQuit(void)
+{
+    ticks_started = SDL_FALSE;
+}
+
+Uint32
+SDL_GetTicks(void)
+{
+    Uint64 elapsed;
+
+    if (!ticks_started) {
+        SDL_TicksInit();
+    }
+
+    if (!tsc_freq) {
+        SDL_Unsupported();
+        return 0;
+    }
+
+    /* Split the division so long uptimes can't overflow. */
+    elapsed = ReadTSC() - start_tsc;
+    return (Uint32) (((elapsed / tsc_freq) * 1000) + (((elapsed % tsc_freq) * 1000) / tsc_freq));
+}
+
+Uint64
+SDL_GetPerformanceCounter(void)
+{
+    if (!ticks_started) {
+        SDL_TicksInit();
+    }
+    return tsc_freq ? ReadTSC() : SDL_GetTicks();
+}
+
+Uint64
+SDL_GetPerformanceFrequency(void)
+{
+    if (!ticks_started) {
+        SDL_TicksInit();
+    }
+    return tsc_freq ? tsc_freq : 1000;
+}
+
+void
+SDL_Delay(Uint32 ms)
+{
+#if HAVE_NANOSLEEP
+    struct timespec elapsed, tv;
+    int was_error;
+
+    elapsed.tv_sec = ms / 1000;
+    elapsed.tv_nsec = (ms % 1000) * 1000000;
+    do {
+        errno = 0;
+        tv.tv_sec = elapsed.tv_sec;
+        tv.tv_nsec = elapsed.tv_nsec;
+        was_error = nanosleep(&tv, &elapsed);
+    } while (was_error && (errno == EINTR));
+#elif defined(XBOX)
+    LARGE_INTEGER interval;
+
+    /* Negative intervals are relative, in 100 ns units. */
+    interval.QuadPart = -((LONGLONG) ms * 10000);
+    KeDelayExecutionThread(UserMode, FALSE, &interval);
+#elif defined(_WIN32)
+    Sleep(ms);
+#else
+    Uint64 start, cycles;
+
+    if (!ticks_started) {
+        SDL_TicksInit();
+    }
+
+    if (!tsc_freq) {
+        SDL_Unsupported();
+        return;
+    }
+
+    /* Without an OS to sleep in there's nothing to block on, so the best
+       we can do is tell the core we're spinning while the counter runs. */
+    start = ReadTSC();
+    cycles = (tsc_freq / 1000) * ms;
+    while ((ReadTSC() - start) < cycles) {
+        PauseCPU();
+    }
+#endif
+}
+
+#endif /* SDL_TIMER_RDTSC */
+
+/* vi: set ts=4 sw=4 expandtab: */
@@ -86,9 +86,11 @@
  */
 
 #include "SDL_video.h"
+#include "SDL_cpuinfo.h"
 #include "SDL_sysvideo.h"
 #include "SDL_blit.h"
 #include "SDL_RLEaccel_c.h"
+#include "SDL_pixelpool_c.h"
 #include "../cpuinfo/SDL_simd.h"
 
 #ifndef MIN
@@ -558,6 +560,90 @@ SDL_RLEBlit(SDL_Surface * surf_src, SDL_Rect * srcrect,
     return (0);
 }
 
+/*
+ * Scaled blitting: destination column i samples source column
+ * srcrect->x + ((i * incx) >> 16), and likewise for rows, the same
+ * nearest-neighbour mapping as the generic scaling blitters. Each source
+ * run is mapped to the span of destination columns that sample it.
+ */
+
+/* the first destination column sampling source column col or later */
+static int
+RLEScaledColumn(int col, int x, Uint32 incx, int w)
+{
+    Uint32 i;
+
+    if (col <= x) {
+        return 0;
+    }
+    i = (((Uint32) (col - x) << 16) + incx - 1) / incx;
+    return (i < (Uint32) w) ? (int) i : w;
+}
+
+/* blit a colorkeyed RLE surface scaled from srcrect to dstrect */
+static void
+RLEScaledBlit(int w, Uint8 * srcbuf, SDL_Surface * surf_dst,
+              Uint8 * dstbuf, SDL_Rect * srcrect, SDL_Rect * dstrect,
+              unsigned alpha)
+{
+    SDL_PixelFormat *fmt = surf_dst->format;
+    const Uint32 incx = ((Uint32) srcrect->w << 16) / dstrect->w;
+    const Uint32 incy = ((Uint32) srcrect->h << 16) / dstrect->h;
+
+#define RLESCALEDBLIT(bpp, Type, do_blit)                       \
+    do {                                                        \
+        int y = 0;                                              \
+        int dy;                                                 \
+        for (dy = 0; dy < dstrect->h; dy++) {                   \
+            int sy = srcrect->y + (int)(((Uint32)dy * incy) >> 16); \
+            Uint8 *line;                                        \
+            int ofs = 0;                                        \
+            /* move on to the source line for this row */       \
+            while (y < sy) {                                    \
+                int run;                                        \
+                ofs += *(Type *)srcbuf;                         \
+                run = ((Type *)srcbuf)[1];                      \
+                srcbuf += 2 * sizeof(Type);                     \
+                if (run) {                                      \
+                    srcbuf += run * bpp;                        \
+                    ofs += run;                                 \
+                } else if (!ofs)                                \
+                    return;                                     \
+                if (ofs == w) {                                 \
+                    ofs = 0;                                    \
+                    y++;                                        \
+                }                                               \
+            }                                                   \
+            line = srcbuf;                                      \
+            for (;;) {                                          \
+                int run;                                        \
+                ofs += *(Type *)line;                           \
+                run = ((Type *)line)[1];                        \
+                line += 2 * sizeof(Type);                       \
+                if (run) {                                      \
+                    int dx = RLEScaledColumn(ofs, srcrect->x, incx, dstrect->w); \
+                    int dxend = RLEScaledColumn(ofs + run, srcrect->x, incx, dstrect->w); \
+                    Uint32 pos = (Uint32)dx * incx;             \
+                    for (; dx < dxend; dx++, pos += incx) {     \
+                        int col = srcrect->x + (int)(pos >> 16) - ofs; \
+                        do_blit(dstbuf + dx * bpp, line + col * bpp, 1, bpp, alpha); \
+                    }                                           \
+                    line += run * bpp;                          \
+                    ofs += run;                                 \
+                } else if (!ofs)                                \
+                    return;                                     \
+                if (ofs == w)                                   \
+                    break;                                      \
+            }                                                   \
+            dstbuf += surf_dst->pitch;                          \
+        }                                                       \
+    } while(0)
+
+    CHOOSE_BLIT(RLESCALEDBLIT, alpha, fmt);
+
+#undef RLESCALEDBLIT
+}
+
 #undef OPAQUE_BLIT
 
 /*
@@ -611,6 +697,70 @@ SDL_RLEBlit(SDL_Surface * surf_src, SDL_Rect * srcrect,
     dst = (Uint16)(d | d >> 16);            \
     } while(0)
 
+/*
+ * Blend a run of translucent pixels. These are what the per-pixel alpha
+ * blitters below call for each translucent run.
+ */
+static void
+BlitTranslRun888(Uint32 * dst, const Uint32 * src, unsigned n)
+{
+    unsigned i;
+    for (i = 0; i < n; i++)
+        BLIT_TRANSL_888(src[i], dst[i]);
+}
+
+#ifdef __SSE2__
+/*
+ * Four pixels at a time in 16-bit lanes. Each component of the macro above
+ * works out to (d * (256 - alpha) + s * alpha) >> 8, which can't overflow
+ * a 16-bit lane, so this gives exactly the same results.
+ */
+static void
+BlitTranslRun888_SSE2(Uint32 * dst, const Uint32 * src, unsigned n)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i c256 = _mm_set1_epi16(256);
+    const __m128i amask = _mm_set1_epi32(0xff000000);
+
+    for (; n >= 4; n -= 4) {
+        __m128i s = _mm_loadu_si128((const __m128i *) src);
+        __m128i d = _mm_loadu_si128((const __m128i *) dst);
+        __m128i slo = _mm_unpacklo_epi8(s, zero);
+        __m128i shi = _mm_unpackhi_epi8(s, zero);
+        __m128i dlo = _mm_unpacklo_epi8(d, zero);
+        __m128i dhi = _mm_unpackhi_epi8(d, zero);
+        __m128i alo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(slo, 0xff), 0xff);
+        __m128i ahi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(shi, 0xff), 0xff);
+
+        dlo = _mm_add_epi16(_mm_mullo_epi16(slo, alo),
+                            _mm_mullo_epi16(dlo, _mm_sub_epi16(c256, alo)));
+        dhi = _mm_add_epi16(_mm_mullo_epi16(shi, ahi),
+                            _mm_mullo_epi16(dhi, _mm_sub_epi16(c256, ahi)));
+        d = _mm_packus_epi16(_mm_srli_epi16(dlo, 8), _mm_srli_epi16(dhi, 8));
+        _mm_storeu_si128((__m128i *) dst, _mm_or_si128(d, amask));
+        src += 4;
+        dst += 4;
+    }
+    BlitTranslRun888(dst, src, n);
+}
+#endif /* __SSE2__ */
+
+static void
+BlitTranslRun565(Uint16 * dst, const Uint32 * src, unsigned n)
+{
+    unsigned i;
+    for (i = 0; i < n; i++)
+        BLIT_TRANSL_565(src[i], dst[i]);
+}
+
+static void
+BlitTranslRun555(Uint16 * dst, const Uint32 * src, unsigned n)
+{
+    unsigned i;
+    for (i = 0; i < n; i++)
+        BLIT_TRANSL_555(src[i], dst[i]);
+}
+
 /* used to save the destination format in the encoding. Designed to be
    macro-compatible with SDL_PixelFormat but without the unneeded fields */
 typedef struct
@@ -639,10 +789,10 @@ RLEAlphaClipBlit(int w, Uint8 * srcbuf, SDL_Surface * surf_dst,
     SDL_PixelFormat *df = surf_dst->format;
     /*
      * clipped blitter: Ptype is the destination pixel type,
-     * Ctype the translucent count type, and do_blend the macro
-     * to blend one pixel.
+     * Ctype the translucent count type, and blend_run the function
+     * to blend a run of pixels.
      */
-#define RLEALPHACLIPBLIT(Ptype, Ctype, do_blend)              \
+#define RLEALPHACLIPBLIT(Ptype, Ctype, blend_run)             \
     do {                                  \
     int linecount = srcrect->h;                   \
     int left = srcrect->x;                        \
@@ -695,13 +845,9 @@ RLEAlphaClipBlit(int w, Uint8 * srcbuf, SDL_Surface * surf_dst,
             }                             \
             if(crun > right - cofs)               \
             crun = right - cofs;                  \
-            if(crun > 0) {                    \
-            Ptype *dst = (Ptype *)dstbuf + cofs;          \
-            Uint32 *src = (Uint32 *)srcbuf + (cofs - ofs);    \
-            int i;                        \
-            for(i = 0; i < crun; i++)             \
-                do_blend(src[i], dst[i]);             \
-            }                             \
+            if(crun > 0)                      \
+            blend_run((Ptype *)dstbuf + cofs,             \
+                  (Uint32 *)srcbuf + (cofs - ofs), crun); \
             srcbuf += run * 4;                    \
             ofs += run;                       \
         }                             \
@@ -713,12 +859,18 @@ RLEAlphaClipBlit(int w, Uint8 * srcbuf, SDL_Surface * surf_dst,
     switch (df->BytesPerPixel) {
     case 2:
         if (df->Gmask == 0x07e0 || df->Rmask == 0x07e0 || df->Bmask == 0x07e0)
-            RLEALPHACLIPBLIT(Uint16, Uint8, BLIT_TRANSL_565);
+            RLEALPHACLIPBLIT(Uint16, Uint8, BlitTranslRun565);
         else
-            RLEALPHACLIPBLIT(Uint16, Uint8, BLIT_TRANSL_555);
+            RLEALPHACLIPBLIT(Uint16, Uint8, BlitTranslRun555);
         break;
     case 4:
-        RLEALPHACLIPBLIT(Uint32, Uint16, BLIT_TRANSL_888);
+#ifdef __SSE2__
+        if (SDL_HasSSE2()) {
+            RLEALPHACLIPBLIT(Uint32, Uint16, BlitTranslRun888_SSE2);
+            break;
+        }
+#endif
+        RLEALPHACLIPBLIT(Uint32, Uint16, BlitTranslRun888);
         break;
     }
 }
@@ -808,10 +960,10 @@ SDL_RLEAlphaBlit(SDL_Surface * surf_src, SDL_Rect * srcrect,
 
         /*
          * non-clipped blitter. Ptype is the destination pixel type,
-         * Ctype the translucent count type, and do_blend the
-         * macro to blend one pixel.
+         * Ctype the translucent count type, and blend_run the
+         * function to blend a run of pixels.
          */
-#define RLEALPHABLIT(Ptype, Ctype, do_blend)                 \
+#define RLEALPHABLIT(Ptype, Ctype, blend_run)                \
     do {                                 \
         int linecount = srcrect->h;                  \
         do {                             \
@@ -841,14 +993,8 @@ SDL_RLEAlphaBlit(SDL_Surface * surf_src, SDL_Rect * srcrect,
             run = ((Uint16 *)srcbuf)[1];             \
             srcbuf += 4;                     \
             if(run) {                        \
-            Ptype *dst = (Ptype *)dstbuf + ofs;      \
-            unsigned i;                  \
-            for(i = 0; i < run; i++) {           \
-                Uint32 src = *(Uint32 *)srcbuf;      \
-                do_blend(src, *dst);             \
-                srcbuf += 4;                 \
-                dst++;                   \
-            }                        \
+            blend_run((Ptype *)dstbuf + ofs, (Uint32 *)srcbuf, run); \
+            srcbuf += run * 4;               \
             ofs += run;                  \
             }                            \
         } while(ofs < w);                    \
@@ -860,12 +1006,18 @@ SDL_RLEAlphaBlit(SDL_Surface * surf_src, SDL_Rect * srcrect,
         case 2:
             if (df->Gmask == 0x07e0 || df->Rmask == 0x07e0
                 || df->Bmask == 0x07e0)
-                RLEALPHABLIT(Uint16, Uint8, BLIT_TRANSL_565);
+                RLEALPHABLIT(Uint16, Uint8, BlitTranslRun565);
             else
-                RLEALPHABLIT(Uint16, Uint8, BLIT_TRANSL_555);
+                RLEALPHABLIT(Uint16, Uint8, BlitTranslRun555);
             break;
         case 4:
-            RLEALPHABLIT(Uint32, Uint16, BLIT_TRANSL_888);
+#ifdef __SSE2__
+            if (SDL_HasSSE2()) {
+                RLEALPHABLIT(Uint32, Uint16, BlitTranslRun888_SSE2);
+                break;
+            }
+#endif
+            RLEALPHABLIT(Uint32, Uint16, BlitTranslRun888);
             break;
         }
     }
@@ -878,6 +1030,147 @@ SDL_RLEAlphaBlit(SDL_Surface * surf_src, SDL_Rect * srcrect,
     return 0;
 }
 
+/* blit a pixel-alpha RLE surface scaled from srcrect to dstrect */
+static void
+RLEAlphaScaledBlit(int w, Uint8 * srcbuf, SDL_Surface * surf_dst,
+                   Uint8 * dstbuf, SDL_Rect * srcrect, SDL_Rect * dstrect)
+{
+    SDL_PixelFormat *df = surf_dst->format;
+    const Uint32 incx = ((Uint32) srcrect->w << 16) / dstrect->w;
+    const Uint32 incy = ((Uint32) srcrect->h << 16) / dstrect->h;
+
+    /*
+     * scaled blitter: Ptype is the destination pixel type,
+     * Ctype the translucent count type, and do_blend the macro
+     * to blend one pixel.
+     */
+#define RLEALPHASCALEDBLIT(Ptype, Ctype, do_blend)                  \
+    do {                                                            \
+        int y = 0;                                                  \
+        int dy;                                                     \
+        for (dy = 0; dy < dstrect->h; dy++) {                       \
+            int sy = srcrect->y + (int)(((Uint32)dy * incy) >> 16); \
+            Ptype *row = (Ptype *)dstbuf;                           \
+            Uint8 *line;                                            \
+            int ofs;                                                \
+            /* move on to the source line for this row */           \
+            for (; y < sy; y++) {                                   \
+                ofs = 0;                                            \
+                do {                                                \
+                    int run;                                        \
+                    ofs += ((Ctype *)srcbuf)[0];                    \
+                    run = ((Ctype *)srcbuf)[1];                     \
+                    srcbuf += 2 * sizeof(Ctype);                    \
+                    if (run) {                                      \
+                        srcbuf += run * sizeof(Ptype);              \
+                        ofs += run;                                 \
+                    } else if (!ofs)                                \
+                        return;                                     \
+                } while (ofs < w);                                  \
+                if (sizeof(Ptype) == 2)                             \
+                    srcbuf += (uintptr_t)srcbuf & 2;                \
+                ofs = 0;                                            \
+                do {                                                \
+                    int run;                                        \
+                    ofs += ((Uint16 *)srcbuf)[0];                   \
+                    run = ((Uint16 *)srcbuf)[1];                    \
+                    srcbuf += 4 * (run + 1);                        \
+                    ofs += run;                                     \
+                } while (ofs < w);                                  \
+            }                                                       \
+            /* blit opaque pixels on the line */                    \
+            line = srcbuf;                                          \
+            ofs = 0;                                                \
+            do {                                                    \
+                int run;                                            \
+                ofs += ((Ctype *)line)[0];                          \
+                run = ((Ctype *)line)[1];                           \
+                line += 2 * sizeof(Ctype);                          \
+                if (run) {                                          \
+                    int dx = RLEScaledColumn(ofs, srcrect->x, incx, dstrect->w); \
+                    int dxend = RLEScaledColumn(ofs + run, srcrect->x, incx, dstrect->w); \
+                    Uint32 pos = (Uint32)dx * incx;                 \
+                    for (; dx < dxend; dx++, pos += incx) {         \
+                        int col = srcrect->x + (int)(pos >> 16) - ofs; \
+                        row[dx] = ((Ptype *)line)[col];             \
+                    }                                               \
+                    line += run * sizeof(Ptype);                    \
+                    ofs += run;                                     \
+                } else if (!ofs)                                    \
+                    return;                                         \
+            } while (ofs < w);                                      \
+            if (sizeof(Ptype) == 2)                                 \
+                line += (uintptr_t)line & 2;                        \
+            /* blit translucent pixels on the same line */          \
+            ofs = 0;                                                \
+            do {                                                    \
+                int run;                                            \
+                ofs += ((Uint16 *)line)[0];                         \
+                run = ((Uint16 *)line)[1];                          \
+                line += 4;                                          \
+                if (run) {                                          \
+                    int dx = RLEScaledColumn(ofs, srcrect->x, incx, dstrect->w); \
+                    int dxend = RLEScaledColumn(ofs + run, srcrect->x, incx, dstrect->w); \
+                    Uint32 pos = (Uint32)dx * incx;                 \
+                    for (; dx < dxend; dx++, pos += incx) {         \
+                        int col = srcrect->x + (int)(pos >> 16) - ofs; \
+                        do_blend(((Uint32 *)line)[col], row[dx]);   \
+                    }                                               \
+                    line += run * 4;                                \
+                    ofs += run;                                     \
+                }                                                   \
+            } while (ofs < w);                                      \
+            dstbuf += surf_dst->pitch;                              \
+        }                                                           \
+    } while(0)
+
+    switch (df->BytesPerPixel) {
+    case 2:
+        if (df->Gmask == 0x07e0 || df->Rmask == 0x07e0 || df->Bmask == 0x07e0)
+            RLEALPHASCALEDBLIT(Uint16, Uint8, BLIT_TRANSL_565);
+        else
+            RLEALPHASCALEDBLIT(Uint16, Uint8, BLIT_TRANSL_555);
+        break;
+    case 4:
+        RLEALPHASCALEDBLIT(Uint32, Uint16, BLIT_TRANSL_888);
+        break;
+    }
+
+#undef RLEALPHASCALEDBLIT
+}
+
+/* blit an RLE surface, either kind, scaled from srcrect to dstrect */
+int SDLCALL
+SDL_RLEBlitScaled(SDL_Surface * surf_src, SDL_Rect * srcrect,
+                  SDL_Surface * surf_dst, SDL_Rect * dstrect)
+{
+    Uint8 *dstbuf;
+    Uint8 *srcbuf = (Uint8 *) surf_src->map->data;
+
+    /* Lock the destination if necessary */
+    if (SDL_MUSTLOCK(surf_dst)) {
+        if (SDL_LockSurface(surf_dst) < 0) {
+            return -1;
+        }
+    }
+
+    dstbuf = (Uint8 *) surf_dst->pixels + dstrect->y * surf_dst->pitch
+        + dstrect->x * surf_dst->format->BytesPerPixel;
+    if (surf_src->map->info.flags & SDL_COPY_RLE_ALPHAKEY) {
+        RLEAlphaScaledBlit(surf_src->w, srcbuf + sizeof(RLEDestFormat),
+                           surf_dst, dstbuf, srcrect, dstrect);
+    } else {
+        RLEScaledBlit(surf_src->w, srcbuf, surf_dst, dstbuf,
+                      srcrect, dstrect, surf_src->map->info.a);
+    }
+
+    /* Unlock the destination if necessary */
+    if (SDL_MUSTLOCK(surf_dst)) {
+        SDL_UnlockSurface(surf_dst);
+    }
+    return 0;
+}
+
 /*
  * Auxiliary functions:
  * The encoding functions take 32bpp rgb + a, and
@@ -1022,6 +1315,102 @@ uncopy_32(Uint32 * dst, void *src, int n,
 #define ISTRANSL(pixel, fmt)    \
     ((unsigned)((((pixel) & fmt->Amask) >> fmt->Ashift) - 1U) < 254U)
 
+/*
+ * Run scanning for the 32bpp encoders: each returns the first x at or after
+ * the given one (or w) where the pixel stops being (match != 0) or not
+ * being (match == 0) of the kind asked for. Short runs are common, so the
+ * first few pixels are checked one at a time. The SSE2 versions then
+ * compare four pixels at a time and stop at the group holding the end of
+ * the run, which the plain loop finds.
+ */
+#ifdef __SSE2__
+static int
+ScanEqual32_SSE2(const Uint32 * src, int x, int w,
+                 Uint32 mask, Uint32 key, int match)
+{
+    const __m128i vmask = _mm_set1_epi32(mask);
+    const __m128i vkey = _mm_set1_epi32(key);
+    const int stop = match ? 0 : 0xf;
+
+    for (; x + 4 <= w; x += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i *) (src + x));
+        v = _mm_cmpeq_epi32(_mm_and_si128(v, vmask), vkey);
+        if ((_mm_movemask_ps(_mm_castsi128_ps(v)) ^ stop) != 0xf)
+            break;
+    }
+    return x;
+}
+
+static int
+ScanTransl32_SSE2(const Uint32 * src, int x, int w, Uint32 amask, int match)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i vmask = _mm_set1_epi32(amask);
+    const int stop = match ? 0xf : 0;
+
+    for (; x + 4 <= w; x += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i *) (src + x));
+        v = _mm_and_si128(v, vmask);
+        v = _mm_or_si128(_mm_cmpeq_epi32(v, zero), _mm_cmpeq_epi32(v, vmask));
+        if ((_mm_movemask_ps(_mm_castsi128_ps(v)) ^ stop) != 0xf)
+            break;
+    }
+    return x;
+}
+#endif /* __SSE2__ */
+
+static int
+ScanColorkey32(const Uint32 * src, int x, int w,
+               Uint32 rgbmask, Uint32 ckey, int match)
+{
+    const int end = MIN(x + 4, w);
+
+    while (x < end && ((src[x] & rgbmask) == ckey) == match)
+        x++;
+#ifdef __SSE2__
+    if (x == end && SDL_HasSSE2())
+        x = ScanEqual32_SSE2(src, x, w, rgbmask, ckey, match);
+#endif
+    while (x < w && ((src[x] & rgbmask) == ckey) == match)
+        x++;
+    return x;
+}
+
+static int
+ScanOpaque32(const Uint32 * src, int x, int w, SDL_PixelFormat * fmt,
+             int match)
+{
+    const int end = MIN(x + 4, w);
+
+    while (x < end && ISOPAQUE(src[x], fmt) == match)
+        x++;
+#ifdef __SSE2__
+    /* opaque is all alpha bits set only for 8 bit alpha */
+    if (x == end && fmt->Amask == (0xffU << fmt->Ashift) && SDL_HasSSE2())
+        x = ScanEqual32_SSE2(src, x, w, fmt->Amask, fmt->Amask, match);
+#endif
+    while (x < w && ISOPAQUE(src[x], fmt) == match)
+        x++;
+    return x;
+}
+
+static int
+ScanTransl32(const Uint32 * src, int x, int w, SDL_PixelFormat * fmt,
+             int match)
+{
+    const int end = MIN(x + 4, w);
+
+    while (x < end && ISTRANSL(src[x], fmt) == match)
+        x++;
+#ifdef __SSE2__
+    if (x == end && fmt->Amask == (0xffU << fmt->Ashift) && SDL_HasSSE2())
+        x = ScanTransl32_SSE2(src, x, w, fmt->Amask, match);
+#endif
+    while (x < w && ISTRANSL(src[x], fmt) == match)
+        x++;
+    return x;
+}
+
 /* convert surface to be quickly alpha-blittable onto dest, if possible */
 static int
 RLEAlphaSurface(SDL_Surface * surface)
@@ -1147,11 +1536,9 @@ RLEAlphaSurface(SDL_Surface * surface)
             do {
                 int run, skip, len;
                 skipstart = x;
-                while (x < w && !ISOPAQUE(src[x], sf))
-                    x++;
+                x = ScanOpaque32(src, x, w, sf, 0);
                 runstart = x;
-                while (x < w && ISOPAQUE(src[x], sf))
-                    x++;
+                x = ScanOpaque32(src, x, w, sf, 1);
                 skip = runstart - skipstart;
                 if (skip == w)
                     blankline = 1;
@@ -1182,11 +1569,9 @@ RLEAlphaSurface(SDL_Surface * surface)
             do {
                 int run, skip, len;
                 skipstart = x;
-                while (x < w && !ISTRANSL(src[x], sf))
-                    x++;
+                x = ScanTransl32(src, x, w, sf, 0);
                 runstart = x;
-                while (x < w && ISTRANSL(src[x], sf))
-                    x++;
+                x = ScanTransl32(src, x, w, sf, 1);
                 skip = runstart - skipstart;
                 blankline &= (skip == w);
                 run = x - runstart;
@@ -1219,11 +1604,11 @@ RLEAlphaSurface(SDL_Surface * surface)
 #undef ADD_OPAQUE_COUNTS
 #undef ADD_TRANSL_COUNTS
 
-    /* Now that we have it encoded, release the original pixels */
-    if (!(surface->flags & SDL_PREALLOC)) {
-        SDL_SIMDFree(surface->pixels);
-        surface->pixels = NULL;
-        surface->flags &= ~SDL_SIMD_ALIGNED;
+    /* Now that we have it encoded, release the original pixels. The 16 bit
+       encodings lose precision, so keep them for encoding again later,
+       such as for a 32 bit destination. */
+    if (!(surface->flags & SDL_PREALLOC) && df->BytesPerPixel == 4) {
+        SDL_ReleaseSurfacePixels(surface);
     }
 
     /* realloc the buffer to release unused memory */
@@ -1343,11 +1728,17 @@ RLEColorkeySurface(SDL_Surface * surface)
             int skipstart = x;
 
             /* find run of transparent, then opaque pixels */
-            while (x < w && (getpix(srcbuf + x * bpp) & rgbmask) == ckey)
-                x++;
-            runstart = x;
-            while (x < w && (getpix(srcbuf + x * bpp) & rgbmask) != ckey)
-                x++;
+            if (bpp == 4) {
+                x = ScanColorkey32((Uint32 *) srcbuf, x, w, rgbmask, ckey, 1);
+                runstart = x;
+                x = ScanColorkey32((Uint32 *) srcbuf, x, w, rgbmask, ckey, 0);
+            } else {
+                while (x < w && (getpix(srcbuf + x * bpp) & rgbmask) == ckey)
+                    x++;
+                runstart = x;
+                while (x < w && (getpix(srcbuf + x * bpp) & rgbmask) != ckey)
+                    x++;
+            }
             skip = runstart - skipstart;
             if (skip == w)
                 blankline = 1;
@@ -1385,9 +1776,7 @@ RLEColorkeySurface(SDL_Surface * surface)
 
     /* Now that we have it encoded, release the original pixels */
     if (!(surface->flags & SDL_PREALLOC)) {
-        SDL_SIMDFree(surface->pixels);
-        surface->pixels = NULL;
-        surface->flags &= ~SDL_SIMD_ALIGNED;
+        SDL_ReleaseSurfacePixels(surface);
     }
 
     /* realloc the buffer to release unused memory */
@@ -1402,30 +1791,19 @@ RLEColorkeySurface(SDL_Surface * surface)
     return 0;
 }
 
-int
-SDL_RLESurface(SDL_Surface * surface)
+static SDL_bool
+RLESupported(SDL_Surface * surface)
 {
-    int flags;
-
-    /* Clear any previous RLE conversion */
-    if ((surface->flags & SDL_RLEACCEL) == SDL_RLEACCEL) {
-        SDL_UnRLESurface(surface, 1);
-    }
+    int flags = surface->map->info.flags;
 
     /* We don't support RLE encoding of bitmaps */
     if (surface->format->BitsPerPixel < 8) {
-        return -1;
-    }
-
-    /* Make sure the pixels are available */
-    if (!surface->pixels) {
-        return -1;
+        return SDL_FALSE;
     }
 
     /* If we don't have colorkey or blending, nothing to do... */
-    flags = surface->map->info.flags;
     if (!(flags & (SDL_COPY_COLORKEY | SDL_COPY_BLEND))) {
-        return -1;
+        return SDL_FALSE;
     }
 
     /* Pass on combinations not supported */
@@ -1433,10 +1811,71 @@ SDL_RLESurface(SDL_Surface * surface)
         ((flags & SDL_COPY_MODULATE_ALPHA) && surface->format->Amask) ||
         (flags & (SDL_COPY_ADD | SDL_COPY_MOD)) ||
         (flags & SDL_COPY_NEAREST)) {
+        return SDL_FALSE;
+    }
+    return SDL_TRUE;
+}
+
+/*
+ * Toggling RLE, changing the blend mode or blitting to another surface all
+ * remap the surface. If the encoding we already have would come out the
+ * same for the new mapping, keep it instead of decoding and encoding again.
+ */
+static SDL_bool
+RLEKeepEncoding(SDL_Surface * surface)
+{
+    SDL_BlitMap *map = surface->map;
+    int flags = map->info.flags;
+
+    if (!map->data || !RLESupported(surface)) {
+        return SDL_FALSE;
+    }
+
+    if (!surface->format->Amask || !(flags & SDL_COPY_BLEND)) {
+        Uint32 ckey = map->info.colorkey & ~surface->format->Amask;
+        if (!(flags & SDL_COPY_RLE_COLORKEY) || !map->identity ||
+            map->rle_colorkey != ckey) {
+            return SDL_FALSE;
+        }
+        map->blit = SDL_RLEBlit;
+    } else {
+        RLEDestFormat *r = (RLEDestFormat *) map->data;
+        SDL_PixelFormat *df = map->dst->format;
+        if (!(flags & SDL_COPY_RLE_ALPHAKEY) ||
+            r->BytesPerPixel != df->BytesPerPixel ||
+            r->Rmask != df->Rmask || r->Gmask != df->Gmask ||
+            r->Bmask != df->Bmask) {
+            return SDL_FALSE;
+        }
+        map->blit = SDL_RLEAlphaBlit;
+    }
+    return SDL_TRUE;
+}
+
+int
+SDL_RLESurface(SDL_Surface * surface)
+{
+    int flags;
+
+    /* Clear any previous RLE conversion, unless it can be kept */
+    if ((surface->flags & SDL_RLEACCEL) == SDL_RLEACCEL) {
+        if (RLEKeepEncoding(surface)) {
+            return 0;
+        }
+        SDL_UnRLESurface(surface, 1);
+    }
+
+    if (!RLESupported(surface)) {
+        return -1;
+    }
+
+    /* Make sure the pixels are available */
+    if (!surface->pixels) {
         return -1;
     }
 
     /* Encode and set up the blit */
+    flags = surface->map->info.flags;
     if (!surface->format->Amask || !(flags & SDL_COPY_BLEND)) {
         if (!surface->map->identity) {
             return -1;
@@ -1446,6 +1885,8 @@ SDL_RLESurface(SDL_Surface * surface)
         }
         surface->map->blit = SDL_RLEBlit;
         surface->map->info.flags |= SDL_COPY_RLE_COLORKEY;
+        surface->map->rle_colorkey =
+            surface->map->info.colorkey & ~surface->format->Amask;
     } else {
         if (RLEAlphaSurface(surface) < 0) {
             return -1;
@@ -1487,7 +1928,7 @@ UnRLEAlpha(SDL_Surface * surface)
         uncopy_opaque = uncopy_transl = uncopy_32;
     }
 
-    surface->pixels = SDL_SIMDAlloc(surface->h * surface->pitch);
+    surface->pixels = SDL_AllocPixelBuffer(surface->pitch, surface->h);
     if (!surface->pixels) {
         return (SDL_FALSE);
     }
@@ -1548,12 +1989,13 @@ SDL_UnRLESurface(SDL_Surface * surface, int recode)
     if (surface->flags & SDL_RLEACCEL) {
         surface->flags &= ~SDL_RLEACCEL;
 
-        if (recode && !(surface->flags & SDL_PREALLOC)) {
+        /* Pixels still around were kept because decoding would lose some */
+        if (recode && !(surface->flags & SDL_PREALLOC) && !surface->pixels) {
             if (surface->map->info.flags & SDL_COPY_RLE_COLORKEY) {
                 SDL_Rect full;
 
                 /* re-create the original surface */
-                surface->pixels = SDL_SIMDAlloc(surface->h * surface->pitch);
+                surface->pixels = SDL_AllocPixelBuffer(surface->pitch, surface->h);
                 if (!surface->pixels) {
                     /* Oh crap... */
                     surface->flags |= SDL_RLEACCEL;
@@ -1561,8 +2003,10 @@ SDL_UnRLESurface(SDL_Surface * surface, int recode)
                 }
                 surface->flags |= SDL_SIMD_ALIGNED;
 
-                /* fill it with the background color */
-                SDL_FillRect(surface, NULL, surface->map->info.colorkey);
+                /* fill it with the colorkey it was encoded with, which
+                   may have changed since */
+                SDL_FillRect(surface, NULL, surface->map->rle_colorkey |
+                             (surface->map->info.colorkey & surface->format->Amask));
 
                 /* now render the encoded surface */
                 full.x = full.y = 0;
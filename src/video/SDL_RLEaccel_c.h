@@ -31,6 +31,8 @@ extern int SDLCALL SDL_RLEBlit     (SDL_Surface * src, SDL_Rect * srcrect,
                                     SDL_Surface * dst, SDL_Rect * dstrect);
 extern int SDLCALL SDL_RLEAlphaBlit(SDL_Surface * src, SDL_Rect * srcrect,
                                     SDL_Surface * dst, SDL_Rect * dstrect);
+extern int SDLCALL SDL_RLEBlitScaled(SDL_Surface * src, SDL_Rect * srcrect,
+                                     SDL_Surface * dst, SDL_Rect * dstrect);
 extern void SDL_UnRLESurface(SDL_Surface * surface, int recode);
 
 #endif /* SDL_RLEaccel_c_h_ */
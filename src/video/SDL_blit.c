@@ -52,7 +52,7 @@ SDL_SoftBlit(SDL_Surface * src, SDL_Rect * srcrect,
     }
     /* Lock the source if it's in hardware */
     src_locked = 0;
-    if (SDL_MUSTLOCK(src)) {
+    if (SDL_MUSTLOCK_READ(src)) {
         if (SDL_LockSurface(src) < 0) {
             okay = 0;
         } else {
@@ -225,8 +225,10 @@ SDL_CalculateBlit(SDL_Surface * surface)
         return SDL_SetError("Blit combination not supported");
     }
 
-    /* Clean everything out to start */
-    if ((surface->flags & SDL_RLEACCEL) == SDL_RLEACCEL) {
+    /* Clean everything out to start, SDL_RLESurface() decides whether an
+       existing encoding can stay */
+    if ((surface->flags & SDL_RLEACCEL) == SDL_RLEACCEL &&
+        !(map->info.flags & SDL_COPY_RLE_DESIRED)) {
         SDL_UnRLESurface(surface, 1);
     }
     map->blit = SDL_SoftBlit;
@@ -258,7 +260,10 @@ SDL_CalculateBlit(SDL_Surface * surface)
     } else if (map->info.flags & SDL_COPY_BLEND) {
         blit = SDL_CalculateBlitA(surface);
     } else {
-        blit = SDL_CalculateBlitN(surface);
+        blit = SDL_CalculateBlitDither(surface);
+        if (blit == NULL) {
+            blit = SDL_CalculateBlitN(surface);
+        }
     }
     if (blit == NULL) {
         Uint32 src_format = surface->format->format;
@@ -91,6 +91,9 @@ typedef struct SDL_BlitMap
     void *data;
     SDL_BlitInfo info;
 
+    /* the colorkey a colorkey RLE encoding in data was made with */
+    Uint32 rle_colorkey;
+
     /* the version count matches the destination; mismatch indicates
        an invalid mapping */
     Uint32 dst_palette_version;
@@ -100,11 +103,20 @@ typedef struct SDL_BlitMap
 /* Functions found in SDL_blit.c */
 extern int SDL_CalculateBlit(SDL_Surface * surface);
 
+/* Functions found in SDL_surface.c */
+extern int SDL_UnshareSurfacePixels(SDL_Surface * surface);
+extern void SDL_ReleaseSurfacePixels(SDL_Surface * surface);
+
+/* Surfaces that are only read from don't need the copy SDL_LockSurface()
+   makes of shared pixels, just the pixels RLE encoding took away */
+#define SDL_MUSTLOCK_READ(S) (((S)->flags & SDL_RLEACCEL) != 0)
+
 /* Functions found in SDL_blit_*.c */
 extern SDL_BlitFunc SDL_CalculateBlit0(SDL_Surface * surface);
 extern SDL_BlitFunc SDL_CalculateBlit1(SDL_Surface * surface);
 extern SDL_BlitFunc SDL_CalculateBlitN(SDL_Surface * surface);
 extern SDL_BlitFunc SDL_CalculateBlitA(SDL_Surface * surface);
+extern SDL_BlitFunc SDL_CalculateBlitDither(SDL_Surface * surface);
 
 /*
  * Useful macros for blitting routines
@@ -0,0 +1,359 @@
+/*
+  Simple DirectMedia Layer
+  Copyright (C) 1997-2019 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+#include "../SDL_internal.h"
+
+#include "SDL_hints.h"
+#include "SDL_video.h"
+#include "SDL_cpuinfo.h"
+#include "SDL_blit.h"
+#include "SDL_pixels_c.h"
+
+/* Dithered blits from 8 bits per channel down to 16-bit, RGB332 and
+   paletted surfaces, used for plain copies when SDL_HINT_BLIT_DITHER asks
+   for them. */
+
+typedef enum
+{
+    DITHER_NONE,
+    DITHER_ORDERED,
+    DITHER_DIFFUSION
+} SDL_DitherMode;
+
+static const Uint8 bayer4x4[4][4] = {
+    {  0,  8,  2, 10 },
+    { 12,  4, 14,  6 },
+    {  3, 11,  1,  9 },
+    { 15,  7, 13,  5 }
+};
+
+/* A 6x6x6 color cube is 51 apart, so that's what paletted surfaces get */
+#define PALETTE_SPREAD  51
+
+#define DITHER_CLAMP(v) (((v) < 0) ? 0 : ((v) > 255) ? 255 : (v))
+
+#define DITHER_PACK(fmt, r, g, b, a) \
+    ((((r) >> (fmt)->Rloss) << (fmt)->Rshift) | \
+     (((g) >> (fmt)->Gloss) << (fmt)->Gshift) | \
+     (((b) >> (fmt)->Bloss) << (fmt)->Bshift) | \
+     ((((a) >> (fmt)->Aloss) << (fmt)->Ashift) & (fmt)->Amask))
+
+#define DITHER_SRC_ALPHA(fmt, p) \
+    ((fmt)->Amask ? (((p) >> (fmt)->Ashift) & 0xFF) : 0xFF)
+
+static SDL_DitherMode
+SDL_GetDitherMode(void)
+{
+    const char *hint = SDL_GetHint(SDL_HINT_BLIT_DITHER);
+
+    if (!hint || *hint == '0' || SDL_strcasecmp(hint, "none") == 0) {
+        return DITHER_NONE;
+    }
+    if (*hint == '1' || SDL_strcasecmp(hint, "ordered") == 0) {
+        return DITHER_ORDERED;
+    }
+    if (*hint == '2' || SDL_strcasecmp(hint, "diffusion") == 0) {
+        return DITHER_DIFFUSION;
+    }
+    return DITHER_NONE;
+}
+
+/* Ordered dithering picks level (c * (levels - 1) + threshold) / 255 for
+   each channel, so the dithered levels average out to the source color.
+   The thresholds for a row of four pixels are (2m + 1) * 255 / 32 for the
+   Bayer matrix entries m. */
+static void
+GetOrderedThresholds(int y, int *thresholds)
+{
+    int x;
+
+    for (x = 0; x < 4; ++x) {
+        thresholds[x] = ((2 * bayer4x4[y & 3][x] + 1) * 255) / 32;
+    }
+}
+
+#ifdef __SSE2__
+/* Eight pixels at a time to 16-bit pixels, in 16-bit lanes, with the
+   division by 255 done as (v + 1 + (v >> 8)) >> 8, which is exact here,
+   so the results match the scalar loop. */
+static int
+BlitOrderedRow16_SSE2(const SDL_PixelFormat *srcfmt, const SDL_PixelFormat *dstfmt,
+                      const Uint32 *src, Uint16 *dst, int width, const int *thresholds)
+{
+    Sint16 mul[8], thr[2][8];
+    __m128i vmul, vthr[2], half[2];
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi16(1);
+    const __m128i rshift = _mm_cvtsi32_si128(srcfmt->Rshift);
+    const __m128i gshift = _mm_cvtsi32_si128(srcfmt->Gshift);
+    const __m128i bshift = _mm_cvtsi32_si128(srcfmt->Bshift);
+    const __m128i ashift = _mm_cvtsi32_si128(srcfmt->Ashift + dstfmt->Aloss);
+    const __m128i rmask = _mm_set1_epi32(0xFF >> dstfmt->Rloss);
+    const __m128i gmask = _mm_set1_epi32(0xFF >> dstfmt->Gloss);
+    const __m128i bmask = _mm_set1_epi32(0xFF >> dstfmt->Bloss);
+    const __m128i amask = _mm_set1_epi32(0xFF >> dstfmt->Aloss);
+    const __m128i rdst = _mm_cvtsi32_si128(dstfmt->Rshift);
+    const __m128i gdst = _mm_cvtsi32_si128(dstfmt->Gshift);
+    const __m128i bdst = _mm_cvtsi32_si128(dstfmt->Bshift);
+    const __m128i adst = _mm_cvtsi32_si128(dstfmt->Ashift);
+    const __m128i opaque = _mm_set1_epi32((dstfmt->Amask && !srcfmt->Amask) ? dstfmt->Amask : 0);
+    const __m128i bias16 = _mm_set1_epi32(0x8000);
+    const SDL_bool alpha = (dstfmt->Amask && srcfmt->Amask) ? SDL_TRUE : SDL_FALSE;
+    int x, i, lane;
+
+    /* Lane i of a pixel holds source bits 8i to 8i + 7 */
+    for (lane = 0; lane < 8; ++lane) {
+        const int shift = (lane & 3) * 8;
+        const int pixel = lane >> 2;
+        int levels = 0;
+
+        if (shift == srcfmt->Rshift) {
+            levels = 0xFF >> dstfmt->Rloss;
+        } else if (shift == srcfmt->Gshift) {
+            levels = 0xFF >> dstfmt->Gloss;
+        } else if (shift == srcfmt->Bshift) {
+            levels = 0xFF >> dstfmt->Bloss;
+        }
+        mul[lane] = (Sint16) levels;
+        thr[0][lane] = (Sint16) (levels ? thresholds[pixel] : 0);
+        thr[1][lane] = (Sint16) (levels ? thresholds[pixel + 2] : 0);
+    }
+    vmul = _mm_loadu_si128((const __m128i *) mul);
+    vthr[0] = _mm_loadu_si128((const __m128i *) thr[0]);
+    vthr[1] = _mm_loadu_si128((const __m128i *) thr[1]);
+
+    for (x = 0; x + 8 <= width; x += 8) {
+        for (i = 0; i < 2; ++i) {
+            const __m128i p = _mm_loadu_si128((const __m128i *) (src + x + 4 * i));
+            __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(p, zero), vmul), vthr[0]);
+            __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(p, zero), vmul), vthr[1]);
+            __m128i q, v;
+
+            lo = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(lo, one), _mm_srli_epi16(lo, 8)), 8);
+            hi = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(hi, one), _mm_srli_epi16(hi, 8)), 8);
+            q = _mm_packus_epi16(lo, hi);
+
+            v = opaque;
+            v = _mm_or_si128(v, _mm_sll_epi32(_mm_and_si128(_mm_srl_epi32(q, rshift), rmask), rdst));
+            v = _mm_or_si128(v, _mm_sll_epi32(_mm_and_si128(_mm_srl_epi32(q, gshift), gmask), gdst));
+            v = _mm_or_si128(v, _mm_sll_epi32(_mm_and_si128(_mm_srl_epi32(q, bshift), bmask), bdst));
+            if (alpha) {
+                v = _mm_or_si128(v, _mm_sll_epi32(_mm_and_si128(_mm_srl_epi32(p, ashift), amask), adst));
+            }
+            /* There's no unsigned 32 to 16 bit pack in SSE2, so go through signed */
+            half[i] = _mm_sub_epi32(v, bias16);
+        }
+        _mm_storeu_si128((__m128i *) (dst + x),
+                         _mm_xor_si128(_mm_packs_epi32(half[0], half[1]), _mm_set1_epi16((short) 0x8000)));
+    }
+    return x;
+}
+#endif /* __SSE2__ */
+
+static void
+BlitOrdered(SDL_BlitInfo *info)
+{
+    const SDL_PixelFormat *srcfmt = info->src_fmt;
+    const SDL_PixelFormat *dstfmt = info->dst_fmt;
+    const int width = info->dst_w;
+    const int height = info->dst_h;
+    const int dstbpp = dstfmt->BytesPerPixel;
+    const int rlevels = 0xFF >> dstfmt->Rloss;
+    const int glevels = 0xFF >> dstfmt->Gloss;
+    const int blevels = 0xFF >> dstfmt->Bloss;
+    int thresholds[4];
+    SDL_bool use_sse2 = SDL_FALSE;
+    int x, y;
+
+#ifdef __SSE2__
+    use_sse2 = (dstbpp == 2 && SDL_HasSSE2()) ? SDL_TRUE : SDL_FALSE;
+#endif
+
+    for (y = 0; y < height; ++y) {
+        const Uint32 *src = (const Uint32 *) (info->src + y * info->src_pitch);
+        Uint8 *dst = info->dst + y * info->dst_pitch;
+
+        GetOrderedThresholds(y, thresholds);
+
+        x = 0;
+#ifdef __SSE2__
+        if (use_sse2) {
+            x = BlitOrderedRow16_SSE2(srcfmt, dstfmt, src, (Uint16 *) dst, width, thresholds);
+        }
+#endif
+        for (; x < width; ++x) {
+            const Uint32 p = src[x];
+            const int t = thresholds[x & 3];
+            const Uint32 r = (((p >> srcfmt->Rshift) & 0xFF) * rlevels + t) / 255;
+            const Uint32 g = (((p >> srcfmt->Gshift) & 0xFF) * glevels + t) / 255;
+            const Uint32 b = (((p >> srcfmt->Bshift) & 0xFF) * blevels + t) / 255;
+            const Uint32 a = DITHER_SRC_ALPHA(srcfmt, p);
+            const Uint32 pixel = (r << dstfmt->Rshift) | (g << dstfmt->Gshift) | (b << dstfmt->Bshift) |
+                                 (((a >> dstfmt->Aloss) << dstfmt->Ashift) & dstfmt->Amask);
+
+            if (dstbpp == 2) {
+                ((Uint16 *) dst)[x] = (Uint16) pixel;
+            } else {
+                dst[x] = (Uint8) pixel;
+            }
+        }
+    }
+}
+
+/* Palettes aren't evenly spaced, so offset both ways and pick the nearest */
+static void
+BlitOrderedPalette(SDL_BlitInfo *info)
+{
+    const SDL_PixelFormat *srcfmt = info->src_fmt;
+    SDL_Palette *pal = info->dst_fmt->palette;
+    const int width = info->dst_w;
+    const int height = info->dst_h;
+    int x, y;
+
+    for (y = 0; y < height; ++y) {
+        const Uint32 *src = (const Uint32 *) (info->src + y * info->src_pitch);
+        Uint8 *dst = info->dst + y * info->dst_pitch;
+
+        for (x = 0; x < width; ++x) {
+            const Uint32 p = src[x];
+            const int offset = ((2 * bayer4x4[y & 3][x & 3] - 15) * PALETTE_SPREAD) / 32;
+            const int r = (int) ((p >> srcfmt->Rshift) & 0xFF) + offset;
+            const int g = (int) ((p >> srcfmt->Gshift) & 0xFF) + offset;
+            const int b = (int) ((p >> srcfmt->Bshift) & 0xFF) + offset;
+
+            dst[x] = SDL_FindColor(pal, (Uint8) DITHER_CLAMP(r), (Uint8) DITHER_CLAMP(g),
+                                   (Uint8) DITHER_CLAMP(b), SDL_ALPHA_OPAQUE);
+        }
+    }
+}
+
+/* Floyd-Steinberg: push each pixel's error onto the pixels not done yet.
+   Errors are kept in sixteenths, one row ahead, with a pixel of padding
+   on each side so the edges need no special cases. */
+static void
+BlitDiffusion(SDL_BlitInfo *info)
+{
+    const SDL_PixelFormat *srcfmt = info->src_fmt;
+    const SDL_PixelFormat *dstfmt = info->dst_fmt;
+    SDL_Palette *pal = dstfmt->palette;
+    const int width = info->dst_w;
+    const int height = info->dst_h;
+    const int dstbpp = dstfmt->BytesPerPixel;
+    int *errors, *cur, *next;
+    int x, y, c;
+
+    errors = (int *) SDL_calloc(2 * 3 * (width + 2), sizeof (int));
+    if (!errors) {
+        /* Better dithered some than not at all */
+        if (pal) {
+            BlitOrderedPalette(info);
+        } else {
+            BlitOrdered(info);
+        }
+        return;
+    }
+    cur = errors;
+    next = errors + 3 * (width + 2);
+
+    for (y = 0; y < height; ++y) {
+        const Uint32 *src = (const Uint32 *) (info->src + y * info->src_pitch);
+        Uint8 *dst = info->dst + y * info->dst_pitch;
+        int *tmp;
+
+        for (x = 0; x < width; ++x) {
+            const Uint32 p = src[x];
+            int *here = cur + 3 * (x + 1);
+            int *below = next + 3 * (x + 1);
+            int v[3], out[3];
+
+            v[0] = (int) ((p >> srcfmt->Rshift) & 0xFF) + here[0] / 16;
+            v[1] = (int) ((p >> srcfmt->Gshift) & 0xFF) + here[1] / 16;
+            v[2] = (int) ((p >> srcfmt->Bshift) & 0xFF) + here[2] / 16;
+            for (c = 0; c < 3; ++c) {
+                v[c] = DITHER_CLAMP(v[c]);
+            }
+
+            if (pal) {
+                const Uint8 index = SDL_FindColor(pal, (Uint8) v[0], (Uint8) v[1], (Uint8) v[2], SDL_ALPHA_OPAQUE);
+                out[0] = pal->colors[index].r;
+                out[1] = pal->colors[index].g;
+                out[2] = pal->colors[index].b;
+                dst[x] = index;
+            } else {
+                const Uint32 pixel = DITHER_PACK(dstfmt, (Uint32) v[0], (Uint32) v[1], (Uint32) v[2], DITHER_SRC_ALPHA(srcfmt, p));
+                out[0] = SDL_expand_byte[dstfmt->Rloss][v[0] >> dstfmt->Rloss];
+                out[1] = SDL_expand_byte[dstfmt->Gloss][v[1] >> dstfmt->Gloss];
+                out[2] = SDL_expand_byte[dstfmt->Bloss][v[2] >> dstfmt->Bloss];
+                if (dstbpp == 2) {
+                    ((Uint16 *) dst)[x] = (Uint16) pixel;
+                } else {
+                    dst[x] = (Uint8) pixel;
+                }
+            }
+
+            for (c = 0; c < 3; ++c) {
+                const int error = v[c] - out[c];
+                here[3 + c] += error * 7;
+                below[c - 3] += error * 3;
+                below[c] += error * 5;
+                below[c + 3] += error;
+            }
+        }
+
+        tmp = cur;
+        cur = next;
+        next = tmp;
+        SDL_memset(next, 0, 3 * (width + 2) * sizeof (int));
+    }
+
+    SDL_free(errors);
+}
+
+SDL_BlitFunc
+SDL_CalculateBlitDither(SDL_Surface * surface)
+{
+    const SDL_PixelFormat *srcfmt = surface->format;
+    const SDL_PixelFormat *dstfmt = surface->map->dst->format;
+    SDL_DitherMode mode;
+
+    /* Only plain copies from 8 bits per channel */
+    if ((surface->map->info.flags & ~SDL_COPY_RLE_MASK) != 0 ||
+        srcfmt->BytesPerPixel != 4 || SDL_ISPIXELFORMAT_INDEXED(srcfmt->format) ||
+        SDL_ISPIXELFORMAT_FOURCC(srcfmt->format) ||
+        srcfmt->Rloss || srcfmt->Gloss || srcfmt->Bloss) {
+        return NULL;
+    }
+    if (SDL_ISPIXELFORMAT_FOURCC(dstfmt->format) || dstfmt->BytesPerPixel > 2) {
+        return NULL;
+    }
+    if (SDL_ISPIXELFORMAT_INDEXED(dstfmt->format) ? !dstfmt->palette : !(dstfmt->Rloss | dstfmt->Gloss | dstfmt->Bloss)) {
+        return NULL;
+    }
+
+    mode = SDL_GetDitherMode();
+    if (mode == DITHER_DIFFUSION) {
+        return BlitDiffusion;
+    } else if (mode == DITHER_ORDERED) {
+        return dstfmt->palette ? BlitOrderedPalette : BlitOrdered;
+    }
+    return NULL;
+}
+
+/* vi: set ts=4 sw=4 expandtab: */
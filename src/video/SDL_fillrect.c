@@ -267,6 +267,9 @@ SDL_FillRect(SDL_Surface * dst, const SDL_Rect * rect, Uint32 color)
     if (!dst->pixels) {
         return SDL_SetError("SDL_FillRect(): You must lock the surface");
     }
+    if (SDL_UnshareSurfacePixels(dst) < 0) {
+        return -1;
+    }
 
     pixels = (Uint8 *) dst->pixels + rect->y * dst->pitch +
                                      rect->x * dst->format->BytesPerPixel;
@@ -0,0 +1,249 @@
+/*
+  Simple DirectMedia Layer
+  Copyright (C) 1997-2019 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+#include "../SDL_internal.h"
+
+#include "SDL_atomic.h"
+#include "SDL_hints.h"
+#include "SDL_log.h"
+#include "SDL_timer.h"
+#include "SDL_pixelpool_c.h"
+#include "../cpuinfo/SDL_simd.h"
+
+/* How many freed buffers are kept at most, and for how many milliseconds
+   when no new surface picks them up. */
+#define PIXEL_POOL_MAX_BUFFERS  64
+#define PIXEL_POOL_MAX_AGE      2000
+
+typedef struct SDL_PooledBuffer
+{
+    void *pixels;
+    int pitch;
+    int height;
+    Uint32 freed;
+} SDL_PooledBuffer;
+
+/* The buffers are in the order they were freed, oldest first. The budget
+   is in kilobytes, and 0 between SDL_QuitPixelPool() and SDL_InitPixelPool(). */
+static struct
+{
+    SDL_SpinLock lock;
+    SDL_atomic_t budget;
+    SDL_bool initialized;
+    SDL_PooledBuffer buffers[PIXEL_POOL_MAX_BUFFERS];
+    int count;
+    size_t bytes;
+    size_t peak_bytes;
+    Uint32 allocs;
+    Uint32 reused;
+    Uint32 trimmed;
+} SDL_PixelPool;
+
+/* Takes the oldest buffers out of the pool, called with the lock held. */
+static int
+SDL_TrimPixelPool(int count, void **trimmed)
+{
+    int i;
+
+    for (i = 0; i < count; ++i) {
+        const SDL_PooledBuffer *buffer = &SDL_PixelPool.buffers[i];
+        trimmed[i] = buffer->pixels;
+        SDL_PixelPool.bytes -= (size_t)buffer->pitch * buffer->height;
+    }
+    SDL_PixelPool.count -= count;
+    SDL_memmove(SDL_PixelPool.buffers, SDL_PixelPool.buffers + count,
+                SDL_PixelPool.count * sizeof(SDL_PooledBuffer));
+    SDL_PixelPool.trimmed += count;
+    return count;
+}
+
+/* Callbacks run before the hint changes, so take the new value from them */
+static void SDLCALL
+SDL_PixelPoolHintChanged(void *userdata, const char *name, const char *oldValue, const char *hint)
+{
+    const char *pool = SDL_GetHint(SDL_HINT_SURFACE_POOL);
+    const char *pools = SDL_GetHint(SDL_HINT_MEMORY_POOLS);
+    void *trimmed[PIXEL_POOL_MAX_BUFFERS];
+    int kilobytes = 0;
+    int numtrimmed, i;
+    size_t bytes;
+
+    if (SDL_strcmp(name, SDL_HINT_SURFACE_POOL) == 0) {
+        pool = hint;
+    } else {
+        pools = hint;
+    }
+    if (pool && (!pools || !*pools || (*pools != '0' && SDL_strcasecmp(pools, "false") != 0))) {
+        kilobytes = SDL_max(SDL_atoi(pool), 0);
+    }
+
+    /* Let go of anything over the new budget now, so the pool is empty
+       whenever it's off */
+    SDL_AtomicLock(&SDL_PixelPool.lock);
+    SDL_AtomicSet(&SDL_PixelPool.budget, kilobytes);
+    bytes = SDL_PixelPool.bytes;
+    for (i = 0; bytes > (size_t)kilobytes * 1024; ++i) {
+        const SDL_PooledBuffer *oldest = &SDL_PixelPool.buffers[i];
+        bytes -= (size_t)oldest->pitch * oldest->height;
+    }
+    numtrimmed = SDL_TrimPixelPool(i, trimmed);
+    SDL_AtomicUnlock(&SDL_PixelPool.lock);
+
+    for (i = 0; i < numtrimmed; ++i) {
+        SDL_SIMDFree(trimmed[i]);
+    }
+}
+
+void
+SDL_InitPixelPool(void)
+{
+    if (SDL_PixelPool.initialized) {
+        return;
+    }
+    SDL_AddHintCallback(SDL_HINT_SURFACE_POOL, SDL_PixelPoolHintChanged, NULL);
+    SDL_AddHintCallback(SDL_HINT_MEMORY_POOLS, SDL_PixelPoolHintChanged, NULL);
+    SDL_PixelPool.initialized = SDL_TRUE;
+}
+
+void *
+SDL_AllocPixelBuffer(int pitch, int height)
+{
+    void *pixels = NULL;
+    int i;
+
+    if (SDL_AtomicGet(&SDL_PixelPool.budget)) {
+        SDL_AtomicLock(&SDL_PixelPool.lock);
+        /* The most recently freed buffer is the likeliest to still be cached */
+        for (i = SDL_PixelPool.count - 1; i >= 0; --i) {
+            const SDL_PooledBuffer *buffer = &SDL_PixelPool.buffers[i];
+            if (buffer->pitch == pitch && buffer->height == height) {
+                pixels = buffer->pixels;
+                SDL_PixelPool.bytes -= (size_t)pitch * height;
+                SDL_PixelPool.count--;
+                SDL_memmove(&SDL_PixelPool.buffers[i], &SDL_PixelPool.buffers[i + 1],
+                            (SDL_PixelPool.count - i) * sizeof(SDL_PooledBuffer));
+                SDL_PixelPool.reused++;
+                break;
+            }
+        }
+        SDL_PixelPool.allocs++;
+        SDL_AtomicUnlock(&SDL_PixelPool.lock);
+    }
+
+    if (!pixels) {
+        pixels = SDL_SIMDAlloc((size_t)pitch * height);
+    }
+    return pixels;
+}
+
+void
+SDL_FreePixelBuffer(void *pixels, int pitch, int height)
+{
+    const size_t size = (size_t)pitch * height;
+    void *trimmed[PIXEL_POOL_MAX_BUFFERS];
+    int numtrimmed = 0;
+    size_t budget;
+    Uint32 now;
+    int i;
+
+    if (!pixels) {
+        return;
+    }
+
+    /* A pool that's off is empty, so there's nothing to age out either,
+       and no need for the lock or the time */
+    if (!SDL_AtomicGet(&SDL_PixelPool.budget)) {
+        SDL_SIMDFree(pixels);
+        return;
+    }
+
+    now = SDL_GetTicks();
+    SDL_AtomicLock(&SDL_PixelPool.lock);
+    budget = (size_t)SDL_AtomicGet(&SDL_PixelPool.budget) * 1024;
+    /* Let go of the buffers nobody picked up in a while */
+    for (i = 0; i < SDL_PixelPool.count; ++i) {
+        if (!SDL_TICKS_PASSED(now, SDL_PixelPool.buffers[i].freed + PIXEL_POOL_MAX_AGE)) {
+            break;
+        }
+    }
+    numtrimmed += SDL_TrimPixelPool(i, trimmed);
+
+    /* Make room for this one, or don't keep it if it's too big */
+    if (size <= budget) {
+        SDL_PooledBuffer *buffer;
+        size_t bytes = SDL_PixelPool.bytes + size;
+
+        for (i = 0; SDL_PixelPool.count - i == PIXEL_POOL_MAX_BUFFERS || bytes > budget; ++i) {
+            const SDL_PooledBuffer *oldest = &SDL_PixelPool.buffers[i];
+            bytes -= (size_t)oldest->pitch * oldest->height;
+        }
+        numtrimmed += SDL_TrimPixelPool(i, trimmed + numtrimmed);
+
+        buffer = &SDL_PixelPool.buffers[SDL_PixelPool.count++];
+        buffer->pixels = pixels;
+        buffer->pitch = pitch;
+        buffer->height = height;
+        buffer->freed = now;
+        SDL_PixelPool.bytes += size;
+        SDL_PixelPool.peak_bytes = SDL_max(SDL_PixelPool.peak_bytes, SDL_PixelPool.bytes);
+        pixels = NULL;
+    }
+    SDL_AtomicUnlock(&SDL_PixelPool.lock);
+
+    for (i = 0; i < numtrimmed; ++i) {
+        SDL_SIMDFree(trimmed[i]);
+    }
+    SDL_SIMDFree(pixels);
+}
+
+void
+SDL_QuitPixelPool(void)
+{
+    const char *report = SDL_GetHint("SDL_MEMORY_POOL_STATISTICS");
+    void *trimmed[PIXEL_POOL_MAX_BUFFERS];
+    int numtrimmed;
+    int i;
+
+    if (SDL_PixelPool.initialized) {
+        SDL_DelHintCallback(SDL_HINT_SURFACE_POOL, SDL_PixelPoolHintChanged, NULL);
+        SDL_DelHintCallback(SDL_HINT_MEMORY_POOLS, SDL_PixelPoolHintChanged, NULL);
+        SDL_PixelPool.initialized = SDL_FALSE;
+    }
+
+    SDL_AtomicLock(&SDL_PixelPool.lock);
+    SDL_AtomicSet(&SDL_PixelPool.budget, 0);
+    numtrimmed = SDL_TrimPixelPool(SDL_PixelPool.count, trimmed);
+    if (report && SDL_atoi(report) && SDL_PixelPool.allocs) {
+        SDL_Log("SDL PIXEL POOL: %u of %u pixel buffers reused, at most %d KB kept, %u freed unused\n",
+                (unsigned int) SDL_PixelPool.reused, (unsigned int) SDL_PixelPool.allocs,
+                (int) (SDL_PixelPool.peak_bytes / 1024), (unsigned int) SDL_PixelPool.trimmed);
+    }
+    SDL_PixelPool.peak_bytes = 0;
+    SDL_PixelPool.allocs = 0;
+    SDL_PixelPool.reused = 0;
+    SDL_PixelPool.trimmed = 0;
+    SDL_AtomicUnlock(&SDL_PixelPool.lock);
+
+    for (i = 0; i < numtrimmed; ++i) {
+        SDL_SIMDFree(trimmed[i]);
+    }
+}
+
+/* vi: set ts=4 sw=4 expandtab: */
@@ -0,0 +1,42 @@
+/*
+  Simple DirectMedia Layer
+  Copyright (C) 1997-2019 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely, subject to the following restrictions:
+
+  1. The origin of this software must not be misrepresented; you must not
+     claim that you wrote the original software. If you use this software
+     in a product, an acknowledgment in the product documentation would be
+     appreciated but is not required.
+  2. Altered source versions must be plainly marked as such, and must not be
+     misrepresented as being the original software.
+  3. This notice may not be removed or altered from any source distribution.
+*/
+#include "../SDL_internal.h"
+
+#ifndef SDL_pixelpool_c_h_
+#define SDL_pixelpool_c_h_
+
+/* The pixels of surfaces SDL allocates itself, SDL_SIMDAlloc()'d and pitch
+   times height bytes big. Freed buffers are kept for new surfaces of the same
+   pitch and height, as far as SDL_HINT_SURFACE_POOL allows, from SDL_Init()
+   until SDL_Quit(). Setting the SDL_MEMORY_POOL_STATISTICS environment
+   variable to "1" logs how many were reused when SDL quits. */
+extern void *SDL_AllocPixelBuffer(int pitch, int height);
+extern void SDL_FreePixelBuffer(void *pixels, int pitch, int height);
+
+/* Start following the hints, it's fine to call this more than once */
+extern void SDL_InitPixelPool(void);
+
+/* Free every buffer in the pool, and keep no more until it's initialized again */
+extern void SDL_QuitPixelPool(void);
+
+#endif /* SDL_pixelpool_c_h_ */
+
+/* vi: set ts=4 sw=4 expandtab: */
@@ -27,7 +27,6 @@
 #include "SDL_sysvideo.h"
 #include "SDL_blit.h"
 #include "SDL_pixels_c.h"
-#include "SDL_RLEaccel_c.h"
 
 
 /* Lookup tables to expand partial bytes to the full 0..255 range */
@@ -635,6 +634,151 @@ SDL_FreeFormat(SDL_PixelFormat *format)
     SDL_free(format);
 }
 
+/*
+ * Inverse colormaps: to speed up matching colors to big palettes, RGB
+ * space is cut into cells, and each cell lists the only palette entries
+ * that can be nearest to a color in it. Cells are filled in the first
+ * time a color falls in them, so the results are exactly those of a
+ * search of the whole palette. Opaque colors are all that's cached, they
+ * are what SDL_MapRGB() and the blit maps ask for.
+ */
+#define COLORMAP_BITS       5
+#define COLORMAP_CELLS      (1 << (3 * COLORMAP_BITS))
+#define COLORMAP_SHIFT      (8 - COLORMAP_BITS)
+#define COLORMAP_MIN_COLORS 32
+#define MAX_COLORMAPS       8
+
+typedef struct
+{
+    const SDL_Palette *palette;
+    Uint32 version;
+    const SDL_Color *colors;
+    int ncolors;
+    Uint32 lastused;
+    Uint32 *cells;              /* 0 if not filled in yet, else offset << 9 | count */
+    Uint8 *candidates;
+    Uint32 used, size;
+} SDL_InverseColormap;
+
+/* SDL_Palette is public and has no room for more state, so colormaps are
+   kept here, keyed by palette. The lock is only contended when several
+   threads map colors at once; otherwise it costs one atomic swap, next to
+   a search of 32 or more colors. The cells take 128 KB a colormap. */
+static SDL_InverseColormap colormaps[MAX_COLORMAPS];
+static Uint32 colormaps_clock = 0;
+static SDL_SpinLock colormaps_lock = 0;
+
+static void
+SDL_ResetColormap(SDL_InverseColormap *cmap)
+{
+    SDL_free(cmap->cells);
+    SDL_free(cmap->candidates);
+    SDL_zerop(cmap);
+}
+
+/* Get the colormap for a palette, the colormaps lock must be held */
+static SDL_InverseColormap *
+SDL_GetColormap(const SDL_Palette *pal)
+{
+    SDL_InverseColormap *cmap = NULL;
+    int i;
+
+    for (i = 0; i < MAX_COLORMAPS; ++i) {
+        if (colormaps[i].palette == pal) {
+            cmap = &colormaps[i];
+            break;
+        }
+        if (!cmap || colormaps[i].lastused < cmap->lastused) {
+            cmap = &colormaps[i];
+        }
+    }
+
+    if (cmap->palette != pal || cmap->version != pal->version ||
+        cmap->colors != pal->colors || cmap->ncolors != pal->ncolors) {
+        SDL_ResetColormap(cmap);
+        cmap->cells = (Uint32 *) SDL_calloc(COLORMAP_CELLS, sizeof (Uint32));
+        if (!cmap->cells) {
+            return NULL;
+        }
+        cmap->palette = pal;
+        cmap->version = pal->version;
+        cmap->colors = pal->colors;
+        cmap->ncolors = pal->ncolors;
+    }
+    cmap->lastused = ++colormaps_clock;
+    return cmap;
+}
+
+/* List the palette entries that could be nearest to some color in a cell:
+   those whose closest approach to the cell is no farther than the
+   farthest point of the cell is from some other entry. */
+static SDL_bool
+SDL_FillColormapCell(SDL_InverseColormap *cmap, int cell)
+{
+    const int lo[3] = {
+        (cell >> (2 * COLORMAP_BITS)) << COLORMAP_SHIFT,
+        ((cell >> COLORMAP_BITS) & ((1 << COLORMAP_BITS) - 1)) << COLORMAP_SHIFT,
+        (cell & ((1 << COLORMAP_BITS) - 1)) << COLORMAP_SHIFT
+    };
+    const int hi = (1 << COLORMAP_SHIFT) - 1;
+    unsigned int nearest[256];
+    unsigned int farthest = ~0;
+    Uint32 count = 0;
+    int i, j;
+
+    if (cmap->size - cmap->used < (Uint32) cmap->ncolors) {
+        const Uint32 size = SDL_max(cmap->size * 2, cmap->used + cmap->ncolors);
+        Uint8 *candidates = (Uint8 *) SDL_realloc(cmap->candidates, size);
+        if (!candidates) {
+            return SDL_FALSE;
+        }
+        cmap->candidates = candidates;
+        cmap->size = size;
+    }
+
+    for (i = 0; i < cmap->ncolors; ++i) {
+        const SDL_Color *color = &cmap->colors[i];
+        const int c[3] = { color->r, color->g, color->b };
+        const int ad = color->a - SDL_ALPHA_OPAQUE;
+        unsigned int dmin = ad * ad;
+        unsigned int dmax = ad * ad;
+
+        for (j = 0; j < 3; ++j) {
+            const int below = c[j] - lo[j];
+            const int above = lo[j] + hi - c[j];
+            const int inside = (below < 0) ? -below : (above < 0) ? -above : 0;
+            const int outside = SDL_max(SDL_abs(below), SDL_abs(above));
+            dmin += inside * inside;
+            dmax += outside * outside;
+        }
+        nearest[i] = dmin;
+        farthest = SDL_min(farthest, dmax);
+    }
+
+    for (i = 0; i < cmap->ncolors; ++i) {
+        if (nearest[i] <= farthest) {
+            cmap->candidates[cmap->used + count++] = (Uint8) i;
+        }
+    }
+    cmap->cells[cell] = (cmap->used << 9) | count;
+    cmap->used += count;
+    return SDL_TRUE;
+}
+
+static void
+SDL_FreeColormap(const SDL_Palette *pal)
+{
+    int i;
+
+    SDL_AtomicLock(&colormaps_lock);
+    for (i = 0; i < MAX_COLORMAPS; ++i) {
+        if (colormaps[i].palette == pal) {
+            SDL_ResetColormap(&colormaps[i]);
+        }
+    }
+    SDL_AtomicUnlock(&colormaps_lock);
+}
+
 SDL_Palette *
 SDL_AllocPalette(int ncolors)
 {
@@ -731,6 +875,7 @@ SDL_FreePalette(SDL_Palette * palette)
     if (--palette->refcount > 0) {
         return;
     }
+    SDL_FreeColormap(palette);
     SDL_free(palette->colors);
     SDL_free(palette);
 }
@@ -776,6 +921,40 @@ SDL_FindColor(SDL_Palette * pal, Uint8 r, Uint8 g, Uint8 b, Uint8 a)
     int i;
     Uint8 pixel = 0;
 
+    if (a == SDL_ALPHA_OPAQUE && pal->ncolors >= COLORMAP_MIN_COLORS && pal->ncolors <= 256) {
+        const int cell = ((r >> COLORMAP_SHIFT) << (2 * COLORMAP_BITS)) |
+                         ((g >> COLORMAP_SHIFT) << COLORMAP_BITS) | (b >> COLORMAP_SHIFT);
+        SDL_InverseColormap *cmap;
+
+        SDL_AtomicLock(&colormaps_lock);
+        cmap = SDL_GetColormap(pal);
+        if (cmap && (cmap->cells[cell] || SDL_FillColormapCell(cmap, cell))) {
+            const Uint8 *candidates = cmap->candidates + (cmap->cells[cell] >> 9);
+            const Uint32 count = cmap->cells[cell] & 0x1FF;
+            Uint32 n;
+
+            smallest = ~0;
+            for (n = 0; n < count; ++n) {
+                const SDL_Color *color = &pal->colors[candidates[n]];
+                rd = color->r - r;
+                gd = color->g - g;
+                bd = color->b - b;
+                ad = color->a - a;
+                distance = (rd * rd) + (gd * gd) + (bd * bd) + (ad * ad);
+                if (distance < smallest) {
+                    pixel = candidates[n];
+                    if (distance == 0) {        /* Perfect match! */
+                        break;
+                    }
+                    smallest = distance;
+                }
+            }
+            SDL_AtomicUnlock(&colormaps_lock);
+            return (pixel);
+        }
+        SDL_AtomicUnlock(&colormaps_lock);
+    }
+
     smallest = ~0;
     for (i = 0; i < pal->ncolors; ++i) {
         rd = pal->colors[i].r - r;
@@ -994,11 +1173,9 @@ SDL_MapSurface(SDL_Surface * src, SDL_Surface * dst)
     SDL_PixelFormat *dstfmt;
     SDL_BlitMap *map;
 
-    /* Clear out any previous mapping */
+    /* Clear out any previous mapping, SDL_CalculateBlit() takes care of
+       any RLE encoding */
     map = src->map;
-    if ((src->flags & SDL_RLEACCEL) == SDL_RLEACCEL) {
-        SDL_UnRLESurface(src, 1);
-    }
     SDL_InvalidateMap(map);
 
     /* Figure out what kind of mapping we're doing */
@@ -262,7 +262,7 @@ SDL_SoftStretch(SDL_Surface * src, const SDL_Rect * srcrect,
     }
     /* Lock the source if it's in hardware */
     src_locked = 0;
-    if (SDL_MUSTLOCK(src)) {
+    if (SDL_MUSTLOCK_READ(src)) {
         if (SDL_LockSurface(src) < 0) {
             if (dst_locked) {
                 SDL_UnlockSurface(dst);
@@ -20,11 +20,14 @@
 */
 #include "../SDL_internal.h"
 
+#include "SDL_atomic.h"
+#include "SDL_hints.h"
 #include "SDL_video.h"
 #include "SDL_sysvideo.h"
 #include "SDL_blit.h"
 #include "SDL_RLEaccel_c.h"
 #include "SDL_pixels_c.h"
+#include "SDL_pixelpool_c.h"
 #include "SDL_yuv_c.h"
 #include "../cpuinfo/SDL_simd.h"
 
@@ -33,6 +36,12 @@
 SDL_COMPILE_TIME_ASSERT(surface_size_assumptions,
     sizeof(int) == sizeof(Sint32) && sizeof(size_t) >= sizeof(Sint32));
 
+/* Pixels shared by surfaces with SDL_SHARED_PIXELS, pointed to by lock_data */
+typedef struct SDL_SharedPixels
+{
+    SDL_atomic_t refcount;
+} SDL_SharedPixels;
+
 /* Public routines */
 
 /*
@@ -60,18 +69,14 @@ SDL_CalculatePitch(Uint32 format, int width)
 }
 
 /*
- * Create an empty RGB surface of the appropriate depth using the given
- * enum SDL_PIXELFORMAT_* format
+ * Create a surface of the given enum SDL_PIXELFORMAT_* format with
+ * everything but the pixels
  */
-SDL_Surface *
-SDL_CreateRGBSurfaceWithFormat(Uint32 flags, int width, int height, int depth,
-                               Uint32 format)
+static SDL_Surface *
+SDL_CreateSurfaceWithoutPixels(int width, int height, Uint32 format)
 {
     SDL_Surface *surface;
 
-    /* The flags are no longer used, make the compiler happy */
-    (void)flags;
-
     /* Allocate the surface */
     surface = (SDL_Surface *) SDL_calloc(1, sizeof(*surface));
     if (surface == NULL) {
@@ -109,6 +114,40 @@ SDL_CreateRGBSurfaceWithFormat(Uint32 flags, int width, int height, int depth,
         SDL_FreePalette(palette);
     }
 
+    /* Allocate an empty mapping */
+    surface->map = SDL_AllocBlitMap();
+    if (!surface->map) {
+        SDL_FreeSurface(surface);
+        return NULL;
+    }
+
+    /* By default surface with an alpha mask are set up for blending */
+    if (surface->format->Amask) {
+        SDL_SetSurfaceBlendMode(surface, SDL_BLENDMODE_BLEND);
+    }
+
+    surface->refcount = 1;
+    return surface;
+}
+
+/*
+ * Create an empty RGB surface of the appropriate depth using the given
+ * enum SDL_PIXELFORMAT_* format
+ */
+SDL_Surface *
+SDL_CreateRGBSurfaceWithFormat(Uint32 flags, int width, int height, int depth,
+                               Uint32 format)
+{
+    SDL_Surface *surface;
+
+    /* The flags are no longer used, make the compiler happy */
+    (void)flags;
+
+    surface = SDL_CreateSurfaceWithoutPixels(width, height, format);
+    if (!surface) {
+        return NULL;
+    }
+
     /* Get the pixels */
     if (surface->w && surface->h) {
         /* Assumptions checked in surface_size_assumptions assert above */
@@ -120,7 +159,7 @@ SDL_CreateRGBSurfaceWithFormat(Uint32 flags, int width, int height, int depth,
             return NULL;
         }
 
-        surface->pixels = SDL_SIMDAlloc((size_t)size);
+        surface->pixels = SDL_AllocPixelBuffer(surface->pitch, surface->h);
         if (!surface->pixels) {
             SDL_FreeSurface(surface);
             SDL_OutOfMemory();
@@ -131,20 +170,7 @@ SDL_CreateRGBSurfaceWithFormat(Uint32 flags, int width, int height, int depth,
         SDL_memset(surface->pixels, 0, surface->h * surface->pitch);
     }
 
-    /* Allocate an empty mapping */
-    surface->map = SDL_AllocBlitMap();
-    if (!surface->map) {
-        SDL_FreeSurface(surface);
-        return NULL;
-    }
-
-    /* By default surface with an alpha mask are set up for blending */
-    if (surface->format->Amask) {
-        SDL_SetSurfaceBlendMode(surface, SDL_BLENDMODE_BLEND);
-    }
-
     /* The surface is ready to go */
-    surface->refcount = 1;
     return surface;
 }
 
@@ -326,7 +352,9 @@ SDL_ConvertColorkeyToAlpha(SDL_Surface * surface, SDL_bool ignore_alpha)
         return;
     }
 
-    SDL_LockSurface(surface);
+    if (SDL_LockSurface(surface) < 0) {
+        return;
+    }
 
     switch (surface->format->BytesPerPixel) {
     case 2:
@@ -600,11 +628,12 @@ SDL_GetClipRect(SDL_Surface * surface, SDL_Rect * rect)
  * you know exactly what you are doing, you can optimize your code
  * by calling the one(s) you need.
  */
-int
-SDL_LowerBlit(SDL_Surface * src, SDL_Rect * srcrect,
-              SDL_Surface * dst, SDL_Rect * dstrect)
+/*
+ * Make sure the blit mapping from src to dst is valid
+ */
+static int
+SDL_ValidateMap(SDL_Surface * src, SDL_Surface * dst)
 {
-    /* Check to make sure the blit mapping is valid */
     if ((src->map->dst != dst) ||
         (dst->format->palette &&
          src->map->dst_palette_version != dst->format->palette->version) ||
@@ -619,6 +648,17 @@ SDL_LowerBlit(SDL_Surface * src, SDL_Rect * srcrect,
 /*              src, dst->flags, src->map->info.flags, dst, dst->flags, */
 /*              dst->map->info.flags, src->map->blit); */
     }
+    return (0);
+}
+
+int
+SDL_LowerBlit(SDL_Surface * src, SDL_Rect * srcrect,
+              SDL_Surface * dst, SDL_Rect * dstrect)
+{
+    /* Check to make sure the blit mapping is valid */
+    if (SDL_ValidateMap(src, dst) < 0) {
+        return (-1);
+    }
     return (src->map->blit(src, srcrect, dst, dstrect));
 }
 
@@ -886,6 +926,18 @@ SDL_LowerBlitScaled(SDL_Surface * src, SDL_Rect * srcrect,
         SDL_COPY_COLORKEY
     );
 
+    /* RLE surfaces scale straight from their encoding, which needs the
+       same mapping as unscaled blits, so mixing the two doesn't remap */
+    if ((src->map->info.flags & (SDL_COPY_RLE_DESIRED | SDL_COPY_NEAREST)) ==
+        SDL_COPY_RLE_DESIRED) {
+        if (SDL_ValidateMap(src, dst) < 0) {
+            return (-1);
+        }
+        if ((src->flags & SDL_RLEACCEL) == SDL_RLEACCEL) {
+            return SDL_RLEBlitScaled(src, srcrect, dst, dstrect);
+        }
+    }
+
     if (!(src->map->info.flags & SDL_COPY_NEAREST)) {
         src->map->info.flags |= SDL_COPY_NEAREST;
         SDL_InvalidateMap(src->map);
@@ -907,6 +959,11 @@ int
 SDL_LockSurface(SDL_Surface * surface)
 {
     if (!surface->locked) {
+        /* Writes must not show up in the surfaces sharing the pixels */
+        if (SDL_UnshareSurfacePixels(surface) < 0) {
+            return -1;
+        }
+
         /* Perform the lock */
         if (surface->flags & SDL_RLEACCEL) {
             SDL_UnRLESurface(surface, 1);
@@ -939,6 +996,136 @@ SDL_UnlockSurface(SDL_Surface * surface)
     }
 }
 
+/*
+ * Give a surface its own copy of the pixels it shares with other surfaces
+ */
+int
+SDL_UnshareSurfacePixels(SDL_Surface * surface)
+{
+    SDL_SharedPixels *shared = (SDL_SharedPixels *) surface->lock_data;
+    void *pixels;
+
+    if (!(surface->flags & SDL_SHARED_PIXELS)) {
+        return 0;
+    }
+
+    /* Nobody else can start sharing the pixels of the last surface with them */
+    if (SDL_AtomicGet(&shared->refcount) == 1) {
+        SDL_free(shared);
+        surface->lock_data = NULL;
+        surface->flags &= ~SDL_SHARED_PIXELS;
+        return 0;
+    }
+
+    pixels = SDL_AllocPixelBuffer(surface->pitch, surface->h);
+    if (!pixels) {
+        return SDL_OutOfMemory();
+    }
+    SDL_memcpy(pixels, surface->pixels, (size_t)surface->h * surface->pitch);
+
+    /* The others may have let go meanwhile, so this can free the original */
+    SDL_ReleaseSurfacePixels(surface);
+    surface->pixels = pixels;
+    surface->flags |= SDL_SIMD_ALIGNED;
+    return 0;
+}
+
+/*
+ * Free the pixels of a surface, or let go of them if they are shared
+ */
+void
+SDL_ReleaseSurfacePixels(SDL_Surface * surface)
+{
+    if (surface->flags & SDL_SHARED_PIXELS) {
+        SDL_SharedPixels *shared = (SDL_SharedPixels *) surface->lock_data;
+
+        surface->lock_data = NULL;
+        surface->flags &= ~SDL_SHARED_PIXELS;
+        if (!SDL_AtomicDecRef(&shared->refcount)) {
+            /* Another surface still uses them */
+            surface->pixels = NULL;
+            surface->flags &= ~SDL_SIMD_ALIGNED;
+            return;
+        }
+        SDL_free(shared);
+    }
+
+    if (surface->flags & SDL_SIMD_ALIGNED) {
+        /* Free aligned, or keep for another surface */
+        SDL_FreePixelBuffer(surface->pixels, surface->pitch, surface->h);
+    } else {
+        /* Normal */
+        SDL_free(surface->pixels);
+    }
+    surface->pixels = NULL;
+    surface->flags &= ~SDL_SIMD_ALIGNED;
+}
+
+/*
+ * Check whether converting a surface to a format would only copy the pixels
+ */
+static SDL_bool
+SDL_CanSharePixels(SDL_Surface * surface, const SDL_PixelFormat * format)
+{
+    Uint32 pixel_format;
+
+    if (!SDL_GetHintBoolean(SDL_HINT_SURFACE_COPY_ON_WRITE, SDL_FALSE)) {
+        return SDL_FALSE;
+    }
+
+    /* Only pixels nobody is writing to, that SDL allocated itself */
+    if (!surface->pixels || surface->locked ||
+        (surface->flags & (SDL_PREALLOC | SDL_RLEACCEL | SDL_DONTFREE))) {
+        return SDL_FALSE;
+    }
+
+    /* The same format SDL_ConvertSurface() would create */
+    pixel_format = SDL_MasksToPixelFormatEnum(format->BitsPerPixel,
+                                              format->Rmask, format->Gmask,
+                                              format->Bmask, format->Amask);
+    if (pixel_format != surface->format->format ||
+        surface->pitch != SDL_CalculatePitch(pixel_format, surface->w)) {
+        return SDL_FALSE;
+    }
+
+    /* Different palettes would remap the pixels */
+    if (format->palette) {
+        const SDL_Palette *palette = surface->format->palette;
+
+        if (!palette || palette->ncolors != format->palette->ncolors ||
+            SDL_memcmp(palette->colors, format->palette->colors,
+                       palette->ncolors * sizeof(SDL_Color)) != 0) {
+            return SDL_FALSE;
+        }
+    }
+    return SDL_TRUE;
+}
+
+/*
+ * Make a surface without pixels use the pixels of another surface
+ */
+static int
+SDL_SharePixels(SDL_Surface * surface, SDL_Surface * copy)
+{
+    SDL_SharedPixels *shared = (SDL_SharedPixels *) surface->lock_data;
+
+    if (!(surface->flags & SDL_SHARED_PIXELS)) {
+        shared = (SDL_SharedPixels *) SDL_malloc(sizeof(*shared));
+        if (!shared) {
+            return SDL_OutOfMemory();
+        }
+        SDL_AtomicSet(&shared->refcount, 1);
+        surface->lock_data = shared;
+        surface->flags |= SDL_SHARED_PIXELS;
+    }
+    SDL_AtomicIncRef(&shared->refcount);
+
+    copy->pixels = surface->pixels;
+    copy->lock_data = shared;
+    copy->flags |= SDL_SHARED_PIXELS | (surface->flags & SDL_SIMD_ALIGNED);
+    return 0;
+}
+
 /*
  * Creates a new surface identical to the existing surface
  */
@@ -959,6 +1146,7 @@ SDL_ConvertSurface(SDL_Surface * surface, const SDL_PixelFormat * format,
     Uint32 copy_flags;
     SDL_Color copy_color;
     SDL_Rect bounds;
+    SDL_bool share;
     int ret;
 
     if (!surface) {
@@ -986,10 +1174,16 @@ SDL_ConvertSurface(SDL_Surface * surface, const SDL_PixelFormat * format,
     }
 
     /* Create a new surface with the desired format */
-    convert = SDL_CreateRGBSurface(flags, surface->w, surface->h,
-                                   format->BitsPerPixel, format->Rmask,
-                                   format->Gmask, format->Bmask,
-                                   format->Amask);
+    share = SDL_CanSharePixels(surface, format);
+    if (share) {
+        convert = SDL_CreateSurfaceWithoutPixels(surface->w, surface->h,
+                                                 surface->format->format);
+    } else {
+        convert = SDL_CreateRGBSurface(flags, surface->w, surface->h,
+                                       format->BitsPerPixel, format->Rmask,
+                                       format->Gmask, format->Bmask,
+                                       format->Amask);
+    }
     if (convert == NULL) {
         return (NULL);
     }
@@ -1015,12 +1209,16 @@ SDL_ConvertSurface(SDL_Surface * surface, const SDL_PixelFormat * format,
     surface->map->info.flags = 0;
     SDL_InvalidateMap(surface->map);
 
-    /* Copy over the image data */
-    bounds.x = 0;
-    bounds.y = 0;
-    bounds.w = surface->w;
-    bounds.h = surface->h;
-    ret = SDL_LowerBlit(surface, &bounds, convert, &bounds);
+    /* Copy over the image data, unless it can be shared */
+    if (share) {
+        ret = SDL_SharePixels(surface, convert);
+    } else {
+        bounds.x = 0;
+        bounds.y = 0;
+        bounds.w = surface->w;
+        bounds.h = surface->h;
+        ret = SDL_LowerBlit(surface, &bounds, convert, &bounds);
+    }
 
     /* Clean up the original surface, and update converted surface */
     convert->map->info.r = copy_color.r;
@@ -1039,7 +1237,7 @@ SDL_ConvertSurface(SDL_Surface * surface, const SDL_PixelFormat * format,
     surface->map->info.flags = copy_flags;
     SDL_InvalidateMap(surface->map);
 
-    /* SDL_LowerBlit failed, and so the conversion */
+    /* Copying or sharing the pixels failed, and so the conversion */
     if (ret < 0) {
         SDL_FreeSurface(convert);
         return NULL;
@@ -1262,12 +1460,8 @@ SDL_FreeSurface(SDL_Surface * surface)
     }
     if (surface->flags & SDL_PREALLOC) {
         /* Don't free */
-    } else if (surface->flags & SDL_SIMD_ALIGNED) {
-        /* Free aligned */
-        SDL_SIMDFree(surface->pixels);
     } else {
-        /* Normal */
-        SDL_free(surface->pixels);
+        SDL_ReleaseSurfacePixels(surface);
     }
     if (surface->map) {
         SDL_FreeBlitMap(surface->map);
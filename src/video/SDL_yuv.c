@@ -20,15 +20,31 @@
 */
 #include "../SDL_internal.h"
 
+#include "SDL_atomic.h"
 #include "SDL_endian.h"
+#include "SDL_cpuinfo.h"
+#include "SDL_hints.h"
+#include "SDL_jobs.h"
 #include "SDL_video.h"
 #include "SDL_pixels_c.h"
 #include "SDL_yuv_c.h"
 
 #include "yuv2rgb/yuv_rgb.h"
 
+#if defined(__AVX2__) && defined(HAVE_IMMINTRIN_H)
+#define HAVE_AVX2_INTRINSICS 1
+#endif
+
 #define SDL_YUV_SD_THRESHOLD    576
 
+/* Frames are split into bands of whole macroblock rows, and only frames of
+   at least SDL_YUV_PARALLEL_PIXELS are split unless SDL_HINT_YUV_PARALLEL
+   says otherwise. Each band handed to a worker is at least
+   SDL_YUV_PARALLEL_BATCH pixels, so small bands don't drown in overhead. */
+#define SDL_YUV_SLICE_ROWS      16
+#define SDL_YUV_PARALLEL_PIXELS (1280 * 720)
+#define SDL_YUV_PARALLEL_BATCH  (128 * 1024)
+
 
 static SDL_YUV_CONVERSION_MODE SDL_YUV_ConversionMode = SDL_YUV_CONVERSION_BT601;
 
@@ -89,6 +105,31 @@ static SDL_bool IsPacked4Format(Uint32 format)
             format == SDL_PIXELFORMAT_YVYU);
 }
 
+/* Call func for every slice of SDL_YUV_SLICE_ROWS rows of the frame,
+   spread across the job workers if the frame is worth splitting. */
+static void ConvertYUVSlices(int width, int height, SDL_ParallelForFunction func, void *data)
+{
+    const int slices = (height + SDL_YUV_SLICE_ROWS - 1) / SDL_YUV_SLICE_ROWS;
+    const char *hint = SDL_GetHint(SDL_HINT_YUV_PARALLEL);
+    SDL_bool parallel;
+
+    if (hint) {
+        parallel = (*hint != '0') ? SDL_TRUE : SDL_FALSE;
+    } else {
+        parallel = ((Sint64) width * height >= SDL_YUV_PARALLEL_PIXELS) ? SDL_TRUE : SDL_FALSE;
+    }
+
+    if (!parallel || slices <= 1) {
+        func(data, 0, slices);
+        return;
+    }
+
+    /* CPU features are detected on first use, which isn't thread safe */
+    SDL_HasAVX2();
+
+    SDL_ParallelFor(slices, SDL_max(SDL_YUV_PARALLEL_BATCH / (width * SDL_YUV_SLICE_ROWS), 1), func, data);
+}
+
 static int GetYUVPlanes(int width, int height, Uint32 format, const void *yuv, int yuv_pitch,
                         const Uint8 **y, const Uint8 **u, const Uint8 **v, Uint32 *y_stride, Uint32 *uv_stride)
 {
@@ -288,6 +329,115 @@ static SDL_bool yuv_rgb_sse(
     return SDL_FALSE;
 }
 
+static SDL_bool yuv_rgb_avx2(
+    Uint32 src_format, Uint32 dst_format,
+    Uint32 width, Uint32 height, 
+    const Uint8 *y, const Uint8 *u, const Uint8 *v, Uint32 y_stride, Uint32 uv_stride, 
+    Uint8 *rgb, Uint32 rgb_stride, 
+    YCbCrType yuv_type)
+{
+#if HAVE_AVX2_INTRINSICS
+    if (!SDL_HasAVX2()) {
+        return SDL_FALSE;
+    }
+
+    if (src_format == SDL_PIXELFORMAT_YV12 ||
+        src_format == SDL_PIXELFORMAT_IYUV) {
+
+        switch (dst_format) {
+        case SDL_PIXELFORMAT_RGB565:
+            yuv420_rgb565_avx2(width, height, y, u, v, y_stride, uv_stride, rgb, rgb_stride, yuv_type);
+            return SDL_TRUE;
+        case SDL_PIXELFORMAT_RGB24:
+            yuv420_rgb24_avx2(width, height, y, u, v, y_stride, uv_stride, rgb, rgb_stride, yuv_type);
+            return SDL_TRUE;
+        case SDL_PIXELFORMAT_RGBX8888:
+        case SDL_PIXELFORMAT_RGBA8888:
+            yuv420_rgba_avx2(width, height, y, u, v, y_stride, uv_stride, rgb, rgb_stride, yuv_type);
+            return SDL_TRUE;
+        case SDL_PIXELFORMAT_BGRX8888:
+        case SDL_PIXELFORMAT_BGRA8888:
+            yuv420_bgra_avx2(width, height, y, u, v, y_stride, uv_stride, rgb, rgb_stride, yuv_type);
+            return SDL_TRUE;
+        case SDL_PIXELFORMAT_RGB888:
+        case SDL_PIXELFORMAT_ARGB8888:
+            yuv420_argb_avx2(width, height, y, u, v, y_stride, uv_stride, rgb, rgb_stride, yuv_type);
+            return SDL_TRUE;
+        case SDL_PIXELFORMAT_BGR888:
+        case SDL_PIXELFORMAT_ABGR8888:
+            yuv420_abgr_avx2(width, height, y, u, v, y_stride, uv_stride, rgb, rgb_stride, yuv_type);
+            return SDL_TRUE;
+        default:
+            break;
+        }
+    }
+
+    if (src_format == SDL_PIXELFORMAT_YUY2 ||
+        src_format == SDL_PIXELFORMAT_UYVY ||
+        src_format == SDL_PIXELFORMAT_YVYU) {
+
+        switch (dst_format) {
+        case SDL_PIXELFORMAT_RGB565:
+            yuv422_rgb565_avx2(width, height, y, u, v, y_stride, uv_stride, rgb, rgb_stride, yuv_type);
+            return SDL_TRUE;
+        case SDL_PIXELFORMAT_RGB24:
+            yuv422_rgb24_avx2(width, height, y, u, v, y_stride, uv_stride, rgb, rgb_stride, yuv_type);
+            return SDL_TRUE;
+        case SDL_PIXELFORMAT_RGBX8888:
+        case SDL_PIXELFORMAT_RGBA8888:
+            yuv422_rgba_avx2(width, height, y, u, v, y_stride, uv_stride, rgb, rgb_stride, yuv_type);
+            return SDL_TRUE;
+        case SDL_PIXELFORMAT_BGRX8888:
+        case SDL_PIXELFORMAT_BGRA8888:
+            yuv422_bgra_avx2(width, height, y, u, v, y_stride, uv_stride, rgb, rgb_stride, yuv_type);
+            return SDL_TRUE;
+        case SDL_PIXELFORMAT_RGB888:
+        case SDL_PIXELFORMAT_ARGB8888:
+            yuv422_argb_avx2(width, height, y, u, v, y_stride, uv_stride, rgb, rgb_stride, yuv_type);
+            return SDL_TRUE;
+        case SDL_PIXELFORMAT_BGR888:
+        case SDL_PIXELFORMAT_ABGR8888:
+            yuv422_abgr_avx2(width, height, y, u, v, y_stride, uv_stride, rgb, rgb_stride, yuv_type);
+            return SDL_TRUE;
+        default:
+            break;
+        }
+    }
+
+    if (src_format == SDL_PIXELFORMAT_NV12 ||
+        src_format == SDL_PIXELFORMAT_NV21) {
+
+        switch (dst_format) {
+        case SDL_PIXELFORMAT_RGB565:
+            yuvnv12_rgb565_avx2(width, height, y, u, v, y_stride, uv_stride, rgb, rgb_stride, yuv_type);
+            return SDL_TRUE;
+        case SDL_PIXELFORMAT_RGB24:
+            yuvnv12_rgb24_avx2(width, height, y, u, v, y_stride, uv_stride, rgb, rgb_stride, yuv_type);
+            return SDL_TRUE;
+        case SDL_PIXELFORMAT_RGBX8888:
+        case SDL_PIXELFORMAT_RGBA8888:
+            yuvnv12_rgba_avx2(width, height, y, u, v, y_stride, uv_stride, rgb, rgb_stride, yuv_type);
+            return SDL_TRUE;
+        case SDL_PIXELFORMAT_BGRX8888:
+        case SDL_PIXELFORMAT_BGRA8888:
+            yuvnv12_bgra_avx2(width, height, y, u, v, y_stride, uv_stride, rgb, rgb_stride, yuv_type);
+            return SDL_TRUE;
+        case SDL_PIXELFORMAT_RGB888:
+        case SDL_PIXELFORMAT_ARGB8888:
+            yuvnv12_argb_avx2(width, height, y, u, v, y_stride, uv_stride, rgb, rgb_stride, yuv_type);
+            return SDL_TRUE;
+        case SDL_PIXELFORMAT_BGR888:
+        case SDL_PIXELFORMAT_ABGR8888:
+            yuvnv12_abgr_avx2(width, height, y, u, v, y_stride, uv_stride, rgb, rgb_stride, yuv_type);
+            return SDL_TRUE;
+        default:
+            break;
+        }
+    }
+#endif
+    return SDL_FALSE;
+}
+
 static SDL_bool yuv_rgb_std(
     Uint32 src_format, Uint32 dst_format,
     Uint32 width, Uint32 height, 
@@ -391,37 +541,227 @@ static SDL_bool yuv_rgb_std(
     return SDL_FALSE;
 }
 
-int
-SDL_ConvertPixels_YUV_to_RGB(int width, int height,
-         Uint32 src_format, const void *src, int src_pitch,
-         Uint32 dst_format, void *dst, int dst_pitch)
+/* One YUV to RGB conversion, from a rectangle of the source frame scaled
+   to the whole destination, converted a slice of the destination at a time */
+typedef struct
 {
-    const Uint8 *y = NULL;
-    const Uint8 *u = NULL;
-    const Uint8 *v = NULL;
-    Uint32 y_stride = 0;
-    Uint32 uv_stride = 0;
-    YCbCrType yuv_type = YCBCR_601;
-
-    if (GetYUVPlanes(width, height, src_format, src, src_pitch, &y, &u, &v, &y_stride, &uv_stride) < 0) {
+    Uint32 src_format, dst_format;
+    const Uint8 *y, *u, *v;
+    Uint32 y_stride, uv_stride;
+    SDL_Rect srcrect;
+    int dst_w, dst_h;
+    Uint8 *rgb;
+    Uint32 rgb_stride;
+    YCbCrType yuv_type;
+    SDL_atomic_t failed;        /* 1 if unsupported, -1 if out of memory */
+} YUV2RGBJob;
+
+/* Convert a block of the source frame starting at an even column */
+static SDL_bool yuv_rgb_block(const YUV2RGBJob *job, int x, int row, Uint32 width, Uint32 height, Uint8 *rgb)
+{
+    const SDL_bool planar = IsPlanar2x2Format(job->src_format);
+    const int y_step = planar ? 1 : 2;
+    const int uv_step = !planar ? 4 : (job->src_format == SDL_PIXELFORMAT_NV12 || job->src_format == SDL_PIXELFORMAT_NV21) ? 2 : 1;
+    const Uint8 *y, *u, *v;
+    Uint32 uv_row;
+
+    /* The kernels pair lines sharing chroma, which an odd line doesn't */
+    if (planar && (row & 1) && height > 1) {
+        if (!yuv_rgb_block(job, x, row, width, 1, rgb)) {
+            return SDL_FALSE;
+        }
+        ++row;
+        --height;
+        rgb += job->rgb_stride;
+    }
+
+    uv_row = planar ? (row / 2) : row;
+    y = job->y + row * job->y_stride + x * y_step;
+    u = job->u + uv_row * job->uv_stride + (x / 2) * uv_step;
+    v = job->v + uv_row * job->uv_stride + (x / 2) * uv_step;
+
+    if (yuv_rgb_avx2(job->src_format, job->dst_format, width, height, y, u, v, job->y_stride, job->uv_stride, rgb, job->rgb_stride, job->yuv_type)) {
+        return SDL_TRUE;
+    }
+
+    if (yuv_rgb_sse(job->src_format, job->dst_format, width, height, y, u, v, job->y_stride, job->uv_stride, rgb, job->rgb_stride, job->yuv_type)) {
+        return SDL_TRUE;
+    }
+
+    if (yuv_rgb_std(job->src_format, job->dst_format, width, height, y, u, v, job->y_stride, job->uv_stride, rgb, job->rgb_stride, job->yuv_type)) {
+        return SDL_TRUE;
+    }
+
+    return SDL_FALSE;
+}
+
+/* Nearest neighbor scaling of one converted row, sampling the source pixel
+   under the center of each destination pixel, same as the rows. That's
+   ((2 * i + 1) * src_w) / (2 * dst_w), stepped along exactly, since 16.16
+   fixed point can land a pixel short right on the boundaries. */
+#define YUV_RGB_STRETCH_STEP() \
+    pos += step;               \
+    frac += frac_step;         \
+    if (frac >= den) {         \
+        frac -= den;           \
+        ++pos;                 \
+    }
+
+static void yuv_rgb_stretch_row(const Uint8 *src, int src_w, Uint8 *dst, int dst_w, int bpp)
+{
+    const int den = 2 * dst_w;
+    const int step = src_w / dst_w;
+    const int frac_step = (2 * src_w) % den;
+    int pos = src_w / den;
+    int frac = src_w % den;
+    int i;
+
+    switch (bpp) {
+    case 4:
+        for (i = 0; i < dst_w; ++i) {
+            ((Uint32 *) dst)[i] = ((const Uint32 *) src)[pos];
+            YUV_RGB_STRETCH_STEP();
+        }
+        break;
+    case 3:
+        for (i = 0; i < dst_w; ++i, dst += 3) {
+            const Uint8 *pixel = src + pos * 3;
+            dst[0] = pixel[0];
+            dst[1] = pixel[1];
+            dst[2] = pixel[2];
+            YUV_RGB_STRETCH_STEP();
+        }
+        break;
+    case 2:
+        for (i = 0; i < dst_w; ++i) {
+            ((Uint16 *) dst)[i] = ((const Uint16 *) src)[pos];
+            YUV_RGB_STRETCH_STEP();
+        }
+        break;
+    }
+}
+
+#undef YUV_RGB_STRETCH_STEP
+
+static void SDLCALL yuv_rgb_slices(void *data, int start, int end)
+{
+    YUV2RGBJob *job = (YUV2RGBJob *) data;
+    const SDL_Rect *rect = &job->srcrect;
+    const int row = start * SDL_YUV_SLICE_ROWS;
+    const int last = SDL_min(end * SDL_YUV_SLICE_ROWS, job->dst_h);
+    const int bpp = SDL_BYTESPERPIXEL(job->dst_format);
+    const int x = rect->x & ~1;
+    const int width = rect->w + (rect->x & 1);
+    const SDL_bool direct = (rect->w == job->dst_w && x == rect->x);
+    Uint8 *buffer = NULL;
+    int dy, sy, prev_sy = -1;
+
+    if (direct && rect->h == job->dst_h) {
+        if (!yuv_rgb_block(job, x, rect->y + row, width, last - row, job->rgb + row * job->rgb_stride)) {
+            SDL_AtomicSet(&job->failed, 1);
+        }
+        return;
+    }
+
+    /* Convert each source row needed once, scaling it into place as we go */
+    if (!direct) {
+        buffer = (Uint8 *) SDL_malloc(width * bpp);
+        if (!buffer) {
+            SDL_AtomicSet(&job->failed, -1);
+            return;
+        }
+    }
+
+    for (dy = row; dy < last; ++dy) {
+        Uint8 *dst = job->rgb + dy * job->rgb_stride;
+
+        sy = rect->y + (int) (((Sint64) (2 * dy + 1) * rect->h) / (2 * job->dst_h));
+        if (sy == prev_sy) {
+            SDL_memcpy(dst, dst - job->rgb_stride, job->dst_w * bpp);
+        } else if (!yuv_rgb_block(job, x, sy, width, 1, direct ? dst : buffer)) {
+            SDL_AtomicSet(&job->failed, 1);
+            break;
+        } else if (!direct) {
+            yuv_rgb_stretch_row(buffer + (rect->x - x) * bpp, rect->w, dst, job->dst_w, bpp);
+        }
+        prev_sy = sy;
+    }
+
+    SDL_free(buffer);
+}
+
+/* Returns 1 if there's no fast path for the formats */
+static int
+ConvertYUVToRGBScaled(int width, int height,
+         Uint32 src_format, const void *src, int src_pitch, const SDL_Rect *srcrect,
+         Uint32 dst_format, void *dst, int dst_w, int dst_h, int dst_pitch)
+{
+    YUV2RGBJob job;
+
+    job.src_format = src_format;
+    job.dst_format = dst_format;
+    job.y = job.u = job.v = NULL;
+    job.y_stride = job.uv_stride = 0;
+    job.srcrect = *srcrect;
+    job.dst_w = dst_w;
+    job.dst_h = dst_h;
+    job.rgb = (Uint8 *) dst;
+    job.rgb_stride = dst_pitch;
+    job.yuv_type = YCBCR_601;
+    SDL_AtomicSet(&job.failed, 0);
+
+    if (GetYUVPlanes(width, height, src_format, src, src_pitch, &job.y, &job.u, &job.v, &job.y_stride, &job.uv_stride) < 0) {
         return -1;
     }
 
-    if (GetYUVConversionType(width, height, &yuv_type) < 0) {
+    if (GetYUVConversionType(width, height, &job.yuv_type) < 0) {
         return -1;
     }
 
-    if (yuv_rgb_sse(src_format, dst_format, width, height, y, u, v, y_stride, uv_stride, (Uint8*)dst, dst_pitch, yuv_type)) {
-        return 0;
+    /* The fast paths depend only on the formats, so either every slice
+       converts or none of them touch the destination. */
+    ConvertYUVSlices(dst_w, dst_h, yuv_rgb_slices, &job);
+    if (SDL_AtomicGet(&job.failed) < 0) {
+        return SDL_OutOfMemory();
     }
+    return SDL_AtomicGet(&job.failed);
+}
 
-    if (yuv_rgb_std(src_format, dst_format, width, height, y, u, v, y_stride, uv_stride, (Uint8*)dst, dst_pitch, yuv_type)) {
+int
+SDL_ConvertPixels_YUV_to_RGB_Scaled(int width, int height,
+         Uint32 src_format, const void *src, int src_pitch, const SDL_Rect *srcrect,
+         Uint32 dst_format, void *dst, int dst_w, int dst_h, int dst_pitch)
+{
+    if (srcrect->x < 0 || srcrect->y < 0 || srcrect->w <= 0 || srcrect->h <= 0 ||
+        srcrect->x + srcrect->w > width || srcrect->y + srcrect->h > height) {
+        return SDL_InvalidParamError("srcrect");
+    }
+    if (dst_w <= 0 || dst_h <= 0) {
         return 0;
     }
 
+    return ConvertYUVToRGBScaled(width, height, src_format, src, src_pitch, srcrect, dst_format, dst, dst_w, dst_h, dst_pitch);
+}
+
+int
+SDL_ConvertPixels_YUV_to_RGB(int width, int height,
+         Uint32 src_format, const void *src, int src_pitch,
+         Uint32 dst_format, void *dst, int dst_pitch)
+{
+    SDL_Rect rect;
+    int ret;
+
+    rect.x = 0;
+    rect.y = 0;
+    rect.w = width;
+    rect.h = height;
+    ret = ConvertYUVToRGBScaled(width, height, src_format, src, src_pitch, &rect, dst_format, dst, width, height, dst_pitch);
+    if (ret <= 0) {
+        return ret;
+    }
+
     /* No fast path for the RGB format, instead convert using an intermediate buffer */
     if (dst_format != SDL_PIXELFORMAT_ARGB8888) {
-        int ret;
         void *tmp;
         int tmp_pitch = (width * sizeof(Uint32));
 
@@ -446,337 +786,612 @@ SDL_ConvertPixels_YUV_to_RGB(int width, int height,
     return SDL_SetError("Unsupported YUV conversion");
 }
 
+/* RGB to YUV factors in 1.15 fixed point, from these matrices:
+     ITU-T T.871 (JPEG):  Y  0.2990  0.5870  0.1140
+                          U -0.1687 -0.3313  0.5000
+                          V  0.5000 -0.4187 -0.0813
+     ITU-R BT.601-7:      Y  0.2568  0.5041  0.0979   (+16)
+                          U -0.1482 -0.2910  0.4392
+                          V  0.4392 -0.3678 -0.0714
+     ITU-R BT.709-6:      Y  0.1826  0.6142  0.0620   (+16)
+                          U -0.1006 -0.3386  0.4392
+                          V  0.4392 -0.3989 -0.0403
+   The green factors absorb the rounding error, so grey still maps to
+   exactly 128 for U and V. */
 struct RGB2YUVFactors
 {
     int y_offset;
-    float y[3]; /* Rfactor, Gfactor, Bfactor */
-    float u[3]; /* Rfactor, Gfactor, Bfactor */
-    float v[3]; /* Rfactor, Gfactor, Bfactor */
+    int y[3]; /* Rfactor, Gfactor, Bfactor */
+    int u[3]; /* Rfactor, Gfactor, Bfactor */
+    int v[3]; /* Rfactor, Gfactor, Bfactor */
+};
+
+static const struct RGB2YUVFactors RGB2YUVFactorTables[SDL_YUV_CONVERSION_BT709 + 1] =
+{
+    { 0,  { 9798, 19234, 3736 }, { -5528, -10856, 16384 }, { 16384, -13720, -2664 } },
+    { 16, { 8415, 16518, 3208 }, { -4856,  -9536, 14392 }, { 14392, -12052, -2340 } },
+    { 16, { 5983, 20126, 2032 }, { -3296, -11096, 14392 }, { 14392, -13071, -1321 } },
 };
 
+#define RGB2YUV_UV_ADD  ((128 << 15) + (1 << 14))
+
+/* Everything the row encoders need to know about one conversion */
+typedef struct
+{
+    int bpp;                    /* 3 or 4 */
+    int r, g, b;                /* bit positions in the little end of a pixel */
+    const int *y, *u, *v;       /* factors from RGB2YUVFactorTables */
+    int y_add;                  /* Y offset and rounding, in 1.15 fixed point */
+    SDL_bool use_sse2;
+    SDL_bool use_avx2;
+} RGB2YUVContext;
+
+/* Fill in the source layout for the RGB formats we can encode directly */
+static SDL_bool
+RGB2YUV_GetLayout(Uint32 format, RGB2YUVContext *ctx)
+{
+    switch (format) {
+    case SDL_PIXELFORMAT_ARGB8888:
+    case SDL_PIXELFORMAT_RGB888:
+        ctx->bpp = 4; ctx->r = 16; ctx->g = 8; ctx->b = 0;
+        return SDL_TRUE;
+    case SDL_PIXELFORMAT_ABGR8888:
+    case SDL_PIXELFORMAT_BGR888:
+        ctx->bpp = 4; ctx->r = 0; ctx->g = 8; ctx->b = 16;
+        return SDL_TRUE;
+    case SDL_PIXELFORMAT_RGBA8888:
+    case SDL_PIXELFORMAT_RGBX8888:
+        ctx->bpp = 4; ctx->r = 24; ctx->g = 16; ctx->b = 8;
+        return SDL_TRUE;
+    case SDL_PIXELFORMAT_BGRA8888:
+    case SDL_PIXELFORMAT_BGRX8888:
+        ctx->bpp = 4; ctx->r = 8; ctx->g = 16; ctx->b = 24;
+        return SDL_TRUE;
+    /* 24-bit formats are byte arrays, so these are byte offsets times 8 */
+    case SDL_PIXELFORMAT_RGB24:
+        ctx->bpp = 3; ctx->r = 0; ctx->g = 8; ctx->b = 16;
+        return SDL_TRUE;
+    case SDL_PIXELFORMAT_BGR24:
+        ctx->bpp = 3; ctx->r = 16; ctx->g = 8; ctx->b = 0;
+        return SDL_TRUE;
+    default:
+        return SDL_FALSE;
+    }
+}
+
+static SDL_INLINE Uint8
+RGB2YUV_Clamp(int v)
+{
+    return (Uint8)((v < 0) ? 0 : ((v > 255) ? 255 : v));
+}
+
+static SDL_INLINE void
+RGB2YUV_Read(const RGB2YUVContext *ctx, const Uint8 *row, int x, int *r, int *g, int *b)
+{
+    if (ctx->bpp == 4) {
+        const Uint32 p = ((const Uint32 *)row)[x];
+        *r = (p >> ctx->r) & 0xFF;
+        *g = (p >> ctx->g) & 0xFF;
+        *b = (p >> ctx->b) & 0xFF;
+    } else {
+        const Uint8 *p = row + x * 3;
+        *r = p[ctx->r >> 3];
+        *g = p[ctx->g >> 3];
+        *b = p[ctx->b >> 3];
+    }
+}
+
+#define RGB2YUV_Y(r, g, b) RGB2YUV_Clamp((ctx->y[0] * (r) + ctx->y[1] * (g) + ctx->y[2] * (b) + ctx->y_add) >> 15)
+#define RGB2YUV_U(r, g, b) RGB2YUV_Clamp((ctx->u[0] * (r) + ctx->u[1] * (g) + ctx->u[2] * (b) + RGB2YUV_UV_ADD) >> 15)
+#define RGB2YUV_V(r, g, b) RGB2YUV_Clamp((ctx->v[0] * (r) + ctx->v[1] * (g) + ctx->v[2] * (b) + RGB2YUV_UV_ADD) >> 15)
+
+/* Where Y0, U, Y1 and V go in a packed 4:2:2 macropixel */
+static void
+RGB2YUV_GetPacked4Offsets(Uint32 format, int *yo, int *uo, int *vo)
+{
+    switch (format) {
+    case SDL_PIXELFORMAT_UYVY:
+        *yo = 1; *uo = 0; *vo = 2;
+        break;
+    case SDL_PIXELFORMAT_YVYU:
+        *yo = 0; *uo = 3; *vo = 1;
+        break;
+    default: /* SDL_PIXELFORMAT_YUY2 */
+        *yo = 0; *uo = 1; *vo = 3;
+        break;
+    }
+}
+
+/* The SIMD encoders below work on whole vectors of pixels, starting at
+   pixel x, and return where they stopped; the scalar code finishes the
+   row. Chroma is the truncated average of each 2x2 (or 2x1) block of RGB,
+   same as the scalar code, so all paths give identical results. */
+
+#ifdef __SSE2__
+/* 24-bit pixels can be read 16 bytes at a time as long as the last load
+   doesn't run off the end of the row: 4 pixels need 12 bytes, so we want
+   room for 4 more, which is 2 pixels. */
+#define RGB2YUV_SIMD_LIMIT(width) ((ctx->bpp == 3) ? ((width) - 2) : (width))
+
+/* Spread four 24-bit pixels into the low bytes of four 32-bit lanes */
+static SDL_INLINE __m128i
+RGB2YUV_SSE2_Load(const RGB2YUVContext *ctx, const Uint8 *row, int x)
+{
+    if (ctx->bpp == 4) {
+        return _mm_loadu_si128((const __m128i *)(row + x * 4));
+    } else {
+        const __m128i mask = _mm_set_epi32(0, 0, 0, 0x00FFFFFF);
+        const __m128i p = _mm_loadu_si128((const __m128i *)(row + x * 3));
+        __m128i v = _mm_and_si128(p, mask);
+        v = _mm_or_si128(v, _mm_and_si128(_mm_slli_si128(p, 1), _mm_slli_si128(mask, 4)));
+        v = _mm_or_si128(v, _mm_and_si128(_mm_slli_si128(p, 2), _mm_slli_si128(mask, 8)));
+        v = _mm_or_si128(v, _mm_and_si128(_mm_slli_si128(p, 3), _mm_slli_si128(mask, 12)));
+        return v;
+    }
+}
+
+/* Pack a factor pair for _mm_madd_epi16() against lanes of (lo | hi << 16) */
+#define RGB2YUV_PAIR(lo, hi) ((int)(((Uint32)(hi) << 16) | ((Uint32)(lo) & 0xFFFF)))
+
+#define RGB2YUV_SSE2_SPLIT(p, r, g, b)                          \
+    r = _mm_and_si128(_mm_srl_epi32(p, rshift), mask);          \
+    g = _mm_and_si128(_mm_srl_epi32(p, gshift), mask);          \
+    b = _mm_and_si128(_mm_srl_epi32(p, bshift), mask);
+
+#define RGB2YUV_SSE2_DOT(r, g, b, f, add)                                               \
+    _mm_srai_epi32(_mm_add_epi32(_mm_add_epi32(                                         \
+        _mm_madd_epi16(_mm_or_si128(r, _mm_slli_epi32(g, 16)), f##_rg),                 \
+        _mm_madd_epi16(b, f##_b)), add), 15)
+
+/* Sum adjacent lanes: [a0+a1, a2+a3, b0+b1, b2+b3] */
+#define RGB2YUV_SSE2_PAIRS(a, b)                                                        \
+    _mm_unpacklo_epi64(                                                                 \
+        _mm_shuffle_epi32(_mm_add_epi32(a, _mm_srli_epi64(a, 32)), _MM_SHUFFLE(3, 1, 2, 0)), \
+        _mm_shuffle_epi32(_mm_add_epi32(b, _mm_srli_epi64(b, 32)), _MM_SHUFFLE(3, 1, 2, 0)))
+
+#define RGB2YUV_SSE2_SETUP                                                              \
+    const __m128i rshift = _mm_cvtsi32_si128(ctx->r);                                   \
+    const __m128i gshift = _mm_cvtsi32_si128(ctx->g);                                   \
+    const __m128i bshift = _mm_cvtsi32_si128(ctx->b);                                   \
+    const __m128i mask = _mm_set1_epi32(0xFF);                                          \
+    const __m128i y_rg = _mm_set1_epi32(RGB2YUV_PAIR(ctx->y[0], ctx->y[1]));            \
+    const __m128i y_b = _mm_set1_epi32(RGB2YUV_PAIR(ctx->y[2], 0));                     \
+    const __m128i u_rg = _mm_set1_epi32(RGB2YUV_PAIR(ctx->u[0], ctx->u[1]));            \
+    const __m128i u_b = _mm_set1_epi32(RGB2YUV_PAIR(ctx->u[2], 0));                     \
+    const __m128i v_rg = _mm_set1_epi32(RGB2YUV_PAIR(ctx->v[0], ctx->v[1]));            \
+    const __m128i v_b = _mm_set1_epi32(RGB2YUV_PAIR(ctx->v[2], 0));                     \
+    const __m128i y_add = _mm_set1_epi32(ctx->y_add);                                   \
+    const __m128i uv_add = _mm_set1_epi32(RGB2YUV_UV_ADD);                              \
+    const int limit = RGB2YUV_SIMD_LIMIT(width);
+
+/* Eight pixels from each of two rows per loop */
 static int
-SDL_ConvertPixels_ARGB8888_to_YUV(int width, int height, const void *src, int src_pitch, Uint32 dst_format, void *dst, int dst_pitch)
+RGB2YUV_EncodeRows420_SSE2(const RGB2YUVContext *ctx, int x, int width,
+                           const Uint8 *src0, const Uint8 *src1,
+                           Uint8 *y0, Uint8 *y1, Uint8 *u, Uint8 *v, int uv_step)
 {
-    const int src_pitch_x_2    = src_pitch * 2;
-    const int height_half      = height / 2;
-    const int height_remainder = (height & 0x1);
-    const int width_half       = width / 2;
-    const int width_remainder  = (width & 0x1);
-    int i, j;
- 
-    static struct RGB2YUVFactors RGB2YUVFactorTables[SDL_YUV_CONVERSION_BT709 + 1] =
-    {
-        /* ITU-T T.871 (JPEG) */
-        {
-            0,
-            {  0.2990f,  0.5870f,  0.1140f },
-            { -0.1687f, -0.3313f,  0.5000f },
-            {  0.5000f, -0.4187f, -0.0813f },
-        },
-        /* ITU-R BT.601-7 */
-        {
-            16,
-            {  0.2568f,  0.5041f,  0.0979f },
-            { -0.1482f, -0.2910f,  0.4392f },
-            {  0.4392f, -0.3678f, -0.0714f },
-        },
-        /* ITU-R BT.709-6 */
-        {
-            16,
-            { 0.1826f,  0.6142f,  0.0620f },
-            {-0.1006f, -0.3386f,  0.4392f },
-            { 0.4392f, -0.3989f, -0.0403f },
-        },
-    };
-    const struct RGB2YUVFactors *cvt = &RGB2YUVFactorTables[SDL_GetYUVConversionModeForResolution(width, height)];
-
-#define MAKE_Y(r, g, b) (Uint8)((int)(cvt->y[0] * (r) + cvt->y[1] * (g) + cvt->y[2] * (b) + 0.5f) + cvt->y_offset)
-#define MAKE_U(r, g, b) (Uint8)((int)(cvt->u[0] * (r) + cvt->u[1] * (g) + cvt->u[2] * (b) + 0.5f) + 128)
-#define MAKE_V(r, g, b) (Uint8)((int)(cvt->v[0] * (r) + cvt->v[1] * (g) + cvt->v[2] * (b) + 0.5f) + 128)
-
-#define READ_2x2_PIXELS                                                                                         \
-        const Uint32 p1 = ((const Uint32 *)curr_row)[2 * i];                                                    \
-        const Uint32 p2 = ((const Uint32 *)curr_row)[2 * i + 1];                                                \
-        const Uint32 p3 = ((const Uint32 *)next_row)[2 * i];                                                    \
-        const Uint32 p4 = ((const Uint32 *)next_row)[2 * i + 1];                                                \
-        const Uint32 r = ((p1 & 0x00ff0000) + (p2 & 0x00ff0000) + (p3 & 0x00ff0000) + (p4 & 0x00ff0000)) >> 18; \
-        const Uint32 g = ((p1 & 0x0000ff00) + (p2 & 0x0000ff00) + (p3 & 0x0000ff00) + (p4 & 0x0000ff00)) >> 10; \
-        const Uint32 b = ((p1 & 0x000000ff) + (p2 & 0x000000ff) + (p3 & 0x000000ff) + (p4 & 0x000000ff)) >> 2;  \
-
-#define READ_2x1_PIXELS                                                                                         \
-        const Uint32 p1 = ((const Uint32 *)curr_row)[2 * i];                                                    \
-        const Uint32 p2 = ((const Uint32 *)next_row)[2 * i];                                                    \
-        const Uint32 r = ((p1 & 0x00ff0000) + (p2 & 0x00ff0000)) >> 17;                                         \
-        const Uint32 g = ((p1 & 0x0000ff00) + (p2 & 0x0000ff00)) >> 9;                                          \
-        const Uint32 b = ((p1 & 0x000000ff) + (p2 & 0x000000ff)) >> 1;                                          \
-
-#define READ_1x2_PIXELS                                                                                         \
-        const Uint32 p1 = ((const Uint32 *)curr_row)[2 * i];                                                    \
-        const Uint32 p2 = ((const Uint32 *)curr_row)[2 * i + 1];                                                \
-        const Uint32 r = ((p1 & 0x00ff0000) + (p2 & 0x00ff0000)) >> 17;                                         \
-        const Uint32 g = ((p1 & 0x0000ff00) + (p2 & 0x0000ff00)) >> 9;                                          \
-        const Uint32 b = ((p1 & 0x000000ff) + (p2 & 0x000000ff)) >> 1;                                          \
-
-#define READ_1x1_PIXEL                                                                                          \
-        const Uint32 p = ((const Uint32 *)curr_row)[2 * i];                                                     \
-        const Uint32 r = (p & 0x00ff0000) >> 16;                                                                \
-        const Uint32 g = (p & 0x0000ff00) >> 8;                                                                 \
-        const Uint32 b = (p & 0x000000ff);                                                                      \
-
-#define READ_TWO_RGB_PIXELS                                                                                     \
-        const Uint32 p = ((const Uint32 *)curr_row)[2 * i];                                                     \
-        const Uint32 r = (p & 0x00ff0000) >> 16;                                                                \
-        const Uint32 g = (p & 0x0000ff00) >> 8;                                                                 \
-        const Uint32 b = (p & 0x000000ff);                                                                      \
-        const Uint32 p1 = ((const Uint32 *)curr_row)[2 * i + 1];                                                \
-        const Uint32 r1 = (p1 & 0x00ff0000) >> 16;                                                              \
-        const Uint32 g1 = (p1 & 0x0000ff00) >> 8;                                                               \
-        const Uint32 b1 = (p1 & 0x000000ff);                                                                    \
-        const Uint32 R = (r + r1)/2;                                                                            \
-        const Uint32 G = (g + g1)/2;                                                                            \
-        const Uint32 B = (b + b1)/2;                                                                            \
-
-#define READ_ONE_RGB_PIXEL  READ_1x1_PIXEL
-
-    switch (dst_format) 
+    RGB2YUV_SSE2_SETUP
+
+    for (; x + 8 <= limit; x += 8) {
+        __m128i r0, g0, b0, r1, g1, b1, r2, g2, b2, r3, g3, b3;
+        __m128i p, r, g, b, uv;
+
+        p = RGB2YUV_SSE2_Load(ctx, src0, x);
+        RGB2YUV_SSE2_SPLIT(p, r0, g0, b0);
+        p = RGB2YUV_SSE2_Load(ctx, src0, x + 4);
+        RGB2YUV_SSE2_SPLIT(p, r1, g1, b1);
+        p = _mm_packs_epi32(RGB2YUV_SSE2_DOT(r0, g0, b0, y, y_add), RGB2YUV_SSE2_DOT(r1, g1, b1, y, y_add));
+        _mm_storel_epi64((__m128i *)(y0 + x), _mm_packus_epi16(p, p));
+
+        p = RGB2YUV_SSE2_Load(ctx, src1, x);
+        RGB2YUV_SSE2_SPLIT(p, r2, g2, b2);
+        p = RGB2YUV_SSE2_Load(ctx, src1, x + 4);
+        RGB2YUV_SSE2_SPLIT(p, r3, g3, b3);
+        if (y1) {
+            p = _mm_packs_epi32(RGB2YUV_SSE2_DOT(r2, g2, b2, y, y_add), RGB2YUV_SSE2_DOT(r3, g3, b3, y, y_add));
+            _mm_storel_epi64((__m128i *)(y1 + x), _mm_packus_epi16(p, p));
+        }
+
+        r = _mm_srli_epi32(RGB2YUV_SSE2_PAIRS(_mm_add_epi32(r0, r2), _mm_add_epi32(r1, r3)), 2);
+        g = _mm_srli_epi32(RGB2YUV_SSE2_PAIRS(_mm_add_epi32(g0, g2), _mm_add_epi32(g1, g3)), 2);
+        b = _mm_srli_epi32(RGB2YUV_SSE2_PAIRS(_mm_add_epi32(b0, b2), _mm_add_epi32(b1, b3)), 2);
+        uv = _mm_packs_epi32(RGB2YUV_SSE2_DOT(r, g, b, u, uv_add), RGB2YUV_SSE2_DOT(r, g, b, v, uv_add));
+        uv = _mm_packus_epi16(uv, uv);      /* U0 U1 U2 U3 V0 V1 V2 V3 */
+        if (uv_step == 1) {
+            *(Uint32 *)(u + x / 2) = (Uint32)_mm_cvtsi128_si32(uv);
+            *(Uint32 *)(v + x / 2) = (Uint32)_mm_cvtsi128_si32(_mm_srli_si128(uv, 4));
+        } else if (u < v) {
+            _mm_storel_epi64((__m128i *)(u + x), _mm_unpacklo_epi8(uv, _mm_srli_si128(uv, 4)));
+        } else {
+            _mm_storel_epi64((__m128i *)(v + x), _mm_unpacklo_epi8(_mm_srli_si128(uv, 4), uv));
+        }
+    }
+    return x;
+}
+
+/* Eight pixels per loop, into four macropixels */
+static int
+RGB2YUV_EncodeRowPacked4_SSE2(const RGB2YUVContext *ctx, int x, int width,
+                              const Uint8 *src, Uint8 *dst, int yo, int uo)
+{
+    RGB2YUV_SSE2_SETUP
+
+    for (; x + 8 <= limit; x += 8) {
+        __m128i r0, g0, b0, r1, g1, b1;
+        __m128i p, r, g, b, yy, uv;
+
+        p = RGB2YUV_SSE2_Load(ctx, src, x);
+        RGB2YUV_SSE2_SPLIT(p, r0, g0, b0);
+        p = RGB2YUV_SSE2_Load(ctx, src, x + 4);
+        RGB2YUV_SSE2_SPLIT(p, r1, g1, b1);
+        yy = _mm_packs_epi32(RGB2YUV_SSE2_DOT(r0, g0, b0, y, y_add), RGB2YUV_SSE2_DOT(r1, g1, b1, y, y_add));
+        yy = _mm_packus_epi16(yy, yy);
+
+        r = _mm_srli_epi32(RGB2YUV_SSE2_PAIRS(r0, r1), 1);
+        g = _mm_srli_epi32(RGB2YUV_SSE2_PAIRS(g0, g1), 1);
+        b = _mm_srli_epi32(RGB2YUV_SSE2_PAIRS(b0, b1), 1);
+        uv = _mm_packs_epi32(RGB2YUV_SSE2_DOT(r, g, b, u, uv_add), RGB2YUV_SSE2_DOT(r, g, b, v, uv_add));
+        uv = _mm_packus_epi16(uv, uv);      /* U0 U1 U2 U3 V0 V1 V2 V3 */
+        if (uo < 2) {
+            uv = _mm_unpacklo_epi8(uv, _mm_srli_si128(uv, 4));
+        } else {
+            uv = _mm_unpacklo_epi8(_mm_srli_si128(uv, 4), uv);
+        }
+        if (yo == 0) {
+            _mm_storeu_si128((__m128i *)(dst + x * 2), _mm_unpacklo_epi8(yy, uv));
+        } else {
+            _mm_storeu_si128((__m128i *)(dst + x * 2), _mm_unpacklo_epi8(uv, yy));
+        }
+    }
+    return x;
+}
+#endif /* __SSE2__ */
+
+#if HAVE_AVX2_INTRINSICS
+static SDL_INLINE __m256i
+RGB2YUV_AVX2_Load(const RGB2YUVContext *ctx, const Uint8 *row, int x)
+{
+    if (ctx->bpp == 4) {
+        return _mm256_loadu_si256((const __m256i *)(row + x * 4));
+    } else {
+        return _mm256_inserti128_si256(_mm256_castsi128_si256(RGB2YUV_SSE2_Load(ctx, row, x)),
+                                       RGB2YUV_SSE2_Load(ctx, row, x + 4), 1);
+    }
+}
+
+#define RGB2YUV_AVX2_SPLIT(p, r, g, b)                          \
+    r = _mm256_and_si256(_mm256_srl_epi32(p, rshift), mask);    \
+    g = _mm256_and_si256(_mm256_srl_epi32(p, gshift), mask);    \
+    b = _mm256_and_si256(_mm256_srl_epi32(p, bshift), mask);
+
+#define RGB2YUV_AVX2_DOT(r, g, b, f, add)                                               \
+    _mm256_srai_epi32(_mm256_add_epi32(_mm256_add_epi32(                                \
+        _mm256_madd_epi16(_mm256_or_si256(r, _mm256_slli_epi32(g, 16)), f##_rg),        \
+        _mm256_madd_epi16(b, f##_b)), add), 15)
+
+/* AVX2 packs and unpacks work within each 128-bit half, so put the 64-bit
+   quarters back in order afterwards. */
+#define RGB2YUV_AVX2_FIXUP(x) _mm256_permute4x64_epi64(x, _MM_SHUFFLE(3, 1, 2, 0))
+
+#define RGB2YUV_AVX2_PAIRS(a, b)                                                        \
+    RGB2YUV_AVX2_FIXUP(_mm256_unpacklo_epi64(                                           \
+        _mm256_shuffle_epi32(_mm256_add_epi32(a, _mm256_srli_epi64(a, 32)), _MM_SHUFFLE(3, 1, 2, 0)), \
+        _mm256_shuffle_epi32(_mm256_add_epi32(b, _mm256_srli_epi64(b, 32)), _MM_SHUFFLE(3, 1, 2, 0))))
+
+/* Sixteen Sint32 in two vectors to sixteen Uint8 */
+#define RGB2YUV_AVX2_PACK(a, b, out)                                                    \
+    out = RGB2YUV_AVX2_FIXUP(_mm256_packs_epi32(a, b));                                 \
+    out = RGB2YUV_AVX2_FIXUP(_mm256_packus_epi16(out, out));
+
+/* Eight U and eight V in two vectors to U0..U7 V0..V7 */
+#define RGB2YUV_AVX2_PACK_UV(uu, vv, out)                                               \
+    {                                                                                   \
+        const __m256i t = RGB2YUV_AVX2_FIXUP(_mm256_packs_epi32(uu, vv));               \
+        out = _mm_packus_epi16(_mm256_castsi256_si128(t), _mm256_extracti128_si256(t, 1)); \
+    }
+
+#define RGB2YUV_AVX2_SETUP                                                              \
+    const __m128i rshift = _mm_cvtsi32_si128(ctx->r);                                   \
+    const __m128i gshift = _mm_cvtsi32_si128(ctx->g);                                   \
+    const __m128i bshift = _mm_cvtsi32_si128(ctx->b);                                   \
+    const __m256i mask = _mm256_set1_epi32(0xFF);                                       \
+    const __m256i y_rg = _mm256_set1_epi32(RGB2YUV_PAIR(ctx->y[0], ctx->y[1]));         \
+    const __m256i y_b = _mm256_set1_epi32(RGB2YUV_PAIR(ctx->y[2], 0));                  \
+    const __m256i u_rg = _mm256_set1_epi32(RGB2YUV_PAIR(ctx->u[0], ctx->u[1]));         \
+    const __m256i u_b = _mm256_set1_epi32(RGB2YUV_PAIR(ctx->u[2], 0));                  \
+    const __m256i v_rg = _mm256_set1_epi32(RGB2YUV_PAIR(ctx->v[0], ctx->v[1]));         \
+    const __m256i v_b = _mm256_set1_epi32(RGB2YUV_PAIR(ctx->v[2], 0));                  \
+    const __m256i y_add = _mm256_set1_epi32(ctx->y_add);                                \
+    const __m256i uv_add = _mm256_set1_epi32(RGB2YUV_UV_ADD);                           \
+    const int limit = RGB2YUV_SIMD_LIMIT(width);
+
+/* Sixteen pixels from each of two rows per loop */
+static int
+RGB2YUV_EncodeRows420_AVX2(const RGB2YUVContext *ctx, int x, int width,
+                           const Uint8 *src0, const Uint8 *src1,
+                           Uint8 *y0, Uint8 *y1, Uint8 *u, Uint8 *v, int uv_step)
+{
+    RGB2YUV_AVX2_SETUP
+
+    for (; x + 16 <= limit; x += 16) {
+        __m256i r0, g0, b0, r1, g1, b1, r2, g2, b2, r3, g3, b3;
+        __m256i p, r, g, b;
+        __m128i uv;
+
+        p = RGB2YUV_AVX2_Load(ctx, src0, x);
+        RGB2YUV_AVX2_SPLIT(p, r0, g0, b0);
+        p = RGB2YUV_AVX2_Load(ctx, src0, x + 8);
+        RGB2YUV_AVX2_SPLIT(p, r1, g1, b1);
+        RGB2YUV_AVX2_PACK(RGB2YUV_AVX2_DOT(r0, g0, b0, y, y_add), RGB2YUV_AVX2_DOT(r1, g1, b1, y, y_add), p);
+        _mm_storeu_si128((__m128i *)(y0 + x), _mm256_castsi256_si128(p));
+
+        p = RGB2YUV_AVX2_Load(ctx, src1, x);
+        RGB2YUV_AVX2_SPLIT(p, r2, g2, b2);
+        p = RGB2YUV_AVX2_Load(ctx, src1, x + 8);
+        RGB2YUV_AVX2_SPLIT(p, r3, g3, b3);
+        if (y1) {
+            RGB2YUV_AVX2_PACK(RGB2YUV_AVX2_DOT(r2, g2, b2, y, y_add), RGB2YUV_AVX2_DOT(r3, g3, b3, y, y_add), p);
+            _mm_storeu_si128((__m128i *)(y1 + x), _mm256_castsi256_si128(p));
+        }
+
+        r = _mm256_srli_epi32(RGB2YUV_AVX2_PAIRS(_mm256_add_epi32(r0, r2), _mm256_add_epi32(r1, r3)), 2);
+        g = _mm256_srli_epi32(RGB2YUV_AVX2_PAIRS(_mm256_add_epi32(g0, g2), _mm256_add_epi32(g1, g3)), 2);
+        b = _mm256_srli_epi32(RGB2YUV_AVX2_PAIRS(_mm256_add_epi32(b0, b2), _mm256_add_epi32(b1, b3)), 2);
+        RGB2YUV_AVX2_PACK_UV(RGB2YUV_AVX2_DOT(r, g, b, u, uv_add), RGB2YUV_AVX2_DOT(r, g, b, v, uv_add), uv);
+        if (uv_step == 1) {
+            _mm_storel_epi64((__m128i *)(u + x / 2), uv);
+            _mm_storel_epi64((__m128i *)(v + x / 2), _mm_srli_si128(uv, 8));
+        } else if (u < v) {
+            _mm_storeu_si128((__m128i *)(u + x), _mm_unpacklo_epi8(uv, _mm_srli_si128(uv, 8)));
+        } else {
+            _mm_storeu_si128((__m128i *)(v + x), _mm_unpacklo_epi8(_mm_srli_si128(uv, 8), uv));
+        }
+    }
+    return x;
+}
+
+/* Sixteen pixels per loop, into eight macropixels */
+static int
+RGB2YUV_EncodeRowPacked4_AVX2(const RGB2YUVContext *ctx, int x, int width,
+                              const Uint8 *src, Uint8 *dst, int yo, int uo)
+{
+    RGB2YUV_AVX2_SETUP
+
+    for (; x + 16 <= limit; x += 16) {
+        __m256i r0, g0, b0, r1, g1, b1;
+        __m256i p, r, g, b;
+        __m128i yy, uv;
+
+        p = RGB2YUV_AVX2_Load(ctx, src, x);
+        RGB2YUV_AVX2_SPLIT(p, r0, g0, b0);
+        p = RGB2YUV_AVX2_Load(ctx, src, x + 8);
+        RGB2YUV_AVX2_SPLIT(p, r1, g1, b1);
+        RGB2YUV_AVX2_PACK(RGB2YUV_AVX2_DOT(r0, g0, b0, y, y_add), RGB2YUV_AVX2_DOT(r1, g1, b1, y, y_add), p);
+        yy = _mm256_castsi256_si128(p);
+
+        r = _mm256_srli_epi32(RGB2YUV_AVX2_PAIRS(r0, r1), 1);
+        g = _mm256_srli_epi32(RGB2YUV_AVX2_PAIRS(g0, g1), 1);
+        b = _mm256_srli_epi32(RGB2YUV_AVX2_PAIRS(b0, b1), 1);
+        RGB2YUV_AVX2_PACK_UV(RGB2YUV_AVX2_DOT(r, g, b, u, uv_add), RGB2YUV_AVX2_DOT(r, g, b, v, uv_add), uv);
+        if (uo < 2) {
+            uv = _mm_unpacklo_epi8(uv, _mm_srli_si128(uv, 8));
+        } else {
+            uv = _mm_unpacklo_epi8(_mm_srli_si128(uv, 8), uv);
+        }
+        if (yo == 0) {
+            _mm_storeu_si128((__m128i *)(dst + x * 2), _mm_unpacklo_epi8(yy, uv));
+            _mm_storeu_si128((__m128i *)(dst + x * 2 + 16), _mm_unpackhi_epi8(yy, uv));
+        } else {
+            _mm_storeu_si128((__m128i *)(dst + x * 2), _mm_unpacklo_epi8(uv, yy));
+            _mm_storeu_si128((__m128i *)(dst + x * 2 + 16), _mm_unpackhi_epi8(uv, yy));
+        }
+    }
+    return x;
+}
+#endif /* HAVE_AVX2_INTRINSICS */
+
+/* Encode two rows of a 4:2:0 image. src1 is the same as src0 and y1 is NULL
+   for the last row of an odd-height image. uv_step is 1 for planar chroma
+   and 2 for interleaved. */
+static void
+RGB2YUV_EncodeRows420(const RGB2YUVContext *ctx, int width,
+                      const Uint8 *src0, const Uint8 *src1,
+                      Uint8 *y0, Uint8 *y1, Uint8 *u, Uint8 *v, int uv_step)
+{
+    int x = 0;
+
+#if HAVE_AVX2_INTRINSICS
+    if (ctx->use_avx2) {
+        x = RGB2YUV_EncodeRows420_AVX2(ctx, x, width, src0, src1, y0, y1, u, v, uv_step);
+    }
+#endif
+#ifdef __SSE2__
+    if (ctx->use_sse2) {
+        x = RGB2YUV_EncodeRows420_SSE2(ctx, x, width, src0, src1, y0, y1, u, v, uv_step);
+    }
+#endif
+
+    for (; x < width; x += 2) {
+        const int x1 = (x + 1 < width) ? (x + 1) : x;
+        const int uv = (x / 2) * uv_step;
+        int r0, g0, b0, r1, g1, b1, r2, g2, b2, r3, g3, b3, r, g, b;
+
+        RGB2YUV_Read(ctx, src0, x, &r0, &g0, &b0);
+        RGB2YUV_Read(ctx, src0, x1, &r1, &g1, &b1);
+        RGB2YUV_Read(ctx, src1, x, &r2, &g2, &b2);
+        RGB2YUV_Read(ctx, src1, x1, &r3, &g3, &b3);
+        y0[x] = RGB2YUV_Y(r0, g0, b0);
+        y0[x1] = RGB2YUV_Y(r1, g1, b1);
+        if (y1) {
+            y1[x] = RGB2YUV_Y(r2, g2, b2);
+            y1[x1] = RGB2YUV_Y(r3, g3, b3);
+        }
+        r = (r0 + r1 + r2 + r3) >> 2;
+        g = (g0 + g1 + g2 + g3) >> 2;
+        b = (b0 + b1 + b2 + b3) >> 2;
+        u[uv] = RGB2YUV_U(r, g, b);
+        v[uv] = RGB2YUV_V(r, g, b);
+    }
+}
+
+/* Encode one row of a packed 4:2:2 image; an odd last pixel fills a whole
+   macropixel. */
+static void
+RGB2YUV_EncodeRowPacked4(const RGB2YUVContext *ctx, int width, const Uint8 *src, Uint8 *dst,
+                         int yo, int uo, int vo)
+{
+    int x = 0;
+
+#if HAVE_AVX2_INTRINSICS
+    if (ctx->use_avx2) {
+        x = RGB2YUV_EncodeRowPacked4_AVX2(ctx, x, width, src, dst, yo, uo);
+    }
+#endif
+#ifdef __SSE2__
+    if (ctx->use_sse2) {
+        x = RGB2YUV_EncodeRowPacked4_SSE2(ctx, x, width, src, dst, yo, uo);
+    }
+#endif
+
+    for (; x < width; x += 2) {
+        const int x1 = (x + 1 < width) ? (x + 1) : x;
+        Uint8 *macropixel = dst + x * 2;
+        int r0, g0, b0, r1, g1, b1, r, g, b;
+
+        RGB2YUV_Read(ctx, src, x, &r0, &g0, &b0);
+        RGB2YUV_Read(ctx, src, x1, &r1, &g1, &b1);
+        r = (r0 + r1) >> 1;
+        g = (g0 + g1) >> 1;
+        b = (b0 + b1) >> 1;
+        macropixel[yo] = RGB2YUV_Y(r0, g0, b0);
+        macropixel[yo + 2] = RGB2YUV_Y(r1, g1, b1);
+        macropixel[uo] = RGB2YUV_U(r, g, b);
+        macropixel[vo] = RGB2YUV_V(r, g, b);
+    }
+}
+
+#undef RGB2YUV_Y
+#undef RGB2YUV_U
+#undef RGB2YUV_V
+
+/* One RGB to YUV conversion, encoded a slice at a time */
+typedef struct
+{
+    const RGB2YUVContext *ctx;
+    int width, height;
+    const Uint8 *src;
+    int src_pitch;
+    Uint8 *dst;
+    int dst_pitch;
+    Uint8 *plane_y, *plane_u, *plane_v;
+    Uint32 y_stride, uv_stride;
+    int uv_step;
+    int yo, uo, vo;
+} RGB2YUVJob;
+
+static void SDLCALL
+RGB2YUV_EncodeSlices420(void *data, int start, int end)
+{
+    const RGB2YUVJob *job = (const RGB2YUVJob *) data;
+    const int height = SDL_min(end * SDL_YUV_SLICE_ROWS, job->height);
+    int j;
+
+    for (j = start * SDL_YUV_SLICE_ROWS; j < height; j += 2) {
+        const Uint8 *src0 = job->src + j * job->src_pitch;
+        const SDL_bool last = (j + 1 == height);
+        const int uv = (j / 2) * job->uv_stride;
+
+        RGB2YUV_EncodeRows420(job->ctx, job->width, src0, last ? src0 : (src0 + job->src_pitch),
+                              job->plane_y + j * job->y_stride, last ? NULL : (job->plane_y + (j + 1) * job->y_stride),
+                              job->plane_u + uv, job->plane_v + uv, job->uv_step);
+    }
+}
+
+static void SDLCALL
+RGB2YUV_EncodeSlicesPacked4(void *data, int start, int end)
+{
+    const RGB2YUVJob *job = (const RGB2YUVJob *) data;
+    const int row = start * SDL_YUV_SLICE_ROWS;
+    int width = job->width;
+    int height = SDL_min(end * SDL_YUV_SLICE_ROWS, job->height) - row;
+    const Uint8 *src = job->src + row * job->src_pitch;
+    Uint8 *dst = job->dst + row * job->dst_pitch;
+    int j;
+
+    /* Slices with no padding are just one long row */
+    if (!(width & 1) && job->src_pitch == width * job->ctx->bpp && job->dst_pitch == 2 * width) {
+        width *= height;
+        height = 1;
+    }
+
+    for (j = 0; j < height; j++) {
+        RGB2YUV_EncodeRowPacked4(job->ctx, width, src + j * job->src_pitch,
+                                 dst + j * job->dst_pitch, job->yo, job->uo, job->vo);
+    }
+}
+
+static int
+SDL_ConvertPixels_RGB_to_YUV_Direct(int width, int height, RGB2YUVContext *ctx,
+                                    const void *src, int src_pitch,
+                                    Uint32 dst_format, void *dst, int dst_pitch)
+{
+    const struct RGB2YUVFactors *factors = &RGB2YUVFactorTables[SDL_GetYUVConversionModeForResolution(width, height)];
+    RGB2YUVJob job;
+
+    ctx->y = factors->y;
+    ctx->u = factors->u;
+    ctx->v = factors->v;
+    ctx->y_add = (factors->y_offset << 15) + (1 << 14);
+    ctx->use_sse2 = SDL_FALSE;
+    ctx->use_avx2 = SDL_FALSE;
+#ifdef __SSE2__
+    ctx->use_sse2 = SDL_HasSSE2();
+#endif
+#if HAVE_AVX2_INTRINSICS
+    ctx->use_avx2 = SDL_HasAVX2();
+#endif
+
+    SDL_zero(job);
+    job.ctx = ctx;
+    job.width = width;
+    job.height = height;
+    job.src = (const Uint8 *) src;
+    job.src_pitch = src_pitch;
+    job.dst = (Uint8 *) dst;
+    job.dst_pitch = dst_pitch;
+
+    switch (dst_format)
     {
     case SDL_PIXELFORMAT_YV12:
     case SDL_PIXELFORMAT_IYUV:
     case SDL_PIXELFORMAT_NV12:
     case SDL_PIXELFORMAT_NV21:
-        {
-            const Uint8 *curr_row, *next_row;
-            
-            Uint8 *plane_y;
-            Uint8 *plane_u;
-            Uint8 *plane_v;
-            Uint8 *plane_interleaved_uv;
-            Uint32 y_stride, uv_stride, y_skip, uv_skip;
-
-            GetYUVPlanes(width, height, dst_format, dst, dst_pitch,
-                         (const Uint8 **)&plane_y, (const Uint8 **)&plane_u, (const Uint8 **)&plane_v,
-                         &y_stride, &uv_stride);
-            plane_interleaved_uv = (plane_y + height * y_stride);
-            y_skip = (y_stride - width);
-
-            curr_row = (const Uint8*)src;
-
-            /* Write Y plane */
-            for (j = 0; j < height; j++) {
-                for (i = 0; i < width; i++) {
-                    const Uint32 p1 = ((const Uint32 *)curr_row)[i];
-                    const Uint32 r = (p1 & 0x00ff0000) >> 16;
-                    const Uint32 g = (p1 & 0x0000ff00) >> 8;
-                    const Uint32 b = (p1 & 0x000000ff);
-                    *plane_y++ = MAKE_Y(r, g, b);
-                }
-                plane_y += y_skip;
-                curr_row += src_pitch;
-            }
-
-            curr_row = (const Uint8*)src;
-            next_row = (const Uint8*)src;
-            next_row += src_pitch;
-
-            if (dst_format == SDL_PIXELFORMAT_YV12 || dst_format == SDL_PIXELFORMAT_IYUV)
-            {
-                /* Write UV planes, not interleaved */
-                uv_skip = (uv_stride - (width + 1)/2);
-                for (j = 0; j < height_half; j++) {
-                    for (i = 0; i < width_half; i++) {
-                        READ_2x2_PIXELS;
-                        *plane_u++ = MAKE_U(r, g, b);
-                        *plane_v++ = MAKE_V(r, g, b);
-                    }
-                    if (width_remainder) {
-                        READ_2x1_PIXELS;
-                        *plane_u++ = MAKE_U(r, g, b);
-                        *plane_v++ = MAKE_V(r, g, b);
-                    }
-                    plane_u += uv_skip;
-                    plane_v += uv_skip;
-                    curr_row += src_pitch_x_2;
-                    next_row += src_pitch_x_2;
-                }
-                if (height_remainder) {
-                    for (i = 0; i < width_half; i++) {
-                        READ_1x2_PIXELS;
-                        *plane_u++ = MAKE_U(r, g, b);
-                        *plane_v++ = MAKE_V(r, g, b);
-                    }
-                    if (width_remainder) {
-                        READ_1x1_PIXEL;
-                        *plane_u++ = MAKE_U(r, g, b);
-                        *plane_v++ = MAKE_V(r, g, b);
-                    }
-                    plane_u += uv_skip;
-                    plane_v += uv_skip;
-                }
-            }
-            else if (dst_format == SDL_PIXELFORMAT_NV12)
-            {
-                uv_skip = (uv_stride - ((width + 1)/2)*2);
-                for (j = 0; j < height_half; j++) {
-                    for (i = 0; i < width_half; i++) {
-                        READ_2x2_PIXELS;
-                        *plane_interleaved_uv++ = MAKE_U(r, g, b);
-                        *plane_interleaved_uv++ = MAKE_V(r, g, b);
-                    }
-                    if (width_remainder) {
-                        READ_2x1_PIXELS;
-                        *plane_interleaved_uv++ = MAKE_U(r, g, b);
-                        *plane_interleaved_uv++ = MAKE_V(r, g, b);
-                    }
-                    plane_interleaved_uv += uv_skip;
-                    curr_row += src_pitch_x_2;
-                    next_row += src_pitch_x_2;
-                }
-                if (height_remainder) {
-                    for (i = 0; i < width_half; i++) {
-                        READ_1x2_PIXELS;
-                        *plane_interleaved_uv++ = MAKE_U(r, g, b);
-                        *plane_interleaved_uv++ = MAKE_V(r, g, b);
-                    }
-                    if (width_remainder) {
-                        READ_1x1_PIXEL;
-                        *plane_interleaved_uv++ = MAKE_U(r, g, b);
-                        *plane_interleaved_uv++ = MAKE_V(r, g, b);
-                    }
-                }
-            } 
-            else /* dst_format == SDL_PIXELFORMAT_NV21 */
-            {
-                uv_skip = (uv_stride - ((width + 1)/2)*2);
-                for (j = 0; j < height_half; j++) {
-                    for (i = 0; i < width_half; i++) {
-                        READ_2x2_PIXELS;
-                        *plane_interleaved_uv++ = MAKE_V(r, g, b);
-                        *plane_interleaved_uv++ = MAKE_U(r, g, b);
-                    }
-                    if (width_remainder) {
-                        READ_2x1_PIXELS;
-                        *plane_interleaved_uv++ = MAKE_V(r, g, b);
-                        *plane_interleaved_uv++ = MAKE_U(r, g, b);
-                    }
-                    plane_interleaved_uv += uv_skip;
-                    curr_row += src_pitch_x_2;
-                    next_row += src_pitch_x_2;
-                }
-                if (height_remainder) {
-                    for (i = 0; i < width_half; i++) {
-                        READ_1x2_PIXELS;
-                        *plane_interleaved_uv++ = MAKE_V(r, g, b);
-                        *plane_interleaved_uv++ = MAKE_U(r, g, b);
-                    }
-                    if (width_remainder) {
-                        READ_1x1_PIXEL;
-                        *plane_interleaved_uv++ = MAKE_V(r, g, b);
-                        *plane_interleaved_uv++ = MAKE_U(r, g, b);
-                    }
-                }
-            }
+        job.uv_step = (dst_format == SDL_PIXELFORMAT_NV12 || dst_format == SDL_PIXELFORMAT_NV21) ? 2 : 1;
+        if (GetYUVPlanes(width, height, dst_format, dst, dst_pitch,
+                         (const Uint8 **)&job.plane_y, (const Uint8 **)&job.plane_u, (const Uint8 **)&job.plane_v,
+                         &job.y_stride, &job.uv_stride) < 0) {
+            return -1;
         }
+        ConvertYUVSlices(width, height, RGB2YUV_EncodeSlices420, &job);
         break;
 
     case SDL_PIXELFORMAT_YUY2:
     case SDL_PIXELFORMAT_UYVY:
     case SDL_PIXELFORMAT_YVYU:
         {
-            const Uint8 *curr_row = (const Uint8*) src;
-            Uint8 *plane           = (Uint8*) dst;
             const int row_size = (4 * ((width + 1) / 2));
-            int plane_skip;
 
             if (dst_pitch < row_size) {
                 return SDL_SetError("Destination pitch is too small, expected at least %d\n", row_size);
             }
-            plane_skip = (dst_pitch - row_size);
-
-            /* Write YUV plane, packed */
-            if (dst_format == SDL_PIXELFORMAT_YUY2) 
-            {
-                for (j = 0; j < height; j++) {
-                    for (i = 0; i < width_half; i++) {
-                        READ_TWO_RGB_PIXELS;
-                        /* Y U Y1 V */
-                        *plane++ = MAKE_Y(r, g, b);
-                        *plane++ = MAKE_U(R, G, B);
-                        *plane++ = MAKE_Y(r1, g1, b1);
-                        *plane++ = MAKE_V(R, G, B);
-                    }
-                    if (width_remainder) {
-                        READ_ONE_RGB_PIXEL;
-                        /* Y U Y V */
-                        *plane++ = MAKE_Y(r, g, b);
-                        *plane++ = MAKE_U(r, g, b);
-                        *plane++ = MAKE_Y(r, g, b);
-                        *plane++ = MAKE_V(r, g, b);
-                    }
-                    plane += plane_skip;
-                    curr_row += src_pitch;
-                }
-            } 
-            else if (dst_format == SDL_PIXELFORMAT_UYVY)
-            {
-                for (j = 0; j < height; j++) {
-                    for (i = 0; i < width_half; i++) {
-                        READ_TWO_RGB_PIXELS;
-                        /* U Y V Y1 */
-                        *plane++ = MAKE_U(R, G, B);
-                        *plane++ = MAKE_Y(r, g, b);
-                        *plane++ = MAKE_V(R, G, B);
-                        *plane++ = MAKE_Y(r1, g1, b1);
-                    }
-                    if (width_remainder) {
-                        READ_ONE_RGB_PIXEL;
-                        /* U Y V Y */
-                        *plane++ = MAKE_U(r, g, b);
-                        *plane++ = MAKE_Y(r, g, b);
-                        *plane++ = MAKE_V(r, g, b);
-                        *plane++ = MAKE_Y(r, g, b);
-                    }
-                    plane += plane_skip;
-                    curr_row += src_pitch;
-                }
-            }
-            else if (dst_format == SDL_PIXELFORMAT_YVYU)
-            {
-                for (j = 0; j < height; j++) {
-                    for (i = 0; i < width_half; i++) {
-                        READ_TWO_RGB_PIXELS;
-                        /* Y V Y1 U */
-                        *plane++ = MAKE_Y(r, g, b);
-                        *plane++ = MAKE_V(R, G, B);
-                        *plane++ = MAKE_Y(r1, g1, b1);
-                        *plane++ = MAKE_U(R, G, B);
-                    }
-                    if (width_remainder) {
-                        READ_ONE_RGB_PIXEL;
-                        /* Y V Y U */
-                        *plane++ = MAKE_Y(r, g, b);
-                        *plane++ = MAKE_V(r, g, b);
-                        *plane++ = MAKE_Y(r, g, b);
-                        *plane++ = MAKE_U(r, g, b);
-                    }
-                    plane += plane_skip;
-                    curr_row += src_pitch;
-                }
-            }
+            RGB2YUV_GetPacked4Offsets(dst_format, &job.yo, &job.uo, &job.vo);
+            ConvertYUVSlices(width, height, RGB2YUV_EncodeSlicesPacked4, &job);
         }
         break;
 
     default:
         return SDL_SetError("Unsupported YUV destination format: %s", SDL_GetPixelFormatName(dst_format));
     }
-#undef MAKE_Y
-#undef MAKE_U
-#undef MAKE_V
-#undef READ_2x2_PIXELS
-#undef READ_2x1_PIXELS
-#undef READ_1x2_PIXELS
-#undef READ_1x1_PIXEL
-#undef READ_TWO_RGB_PIXELS
-#undef READ_ONE_RGB_PIXEL
     return 0;
 }
 
@@ -785,35 +1400,14 @@ SDL_ConvertPixels_RGB_to_YUV(int width, int height,
          Uint32 src_format, const void *src, int src_pitch,
          Uint32 dst_format, void *dst, int dst_pitch)
 {
-#if 0 /* Doesn't handle odd widths */
-    /* RGB24 to FOURCC */
-    if (src_format == SDL_PIXELFORMAT_RGB24) {
-        Uint8 *y;
-        Uint8 *u;
-        Uint8 *v;
-        Uint32 y_stride;
-        Uint32 uv_stride;
-        YCbCrType yuv_type;
-
-        if (GetYUVPlanes(width, height, dst_format, dst, dst_pitch, (const Uint8 **)&y, (const Uint8 **)&u, (const Uint8 **)&v, &y_stride, &uv_stride) < 0) {
-            return -1;
-        }
-
-        if (GetYUVConversionType(width, height, &yuv_type) < 0) {
-            return -1;
-        }
-
-        rgb24_yuv420_std(width, height, src, src_pitch, y, u, v, y_stride, uv_stride, yuv_type);
-        return 0;
-    }
-#endif
+    RGB2YUVContext ctx;
 
-    /* ARGB8888 to FOURCC */
-    if (src_format == SDL_PIXELFORMAT_ARGB8888) {
-        return SDL_ConvertPixels_ARGB8888_to_YUV(width, height, src, src_pitch, dst_format, dst, dst_pitch);
+    /* Common RGB formats to FOURCC */
+    if (RGB2YUV_GetLayout(src_format, &ctx)) {
+        return SDL_ConvertPixels_RGB_to_YUV_Direct(width, height, &ctx, src, src_pitch, dst_format, dst, dst_pitch);
     }
 
-    /* not ARGB8888 to FOURCC : need an intermediate conversion */
+    /* anything else to FOURCC : need an intermediate conversion */
     {
         int ret;
         void *tmp;
@@ -832,7 +1426,8 @@ SDL_ConvertPixels_RGB_to_YUV(int width, int height,
         }
 
         /* convert tmp/ARGB8888 to dst/FOURCC */
-        ret = SDL_ConvertPixels_ARGB8888_to_YUV(width, height, tmp, tmp_pitch, dst_format, dst, dst_pitch);
+        RGB2YUV_GetLayout(SDL_PIXELFORMAT_ARGB8888, &ctx);
+        ret = SDL_ConvertPixels_RGB_to_YUV_Direct(width, height, &ctx, tmp, tmp_pitch, dst_format, dst, dst_pitch);
         SDL_free(tmp);
         return ret;
     }
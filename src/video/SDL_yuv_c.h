@@ -22,12 +22,16 @@
 #ifndef SDL_yuv_c_h_
 #define SDL_yuv_c_h_
 
-#include "../SDL_internal.h"
+#include "SDL_rect.h"
 
 
 /* YUV conversion functions */
 
 extern int SDL_ConvertPixels_YUV_to_RGB(int width, int height, Uint32 src_format, const void *src, int src_pitch, Uint32 dst_format, void *dst, int dst_pitch);
+/* Converts srcrect of the source to the whole destination, with nearest
+   neighbor scaling. Returns 1, without setting an error, if there's no fast
+   path for the formats, so the caller can fall back to something else. */
+extern int SDL_ConvertPixels_YUV_to_RGB_Scaled(int width, int height, Uint32 src_format, const void *src, int src_pitch, const SDL_Rect *srcrect, Uint32 dst_format, void *dst, int dst_w, int dst_h, int dst_pitch);
 extern int SDL_ConvertPixels_RGB_to_YUV(int width, int height, Uint32 src_format, const void *src, int src_pitch, Uint32 dst_format, void *dst, int dst_pitch);
 extern int SDL_ConvertPixels_YUV_to_YUV(int width, int height, Uint32 src_format, const void *src, int src_pitch, Uint32 dst_format, void *dst, int dst_pitch);
 
@@ -71,7 +71,8 @@ static const RGB2YUVParam RGB2YUV[3] = {
 #define RGB_FORMAT_ABGR		6
 
 // divide by PRECISION_FACTOR and clamp to [0:255] interval
-// input must be in the [-128*PRECISION_FACTOR:384*PRECISION_FACTOR] range
+// input outside of the [-128*PRECISION_FACTOR:384*PRECISION_FACTOR] range is clamped to it first,
+// out of gamut yuv values (such as full V with bright Y in BT.709) can go past it
 static uint8_t clampU8(int32_t v)
 {
 	static const uint8_t lut[512] = 
@@ -89,7 +90,8 @@ static uint8_t clampU8(int32_t v)
 	255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,
 	255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255
 	};
-	return lut[(v+128*PRECISION_FACTOR)>>PRECISION];
+	const int32_t i = (v+128*PRECISION_FACTOR)>>PRECISION;
+	return lut[(i < 0) ? 0 : ((i > 511) ? 511 : i)];
 }
 
 
@@ -685,3 +687,133 @@ void rgb24_yuv420_sseu(uint32_t width, uint32_t height,
 
 #endif //__SSE2__
 
+#if defined(__AVX2__) && defined(HAVE_IMMINTRIN_H)
+
+#define AVX2_FUNCTION_NAME	yuv420_rgb565_avx2
+#define SSE_FUNCTION_NAME	yuv420_rgb565_sseu
+#define STD_FUNCTION_NAME	yuv420_rgb565_std
+#define YUV_FORMAT			YUV_FORMAT_420
+#define RGB_FORMAT			RGB_FORMAT_RGB565
+#include "yuv_rgb_avx2_func.h"
+
+#define AVX2_FUNCTION_NAME	yuv420_rgb24_avx2
+#define SSE_FUNCTION_NAME	yuv420_rgb24_sseu
+#define STD_FUNCTION_NAME	yuv420_rgb24_std
+#define YUV_FORMAT			YUV_FORMAT_420
+#define RGB_FORMAT			RGB_FORMAT_RGB24
+#include "yuv_rgb_avx2_func.h"
+
+#define AVX2_FUNCTION_NAME	yuv420_rgba_avx2
+#define SSE_FUNCTION_NAME	yuv420_rgba_sseu
+#define STD_FUNCTION_NAME	yuv420_rgba_std
+#define YUV_FORMAT			YUV_FORMAT_420
+#define RGB_FORMAT			RGB_FORMAT_RGBA
+#include "yuv_rgb_avx2_func.h"
+
+#define AVX2_FUNCTION_NAME	yuv420_bgra_avx2
+#define SSE_FUNCTION_NAME	yuv420_bgra_sseu
+#define STD_FUNCTION_NAME	yuv420_bgra_std
+#define YUV_FORMAT			YUV_FORMAT_420
+#define RGB_FORMAT			RGB_FORMAT_BGRA
+#include "yuv_rgb_avx2_func.h"
+
+#define AVX2_FUNCTION_NAME	yuv420_argb_avx2
+#define SSE_FUNCTION_NAME	yuv420_argb_sseu
+#define STD_FUNCTION_NAME	yuv420_argb_std
+#define YUV_FORMAT			YUV_FORMAT_420
+#define RGB_FORMAT			RGB_FORMAT_ARGB
+#include "yuv_rgb_avx2_func.h"
+
+#define AVX2_FUNCTION_NAME	yuv420_abgr_avx2
+#define SSE_FUNCTION_NAME	yuv420_abgr_sseu
+#define STD_FUNCTION_NAME	yuv420_abgr_std
+#define YUV_FORMAT			YUV_FORMAT_420
+#define RGB_FORMAT			RGB_FORMAT_ABGR
+#include "yuv_rgb_avx2_func.h"
+
+#define AVX2_FUNCTION_NAME	yuv422_rgb565_avx2
+#define SSE_FUNCTION_NAME	yuv422_rgb565_sseu
+#define STD_FUNCTION_NAME	yuv422_rgb565_std
+#define YUV_FORMAT			YUV_FORMAT_422
+#define RGB_FORMAT			RGB_FORMAT_RGB565
+#include "yuv_rgb_avx2_func.h"
+
+#define AVX2_FUNCTION_NAME	yuv422_rgb24_avx2
+#define SSE_FUNCTION_NAME	yuv422_rgb24_sseu
+#define STD_FUNCTION_NAME	yuv422_rgb24_std
+#define YUV_FORMAT			YUV_FORMAT_422
+#define RGB_FORMAT			RGB_FORMAT_RGB24
+#include "yuv_rgb_avx2_func.h"
+
+#define AVX2_FUNCTION_NAME	yuv422_rgba_avx2
+#define SSE_FUNCTION_NAME	yuv422_rgba_sseu
+#define STD_FUNCTION_NAME	yuv422_rgba_std
+#define YUV_FORMAT			YUV_FORMAT_422
+#define RGB_FORMAT			RGB_FORMAT_RGBA
+#include "yuv_rgb_avx2_func.h"
+
+#define AVX2_FUNCTION_NAME	yuv422_bgra_avx2
+#define SSE_FUNCTION_NAME	yuv422_bgra_sseu
+#define STD_FUNCTION_NAME	yuv422_bgra_std
+#define YUV_FORMAT			YUV_FORMAT_422
+#define RGB_FORMAT			RGB_FORMAT_BGRA
+#include "yuv_rgb_avx2_func.h"
+
+#define AVX2_FUNCTION_NAME	yuv422_argb_avx2
+#define SSE_FUNCTION_NAME	yuv422_argb_sseu
+#define STD_FUNCTION_NAME	yuv422_argb_std
+#define YUV_FORMAT			YUV_FORMAT_422
+#define RGB_FORMAT			RGB_FORMAT_ARGB
+#include "yuv_rgb_avx2_func.h"
+
+#define AVX2_FUNCTION_NAME	yuv422_abgr_avx2
+#define SSE_FUNCTION_NAME	yuv422_abgr_sseu
+#define STD_FUNCTION_NAME	yuv422_abgr_std
+#define YUV_FORMAT			YUV_FORMAT_422
+#define RGB_FORMAT			RGB_FORMAT_ABGR
+#include "yuv_rgb_avx2_func.h"
+
+#define AVX2_FUNCTION_NAME	yuvnv12_rgb565_avx2
+#define SSE_FUNCTION_NAME	yuvnv12_rgb565_sseu
+#define STD_FUNCTION_NAME	yuvnv12_rgb565_std
+#define YUV_FORMAT			YUV_FORMAT_NV12
+#define RGB_FORMAT			RGB_FORMAT_RGB565
+#include "yuv_rgb_avx2_func.h"
+
+#define AVX2_FUNCTION_NAME	yuvnv12_rgb24_avx2
+#define SSE_FUNCTION_NAME	yuvnv12_rgb24_sseu
+#define STD_FUNCTION_NAME	yuvnv12_rgb24_std
+#define YUV_FORMAT			YUV_FORMAT_NV12
+#define RGB_FORMAT			RGB_FORMAT_RGB24
+#include "yuv_rgb_avx2_func.h"
+
+#define AVX2_FUNCTION_NAME	yuvnv12_rgba_avx2
+#define SSE_FUNCTION_NAME	yuvnv12_rgba_sseu
+#define STD_FUNCTION_NAME	yuvnv12_rgba_std
+#define YUV_FORMAT			YUV_FORMAT_NV12
+#define RGB_FORMAT			RGB_FORMAT_RGBA
+#include "yuv_rgb_avx2_func.h"
+
+#define AVX2_FUNCTION_NAME	yuvnv12_bgra_avx2
+#define SSE_FUNCTION_NAME	yuvnv12_bgra_sseu
+#define STD_FUNCTION_NAME	yuvnv12_bgra_std
+#define YUV_FORMAT			YUV_FORMAT_NV12
+#define RGB_FORMAT			RGB_FORMAT_BGRA
+#include "yuv_rgb_avx2_func.h"
+
+#define AVX2_FUNCTION_NAME	yuvnv12_argb_avx2
+#define SSE_FUNCTION_NAME	yuvnv12_argb_sseu
+#define STD_FUNCTION_NAME	yuvnv12_argb_std
+#define YUV_FORMAT			YUV_FORMAT_NV12
+#define RGB_FORMAT			RGB_FORMAT_ARGB
+#include "yuv_rgb_avx2_func.h"
+
+#define AVX2_FUNCTION_NAME	yuvnv12_abgr_avx2
+#define SSE_FUNCTION_NAME	yuvnv12_abgr_sseu
+#define STD_FUNCTION_NAME	yuvnv12_abgr_std
+#define YUV_FORMAT			YUV_FORMAT_NV12
+#define RGB_FORMAT			RGB_FORMAT_ABGR
+#include "yuv_rgb_avx2_func.h"
+
+#endif //__AVX2__
+
@@ -37,16 +37,18 @@
 	G2 = _mm_unpackhi_epi16(g_tmp, g_tmp); \
 	B2 = _mm_unpackhi_epi16(b_tmp, b_tmp); \
 
+/* Bright luma plus strong chroma can pass 16 bits, so saturate like the
+   scalar code clamps */
 #define ADD_Y2RGB_16(Y1,Y2,R1,G1,B1,R2,G2,B2) \
 	Y1 = _mm_mullo_epi16(_mm_sub_epi16(Y1, _mm_set1_epi16(param->y_shift)), _mm_set1_epi16(param->y_factor)); \
 	Y2 = _mm_mullo_epi16(_mm_sub_epi16(Y2, _mm_set1_epi16(param->y_shift)), _mm_set1_epi16(param->y_factor)); \
 	\
-	R1 = _mm_srai_epi16(_mm_add_epi16(R1, Y1), PRECISION); \
-	G1 = _mm_srai_epi16(_mm_add_epi16(G1, Y1), PRECISION); \
-	B1 = _mm_srai_epi16(_mm_add_epi16(B1, Y1), PRECISION); \
-	R2 = _mm_srai_epi16(_mm_add_epi16(R2, Y2), PRECISION); \
-	G2 = _mm_srai_epi16(_mm_add_epi16(G2, Y2), PRECISION); \
-	B2 = _mm_srai_epi16(_mm_add_epi16(B2, Y2), PRECISION); \
+	R1 = _mm_srai_epi16(_mm_adds_epi16(R1, Y1), PRECISION); \
+	G1 = _mm_srai_epi16(_mm_adds_epi16(G1, Y1), PRECISION); \
+	B1 = _mm_srai_epi16(_mm_adds_epi16(B1, Y1), PRECISION); \
+	R2 = _mm_srai_epi16(_mm_adds_epi16(R2, Y2), PRECISION); \
+	G2 = _mm_srai_epi16(_mm_adds_epi16(G2, Y2), PRECISION); \
+	B2 = _mm_srai_epi16(_mm_adds_epi16(B2, Y2), PRECISION); \
 
 #define PACK_RGB565_32(R1, R2, G1, G2, B1, B2, RGB1, RGB2, RGB3, RGB4) \
 { \
@@ -393,16 +395,19 @@ void SSE_FUNCTION_NAME(uint32_t width, uint32_t height,
 	const int uv_pixel_stride = 1;
 	const int uv_x_sample_interval = 2;
 	const int uv_y_sample_interval = 2;
+	const int reads_past_block = 0;
 #elif YUV_FORMAT == YUV_FORMAT_422
 	const int y_pixel_stride = 2;
 	const int uv_pixel_stride = 4;
 	const int uv_x_sample_interval = 2;
 	const int uv_y_sample_interval = 1;
+	const int reads_past_block = 1;  /* up to 3 bytes, as Y, U and V are interleaved */
 #elif YUV_FORMAT == YUV_FORMAT_NV12
 	const int y_pixel_stride = 1;
 	const int uv_pixel_stride = 2;
 	const int uv_x_sample_interval = 2;
 	const int uv_y_sample_interval = 2;
+	const int reads_past_block = 1;  /* 1 byte, as U and V are interleaved */
 #endif
 #if RGB_FORMAT == RGB_FORMAT_RGB565
 	const int rgb_pixel_stride = 2;
@@ -417,23 +422,29 @@ void SSE_FUNCTION_NAME(uint32_t width, uint32_t height,
 
 	if (width >= 32) {
 		uint32_t xpos, ypos;
-		for(ypos=0; ypos<(height-(uv_y_sample_interval-1)); ypos+=uv_y_sample_interval)
+		for(ypos=0; ypos<height; ypos+=uv_y_sample_interval)
 		{
+			/* Only 4:2:0 has a second line, and on the last line of an odd
+			   height image we read the first one twice and don't save it */
+			const int has_line2 = (uv_y_sample_interval > 1 && (ypos+1) < height);
+			/* If the last block of the last row ends the source, loading it
+			   would read past the end, so it's left to the scalar code */
+			const uint32_t simd_width = (reads_past_block && (ypos+uv_y_sample_interval) >= height && (width % 32) == 0) ? (width-32) : width;
 			const uint8_t *y_ptr1=Y+ypos*Y_stride,
-				*y_ptr2=Y+(ypos+1)*Y_stride,
+				*y_ptr2=has_line2 ? (y_ptr1+Y_stride) : y_ptr1,
 				*u_ptr=U+(ypos/uv_y_sample_interval)*UV_stride,
 				*v_ptr=V+(ypos/uv_y_sample_interval)*UV_stride;
 			
 			uint8_t *rgb_ptr1=RGB+ypos*RGB_stride,
-				*rgb_ptr2=RGB+(ypos+1)*RGB_stride;
+				*rgb_ptr2=rgb_ptr1+RGB_stride;
 			
-			for(xpos=0; xpos<(width-31); xpos+=32)
+			for(xpos=0; (xpos+31)<simd_width; xpos+=32)
 			{
 				YUV2RGB_32
 				{
 					PACK_PIXEL
 					SAVE_LINE1
-					if (uv_y_sample_interval > 1)
+					if (has_line2)
 					{
 						SAVE_LINE2
 					}
@@ -446,18 +457,11 @@ void SSE_FUNCTION_NAME(uint32_t width, uint32_t height,
 				rgb_ptr1+=32*rgb_pixel_stride;
 				rgb_ptr2+=32*rgb_pixel_stride;
 			}
-		}
-
-		/* Catch the last line, if needed */
-		if (uv_y_sample_interval == 2 && ypos == (height-1))
-		{
-			const uint8_t *y_ptr=Y+ypos*Y_stride,
-				*u_ptr=U+(ypos/uv_y_sample_interval)*UV_stride,
-				*v_ptr=V+(ypos/uv_y_sample_interval)*UV_stride;
-			
-			uint8_t *rgb_ptr=RGB+ypos*RGB_stride;
 
-			STD_FUNCTION_NAME(width, 1, y_ptr, u_ptr, v_ptr, Y_stride, UV_stride, rgb_ptr, RGB_stride, yuv_type);
+			if (simd_width != width)
+			{
+				STD_FUNCTION_NAME(32, height-ypos, y_ptr1, u_ptr, v_ptr, Y_stride, UV_stride, rgb_ptr1, RGB_stride, yuv_type);
+			}
 		}
 	}
 
@@ -486,6 +490,7 @@ void SSE_FUNCTION_NAME(uint32_t width, uint32_t height,
 #undef SAVE_SI128
 #undef UV2RGB_16
 #undef ADD_Y2RGB_16
+#undef PACK_RGB565_32
 #undef PACK_RGB24_32_STEP1
 #undef PACK_RGB24_32_STEP2
 #undef PACK_RGB24_32
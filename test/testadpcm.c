@@ -0,0 +1,204 @@
+/*
+  Copyright (C) 1997-2019 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely.
+*/
+
+/* Measures how fast ADPCM WAVE files decode, both loaded whole with
+   SDL_LoadWAV_RW() and streamed with SDL_WAVStreamRead(). With no
+   arguments it makes up some files in memory, otherwise it uses the
+   files named on the command line. */
+
+#include "SDL_test.h"
+
+#define ITERATIONS 10
+
+static SDLTest_RandomContext rndctx;
+
+static Uint8 *
+put16(Uint8 *ptr, Uint16 val)
+{
+    ptr[0] = (Uint8) (val & 0xFF);
+    ptr[1] = (Uint8) (val >> 8);
+    return ptr + 2;
+}
+
+static Uint8 *
+put32(Uint8 *ptr, Uint32 val)
+{
+    ptr = put16(ptr, (Uint16) (val & 0xFFFF));
+    return put16(ptr, (Uint16) (val >> 16));
+}
+
+/* Random nybbles are valid ADPCM data, so only the block headers need
+   any care: MS ADPCM predictors must be less than 7, IMA step indices
+   less than 89. */
+static Uint8 *
+make_adpcm(Uint16 encoding, Uint16 channels, Uint16 blockalign, Uint32 blocks, Uint32 *len)
+{
+    static const Sint16 coefficients[7][2] = {
+        { 256, 0 }, { 512, -256 }, { 0, 0 }, { 192, 64 },
+        { 240, 0 }, { 460, -208 }, { 392, -232 }
+    };
+    const SDL_bool ms = (encoding == 0x0002);
+    const Uint32 fmtlen = ms ? 50 : 20;
+    const Uint32 datalen = blocks * blockalign;
+    const Uint16 samplesperblock = ms ? (((blockalign - 7 * channels) * 2) / channels + 2)
+                                      : (((blockalign - 4 * channels) * 2) / channels + 1);
+    Uint8 *wav, *ptr;
+    Uint32 i, j;
+
+    *len = 12 + 8 + fmtlen + 8 + datalen;
+    wav = (Uint8 *) SDL_malloc(*len);
+    if (!wav) {
+        return NULL;
+    }
+
+    ptr = wav;
+    SDL_memcpy(ptr, "RIFF", 4);
+    ptr = put32(ptr + 4, *len - 8);
+    SDL_memcpy(ptr, "WAVEfmt ", 8);
+    ptr = put32(ptr + 8, fmtlen);
+    ptr = put16(ptr, encoding);
+    ptr = put16(ptr, channels);
+    ptr = put32(ptr, 44100);
+    ptr = put32(ptr, (44100 / samplesperblock) * blockalign);
+    ptr = put16(ptr, blockalign);
+    ptr = put16(ptr, 4);
+    ptr = put16(ptr, (Uint16) (fmtlen - 18));
+    ptr = put16(ptr, samplesperblock);
+    if (ms) {
+        ptr = put16(ptr, 7);
+        for (i = 0; i < 7; i++) {
+            ptr = put16(ptr, (Uint16) coefficients[i][0]);
+            ptr = put16(ptr, (Uint16) coefficients[i][1]);
+        }
+    }
+    SDL_memcpy(ptr, "data", 4);
+    ptr = put32(ptr + 4, datalen);
+
+    for (i = 0; i < blocks; i++) {
+        Uint8 *block = ptr + i * blockalign;
+        for (j = 0; j < blockalign; j++) {
+            block[j] = (Uint8) SDLTest_RandomInt(&rndctx);
+        }
+        for (j = 0; j < channels; j++) {
+            if (ms) {
+                block[j] %= 7;
+            } else {
+                block[4 * j + 2] %= 89;
+                block[4 * j + 3] = 0;
+            }
+        }
+    }
+
+    return wav;
+}
+
+static void
+bench(const char *desc, const Uint8 *wav, Uint32 wavlen)
+{
+    const double freq = (double) SDL_GetPerformanceFrequency();
+    SDL_AudioSpec spec;
+    Uint8 *buf = NULL;
+    Uint32 len = 0;
+    Uint64 start, loadticks = 0, streamticks = 0;
+    int i;
+
+    for (i = 0; i < ITERATIONS; i++) {
+        start = SDL_GetPerformanceCounter();
+        if (!SDL_LoadWAV_RW(SDL_RWFromConstMem(wav, wavlen), 1, &spec, &buf, &len)) {
+            SDL_Log("%s: couldn't load: %s", desc, SDL_GetError());
+            return;
+        }
+        loadticks += SDL_GetPerformanceCounter() - start;
+        SDL_FreeWAV(buf);
+    }
+
+    for (i = 0; i < ITERATIONS; i++) {
+        SDL_WAVStream *stream;
+        Uint8 chunk[4096];
+        int rc;
+
+        start = SDL_GetPerformanceCounter();
+        stream = SDL_OpenWAVStream_RW(SDL_RWFromConstMem(wav, wavlen), 1, &spec);
+        if (!stream) {
+            SDL_Log("%s: couldn't stream: %s", desc, SDL_GetError());
+            return;
+        }
+        while ((rc = SDL_WAVStreamRead(stream, chunk, sizeof (chunk))) > 0) {
+            /* just decoding. */
+        }
+        SDL_CloseWAVStream(stream);
+        streamticks += SDL_GetPerformanceCounter() - start;
+    }
+
+    SDL_Log("%s: %u bytes decode to %u bytes (%d channels)", desc, (unsigned int) wavlen, (unsigned int) len, (int) spec.channels);
+    SDL_Log("    SDL_LoadWAV_RW:    %8.2f ms, %8.2f MB/s decoded",
+            (loadticks * 1000.0) / (freq * ITERATIONS), (len * (double) ITERATIONS) / ((loadticks / freq) * 1024.0 * 1024.0));
+    SDL_Log("    SDL_WAVStreamRead: %8.2f ms, %8.2f MB/s decoded",
+            (streamticks * 1000.0) / (freq * ITERATIONS), (len * (double) ITERATIONS) / ((streamticks / freq) * 1024.0 * 1024.0));
+}
+
+int
+main(int argc, char *argv[])
+{
+    static const struct {
+        const char *desc;
+        Uint16 encoding;
+        Uint16 channels;
+        Uint16 blockalign;
+    } files[] = {
+        { "MS ADPCM mono", 0x0002, 1, 256 },
+        { "MS ADPCM stereo", 0x0002, 2, 2048 },
+        { "IMA ADPCM mono", 0x0011, 1, 256 },
+        { "IMA ADPCM stereo", 0x0011, 2, 2048 }
+    };
+    int i;
+
+    /* Enable standard application logging */
+    SDL_LogSetPriority(SDL_LOG_CATEGORY_APPLICATION, SDL_LOG_PRIORITY_INFO);
+
+    SDLTest_RandomInit(&rndctx, 0x12345678, 0x9abcdef0);
+
+    if (argc > 1) {
+        for (i = 1; i < argc; i++) {
+            SDL_RWops *rw = SDL_RWFromFile(argv[i], "rb");
+            Sint64 size = rw ? SDL_RWsize(rw) : -1;
+            Uint8 *wav = (size > 0) ? (Uint8 *) SDL_malloc((size_t) size) : NULL;
+            if (!wav || (SDL_RWread(rw, wav, (size_t) size, 1) != 1)) {
+                SDL_Log("Couldn't read %s: %s", argv[i], SDL_GetError());
+            } else {
+                bench(argv[i], wav, (Uint32) size);
+            }
+            SDL_free(wav);
+            if (rw) {
+                SDL_RWclose(rw);
+            }
+        }
+        return 0;
+    }
+
+    for (i = 0; i < SDL_arraysize(files); i++) {
+        /* About 16 megabytes of encoded data apiece */
+        const Uint32 blocks = (16 * 1024 * 1024) / files[i].blockalign;
+        Uint32 len;
+        Uint8 *wav = make_adpcm(files[i].encoding, files[i].channels, files[i].blockalign, blocks, &len);
+        if (!wav) {
+            SDL_Log("Out of memory!");
+            return 1;
+        }
+        bench(files[i].desc, wav, len);
+        SDL_free(wav);
+    }
+
+    return 0;
+}
+
+/* vi: set ts=4 sw=4 expandtab: */
@@ -708,6 +708,265 @@ static void RunFIFOTest(SDL_bool lock_free)
 /* End FIFO test */
 /**************************************************************************/
 
+/**************************************************************************/
+/* SDL_AtomicQueue and SDL_AtomicStack tests */
+
+#define QUEUE_CAPACITY      256
+#define ITEMS_PER_WRITER    1000000
+#define STACK_THREADS       4
+#define STACK_ITEMS         64
+#define STACK_OPS           1000000
+
+/* Items are (writer << 24) | (sequence + 1), so they're never NULL. */
+#define MAKE_ITEM(w, i)     ((void *) (uintptr_t) ((((Uint32) (w)) << 24) | ((Uint32) (i) + 1)))
+#define ITEM_WRITER(p)      ((int) (((uintptr_t) (p)) >> 24))
+#define ITEM_SEQUENCE(p)    ((int) ((((uintptr_t) (p)) & 0xFFFFFF) - 1))
+
+typedef struct
+{
+    SDL_AtomicQueue *queue;
+    int index;
+    int waits;
+    char padding[SDL_CACHELINE_SIZE];
+} QueueWriterData;
+
+typedef struct
+{
+    SDL_AtomicQueue *queue;
+    int counters[NUM_WRITERS];
+    int last[NUM_WRITERS];
+    int out_of_order;
+    int waits;
+    char padding[SDL_CACHELINE_SIZE];
+} QueueReaderData;
+
+static SDL_atomic_t queueActive;
+
+static int SDLCALL Queue_Writer(void *_data)
+{
+    QueueWriterData *data = (QueueWriterData *)_data;
+    int i;
+
+    for (i = 0; i < ITEMS_PER_WRITER; ++i) {
+        while (!SDL_AtomicQueuePush(data->queue, MAKE_ITEM(data->index, i))) {
+            ++data->waits;
+            SDL_Delay(0);
+        }
+    }
+    SDL_AtomicAdd(&writersRunning, -1);
+    SDL_SemPost(writersDone);
+    return 0;
+}
+
+static int SDLCALL Queue_Reader(void *_data)
+{
+    QueueReaderData *data = (QueueReaderData *)_data;
+    void *item;
+
+    for ( ; ; ) {
+        if (SDL_AtomicQueuePop(data->queue, &item)) {
+            const int writer = ITEM_WRITER(item);
+            const int sequence = ITEM_SEQUENCE(item);
+            /* Each writer's items must come out in the order it pushed them */
+            if (sequence <= data->last[writer]) {
+                ++data->out_of_order;
+            }
+            data->last[writer] = sequence;
+            ++data->counters[writer];
+        } else if (SDL_AtomicGet(&queueActive)) {
+            ++data->waits;
+            SDL_Delay(0);
+        } else {
+            break;
+        }
+    }
+    SDL_AtomicAdd(&readersRunning, -1);
+    SDL_SemPost(readersDone);
+    return 0;
+}
+
+static void RunAtomicQueueTest(Uint32 flags)
+{
+    const SDL_bool spsc = (flags & SDL_ATOMICQUEUE_SPSC) ? SDL_TRUE : SDL_FALSE;
+    const int num_writers = spsc ? 1 : NUM_WRITERS;
+    const int num_readers = spsc ? 1 : NUM_READERS;
+    QueueWriterData writerData[NUM_WRITERS];
+    QueueReaderData readerData[NUM_READERS];
+    SDL_AtomicQueue *queue;
+    Uint64 start, end;
+    double seconds;
+    int i, j;
+    int grand_total = 0, out_of_order = 0;
+
+    SDL_Log("\nSDL_AtomicQueue test----------------------------\n\n");
+    SDL_Log("Mode: %s, %d writers, %d readers\n", spsc ? "SPSC" : "MPMC", num_writers, num_readers);
+
+    queue = SDL_CreateAtomicQueue(QUEUE_CAPACITY, flags);
+    if (!queue) {
+        SDL_Log("Couldn't create queue: %s\n", SDL_GetError());
+        return;
+    }
+    readersDone = SDL_CreateSemaphore(0);
+    writersDone = SDL_CreateSemaphore(0);
+    SDL_AtomicSet(&queueActive, 1);
+
+    start = SDL_GetPerformanceCounter();
+
+    SDL_zero(readerData);
+    SDL_AtomicSet(&readersRunning, num_readers);
+    for (i = 0; i < num_readers; ++i) {
+        char name[64];
+        SDL_snprintf(name, sizeof (name), "QueueReader%d", i);
+        readerData[i].queue = queue;
+        for (j = 0; j < NUM_WRITERS; ++j) {
+            readerData[i].last[j] = -1;
+        }
+        SDL_CreateThread(Queue_Reader, name, &readerData[i]);
+    }
+
+    SDL_zero(writerData);
+    SDL_AtomicSet(&writersRunning, num_writers);
+    for (i = 0; i < num_writers; ++i) {
+        char name[64];
+        SDL_snprintf(name, sizeof (name), "QueueWriter%d", i);
+        writerData[i].queue = queue;
+        writerData[i].index = i;
+        SDL_CreateThread(Queue_Writer, name, &writerData[i]);
+    }
+
+    while (SDL_AtomicGet(&writersRunning) > 0) {
+        SDL_SemWait(writersDone);
+    }
+    SDL_AtomicSet(&queueActive, 0);
+    while (SDL_AtomicGet(&readersRunning) > 0) {
+        SDL_SemWait(readersDone);
+    }
+
+    end = SDL_GetPerformanceCounter();
+    seconds = (double) (end - start) / SDL_GetPerformanceFrequency();
+
+    SDL_DestroySemaphore(readersDone);
+    SDL_DestroySemaphore(writersDone);
+    SDL_DestroyAtomicQueue(queue);
+
+    for (i = 0; i < num_writers; ++i) {
+        SDL_Log("Writer %d wrote %d items, had %d waits\n", i, ITEMS_PER_WRITER, writerData[i].waits);
+    }
+    for (i = 0; i < num_readers; ++i) {
+        int total = 0;
+        for (j = 0; j < num_writers; ++j) {
+            total += readerData[i].counters[j];
+        }
+        grand_total += total;
+        out_of_order += readerData[i].out_of_order;
+        SDL_Log("Reader %d read %d items, had %d waits\n", i, total, readerData[i].waits);
+    }
+    SDL_Log("Finished in %f sec, %.0f items/sec\n", seconds, grand_total / seconds);
+    SDL_Log("Items written: %d, read: %d, out of order: %d\n", num_writers * ITEMS_PER_WRITER, grand_total, out_of_order);
+    SDL_assert(grand_total == num_writers * ITEMS_PER_WRITER);
+    SDL_assert(out_of_order == 0);
+}
+
+typedef struct
+{
+    SDL_AtomicStack *stack;
+    SDL_atomic_t *owners;
+    int pops;
+    int misses;
+    int duplicates;
+    char padding[SDL_CACHELINE_SIZE];
+} StackThreadData;
+
+/* Every thread pops items and pushes them back. An item must never be held
+   by two threads at once, which is exactly what an ABA bug would cause. */
+static int SDLCALL Stack_Thread(void *_data)
+{
+    StackThreadData *data = (StackThreadData *)_data;
+    void *item;
+    int i;
+
+    for (i = 0; i < STACK_OPS; ++i) {
+        if (SDL_AtomicStackPop(data->stack, &item)) {
+            const int index = (int) (uintptr_t) item - 1;
+            if (!SDL_AtomicCAS(&data->owners[index], 0, 1)) {
+                ++data->duplicates;
+            }
+            ++data->pops;
+            SDL_AtomicSet(&data->owners[index], 0);
+            if (!SDL_AtomicStackPush(data->stack, item)) {
+                ++data->duplicates;  /* more pushes than nodes */
+            }
+        } else {
+            ++data->misses;
+        }
+    }
+    SDL_AtomicAdd(&readersRunning, -1);
+    SDL_SemPost(readersDone);
+    return 0;
+}
+
+static void RunAtomicStackTest(void)
+{
+    StackThreadData threadData[STACK_THREADS];
+    SDL_atomic_t owners[STACK_ITEMS];
+    SDL_AtomicStack *stack;
+    Uint64 start, end;
+    double seconds;
+    void *item;
+    int i, pops = 0, duplicates = 0, remaining = 0;
+
+    SDL_Log("\nSDL_AtomicStack test----------------------------\n\n");
+
+    stack = SDL_CreateAtomicStack(STACK_ITEMS);
+    if (!stack) {
+        SDL_Log("Couldn't create stack: %s\n", SDL_GetError());
+        return;
+    }
+    for (i = 0; i < STACK_ITEMS; ++i) {
+        SDL_AtomicSet(&owners[i], 0);
+        SDL_AtomicStackPush(stack, (void *) (uintptr_t) (i + 1));
+    }
+    SDL_assert(!SDL_AtomicStackPush(stack, (void *) (uintptr_t) (STACK_ITEMS + 1)));
+
+    readersDone = SDL_CreateSemaphore(0);
+    start = SDL_GetPerformanceCounter();
+
+    SDL_zero(threadData);
+    SDL_AtomicSet(&readersRunning, STACK_THREADS);
+    for (i = 0; i < STACK_THREADS; ++i) {
+        char name[64];
+        SDL_snprintf(name, sizeof (name), "StackThread%d", i);
+        threadData[i].stack = stack;
+        threadData[i].owners = owners;
+        SDL_CreateThread(Stack_Thread, name, &threadData[i]);
+    }
+    while (SDL_AtomicGet(&readersRunning) > 0) {
+        SDL_SemWait(readersDone);
+    }
+
+    end = SDL_GetPerformanceCounter();
+    seconds = (double) (end - start) / SDL_GetPerformanceFrequency();
+    SDL_DestroySemaphore(readersDone);
+
+    for (i = 0; i < STACK_THREADS; ++i) {
+        SDL_Log("Thread %d popped %d items, found the stack empty %d times\n", i, threadData[i].pops, threadData[i].misses);
+        pops += threadData[i].pops;
+        duplicates += threadData[i].duplicates;
+    }
+    while (SDL_AtomicStackPop(stack, &item)) {
+        ++remaining;
+    }
+    SDL_DestroyAtomicStack(stack);
+
+    SDL_Log("Finished in %f sec, %.0f pop/push pairs/sec\n", seconds, pops / seconds);
+    SDL_Log("Duplicates: %d, items left: %d of %d\n", duplicates, remaining, STACK_ITEMS);
+    SDL_assert(duplicates == 0);
+    SDL_assert(remaining == STACK_ITEMS);
+}
+
+/* End SDL_AtomicQueue and SDL_AtomicStack tests */
+/**************************************************************************/
+
 int
 main(int argc, char *argv[])
 {
@@ -721,6 +980,9 @@ main(int argc, char *argv[])
     RunFIFOTest(SDL_FALSE);
 #endif
     RunFIFOTest(SDL_TRUE);
+    RunAtomicQueueTest(0);
+    RunAtomicQueueTest(SDL_ATOMICQUEUE_SPSC);
+    RunAtomicStackTest();
     return 0;
 }
 
@@ -11,6 +11,9 @@
 
 #include "SDL.h"
 #include "SDL_test.h"
+#if TESTAUTOMATION_INTERNALS
+#include "../src/audio/SDL_audiomixer_c.h"
+#endif
 
 /* ================= Test Case Implementation ================== */
 
@@ -969,6 +972,572 @@ int audio_openCloseAudioDeviceConnected()
 
 
 
+/* Straightforward per-sample mixer to check SDL_MixAudioFormat() against */
+static Sint64
+_audio_readSample(const Uint8 *p, SDL_AudioFormat format)
+{
+   Uint32 u;
+   switch (format) {
+     case AUDIO_S16LSB: return (Sint16) ((p[1] << 8) | p[0]);
+     case AUDIO_S16MSB: return (Sint16) ((p[0] << 8) | p[1]);
+     case AUDIO_S32LSB: case AUDIO_F32LSB:
+       u = ((Uint32) p[3] << 24) | ((Uint32) p[2] << 16) | ((Uint32) p[1] << 8) | p[0];
+       return (Sint32) u;
+     default:
+       u = ((Uint32) p[0] << 24) | ((Uint32) p[1] << 16) | ((Uint32) p[2] << 8) | p[3];
+       return (Sint32) u;
+   }
+}
+
+static void
+_audio_writeSample(Uint8 *p, SDL_AudioFormat format, Sint64 sample)
+{
+   const int size = SDL_AUDIO_BITSIZE(format) / 8;
+   int i;
+   for (i = 0; i < size; i++) {
+     const int shift = SDL_AUDIO_ISBIGENDIAN(format) ? (size - 1 - i) * 8 : i * 8;
+     p[i] = (Uint8) ((sample >> shift) & 0xFF);
+   }
+}
+
+static void
+_audio_referenceMix(Uint8 *dst, const Uint8 *src, SDL_AudioFormat format, Uint32 len, int volume)
+{
+   const int size = SDL_AUDIO_BITSIZE(format) / 8;
+   Uint32 i;
+   for (i = 0; i + size <= len; i += size) {
+     if (SDL_AUDIO_ISFLOAT(format)) {
+       union { Uint32 u; float f; } s, d;
+       double sum;
+       s.u = (Uint32) _audio_readSample(src + i, format);
+       d.u = (Uint32) _audio_readSample(dst + i, format);
+       sum = (double) ((s.f * (float) volume) * (1.0f / SDL_MIX_MAXVOLUME)) + (double) d.f;
+       sum = SDL_min(SDL_max(sum, -3.402823466e+38F), 3.402823466e+38F);
+       d.f = (float) sum;
+       _audio_writeSample(dst + i, format, d.u);
+     } else {
+       const Sint64 maxval = (((Sint64) 1) << (SDL_AUDIO_BITSIZE(format) - 1)) - 1;
+       const Sint64 minval = -(((Sint64) 1) << (SDL_AUDIO_BITSIZE(format) - 1));
+       Sint64 sum = ((_audio_readSample(src + i, format) * volume) / SDL_MIX_MAXVOLUME) + _audio_readSample(dst + i, format);
+       sum = SDL_min(SDL_max(sum, minval), maxval);
+       _audio_writeSample(dst + i, format, sum);
+     }
+   }
+}
+
+/**
+ * \brief Mix buffers in all vectorized formats and compare to a per-sample mix.
+ *
+ * \sa https://wiki.libsdl.org/SDL_MixAudioFormat
+ */
+int audio_mixAudioFormat()
+{
+   const SDL_AudioFormat formats[] = { AUDIO_S16LSB, AUDIO_S16MSB, AUDIO_S32LSB, AUDIO_S32MSB, AUDIO_F32LSB, AUDIO_F32MSB };
+   const char *formatNames[] = { "AUDIO_S16LSB", "AUDIO_S16MSB", "AUDIO_S32LSB", "AUDIO_S32MSB", "AUDIO_F32LSB", "AUDIO_F32MSB" };
+   const int volumes[] = { 1, 37, 64, 127, SDL_MIX_MAXVOLUME };
+   /* Whole samples in every format, set against the 16 byte SSE2 and 32 byte
+      AVX2 blocks: less than a block, whole blocks, and 4 or 12 bytes left for
+      the scalar loop after AVX2 only, SSE2 only or both (52 and 1020). */
+   const Uint32 lengths[] = { 4, 12, 28, 36, 52, 64, 100, 1020 };
+   Uint8 src[1024 + 1], dst[1024 + 1], expected[1024 + 1];
+   int i, j, k;
+   Uint32 n;
+
+   for (i = 0; i < (int) SDL_arraysize(formats); i++) {
+     for (j = 0; j < (int) SDL_arraysize(volumes); j++) {
+       for (k = 0; k < (int) SDL_arraysize(lengths); k++) {
+         const Uint32 len = lengths[k];
+         for (n = 0; n < len; n++) {
+           src[n + 1] = (Uint8) SDLTest_RandomUint8();
+           dst[n + 1] = (Uint8) SDLTest_RandomUint8();
+         }
+         if (SDL_AUDIO_ISFLOAT(formats[i])) {
+           /* Keep float samples in a sane range; the exponent lives in the top bits. */
+           const int hi = SDL_AUDIO_ISBIGENDIAN(formats[i]) ? 0 : 3;
+           for (n = 0; n < len; n += 4) {
+             src[n + 1 + hi] &= 0xBF;
+             dst[n + 1 + hi] &= 0xBF;
+           }
+         }
+         SDL_memcpy(expected + 1, dst + 1, len);
+         _audio_referenceMix(expected + 1, src + 1, formats[i], len, volumes[j]);
+
+         /* Offset by one byte so the mixer can't rely on aligned buffers. */
+         SDL_MixAudioFormat(dst + 1, src + 1, formats[i], len, volumes[j]);
+         SDLTest_AssertCheck(SDL_memcmp(dst + 1, expected + 1, len) == 0,
+           "Verify mixed %s output (volume %i, %i bytes) matches the reference", formatNames[i], volumes[j], (int) len);
+       }
+     }
+   }
+
+   /* Make sure saturation kicks in at both ends. */
+   for (n = 0; n < 64; n += 2) {
+     _audio_writeSample(src + n, AUDIO_S16LSB, (n & 2) ? 32000 : -32000);
+     _audio_writeSample(dst + n, AUDIO_S16LSB, (n & 2) ? 32000 : -32000);
+   }
+   SDL_MixAudioFormat(dst, src, AUDIO_S16LSB, 64, SDL_MIX_MAXVOLUME);
+   SDLTest_AssertCheck(_audio_readSample(dst, AUDIO_S16LSB) == -32768, "Verify negative S16 saturation");
+   SDLTest_AssertCheck(_audio_readSample(dst + 2, AUDIO_S16LSB) == 32767, "Verify positive S16 saturation");
+
+   return TEST_COMPLETED;
+}
+
+
+/**
+ * \brief Mix a few voices through an SDL_AudioMixer and check the output.
+ *
+ * \sa https://wiki.libsdl.org/SDL_NewAudioMixer
+ * \sa https://wiki.libsdl.org/SDL_AudioMixerGet
+ */
+int audio_audioMixer()
+{
+#if TESTAUTOMATION_INTERNALS
+   SDL_AudioMixer *mixer;
+   Sint16 tone[64];
+   Sint16 out[2 * 256];
+   float ftone[16];
+   int voice, voice2, voice3, result, i;
+   SDL_bool ok;
+
+   for (i = 0; i < (int) SDL_arraysize(tone); i++) {
+     tone[i] = 1000;
+   }
+   for (i = 0; i < (int) SDL_arraysize(ftone); i++) {
+     ftone[i] = 0.25f;
+   }
+
+   mixer = SDL_NewAudioMixer(AUDIO_S16SYS, 2, 44100);
+   SDLTest_AssertPass("Call to SDL_NewAudioMixer(AUDIO_S16SYS, 2, 44100)");
+   SDLTest_AssertCheck(mixer != NULL, "Verify mixer is not NULL");
+   if (mixer == NULL) return TEST_ABORTED;
+
+   /* Nothing playing yet: silence. */
+   result = SDL_AudioMixerGet(mixer, out, sizeof (out));
+   SDLTest_AssertCheck(result == sizeof (out), "Verify SDL_AudioMixerGet result; expected: %i, got: %i", (int) sizeof (out), result);
+   ok = SDL_TRUE;
+   for (i = 0; i < (int) SDL_arraysize(out); i++) {
+     ok = ok && (out[i] == 0);
+   }
+   SDLTest_AssertCheck(ok, "Verify output is silent without voices");
+
+   /* A mono voice at the mixer's rate comes out unchanged on both channels. */
+   voice = SDL_AudioMixerAddVoice(mixer, AUDIO_S16SYS, 1, 44100, tone, sizeof (tone));
+   SDLTest_AssertCheck(voice >= 0, "Verify SDL_AudioMixerAddVoice result; expected: >=0, got: %i", voice);
+   result = SDL_AudioMixerGet(mixer, out, 2 * 32 * sizeof (Sint16));
+   SDLTest_AssertCheck(result == 2 * 32 * sizeof (Sint16), "Verify SDL_AudioMixerGet result; got: %i", result);
+   ok = SDL_TRUE;
+   for (i = 0; i < 2 * 32; i++) {
+     ok = ok && (SDL_abs(out[i] - 1000) <= 1);
+   }
+   SDLTest_AssertCheck(ok, "Verify mono voice is mixed to both channels; got: %i, %i", out[0], out[1]);
+
+   /* The rest of the voice plays out, then it stops. */
+   SDL_AudioMixerGet(mixer, out, sizeof (out));
+   SDLTest_AssertCheck(out[2 * 40] == 0, "Verify output is silent after the voice ended; got: %i", out[2 * 40]);
+   result = SDL_AudioMixerVoicePlaying(mixer, voice);
+   SDLTest_AssertCheck(result == 0, "Verify SDL_AudioMixerVoicePlaying result; expected: 0, got: %i", result);
+
+   /* A looping float voice at half the rate keeps going, panned hard right. */
+   voice2 = SDL_AudioMixerAddVoice(mixer, AUDIO_F32SYS, 1, 22050, ftone, sizeof (ftone));
+   SDLTest_AssertCheck(voice2 >= 0 && voice2 != voice, "Verify second voice ID; got: %i", voice2);
+   result = SDL_AudioMixerSetVoiceLoop(mixer, voice2, 0, 0);
+   SDLTest_AssertCheck(result == 0, "Verify SDL_AudioMixerSetVoiceLoop result; expected: 0, got: %i", result);
+   result = SDL_AudioMixerSetVoiceGain(mixer, voice2, 1.0f, 1.0f);
+   SDLTest_AssertCheck(result == 0, "Verify SDL_AudioMixerSetVoiceGain result; expected: 0, got: %i", result);
+   SDL_AudioMixerGet(mixer, out, sizeof (out));
+   ok = SDL_TRUE;
+   for (i = 0; i < (int) SDL_arraysize(out); i += 2) {
+     ok = ok && (out[i] == 0) && (SDL_abs(out[i + 1] - 8192) <= 1);
+   }
+   SDLTest_AssertCheck(ok, "Verify looping voice is resampled and panned right; got: %i, %i", out[0], out[1]);
+   result = SDL_AudioMixerVoicePlaying(mixer, voice2);
+   SDLTest_AssertCheck(result == 1, "Verify SDL_AudioMixerVoicePlaying result; expected: 1, got: %i", result);
+
+   /* A muted voice keeps playing silently, so unmuting it halfway through
+      only plays the second half. */
+   SDL_AudioMixerSetVoiceGain(mixer, voice2, 0.0f, 0.0f);
+   voice3 = SDL_AudioMixerAddVoice(mixer, AUDIO_S16SYS, 1, 44100, tone, sizeof (tone));
+   SDLTest_AssertCheck(voice3 >= 0, "Verify SDL_AudioMixerAddVoice result; expected: >=0, got: %i", voice3);
+   result = SDL_AudioMixerSetVoiceGain(mixer, voice3, 0.0f, 0.0f);
+   SDLTest_AssertCheck(result == 0, "Verify SDL_AudioMixerSetVoiceGain result; expected: 0, got: %i", result);
+   SDL_AudioMixerGet(mixer, out, 2 * 32 * sizeof (Sint16));
+   ok = SDL_TRUE;
+   for (i = 0; i < 2 * 32; i++) {
+     ok = ok && (out[i] == 0);
+   }
+   SDLTest_AssertCheck(ok, "Verify muted voices are silent");
+   SDL_AudioMixerSetVoiceGain(mixer, voice3, 1.0f, 0.0f);
+   SDL_AudioMixerGet(mixer, out, sizeof (out));
+   SDLTest_AssertCheck((SDL_abs(out[2 * 31] - 1000) <= 1) && (out[2 * 32] == 0),
+                       "Verify unmuted voice plays from where it got to; got: %i, %i", out[2 * 31], out[2 * 32]);
+   result = SDL_AudioMixerVoicePlaying(mixer, voice3);
+   SDLTest_AssertCheck(result == 0, "Verify SDL_AudioMixerVoicePlaying result; expected: 0, got: %i", result);
+
+   /* Muted looping voices wrap around their loop like audible ones. */
+   SDL_AudioMixerGet(mixer, out, 2 * 7 * sizeof (Sint16));
+   result = SDL_AudioMixerVoicePlaying(mixer, voice2);
+   SDLTest_AssertCheck(result == 1, "Verify muted looping voice is still playing; got: %i", result);
+
+   /* Negative cases */
+   result = SDL_AudioMixerGet(mixer, out, 3);
+   SDLTest_AssertCheck(result == -1, "Verify partial sample frames are rejected; got: %i", result);
+   result = SDL_AudioMixerRemoveVoice(mixer, voice);
+   SDLTest_AssertCheck(result == 0, "Verify SDL_AudioMixerRemoveVoice result; expected: 0, got: %i", result);
+   result = SDL_AudioMixerRemoveVoice(mixer, voice);
+   SDLTest_AssertCheck(result == -1, "Verify removing a voice twice fails; got: %i", result);
+   result = SDL_AudioMixerSetVoiceLoop(mixer, voice2, 10, 100);
+   SDLTest_AssertCheck(result == -1, "Verify loop points past the end are rejected; got: %i", result);
+
+   SDL_FreeAudioMixer(mixer);
+   SDLTest_AssertPass("Call to SDL_FreeAudioMixer()");
+
+   return TEST_COMPLETED;
+#else
+   SDLTest_Log("SDL_AudioMixer is internal, so it can only be tested against the static library");
+   return TEST_SKIPPED;
+#endif
+}
+
+
+/* Per-frame channel remixing, as SDL_audiocvt.c's scalar converters do it */
+static float
+_audio_clampSample(float x)
+{
+   return (x > 1.0f) ? 1.0f : ((x < -1.0f) ? -1.0f : x);
+}
+
+static void
+_audio_referenceRemix(const float *src, float *dst, int src_channels, int dst_channels)
+{
+   float ce, ls, rs;
+   switch ((src_channels * 10) + dst_channels) {
+     case 21:  /* stereo -> mono */
+       dst[0] = (src[0] + src[1]) * 0.5f;
+       break;
+     case 62:  /* 5.1 -> stereo */
+       ce = src[2] * 0.5f;
+       dst[0] = (src[0] + ce + src[4]) / 2.5f;
+       dst[1] = (src[1] + ce + src[5]) / 2.5f;
+       break;
+     case 42:  /* quad -> stereo */
+       dst[0] = (src[0] + src[2]) * 0.5f;
+       dst[1] = (src[1] + src[3]) * 0.5f;
+       break;
+     case 86:  /* 7.1 -> 5.1 */
+       ls = src[6] * 0.5f;
+       rs = src[7] * 0.5f;
+       dst[0] = (src[0] + ls) / 1.5f;
+       dst[1] = (src[1] + rs) / 1.5f;
+       dst[2] = src[2] / 1.5f;
+       dst[3] = src[3] / 1.5f;
+       dst[4] = (src[4] + ls) / 1.5f;
+       dst[5] = (src[5] + rs) / 1.5f;
+       break;
+     case 64:  /* 5.1 -> quad */
+       ce = src[2] * 0.5f;
+       dst[0] = (src[0] + ce) / 1.5f;
+       dst[1] = (src[1] + ce) / 1.5f;
+       dst[2] = src[4] / 1.5f;
+       dst[3] = src[5] / 1.5f;
+       break;
+     case 12:  /* mono -> stereo */
+       dst[0] = dst[1] = src[0];
+       break;
+     case 26:  /* stereo -> 5.1 */
+     case 46:  /* quad -> 5.1 */
+       ce = (src[0] + src[1]) * 0.5f;
+       dst[0] = _audio_clampSample(src[0] + (src[0] - ce));
+       dst[1] = _audio_clampSample(src[1] + (src[1] - ce));
+       dst[2] = ce;
+       dst[3] = 0.0f;
+       dst[4] = (src_channels == 4) ? src[2] : src[0];
+       dst[5] = (src_channels == 4) ? src[3] : src[1];
+       break;
+     case 24:  /* stereo -> quad */
+       dst[0] = dst[2] = src[0];
+       dst[1] = dst[3] = src[1];
+       break;
+     case 68:  /* 5.1 -> 7.1 */
+       ls = (src[0] + src[4]) * 0.5f;
+       rs = (src[1] + src[5]) * 0.5f;
+       dst[0] = _audio_clampSample(src[0] + (src[0] - ls));
+       dst[1] = _audio_clampSample(src[1] + (src[1] - rs));
+       dst[2] = src[2];
+       dst[3] = src[3];
+       dst[4] = _audio_clampSample(src[4] + (src[4] - ls));
+       dst[5] = _audio_clampSample(src[5] + (src[5] - rs));
+       dst[6] = ls;
+       dst[7] = rs;
+       break;
+   }
+}
+
+/**
+ * \brief Remix float audio between channel layouts and compare bit-exactly to a per-frame reference.
+ *
+ * \sa https://wiki.libsdl.org/SDL_BuildAudioCVT
+ * \sa https://wiki.libsdl.org/SDL_ConvertAudio
+ */
+int audio_convertChannels()
+{
+   const int conversions[][2] = {
+     { 2, 1 }, { 6, 2 }, { 4, 2 }, { 8, 6 }, { 6, 4 },
+     { 1, 2 }, { 2, 6 }, { 4, 6 }, { 2, 4 }, { 6, 8 }
+   };
+   /* The SSE remixers take 4 frames (mono <-> stereo), 2 frames or 1 frame at a time:
+      short buffers that never reach a block, whole blocks (4, 256), and 37..39 to leave
+      1, 2 and 3 frames for the scalar loop after a run of blocks. */
+   const int frameCounts[] = { 1, 2, 3, 4, 37, 38, 39, 256 };
+   SDL_AudioCVT cvt;
+   float *src, *expected;
+   int i, j, n, result;
+
+   for (i = 0; i < (int) SDL_arraysize(conversions); i++) {
+     const int src_channels = conversions[i][0];
+     const int dst_channels = conversions[i][1];
+     for (j = 0; j < (int) SDL_arraysize(frameCounts); j++) {
+       const int frames = frameCounts[j];
+       result = SDL_BuildAudioCVT(&cvt, AUDIO_F32SYS, src_channels, 48000, AUDIO_F32SYS, dst_channels, 48000);
+       SDLTest_AssertCheck(result == 1, "Verify SDL_BuildAudioCVT(%i -> %i channels) result; expected: 1, got: %i", src_channels, dst_channels, result);
+       if (result != 1) return TEST_ABORTED;
+
+       cvt.len = frames * src_channels * sizeof (float);
+       cvt.buf = (Uint8 *) SDL_malloc(cvt.len * cvt.len_mult);
+       src = (float *) SDL_malloc(cvt.len);
+       expected = (float *) SDL_malloc(frames * dst_channels * sizeof (float));
+       SDLTest_AssertCheck(cvt.buf && src && expected, "Check buffers are not NULL");
+       if (!cvt.buf || !src || !expected) return TEST_ABORTED;
+
+       /* Go past full scale so upmixing has something to clamp, and throw in signed zeros. */
+       for (n = 0; n < frames * src_channels; n++) {
+         src[n] = (SDLTest_RandomUnitFloat() * 3.0f) - 1.5f;
+         if ((n % 11) == 0) {
+           src[n] = (n & 1) ? 0.0f : -0.0f;
+         }
+       }
+       for (n = 0; n < frames; n++) {
+         _audio_referenceRemix(src + (n * src_channels), expected + (n * dst_channels), src_channels, dst_channels);
+       }
+
+       SDL_memcpy(cvt.buf, src, cvt.len);
+       result = SDL_ConvertAudio(&cvt);
+       SDLTest_AssertCheck(result == 0, "Verify SDL_ConvertAudio result; expected: 0, got: %i", result);
+       SDLTest_AssertCheck(cvt.len_cvt == (int) (frames * dst_channels * sizeof (float)), "Verify converted length; got: %i", cvt.len_cvt);
+       SDLTest_AssertCheck(SDL_memcmp(cvt.buf, expected, frames * dst_channels * sizeof (float)) == 0,
+         "Verify %i -> %i channel output (%i frames) matches the reference bit for bit", src_channels, dst_channels, frames);
+
+       SDL_free(expected);
+       SDL_free(src);
+       SDL_free(cvt.buf);
+     }
+   }
+
+   return TEST_COMPLETED;
+}
+
+/**
+ * \brief Stream sample.wav a piece at a time and compare to loading it whole.
+ *
+ * \sa https://wiki.libsdl.org/SDL_LoadWAV_RW
+ */
+int audio_streamWAV()
+{
+   /* Sizes that don't line up with the ADPCM blocks or the sample frames. */
+   const int readSizes[] = { 1, 3, 1000, 4097 };
+   SDL_AudioSpec spec, streamSpec;
+   SDL_AudioStream *stream;
+   SDL_WAVStream *wav;
+   Uint8 *expected = NULL, *buf;
+   Uint32 len = 0;
+   int i, total, result;
+
+   SDLTest_AssertCheck(SDL_LoadWAV("sample.wav", &spec, &expected, &len) != NULL, "Verify SDL_LoadWAV(sample.wav) succeeds");
+   if (!expected) return TEST_ABORTED;
+
+   wav = SDL_OpenWAVStream("sample.wav", &streamSpec);
+   SDLTest_AssertCheck(wav != NULL, "Verify SDL_OpenWAVStream(sample.wav) succeeds");
+   if (!wav) return TEST_ABORTED;
+   SDLTest_AssertCheck(streamSpec.format == spec.format && streamSpec.channels == spec.channels && streamSpec.freq == spec.freq,
+     "Verify the stream's spec matches SDL_LoadWAV's");
+
+   buf = (Uint8 *) SDL_malloc(len + 4097);
+   SDLTest_AssertCheck(buf != NULL, "Check buffer is not NULL");
+   if (!buf) return TEST_ABORTED;
+
+   for (i = 0; i < (int) SDL_arraysize(readSizes); i++) {
+     result = SDL_WAVStreamRewind(wav);
+     SDLTest_AssertCheck(result == 0, "Verify SDL_WAVStreamRewind result; expected: 0, got: %i", result);
+     total = 0;
+     while ((result = SDL_WAVStreamRead(wav, buf + total, readSizes[i])) > 0) {
+       total += result;
+     }
+     SDLTest_AssertCheck(result == 0, "Verify SDL_WAVStreamRead ends with 0, got: %i", result);
+     SDLTest_AssertCheck(total == (int) len, "Verify streamed length; expected: %u, got: %i", len, total);
+     SDLTest_AssertCheck(SDL_memcmp(buf, expected, len) == 0, "Verify audio read %i bytes at a time matches SDL_LoadWAV", readSizes[i]);
+   }
+
+   /* Through an audio stream that doesn't convert anything, it should come out the same. */
+   stream = SDL_NewAudioStream(spec.format, spec.channels, spec.freq, spec.format, spec.channels, spec.freq);
+   SDLTest_AssertCheck(stream != NULL, "Verify SDL_NewAudioStream succeeds");
+   if (!stream) return TEST_ABORTED;
+   SDL_WAVStreamRewind(wav);
+   while ((result = SDL_WAVStreamPut(wav, stream, 4096)) > 0) {
+     /* keep going. */
+   }
+   SDLTest_AssertCheck(result == 0, "Verify SDL_WAVStreamPut ends with 0, got: %i", result);
+   total = SDL_AudioStreamAvailable(stream);
+   SDLTest_AssertCheck(total == (int) len, "Verify audio stream length; expected: %u, got: %i", len, total);
+   result = SDL_AudioStreamGet(stream, buf, len);
+   SDLTest_AssertCheck(result == (int) len, "Verify SDL_AudioStreamGet result; expected: %u, got: %i", len, result);
+   SDLTest_AssertCheck(SDL_memcmp(buf, expected, len) == 0, "Verify audio put into an audio stream matches SDL_LoadWAV");
+
+   SDL_FreeAudioStream(stream);
+   SDL_CloseWAVStream(wav);
+   SDL_free(buf);
+   SDL_FreeWAV(expected);
+
+   return TEST_COMPLETED;
+}
+
+/* An SDL_RWops over memory that can only be read front to back, like a pipe.
+   If data2 is set, it's the most bytes a read hands back at a time. */
+static Sint64 SDLCALL
+_audio_pipeSize(SDL_RWops *context)
+{
+   return -1;
+}
+
+static Sint64 SDLCALL
+_audio_pipeSeek(SDL_RWops *context, Sint64 offset, int whence)
+{
+   return SDL_SetError("Can't seek in a pipe");
+}
+
+static size_t SDLCALL
+_audio_pipeRead(SDL_RWops *context, void *ptr, size_t size, size_t maxnum)
+{
+   const size_t most = (size_t) context->hidden.unknown.data2;
+   if (most && (size == 1) && (maxnum > most)) {
+     maxnum = most;
+   }
+   return SDL_RWread((SDL_RWops *) context->hidden.unknown.data1, ptr, size, maxnum);
+}
+
+static int SDLCALL
+_audio_pipeClose(SDL_RWops *context)
+{
+   SDL_RWclose((SDL_RWops *) context->hidden.unknown.data1);
+   SDL_FreeRW(context);
+   return 0;
+}
+
+/**
+ * \brief Load a WAVE file with extra chunks from an SDL_RWops that can't seek.
+ *
+ * \sa https://wiki.libsdl.org/SDL_LoadWAV_RW
+ */
+int audio_loadWAVNonSeekable()
+{
+   /* 16-bit mono PCM, with a LIST chunk between the format and the data. */
+   const Uint8 wave[] = {
+     'R', 'I', 'F', 'F', 60, 0, 0, 0, 'W', 'A', 'V', 'E',
+     'f', 'm', 't', ' ', 16, 0, 0, 0, 1, 0, 1, 0, 0x22, 0x56, 0, 0, 0x44, 0xAC, 0, 0, 2, 0, 16, 0,
+     'L', 'I', 'S', 'T', 4, 0, 0, 0, 'I', 'N', 'F', 'O',
+     'd', 'a', 't', 'a', 8, 0, 0, 0, 1, 0, 2, 0, 3, 0, 4, 0
+   };
+   SDL_AudioSpec spec;
+   SDL_RWops *rw;
+   Uint8 *buf = NULL;
+   Uint32 len = 0;
+
+   rw = SDL_AllocRW();
+   SDLTest_AssertCheck(rw != NULL, "Verify SDL_AllocRW() succeeds");
+   if (!rw) return TEST_ABORTED;
+   rw->size = _audio_pipeSize;
+   rw->seek = _audio_pipeSeek;
+   rw->read = _audio_pipeRead;
+   rw->close = _audio_pipeClose;
+   rw->hidden.unknown.data1 = SDL_RWFromConstMem(wave, sizeof (wave));
+
+   SDLTest_AssertCheck(SDL_LoadWAV_RW(rw, 1, &spec, &buf, &len) != NULL, "Verify SDL_LoadWAV_RW() succeeds without seeking");
+   SDLTest_AssertCheck(spec.format == AUDIO_S16 && spec.channels == 1 && spec.freq == 22050,
+     "Verify spec; got: format 0x%x, %i channels, %i Hz", spec.format, spec.channels, spec.freq);
+   SDLTest_AssertCheck(len == 8 && buf && SDL_memcmp(buf, wave + sizeof (wave) - 8, 8) == 0,
+     "Verify audio data after the skipped chunk; got %u bytes", len);
+   SDL_FreeWAV(buf);
+
+   return TEST_COMPLETED;
+}
+
+/**
+ * \brief Stream a WAVE file from a pipe that comes up short in the middle of frames.
+ *
+ * \sa https://wiki.libsdl.org/SDL_LoadWAV_RW
+ */
+int audio_streamWAVShortReads()
+{
+   /* 16-bit stereo PCM, 11 frames. Reads of 5 bytes split most of them. */
+   const Uint8 wave[] = {
+     'R', 'I', 'F', 'F', 80, 0, 0, 0, 'W', 'A', 'V', 'E',
+     'f', 'm', 't', ' ', 16, 0, 0, 0, 1, 0, 2, 0, 0x22, 0x56, 0, 0, 0x88, 0x58, 1, 0, 4, 0, 16, 0,
+     'd', 'a', 't', 'a', 44, 0, 0, 0,
+     0x01, 0x10, 0x02, 0x20, 0x03, 0x30, 0x04, 0x40, 0x05, 0x50, 0x06, 0x60, 0x07, 0x70, 0x08, 0x80,
+     0x09, 0x90, 0x0A, 0xA0, 0x0B, 0xB0, 0x0C, 0xC0, 0x0D, 0xD0, 0x0E, 0xE0, 0x0F, 0xF0, 0x10, 0x01,
+     0x11, 0x11, 0x12, 0x21, 0x13, 0x31, 0x14, 0x41, 0x15, 0x51, 0x16, 0x61
+   };
+   const Uint8 *data = wave + sizeof (wave) - 44;
+   const int readSizes[] = { 1, 4, 7, 100 };
+   SDL_AudioSpec spec;
+   SDL_AudioStream *stream;
+   SDL_WAVStream *wav;
+   SDL_RWops *rw;
+   Uint8 buf[64];
+   int i, total, result;
+
+   for (i = 0; i < (int) SDL_arraysize(readSizes); i++) {
+     rw = SDL_AllocRW();
+     SDLTest_AssertCheck(rw != NULL, "Verify SDL_AllocRW() succeeds");
+     if (!rw) return TEST_ABORTED;
+     rw->size = _audio_pipeSize;
+     rw->seek = _audio_pipeSeek;
+     rw->read = _audio_pipeRead;
+     rw->close = _audio_pipeClose;
+     rw->hidden.unknown.data1 = SDL_RWFromConstMem(wave, sizeof (wave));
+     rw->hidden.unknown.data2 = NULL;
+
+     wav = SDL_OpenWAVStream_RW(rw, 1, &spec);
+     SDLTest_AssertCheck(wav != NULL, "Verify SDL_OpenWAVStream_RW() succeeds without seeking");
+     if (!wav) return TEST_ABORTED;
+     rw->hidden.unknown.data2 = (void *) (size_t) 5;
+
+     total = 0;
+     while ((result = SDL_WAVStreamRead(wav, buf + total, SDL_min(readSizes[i], (int) sizeof (buf) - total))) > 0) {
+       total += result;
+     }
+     SDLTest_AssertCheck(result == 0, "Verify SDL_WAVStreamRead ends with 0, got: %i", result);
+     SDLTest_AssertCheck(total == 44, "Verify streamed length; expected: 44, got: %i", total);
+     SDLTest_AssertCheck(SDL_memcmp(buf, data, 44) == 0, "Verify audio read %i bytes at a time from 5 byte pipe reads is intact", readSizes[i]);
+     SDL_CloseWAVStream(wav);
+   }
+
+   /* Putting a length near the limit mustn't overflow rounding it up to a frame. */
+   rw = SDL_RWFromConstMem(wave, sizeof (wave));
+   wav = SDL_OpenWAVStream_RW(rw, 1, &spec);
+   SDLTest_AssertCheck(wav != NULL, "Verify SDL_OpenWAVStream_RW() succeeds");
+   if (!wav) return TEST_ABORTED;
+   stream = SDL_NewAudioStream(spec.format, spec.channels, spec.freq, spec.format, spec.channels, spec.freq);
+   SDLTest_AssertCheck(stream != NULL, "Verify SDL_NewAudioStream succeeds");
+   if (!stream) return TEST_ABORTED;
+   result = SDL_WAVStreamPut(wav, stream, SDL_MAX_SINT32);
+   SDLTest_AssertCheck(result == 44, "Verify SDL_WAVStreamPut(SDL_MAX_SINT32) result; expected: 44, got: %i", result);
+   result = SDL_AudioStreamGet(stream, buf, sizeof (buf));
+   SDLTest_AssertCheck(result == 44 && SDL_memcmp(buf, data, 44) == 0, "Verify the audio stream got all 44 bytes; got: %i", result);
+   SDL_FreeAudioStream(stream);
+   SDL_CloseWAVStream(wav);
+
+   return TEST_COMPLETED;
+}
+
 /* ================= Test Case References ================== */
 
 /* Audio test cases */
@@ -1022,11 +1591,29 @@ static const SDLTest_TestCaseReference audioTest14 =
 static const SDLTest_TestCaseReference audioTest15 =
         { (SDLTest_TestCaseFp)audio_pauseUnpauseAudio, "audio_pauseUnpauseAudio", "Pause and Unpause audio for various audio specs while testing callback.", TEST_ENABLED };
 
+static const SDLTest_TestCaseReference audioTest16 =
+        { (SDLTest_TestCaseFp)audio_mixAudioFormat, "audio_mixAudioFormat", "Mix audio in various formats and compare to a per-sample reference.", TEST_ENABLED };
+
+static const SDLTest_TestCaseReference audioTest17 =
+        { (SDLTest_TestCaseFp)audio_audioMixer, "audio_audioMixer", "Mix voices with SDL_AudioMixer.", TEST_ENABLED };
+
+static const SDLTest_TestCaseReference audioTest18 =
+        { (SDLTest_TestCaseFp)audio_convertChannels, "audio_convertChannels", "Remix between channel layouts and compare to a per-frame reference.", TEST_ENABLED };
+
+static const SDLTest_TestCaseReference audioTest19 =
+        { (SDLTest_TestCaseFp)audio_streamWAV, "audio_streamWAV", "Stream a WAVE file and compare to loading it whole.", TEST_ENABLED };
+
+static const SDLTest_TestCaseReference audioTest20 =
+        { (SDLTest_TestCaseFp)audio_loadWAVNonSeekable, "audio_loadWAVNonSeekable", "Load a WAVE file with extra chunks from a stream that can't seek.", TEST_ENABLED };
+
+static const SDLTest_TestCaseReference audioTest21 =
+        { (SDLTest_TestCaseFp)audio_streamWAVShortReads, "audio_streamWAVShortReads", "Stream a WAVE file from a pipe that comes up short mid-frame.", TEST_ENABLED };
+
 /* Sequence of Audio test cases */
 static const SDLTest_TestCaseReference *audioTests[] =  {
     &audioTest1, &audioTest2, &audioTest3, &audioTest4, &audioTest5, &audioTest6,
     &audioTest7, &audioTest8, &audioTest9, &audioTest10, &audioTest11,
-    &audioTest12, &audioTest13, &audioTest14, &audioTest15, NULL
+    &audioTest12, &audioTest13, &audioTest14, &audioTest15, &audioTest16, &audioTest17, &audioTest18, &audioTest19, &audioTest20, &audioTest21, NULL
 };
 
 /* Audio test suite (global) */
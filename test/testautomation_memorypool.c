@@ -0,0 +1,279 @@
+/**
+ * Memory pool test suite
+ */
+
+#include <stdio.h>
+
+#include "SDL.h"
+#include "SDL_test.h"
+#if TESTAUTOMATION_INTERNALS
+#include "../src/SDL_memorypool.h"
+#endif
+
+/* ================= Test Case Implementation ================== */
+
+#if TESTAUTOMATION_INTERNALS
+
+#define POOL_TEST_OBJECTS   64
+
+/* Returns SDL_TRUE if every pointer in a can be found in b. */
+static SDL_bool
+_memorypool_sameObjects(void **a, void **b, const int count)
+{
+   int i, j;
+   for (i = 0; i < count; i++) {
+     for (j = 0; j < count; j++) {
+       if (a[i] == b[j]) {
+         break;
+       }
+     }
+     if (j == count) {
+       return SDL_FALSE;
+     }
+   }
+   return SDL_TRUE;
+}
+
+typedef struct
+{
+   SDL_MemoryPool *pool;
+   void *objects[POOL_TEST_OBJECTS];
+} _memorypool_threadData;
+
+static int SDLCALL
+_memorypool_thread(void *arg)
+{
+   _memorypool_threadData *data = (_memorypool_threadData *) arg;
+   int i;
+
+   for (i = 0; i < POOL_TEST_OBJECTS; i++) {
+     data->objects[i] = SDL_AllocFromPool(data->pool);
+   }
+   for (i = 0; i < POOL_TEST_OBJECTS; i++) {
+     SDL_FreeToPool(data->pool, data->objects[i]);
+   }
+   return 0;
+}
+
+#endif /* TESTAUTOMATION_INTERNALS */
+
+/**
+ * @brief Allocate objects from a pool, free them, and check they get reused.
+ */
+int
+memorypool_allocFree(void *arg)
+{
+#if TESTAUTOMATION_INTERNALS
+   void *objects[POOL_TEST_OBJECTS], *again[POOL_TEST_OBJECTS];
+   SDL_MemoryPool *pool;
+   SDL_bool ok;
+   int i;
+
+   pool = SDL_CreateMemoryPool("test", 24, 8);
+   SDLTest_AssertCheck(pool != NULL, "Verify SDL_CreateMemoryPool() succeeds");
+   if (!pool) return TEST_ABORTED;
+
+   ok = SDL_TRUE;
+   for (i = 0; i < POOL_TEST_OBJECTS; i++) {
+     objects[i] = SDL_AllocFromPool(pool);
+     ok = ok && objects[i] && ((((size_t) objects[i]) % 16) == 0);
+     if (objects[i]) {
+       SDL_memset(objects[i], i, 24);
+     }
+   }
+   SDLTest_AssertCheck(ok, "Verify objects are allocated and 16-byte aligned");
+   ok = SDL_TRUE;
+   for (i = 0; i < POOL_TEST_OBJECTS; i++) {
+     const Uint8 *obj = (const Uint8 *) objects[i];
+     ok = ok && obj && (obj[0] == i) && (obj[23] == i);
+   }
+   SDLTest_AssertCheck(ok, "Verify objects don't overlap");
+
+   for (i = 0; i < POOL_TEST_OBJECTS; i++) {
+     SDL_FreeToPool(pool, objects[i]);
+   }
+   for (i = 0; i < POOL_TEST_OBJECTS; i++) {
+     again[i] = SDL_AllocFromPool(pool);
+   }
+   SDLTest_AssertCheck(_memorypool_sameObjects(again, objects, POOL_TEST_OBJECTS), "Verify freed objects are reused");
+   for (i = 0; i < POOL_TEST_OBJECTS; i++) {
+     SDL_FreeToPool(pool, again[i]);
+   }
+   SDL_DestroyMemoryPool(pool);
+   SDLTest_AssertPass("Call to SDL_DestroyMemoryPool()");
+
+   /* Negative cases */
+   SDLTest_AssertCheck(SDL_CreateMemoryPool("test", 0, 8) == NULL, "Verify objsize 0 is rejected");
+   SDLTest_AssertCheck(SDL_CreateMemoryPool("test", 24, 0) == NULL, "Verify objsperblock 0 is rejected");
+   SDLTest_AssertCheck(SDL_AllocFromPool(NULL) == NULL, "Verify SDL_AllocFromPool(NULL) fails");
+   SDL_FreeToPool(NULL, objects[0]);
+   SDL_DestroyMemoryPool(NULL);
+   SDLTest_AssertPass("Call to SDL_FreeToPool(NULL) and SDL_DestroyMemoryPool(NULL)");
+
+   return TEST_COMPLETED;
+#else
+   SDLTest_Log("Memory pools are internal, so they can only be tested against the static library");
+   return TEST_SKIPPED;
+#endif
+}
+
+/**
+ * @brief Check objects cached by a thread go back to the pool when it exits,
+ *        and that caches don't outlive their pool.
+ */
+int
+memorypool_threadCache(void *arg)
+{
+#if TESTAUTOMATION_INTERNALS
+   _memorypool_threadData data;
+   void *objects[POOL_TEST_OBJECTS];
+   SDL_Thread *thread;
+   SDL_MemoryPool *pool;
+   void *obj;
+   int i;
+
+   data.pool = pool = SDL_CreateMemoryPool("test", 32, 8);
+   SDLTest_AssertCheck(pool != NULL, "Verify SDL_CreateMemoryPool() succeeds");
+   if (!pool) return TEST_ABORTED;
+
+   thread = SDL_CreateThread(_memorypool_thread, "MemoryPoolTest", &data);
+   SDLTest_AssertCheck(thread != NULL, "Verify SDL_CreateThread() succeeds");
+   if (!thread) return TEST_ABORTED;
+   SDL_WaitThread(thread, NULL);
+
+   /* The thread carved exactly enough blocks for its objects, so if its
+      cache didn't go back to the pool we'd see new objects here. */
+   for (i = 0; i < POOL_TEST_OBJECTS; i++) {
+     objects[i] = SDL_AllocFromPool(pool);
+   }
+   SDLTest_AssertCheck(_memorypool_sameObjects(objects, data.objects, POOL_TEST_OBJECTS),
+     "Verify objects cached by an exited thread are reused");
+   for (i = 0; i < POOL_TEST_OBJECTS; i++) {
+     SDL_FreeToPool(pool, objects[i]);
+   }
+
+   /* This thread's cache still holds objects from the old pool; a new
+      pool must not hand them out. */
+   SDL_DestroyMemoryPool(pool);
+   pool = SDL_CreateMemoryPool("test", 32, 8);
+   SDLTest_AssertCheck(pool != NULL, "Verify SDL_CreateMemoryPool() succeeds again");
+   if (!pool) return TEST_ABORTED;
+   obj = SDL_AllocFromPool(pool);
+   SDLTest_AssertCheck(obj != NULL, "Verify allocating from the new pool succeeds");
+   for (i = 0; i < POOL_TEST_OBJECTS; i++) {
+     if (obj == objects[i]) {
+       break;
+     }
+   }
+   SDLTest_AssertCheck(i == POOL_TEST_OBJECTS, "Verify the new pool doesn't hand out the old pool's objects");
+   SDL_FreeToPool(pool, obj);
+   SDL_DestroyMemoryPool(pool);
+
+   return TEST_COMPLETED;
+#else
+   SDLTest_Log("Memory pools are internal, so they can only be tested against the static library");
+   return TEST_SKIPPED;
+#endif
+}
+
+/**
+ * @brief Check a frame arena reuses its memory on reset and gives back
+ *        blocks it doesn't need anymore.
+ */
+int
+memorypool_arenaReset(void *arg)
+{
+#if TESTAUTOMATION_INTERNALS
+   SDL_FrameArena *arena;
+   Uint8 *first, *second, *ptr;
+   int allocations, i;
+
+   arena = SDL_CreateFrameArena("test", 1024);
+   SDLTest_AssertCheck(arena != NULL, "Verify SDL_CreateFrameArena() succeeds");
+   if (!arena) return TEST_ABORTED;
+
+   first = (Uint8 *) SDL_AllocFromArena(arena, 100);
+   second = (Uint8 *) SDL_AllocFromArena(arena, 1);
+   SDLTest_AssertCheck(first && second, "Verify SDL_AllocFromArena() succeeds");
+   if (!first || !second) return TEST_ABORTED;
+   SDLTest_AssertCheck(((((size_t) first) % 16) == 0) && ((((size_t) second) % 16) == 0), "Verify allocations are 16-byte aligned");
+   SDLTest_AssertCheck(second >= first + 100, "Verify allocations don't overlap");
+
+   SDL_ResetFrameArena(arena);
+   ptr = (Uint8 *) SDL_AllocFromArena(arena, 100);
+   SDLTest_AssertCheck(ptr == first, "Verify memory is reused after a reset");
+
+   /* An allocation bigger than a block gets its own, which goes on reset. */
+   allocations = SDL_GetNumAllocations();
+   ptr = (Uint8 *) SDL_AllocFromArena(arena, 100000);
+   SDLTest_AssertCheck(ptr != NULL, "Verify an oversized SDL_AllocFromArena() succeeds");
+   SDLTest_AssertCheck(SDL_GetNumAllocations() == allocations + 1, "Verify an oversized allocation gets a block");
+   SDL_ResetFrameArena(arena);
+   SDLTest_AssertCheck(SDL_GetNumAllocations() == allocations, "Verify the oversized block is freed on reset");
+
+   /* Extra blocks from one busy frame go once they've been idle a while,
+      but the first block stays. */
+   SDL_AllocFromArena(arena, 1000);
+   SDL_AllocFromArena(arena, 1000);
+   SDL_AllocFromArena(arena, 1000);
+   SDLTest_AssertCheck(SDL_GetNumAllocations() == allocations + 2, "Verify a busy frame takes more blocks");
+   for (i = 0; i < 100; i++) {
+     SDL_ResetFrameArena(arena);
+     ptr = (Uint8 *) SDL_AllocFromArena(arena, 100);
+   }
+   SDLTest_AssertCheck(SDL_GetNumAllocations() == allocations, "Verify idle blocks are freed");
+   SDLTest_AssertCheck(ptr == first, "Verify the first block is kept");
+   SDL_DestroyFrameArena(arena);
+
+   /* Without pooling, every allocation is its own and goes on reset. */
+   SDL_SetHint(SDL_HINT_MEMORY_POOLS, "0");
+   arena = SDL_CreateFrameArena("test", 1024);
+   SDL_SetHint(SDL_HINT_MEMORY_POOLS, "1");
+   SDLTest_AssertCheck(arena != NULL, "Verify SDL_CreateFrameArena() succeeds without pooling");
+   if (!arena) return TEST_ABORTED;
+   allocations = SDL_GetNumAllocations();
+   SDL_AllocFromArena(arena, 10);
+   SDL_AllocFromArena(arena, 10);
+   SDLTest_AssertCheck(SDL_GetNumAllocations() == allocations + 2, "Verify allocations aren't pooled");
+   SDL_ResetFrameArena(arena);
+   SDLTest_AssertCheck(SDL_GetNumAllocations() == allocations, "Verify allocations are freed on reset");
+   SDL_DestroyFrameArena(arena);
+
+   /* Negative cases */
+   SDLTest_AssertCheck(SDL_CreateFrameArena("test", 0) == NULL, "Verify blocksize 0 is rejected");
+   SDLTest_AssertCheck(SDL_AllocFromArena(NULL, 10) == NULL, "Verify SDL_AllocFromArena(NULL) fails");
+   SDL_ResetFrameArena(NULL);
+   SDL_DestroyFrameArena(NULL);
+   SDLTest_AssertPass("Call to SDL_ResetFrameArena(NULL) and SDL_DestroyFrameArena(NULL)");
+
+   return TEST_COMPLETED;
+#else
+   SDLTest_Log("Frame arenas are internal, so they can only be tested against the static library");
+   return TEST_SKIPPED;
+#endif
+}
+
+/* ================= Test References ================== */
+
+/* Memory pool test cases */
+static const SDLTest_TestCaseReference memorypoolTest1 =
+        { (SDLTest_TestCaseFp)memorypool_allocFree, "memorypool_allocFree", "Allocate and free objects from a memory pool", TEST_ENABLED };
+
+static const SDLTest_TestCaseReference memorypoolTest2 =
+        { (SDLTest_TestCaseFp)memorypool_threadCache, "memorypool_threadCache", "Hand objects back from per-thread caches", TEST_ENABLED };
+
+static const SDLTest_TestCaseReference memorypoolTest3 =
+        { (SDLTest_TestCaseFp)memorypool_arenaReset, "memorypool_arenaReset", "Reuse and trim frame arena blocks on reset", TEST_ENABLED };
+
+/* Sequence of Memory pool test cases */
+static const SDLTest_TestCaseReference *memorypoolTests[] =  {
+    &memorypoolTest1, &memorypoolTest2, &memorypoolTest3, NULL
+};
+
+/* Memory pool test suite (global) */
+SDLTest_TestSuiteReference memorypoolTestSuite = {
+    "MemoryPool",
+    NULL,
+    memorypoolTests,
+    NULL
+};
@@ -6,6 +6,9 @@
 
 #include "SDL.h"
 #include "SDL_test.h"
+#if TESTAUTOMATION_INTERNALS
+#include "../src/video/SDL_yuv_c.h"
+#endif
 
 /* Test case functions */
 
@@ -500,6 +503,711 @@ pixels_calcGammaRamp(void *arg)
   return TEST_COMPLETED;
 }
 
+/**
+ * @brief Convert YUV images from buffers sized exactly to their planes, so
+ *        reading past the end of the source is caught by memory checkers.
+ *
+ * @sa http://wiki.libsdl.org/moin.fcg/SDL_ConvertPixels
+ */
+int
+pixels_convertYUVExactSize(void *arg)
+{
+  const Uint32 formats[] = {
+    SDL_PIXELFORMAT_YUY2, SDL_PIXELFORMAT_UYVY, SDL_PIXELFORMAT_YVYU,
+    SDL_PIXELFORMAT_NV12, SDL_PIXELFORMAT_NV21, SDL_PIXELFORMAT_IYUV
+  };
+  /* Multiples of the 32 and 64 pixel SIMD blocks, and one that isn't */
+  const int widths[] = { 32, 64, 96, 128, 130 };
+  const int heights[] = { 1, 2, 3 };
+  const Uint8 y = 0x60, u = 0x70, v = 0x90;
+  int i, j, k, n, result;
+
+  for (i = 0; i < SDL_arraysize(formats); i++) {
+    for (j = 0; j < SDL_arraysize(widths); j++) {
+      for (k = 0; k < SDL_arraysize(heights); k++) {
+        const int w = widths[j], h = heights[k];
+        const int chroma_w = (w + 1) / 2, chroma_h = (h + 1) / 2;
+        Uint8 *src;
+        Uint32 *dst;
+        int pitch, len;
+        SDL_bool same;
+
+        if (SDL_ISPIXELFORMAT_FOURCC(formats[i]) && SDL_BYTESPERPIXEL(formats[i]) == 2) {
+          pitch = chroma_w * 4;
+          len = pitch * h;
+        } else {
+          pitch = w;
+          len = (w * h) + (2 * chroma_w * chroma_h);
+        }
+        src = (Uint8 *)SDL_malloc(len);
+        dst = (Uint32 *)SDL_malloc(w * h * sizeof(Uint32));
+        SDLTest_AssertCheck(src != NULL && dst != NULL, "Validate buffers could be allocated");
+        if (src == NULL || dst == NULL) return TEST_ABORTED;
+
+        /* One flat color, laid out as each format does it */
+        switch (formats[i]) {
+          case SDL_PIXELFORMAT_YUY2:
+            for (n = 0; n < len; n += 4) { src[n] = y; src[n+1] = u; src[n+2] = y; src[n+3] = v; }
+            break;
+          case SDL_PIXELFORMAT_UYVY:
+            for (n = 0; n < len; n += 4) { src[n] = u; src[n+1] = y; src[n+2] = v; src[n+3] = y; }
+            break;
+          case SDL_PIXELFORMAT_YVYU:
+            for (n = 0; n < len; n += 4) { src[n] = y; src[n+1] = v; src[n+2] = y; src[n+3] = u; }
+            break;
+          case SDL_PIXELFORMAT_NV12:
+          case SDL_PIXELFORMAT_NV21:
+            SDL_memset(src, y, w * h);
+            for (n = w * h; n < len; n += 2) {
+              src[n] = (formats[i] == SDL_PIXELFORMAT_NV12) ? u : v;
+              src[n+1] = (formats[i] == SDL_PIXELFORMAT_NV12) ? v : u;
+            }
+            break;
+          default:
+            SDL_memset(src, y, w * h);
+            SDL_memset(src + (w * h), u, chroma_w * chroma_h);
+            SDL_memset(src + (w * h) + (chroma_w * chroma_h), v, chroma_w * chroma_h);
+            break;
+        }
+
+        result = SDL_ConvertPixels(w, h, formats[i], src, pitch, SDL_PIXELFORMAT_ARGB8888, dst, w * sizeof(Uint32));
+        SDLTest_AssertCheck(result == 0, "Validate result from SDL_ConvertPixels(%s, %dx%d), expected: 0, got: %d",
+          SDL_GetPixelFormatName(formats[i]), w, h, result);
+        same = SDL_TRUE;
+        for (n = 1; n < w * h; n++) {
+          if (dst[n] != dst[0]) {
+            same = SDL_FALSE;
+            break;
+          }
+        }
+        SDLTest_AssertCheck(same, "Validate every pixel has the same color; pixel %d is 0x%.8x, expected 0x%.8x",
+          n, (same ? dst[0] : dst[n]), dst[0]);
+
+        SDL_free(dst);
+        SDL_free(src);
+      }
+    }
+  }
+
+  return TEST_COMPLETED;
+}
+
+/* Sizes of a w x h image in each YUV layout, with no padding between rows */
+static int
+_pixelsYUVSize(Uint32 format, int w, int h, int *pitch)
+{
+  const int chroma_w = (w + 1) / 2, chroma_h = (h + 1) / 2;
+
+  if (SDL_BYTESPERPIXEL(format) == 2) {
+    *pitch = chroma_w * 4;
+    return *pitch * h;
+  }
+  *pitch = w;
+  return (w * h) + (2 * chroma_w * chroma_h);
+}
+
+/* Pick pixel (x, y) out of an image laid out as _pixelsYUVSize() says */
+static void
+_pixelsGetYUV(Uint32 format, const Uint8 *yuv, int w, int h, int x, int y, int *Y, int *U, int *V)
+{
+  const int chroma_w = (w + 1) / 2, chroma_h = (h + 1) / 2;
+  const Uint8 *chroma = yuv + (w * h);
+  const Uint8 *macropixel = yuv + (y * chroma_w * 4) + ((x / 2) * 4);
+  const int c = ((y / 2) * chroma_w) + (x / 2);
+
+  switch (format) {
+    case SDL_PIXELFORMAT_YUY2:
+      *Y = macropixel[(x & 1) * 2]; *U = macropixel[1]; *V = macropixel[3];
+      break;
+    case SDL_PIXELFORMAT_UYVY:
+      *Y = macropixel[(x & 1) * 2 + 1]; *U = macropixel[0]; *V = macropixel[2];
+      break;
+    case SDL_PIXELFORMAT_YVYU:
+      *Y = macropixel[(x & 1) * 2]; *U = macropixel[3]; *V = macropixel[1];
+      break;
+    case SDL_PIXELFORMAT_NV12:
+      *Y = yuv[y * w + x]; *U = chroma[c * 2]; *V = chroma[c * 2 + 1];
+      break;
+    case SDL_PIXELFORMAT_NV21:
+      *Y = yuv[y * w + x]; *U = chroma[c * 2 + 1]; *V = chroma[c * 2];
+      break;
+    case SDL_PIXELFORMAT_YV12:
+      *Y = yuv[y * w + x]; *V = chroma[c]; *U = chroma[chroma_w * chroma_h + c];
+      break;
+    default: /* SDL_PIXELFORMAT_IYUV */
+      *Y = yuv[y * w + x]; *U = chroma[c]; *V = chroma[chroma_w * chroma_h + c];
+      break;
+  }
+}
+
+/**
+ * @brief Convert RGB patterns to YUV and compare against the BT.601 formulas,
+ *        at widths around the SIMD block sizes and with unpadded rows.
+ *
+ * @sa http://wiki.libsdl.org/moin.fcg/SDL_ConvertPixels
+ */
+int
+pixels_convertRGBToYUV(void *arg)
+{
+  const Uint32 srcFormats[] = {
+    SDL_PIXELFORMAT_ARGB8888, SDL_PIXELFORMAT_ABGR8888, SDL_PIXELFORMAT_RGBA8888,
+    SDL_PIXELFORMAT_BGRX8888, SDL_PIXELFORMAT_RGB24, SDL_PIXELFORMAT_BGR24
+  };
+  const Uint32 dstFormats[] = {
+    SDL_PIXELFORMAT_YUY2, SDL_PIXELFORMAT_UYVY, SDL_PIXELFORMAT_YVYU,
+    SDL_PIXELFORMAT_NV12, SDL_PIXELFORMAT_NV21, SDL_PIXELFORMAT_YV12, SDL_PIXELFORMAT_IYUV
+  };
+  /* Around the 8, 16 and 32 pixel SIMD blocks, odd and even */
+  const int widths[] = { 1, 2, 7, 8, 15, 16, 17, 31, 32, 33, 66, 67 };
+  const int heights[] = { 1, 2, 3 };
+  /* Black, white, grey and the primaries and secondaries */
+  const Uint8 colors[][3] = {
+    { 0, 0, 0 }, { 255, 255, 255 }, { 128, 128, 128 },
+    { 255, 0, 0 }, { 0, 255, 0 }, { 0, 0, 255 },
+    { 255, 255, 0 }, { 0, 255, 255 }, { 255, 0, 255 }
+  };
+  const SDL_YUV_CONVERSION_MODE mode = SDL_GetYUVConversionMode();
+  int i, j, k, l, x, y, result;
+
+  /* The reference below is BT.601, and small images would use it anyway */
+  SDL_SetYUVConversionMode(SDL_YUV_CONVERSION_BT601);
+
+  for (i = 0; i < SDL_arraysize(srcFormats); i++) {
+    const int bpp = SDL_BYTESPERPIXEL(srcFormats[i]);
+    SDL_PixelFormat *fmt = SDL_AllocFormat(srcFormats[i]);
+    SDLTest_AssertCheck(fmt != NULL, "Validate SDL_AllocFormat(%s)", SDL_GetPixelFormatName(srcFormats[i]));
+    if (fmt == NULL) return TEST_ABORTED;
+
+    for (j = 0; j < SDL_arraysize(widths); j++) {
+      for (k = 0; k < SDL_arraysize(heights); k++) {
+        const int w = widths[j], h = heights[k];
+        Uint8 *rgb = (Uint8 *)SDL_malloc(w * h * 3);
+        Uint8 *src = (Uint8 *)SDL_malloc(w * h * bpp);
+        Uint8 *dst = (Uint8 *)SDL_malloc(w * h * 4);
+        SDLTest_AssertCheck(rgb != NULL && src != NULL && dst != NULL, "Validate buffers could be allocated");
+        if (rgb == NULL || src == NULL || dst == NULL) return TEST_ABORTED;
+
+        /* Every third pixel is one of the fixed colors, the rest random */
+        for (y = 0; y < h; y++) {
+          for (x = 0; x < w; x++) {
+            Uint8 *p = rgb + (y * w + x) * 3;
+            if (((x + y) % 3) == 0) {
+              SDL_memcpy(p, colors[(x * 7 + y) % SDL_arraysize(colors)], 3);
+            } else {
+              p[0] = SDLTest_RandomUint8(); p[1] = SDLTest_RandomUint8(); p[2] = SDLTest_RandomUint8();
+            }
+            if (bpp == 4) {
+              Uint32 pixel = SDL_MapRGB(fmt, p[0], p[1], p[2]);
+              SDL_memcpy(src + (y * w + x) * 4, &pixel, 4);
+            } else if (srcFormats[i] == SDL_PIXELFORMAT_RGB24) {
+              src[(y * w + x) * 3 + 0] = p[0]; src[(y * w + x) * 3 + 1] = p[1]; src[(y * w + x) * 3 + 2] = p[2];
+            } else {
+              src[(y * w + x) * 3 + 0] = p[2]; src[(y * w + x) * 3 + 1] = p[1]; src[(y * w + x) * 3 + 2] = p[0];
+            }
+          }
+        }
+
+        for (l = 0; l < SDL_arraysize(dstFormats); l++) {
+          const SDL_bool packed = (SDL_BYTESPERPIXEL(dstFormats[l]) == 2);
+          int pitch, worstY = 0, worstUV = 0;
+
+          _pixelsYUVSize(dstFormats[l], w, h, &pitch);
+          result = SDL_ConvertPixels(w, h, srcFormats[i], src, w * bpp, dstFormats[l], dst, pitch);
+          SDLTest_AssertCheck(result == 0, "Validate result from SDL_ConvertPixels(%s -> %s, %dx%d), expected: 0, got: %d",
+            SDL_GetPixelFormatName(srcFormats[i]), SDL_GetPixelFormatName(dstFormats[l]), w, h, result);
+
+          for (y = 0; y < h; y++) {
+            for (x = 0; x < w; x++) {
+              /* Chroma comes from the average of each 2x2 (2x1 for packed)
+                 block, with the last row and column standing in for missing ones */
+              const int x1 = SDL_min(x | 1, w - 1);
+              const int y0 = packed ? y : (y & ~1);
+              const int y1 = packed ? y : SDL_min(y | 1, h - 1);
+              const Uint8 *p = rgb + (y * w + x) * 3;
+              const Uint8 *b[4];
+              double r, g, bl, ref;
+              int Y, U, V;
+
+              b[0] = rgb + (y0 * w + (x & ~1)) * 3;
+              b[1] = rgb + (y0 * w + x1) * 3;
+              b[2] = rgb + (y1 * w + (x & ~1)) * 3;
+              b[3] = rgb + (y1 * w + x1) * 3;
+              r = (b[0][0] + b[1][0] + b[2][0] + b[3][0]) / 4.0;
+              g = (b[0][1] + b[1][1] + b[2][1] + b[3][1]) / 4.0;
+              bl = (b[0][2] + b[1][2] + b[2][2] + b[3][2]) / 4.0;
+
+              _pixelsGetYUV(dstFormats[l], dst, w, h, x, y, &Y, &U, &V);
+              ref = 16.0 + 0.2568 * p[0] + 0.5041 * p[1] + 0.0979 * p[2];
+              worstY = SDL_max(worstY, (int)SDL_ceil(SDL_fabs(Y - ref)));
+              ref = 128.0 - 0.1482 * r - 0.2910 * g + 0.4392 * bl;
+              worstUV = SDL_max(worstUV, (int)SDL_ceil(SDL_fabs(U - ref)));
+              ref = 128.0 + 0.4392 * r - 0.3678 * g - 0.0714 * bl;
+              worstUV = SDL_max(worstUV, (int)SDL_ceil(SDL_fabs(V - ref)));
+            }
+          }
+
+          /* Y is rounded once; chroma also truncates the average of the block */
+          SDLTest_AssertCheck(worstY <= 1 && worstUV <= 2,
+            "Validate %s -> %s at %dx%d is within 1 (Y) and 2 (U, V) of BT.601; worst: %d, %d",
+            SDL_GetPixelFormatName(srcFormats[i]), SDL_GetPixelFormatName(dstFormats[l]), w, h, worstY, worstUV);
+        }
+
+        SDL_free(dst);
+        SDL_free(src);
+        SDL_free(rgb);
+      }
+    }
+    SDL_FreeFormat(fmt);
+  }
+
+  /* Greys are colorless, exactly */
+  for (i = 0; i < 256; i += 5) {
+    Uint32 grey[16 * 2];
+    Uint8 dst[16 * 2 * 2];
+    SDL_bool neutral = SDL_TRUE;
+
+    for (j = 0; j < SDL_arraysize(grey); j++) {
+      grey[j] = 0xFF000000 | (i << 16) | (i << 8) | i;
+    }
+    for (l = 0; l < SDL_arraysize(dstFormats); l++) {
+      int pitch, Y, U, V;
+
+      _pixelsYUVSize(dstFormats[l], 16, 2, &pitch);
+      SDL_ConvertPixels(16, 2, SDL_PIXELFORMAT_ARGB8888, grey, 16 * 4, dstFormats[l], dst, pitch);
+      for (y = 0; y < 2; y++) {
+        for (x = 0; x < 16; x++) {
+          _pixelsGetYUV(dstFormats[l], dst, 16, 2, x, y, &Y, &U, &V);
+          if (U != 128 || V != 128) {
+            neutral = SDL_FALSE;
+          }
+        }
+      }
+    }
+    SDLTest_AssertCheck(neutral, "Validate grey %d encodes to U = V = 128 in every format", i);
+  }
+
+  SDL_SetYUVConversionMode(mode);
+  return TEST_COMPLETED;
+}
+
+/* Store pixel (x, y) into an image laid out as _pixelsYUVSize() says */
+static void
+_pixelsSetYUV(Uint32 format, Uint8 *yuv, int w, int h, int x, int y, int Y, int U, int V)
+{
+  const int chroma_w = (w + 1) / 2, chroma_h = (h + 1) / 2;
+  Uint8 *chroma = yuv + (w * h);
+  Uint8 *macropixel = yuv + (y * chroma_w * 4) + ((x / 2) * 4);
+  const int c = ((y / 2) * chroma_w) + (x / 2);
+
+  switch (format) {
+    case SDL_PIXELFORMAT_YUY2:
+      macropixel[(x & 1) * 2] = Y; macropixel[1] = U; macropixel[3] = V;
+      break;
+    case SDL_PIXELFORMAT_UYVY:
+      macropixel[(x & 1) * 2 + 1] = Y; macropixel[0] = U; macropixel[2] = V;
+      break;
+    case SDL_PIXELFORMAT_YVYU:
+      macropixel[(x & 1) * 2] = Y; macropixel[3] = U; macropixel[1] = V;
+      break;
+    case SDL_PIXELFORMAT_NV12:
+      yuv[y * w + x] = Y; chroma[c * 2] = U; chroma[c * 2 + 1] = V;
+      break;
+    case SDL_PIXELFORMAT_NV21:
+      yuv[y * w + x] = Y; chroma[c * 2 + 1] = U; chroma[c * 2] = V;
+      break;
+    case SDL_PIXELFORMAT_YV12:
+      yuv[y * w + x] = Y; chroma[c] = V; chroma[chroma_w * chroma_h + c] = U;
+      break;
+    default: /* SDL_PIXELFORMAT_IYUV */
+      yuv[y * w + x] = Y; chroma[c] = U; chroma[chroma_w * chroma_h + c] = V;
+      break;
+  }
+}
+
+/* The largest difference in any channel between two same-sized surfaces */
+static int
+_pixelsMaxDifference(SDL_Surface *a, SDL_Surface *b)
+{
+  int x, y, worst = 0;
+
+  for (y = 0; y < a->h; y++) {
+    for (x = 0; x < a->w; x++) {
+      const int bpp = a->format->BytesPerPixel;
+      Uint32 pa = 0, pb = 0;
+      Uint8 ra, ga, ba, rb, gb, bb;
+
+      SDL_memcpy(&pa, (Uint8 *)a->pixels + y * a->pitch + x * bpp, bpp);
+      SDL_memcpy(&pb, (Uint8 *)b->pixels + y * b->pitch + x * bpp, bpp);
+      SDL_GetRGB(pa, a->format, &ra, &ga, &ba);
+      SDL_GetRGB(pb, b->format, &rb, &gb, &bb);
+      worst = SDL_max(worst, SDL_abs(ra - rb));
+      worst = SDL_max(worst, SDL_abs(ga - gb));
+      worst = SDL_max(worst, SDL_abs(ba - bb));
+    }
+  }
+  return worst;
+}
+
+/**
+ * @brief Convert part of a YUV image straight to a different size, and compare
+ *        that to converting it all and stretching it.
+ */
+int
+pixels_convertYUVScaled(void *arg)
+{
+#if TESTAUTOMATION_INTERNALS
+  const Uint32 srcFormats[] = {
+    SDL_PIXELFORMAT_YUY2, SDL_PIXELFORMAT_UYVY, SDL_PIXELFORMAT_YVYU,
+    SDL_PIXELFORMAT_NV12, SDL_PIXELFORMAT_NV21, SDL_PIXELFORMAT_YV12, SDL_PIXELFORMAT_IYUV
+  };
+  const Uint32 dstFormats[] = { SDL_PIXELFORMAT_ARGB8888, SDL_PIXELFORMAT_RGB565, SDL_PIXELFORMAT_RGB24 };
+  const int sizes[][2] = { { 37, 23 }, { 64, 48 } };
+  /* Scaled up, down, and not at all */
+  const int scales[][2] = { { 5, 2 }, { 1, 3 }, { 1, 1 } };
+  int i, j, k, l, m, x, y, result;
+
+  for (i = 0; i < SDL_arraysize(srcFormats); i++) {
+    for (j = 0; j < SDL_arraysize(sizes); j++) {
+      const int w = sizes[j][0], h = sizes[j][1];
+      /* The whole image, and clipped ones at odd and even offsets */
+      SDL_Rect rects[3];
+      int pitch, len;
+      Uint8 *yuv;
+
+      rects[0].x = 0; rects[0].y = 0; rects[0].w = w; rects[0].h = h;
+      rects[1].x = 3; rects[1].y = 5; rects[1].w = w - 10; rects[1].h = h - 9;
+      rects[2].x = 2; rects[2].y = 1; rects[2].w = w - 3; rects[2].h = h - 2;
+
+      len = _pixelsYUVSize(srcFormats[i], w, h, &pitch);
+      yuv = (Uint8 *)SDL_malloc(len);
+      SDLTest_AssertCheck(yuv != NULL, "Validate buffers could be allocated");
+      if (yuv == NULL) return TEST_ABORTED;
+
+      /* Smooth ramps, so a stretch sampling a neighboring pixel is only a little off */
+      for (y = 0; y < h; y++) {
+        for (x = 0; x < w; x++) {
+          _pixelsSetYUV(srcFormats[i], yuv, w, h, x, y,
+            16 + (128 * x) / w, 112 + (32 * (y & ~1)) / h, 112 + (32 * (x & ~1)) / w);
+        }
+      }
+
+      for (k = 0; k < SDL_arraysize(dstFormats); k++) {
+        SDL_Surface *full = SDL_CreateRGBSurfaceWithFormat(0, w, h, 0, dstFormats[k]);
+        SDLTest_AssertCheck(full != NULL, "Validate SDL_CreateRGBSurfaceWithFormat(%s)", SDL_GetPixelFormatName(dstFormats[k]));
+        if (full == NULL) return TEST_ABORTED;
+        result = SDL_ConvertPixels(w, h, srcFormats[i], yuv, pitch, dstFormats[k], full->pixels, full->pitch);
+        SDLTest_AssertCheck(result == 0, "Validate result from SDL_ConvertPixels, expected: 0, got: %d", result);
+
+        for (l = 0; l < SDL_arraysize(rects); l++) {
+          for (m = 0; m < SDL_arraysize(scales); m++) {
+            const SDL_Rect *rect = &rects[l];
+            const int dst_w = (rect->w * scales[m][0]) / scales[m][1];
+            const int dst_h = (rect->h * scales[m][0]) / scales[m][1];
+            SDL_Surface *scaled = SDL_CreateRGBSurfaceWithFormat(0, dst_w, dst_h, 0, dstFormats[k]);
+            SDL_Surface *sampled = SDL_CreateRGBSurfaceWithFormat(0, dst_w, dst_h, 0, dstFormats[k]);
+            SDL_Surface *stretched = SDL_CreateRGBSurfaceWithFormat(0, dst_w, dst_h, 0, dstFormats[k]);
+            const int bpp = SDL_BYTESPERPIXEL(dstFormats[k]);
+            int worstSampled, worstStretched;
+
+            SDLTest_AssertCheck(scaled != NULL && sampled != NULL && stretched != NULL, "Validate surfaces could be created");
+            if (scaled == NULL || sampled == NULL || stretched == NULL) return TEST_ABORTED;
+
+            result = SDL_ConvertPixels_YUV_to_RGB_Scaled(w, h, srcFormats[i], yuv, pitch, rect,
+                                                         dstFormats[k], scaled->pixels, dst_w, dst_h, scaled->pitch);
+            SDLTest_AssertCheck(result == 0, "Validate result from SDL_ConvertPixels_YUV_to_RGB_Scaled, expected: 0, got: %d", result);
+
+            /* The pixel nearest the center of each destination pixel */
+            for (y = 0; y < dst_h; y++) {
+              const int sy = rect->y + ((2 * y + 1) * rect->h) / (2 * dst_h);
+              for (x = 0; x < dst_w; x++) {
+                const int sx = rect->x + ((2 * x + 1) * rect->w) / (2 * dst_w);
+                SDL_memcpy((Uint8 *)sampled->pixels + y * sampled->pitch + x * bpp,
+                           (Uint8 *)full->pixels + sy * full->pitch + sx * bpp, bpp);
+              }
+            }
+            result = SDL_SoftStretch(full, rect, stretched, NULL);
+            SDLTest_AssertCheck(result == 0, "Validate result from SDL_SoftStretch, expected: 0, got: %d", result);
+
+            /* Converting part of a row can take a different SIMD or scalar
+               path than the whole row, which may round a little differently.
+               SDL_SoftStretch() samples the left and top edge of each pixel
+               instead of its center, so it can be a source pixel off in each
+               direction, which on these ramps is up to 17 in RGB565. */
+            worstSampled = _pixelsMaxDifference(scaled, sampled);
+            worstStretched = _pixelsMaxDifference(scaled, stretched);
+            SDLTest_AssertCheck(worstSampled <= 2 && worstStretched <= 20,
+              "Validate %s -> %s from %d,%d %dx%d of %dx%d to %dx%d is within 2 of center sampling and 20 of SDL_SoftStretch; worst: %d, %d",
+              SDL_GetPixelFormatName(srcFormats[i]), SDL_GetPixelFormatName(dstFormats[k]),
+              rect->x, rect->y, rect->w, rect->h, w, h, dst_w, dst_h, worstSampled, worstStretched);
+
+            SDL_FreeSurface(stretched);
+            SDL_FreeSurface(sampled);
+            SDL_FreeSurface(scaled);
+          }
+        }
+        SDL_FreeSurface(full);
+      }
+      SDL_free(yuv);
+    }
+  }
+
+  /* Formats without a fast path are declined without an error, for the caller to fall back */
+  {
+    Uint8 yuv[4 * 4 * 2];
+    Uint32 rgb[4 * 4];
+    SDL_Rect rect;
+
+    rect.x = 1; rect.y = 1; rect.w = 2; rect.h = 2;
+    SDL_memset(yuv, 0x80, sizeof(yuv));
+    SDL_ClearError();
+    result = SDL_ConvertPixels_YUV_to_RGB_Scaled(4, 4, SDL_PIXELFORMAT_IYUV, yuv, 4, &rect,
+                                                 SDL_PIXELFORMAT_ARGB2101010, rgb, 4, 4, 4 * 4);
+    SDLTest_AssertCheck(result == 1, "Validate result converting to ARGB2101010, expected: 1, got: %d", result);
+    SDLTest_AssertCheck(*SDL_GetError() == '\0', "Validate no error is set, got: '%s'", SDL_GetError());
+  }
+
+  return TEST_COMPLETED;
+#else
+  SDLTest_Log("SDL_ConvertPixels_YUV_to_RGB_Scaled() is internal, so it can only be tested against the static library");
+  return TEST_SKIPPED;
+#endif
+}
+
+/* The palette index SDL_MapRGB() should give: the first of the nearest colors */
+static int
+_pixelsNearestColor(const SDL_Palette *palette, Uint8 r, Uint8 g, Uint8 b)
+{
+  int i, nearest = 0;
+  int smallest = -1;
+
+  for (i = 0; i < palette->ncolors; i++) {
+    const SDL_Color *color = &palette->colors[i];
+    const int rd = color->r - r, gd = color->g - g, bd = color->b - b, ad = color->a - 255;
+    const int distance = (rd * rd) + (gd * gd) + (bd * bd) + (ad * ad);
+    if (smallest < 0 || distance < smallest) {
+      smallest = distance;
+      nearest = i;
+    }
+  }
+  return nearest;
+}
+
+/* Map colors to the palette and count the ones that aren't the nearest */
+static int
+_pixelsCheckMapRGB(SDL_PixelFormat *format, int *badColor)
+{
+  const SDL_Palette *palette = format->palette;
+  int i, wrong = 0;
+
+  for (i = 0; i < 8192; i++) {
+    Uint8 r, g, b;
+    int expected, result;
+
+    if (i < palette->ncolors) {
+      /* The palette colors themselves */
+      r = palette->colors[i].r; g = palette->colors[i].g; b = palette->colors[i].b;
+    } else if (i % 2) {
+      /* Halfway between two entries, where there are likely to be ties */
+      const SDL_Color *c1 = &palette->colors[SDLTest_RandomIntegerInRange(0, palette->ncolors - 1)];
+      const SDL_Color *c2 = &palette->colors[SDLTest_RandomIntegerInRange(0, palette->ncolors - 1)];
+      r = (c1->r + c2->r) / 2; g = (c1->g + c2->g) / 2; b = (c1->b + c2->b) / 2;
+    } else {
+      r = SDLTest_RandomUint8(); g = SDLTest_RandomUint8(); b = SDLTest_RandomUint8();
+    }
+    expected = _pixelsNearestColor(palette, r, g, b);
+    result = (int)SDL_MapRGB(format, r, g, b);
+    if (result != expected) {
+      if (!wrong) {
+        *badColor = (r << 16) | (g << 8) | b;
+      }
+      wrong++;
+    }
+  }
+  return wrong;
+}
+
+/**
+ * @brief Map colors to palettes with SDL_MapRGB and compare them with a
+ *        search of the whole palette, ties included.
+ *
+ * @sa http://wiki.libsdl.org/moin.fcg/SDL_MapRGB
+ */
+int
+pixels_mapRGBPalette(void *arg)
+{
+  const int counts[] = { 2, 31, 32, 33, 100, 256 };
+  const Uint8 levels[] = { 0, 51, 102, 153, 204, 255 };
+  SDL_PixelFormat *format;
+  SDL_Palette *palette;
+  SDL_Color colors[256];
+  int c, variation, i;
+  int wrong, badColor = 0;
+
+  format = SDL_AllocFormat(SDL_PIXELFORMAT_INDEX8);
+  SDLTest_AssertPass("Call to SDL_AllocFormat(SDL_PIXELFORMAT_INDEX8)");
+  SDLTest_AssertCheck(format != NULL, "Verify result is not NULL");
+  if (format == NULL) {
+    return TEST_ABORTED;
+  }
+
+  for (c = 0; c < SDL_arraysize(counts); c++) {
+    for (variation = 0; variation < 3; variation++) {
+      palette = SDL_AllocPalette(counts[c]);
+      SDLTest_AssertCheck(palette != NULL, "Verify SDL_AllocPalette(%d) is not NULL", counts[c]);
+      if (palette == NULL) {
+        continue;
+      }
+
+      for (i = 0; i < counts[c]; i++) {
+        switch (variation) {
+          case 0:
+            /* Random colors, a few of them repeated and a few translucent */
+            colors[i].r = SDLTest_RandomUint8(); colors[i].g = SDLTest_RandomUint8(); colors[i].b = SDLTest_RandomUint8();
+            colors[i].a = (i % 7 == 3) ? SDLTest_RandomUint8() : 255;
+            if (i % 5 == 4) {
+              colors[i] = colors[SDLTest_RandomIntegerInRange(0, i - 1)];
+            }
+            break;
+          case 1:
+            /* Colors on a coarse grid, so lots of colors are equally near */
+            colors[i].r = levels[SDLTest_RandomIntegerInRange(0, 5)];
+            colors[i].g = levels[SDLTest_RandomIntegerInRange(0, 5)];
+            colors[i].b = levels[SDLTest_RandomIntegerInRange(0, 5)];
+            colors[i].a = 255;
+            break;
+          default:
+            /* Greys, all in the same few cells */
+            colors[i].r = colors[i].g = colors[i].b = (Uint8)SDLTest_RandomIntegerInRange(96, 127);
+            colors[i].a = 255;
+            break;
+        }
+      }
+      SDL_SetPaletteColors(palette, colors, 0, counts[c]);
+      SDL_SetPixelFormatPalette(format, palette);
+      SDLTest_AssertPass("Call to SDL_SetPixelFormatPalette() with %d colors", counts[c]);
+
+      wrong = _pixelsCheckMapRGB(format, &badColor);
+      SDLTest_AssertCheck(wrong == 0,
+        "Verify SDL_MapRGB() finds the nearest of %d colors (variation %d); wrong: %d, first: 0x%06x",
+        counts[c], variation, wrong, badColor);
+
+      /* Colors mapped before the palette changed mustn't stick */
+      for (i = 0; i < counts[c]; i++) {
+        colors[i].r = ~colors[i].r;
+        colors[i].b = colors[(i + 1) % counts[c]].g;
+      }
+      SDL_SetPaletteColors(palette, colors, 0, counts[c]);
+      wrong = _pixelsCheckMapRGB(format, &badColor);
+      SDLTest_AssertCheck(wrong == 0,
+        "Verify SDL_MapRGB() finds the nearest of %d changed colors (variation %d); wrong: %d, first: 0x%06x",
+        counts[c], variation, wrong, badColor);
+
+      SDL_SetPixelFormatPalette(format, NULL);
+      SDL_FreePalette(palette);
+    }
+  }
+
+  SDL_FreeFormat(format);
+  return TEST_COMPLETED;
+}
+
+/* Converts with SDL_HINT_YUV_PARALLEL set to the given value */
+static int
+_pixelsConvertWithHint(const char *parallel, int w, int h, Uint32 srcFormat, const void *src, int srcPitch,
+                       Uint32 dstFormat, void *dst, int dstPitch)
+{
+  int result;
+
+  SDL_SetHint(SDL_HINT_YUV_PARALLEL, parallel);
+  result = SDL_ConvertPixels(w, h, srcFormat, src, srcPitch, dstFormat, dst, dstPitch);
+  SDLTest_AssertCheck(result == 0, "Validate result from SDL_ConvertPixels(%s to %s) with SDL_HINT_YUV_PARALLEL \"%s\", expected: 0, got: %d",
+    SDL_GetPixelFormatName(srcFormat), SDL_GetPixelFormatName(dstFormat), parallel, result);
+  return result;
+}
+
+/**
+ * @brief Convert frames big enough to be split across the job workers to and
+ *        from YUV, and compare that to converting them on one thread.
+ */
+int
+pixels_convertYUVParallel(void *arg)
+{
+  const Uint32 yuvFormats[] = {
+    SDL_PIXELFORMAT_YV12, SDL_PIXELFORMAT_NV12, SDL_PIXELFORMAT_YUY2
+  };
+  const Uint32 rgbFormats[] = {
+    SDL_PIXELFORMAT_ARGB8888, SDL_PIXELFORMAT_RGB565
+  };
+  /* 720p, and a frame of about the same size that isn't a whole number of
+     bands high or SIMD blocks wide */
+  const int widths[] = { 1280, 1283 };
+  const int heights[] = { 720, 739 };
+  int i, j, k, n, result;
+
+  /* Make sure there are workers to split the frames across */
+  SDL_SetHint(SDL_HINT_JOB_WORKERS, "3");
+  SDLTest_Log("Converting with %d job workers", SDL_GetNumJobWorkers());
+
+  for (k = 0; k < SDL_arraysize(widths); k++) {
+    const int w = widths[k], h = heights[k];
+    int yuvPitch;
+    const int yuvSize = _pixelsYUVSize(SDL_PIXELFORMAT_YUY2, w, h, &yuvPitch) + w * h;
+    Uint8 *yuv = (Uint8 *)SDL_malloc(yuvSize);
+    Uint8 *serial = (Uint8 *)SDL_malloc(yuvSize + w * h * 4);
+    Uint8 *parallel = (Uint8 *)SDL_malloc(yuvSize + w * h * 4);
+    Uint8 *rgb = (Uint8 *)SDL_malloc(w * h * 4);
+    SDLTest_AssertCheck(yuv != NULL && serial != NULL && parallel != NULL && rgb != NULL, "Validate buffers could be allocated");
+    if (yuv == NULL || serial == NULL || parallel == NULL || rgb == NULL) return TEST_ABORTED;
+
+    for (n = 0; n < yuvSize; n++) {
+      yuv[n] = SDLTest_RandomUint8();
+    }
+    for (n = 0; n < w * h * 4; n++) {
+      rgb[n] = SDLTest_RandomUint8();
+    }
+
+    for (i = 0; i < SDL_arraysize(yuvFormats); i++) {
+      int pitch;
+      const int size = _pixelsYUVSize(yuvFormats[i], w, h, &pitch);
+
+      for (j = 0; j < SDL_arraysize(rgbFormats); j++) {
+        const int rgbPitch = w * SDL_BYTESPERPIXEL(rgbFormats[j]);
+
+        /* YUV to RGB */
+        result = _pixelsConvertWithHint("0", w, h, yuvFormats[i], yuv, pitch, rgbFormats[j], serial, rgbPitch);
+        result |= _pixelsConvertWithHint("1", w, h, yuvFormats[i], yuv, pitch, rgbFormats[j], parallel, rgbPitch);
+        if (result == 0) {
+          SDLTest_AssertCheck(SDL_memcmp(serial, parallel, rgbPitch * h) == 0,
+            "Verify %dx%d %s to %s is the same split across workers",
+            w, h, SDL_GetPixelFormatName(yuvFormats[i]), SDL_GetPixelFormatName(rgbFormats[j]));
+        }
+
+        /* RGB to YUV, which only starts from 32-bit RGB */
+        if (SDL_BYTESPERPIXEL(rgbFormats[j]) != 4) {
+          continue;
+        }
+        result = _pixelsConvertWithHint("0", w, h, rgbFormats[j], rgb, rgbPitch, yuvFormats[i], serial, pitch);
+        result |= _pixelsConvertWithHint("1", w, h, rgbFormats[j], rgb, rgbPitch, yuvFormats[i], parallel, pitch);
+        if (result == 0) {
+          SDLTest_AssertCheck(SDL_memcmp(serial, parallel, size) == 0,
+            "Verify %dx%d %s to %s is the same split across workers",
+            w, h, SDL_GetPixelFormatName(rgbFormats[j]), SDL_GetPixelFormatName(yuvFormats[i]));
+        }
+      }
+    }
+
+    SDL_free(rgb);
+    SDL_free(parallel);
+    SDL_free(serial);
+    SDL_free(yuv);
+  }
+
+  /* Leave other tests converting on one thread, as they used to */
+  SDL_SetHint(SDL_HINT_YUV_PARALLEL, "0");
+
+  return TEST_COMPLETED;
+}
+
 /* ================= Test References ================== */
 
 /* Pixels test cases */
@@ -515,9 +1223,24 @@ static const SDLTest_TestCaseReference pixelsTest3 =
 static const SDLTest_TestCaseReference pixelsTest4 =
         { (SDLTest_TestCaseFp)pixels_getPixelFormatName, "pixels_getPixelFormatName", "Call to SDL_GetPixelFormatName", TEST_ENABLED };
 
+static const SDLTest_TestCaseReference pixelsTest5 =
+        { (SDLTest_TestCaseFp)pixels_convertYUVExactSize, "pixels_convertYUVExactSize", "Call to SDL_ConvertPixels from exactly sized YUV buffers", TEST_ENABLED };
+
+static const SDLTest_TestCaseReference pixelsTest6 =
+        { (SDLTest_TestCaseFp)pixels_convertRGBToYUV, "pixels_convertRGBToYUV", "Call to SDL_ConvertPixels from RGB to YUV, checked against BT.601", TEST_ENABLED };
+
+static const SDLTest_TestCaseReference pixelsTest7 =
+        { (SDLTest_TestCaseFp)pixels_convertYUVScaled, "pixels_convertYUVScaled", "Convert part of a YUV image to RGB at another size", TEST_ENABLED };
+
+static const SDLTest_TestCaseReference pixelsTest8 =
+        { (SDLTest_TestCaseFp)pixels_mapRGBPalette, "pixels_mapRGBPalette", "Call to SDL_MapRGB with palettes, checked against a full search", TEST_ENABLED };
+
+static const SDLTest_TestCaseReference pixelsTest9 =
+        { (SDLTest_TestCaseFp)pixels_convertYUVParallel, "pixels_convertYUVParallel", "Convert big frames to and from YUV split across the job workers", TEST_ENABLED };
+
 /* Sequence of Pixels test cases */
 static const SDLTest_TestCaseReference *pixelsTests[] =  {
-    &pixelsTest1, &pixelsTest2, &pixelsTest3, &pixelsTest4, NULL
+    &pixelsTest1, &pixelsTest2, &pixelsTest3, &pixelsTest4, &pixelsTest5, &pixelsTest6, &pixelsTest7, &pixelsTest8, &pixelsTest9, NULL
 };
 
 /* Pixels test suite (global) */
@@ -14,6 +14,7 @@ extern SDLTest_TestSuiteReference clipboardTestSuite;
 extern SDLTest_TestSuiteReference eventsTestSuite;
 extern SDLTest_TestSuiteReference keyboardTestSuite;
 extern SDLTest_TestSuiteReference mainTestSuite;
+extern SDLTest_TestSuiteReference memorypoolTestSuite;
 extern SDLTest_TestSuiteReference mouseTestSuite;
 extern SDLTest_TestSuiteReference pixelsTestSuite;
 extern SDLTest_TestSuiteReference platformTestSuite;
@@ -35,6 +36,7 @@ SDLTest_TestSuiteReference *testSuites[] =  {
     &eventsTestSuite,
     &keyboardTestSuite,
     &mainTestSuite,
+    &memorypoolTestSuite,
     &mouseTestSuite,
     &pixelsTestSuite,
     &platformTestSuite,
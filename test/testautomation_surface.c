@@ -588,6 +588,585 @@ surface_testBlitBlendLoop(void *arg) {
 
 }
 
+/* Checks every pixel of a 32-bit surface has the given value */
+static SDL_bool
+_surfaceHasColor(SDL_Surface *surface, Uint32 color)
+{
+   const Uint32 *pixels = (const Uint32 *)surface->pixels;
+   int i;
+
+   for (i = 0; i < surface->w * surface->h; i++) {
+      if (pixels[i] != color) {
+         return SDL_FALSE;
+      }
+   }
+   return SDL_TRUE;
+}
+
+/**
+ * @brief Tests writes to surfaces sharing pixels after SDL_DuplicateSurface
+ *        don't show up in the other surfaces.
+ */
+int
+surface_testCopyOnWrite(void *arg)
+{
+   const Uint32 red = 0xFFFF0000, green = 0xFF00FF00, blue = 0xFF0000FF;
+   SDL_Surface *original, *copy, *target;
+   int ret;
+
+   SDL_SetHint(SDL_HINT_SURFACE_COPY_ON_WRITE, "1");
+
+   original = SDL_CreateRGBSurfaceWithFormat(0, 16, 16, 32, SDL_PIXELFORMAT_ARGB8888);
+   SDLTest_AssertCheck(original != NULL, "Verify original surface is not NULL");
+   if (original == NULL) return TEST_ABORTED;
+   SDL_FillRect(original, NULL, red);
+
+   /* Writing to a locked copy */
+   copy = SDL_DuplicateSurface(original);
+   SDLTest_AssertCheck(copy != NULL, "Verify copy is not NULL");
+   if (copy == NULL) return TEST_ABORTED;
+   SDLTest_AssertCheck(copy->pixels == original->pixels, "Verify copy shares the original's pixels");
+   SDLTest_AssertCheck(SDL_MUSTLOCK(copy) && SDL_MUSTLOCK(original), "Verify SDL_MUSTLOCK() is true for both surfaces");
+   ret = SDL_LockSurface(copy);
+   SDLTest_AssertCheck(ret == 0, "Validate result from SDL_LockSurface, expected: 0, got: %i", ret);
+   ((Uint32 *)copy->pixels)[0] = green;
+   SDL_UnlockSurface(copy);
+   SDLTest_AssertCheck(copy->pixels != original->pixels, "Verify the locked copy has pixels of its own");
+   SDLTest_AssertCheck(((Uint32 *)copy->pixels)[0] == green, "Verify the write to the copy happened");
+   SDLTest_AssertCheck(_surfaceHasColor(original, red), "Verify the original is unchanged after writing to the copy");
+   SDL_FreeSurface(copy);
+
+   /* Filling the original */
+   copy = SDL_DuplicateSurface(original);
+   SDLTest_AssertCheck(copy != NULL, "Verify copy is not NULL");
+   if (copy == NULL) return TEST_ABORTED;
+   ret = SDL_FillRect(original, NULL, blue);
+   SDLTest_AssertCheck(ret == 0, "Validate result from SDL_FillRect, expected: 0, got: %i", ret);
+   SDLTest_AssertCheck(_surfaceHasColor(original, blue), "Verify the original was filled");
+   SDLTest_AssertCheck(_surfaceHasColor(copy, red), "Verify the copy is unchanged after filling the original");
+   SDL_FreeSurface(copy);
+
+   /* Freeing the original first */
+   copy = SDL_DuplicateSurface(original);
+   SDLTest_AssertCheck(copy != NULL, "Verify copy is not NULL");
+   if (copy == NULL) return TEST_ABORTED;
+   SDL_FreeSurface(original);
+   SDLTest_AssertCheck(_surfaceHasColor(copy, blue), "Verify the copy is intact after freeing the original");
+   ret = SDL_FillRect(copy, NULL, green);
+   SDLTest_AssertCheck(ret == 0 && _surfaceHasColor(copy, green), "Verify the copy can still be filled");
+
+   /* RLE encoding a shared surface */
+   original = copy;
+   copy = SDL_DuplicateSurface(original);
+   target = SDL_CreateRGBSurfaceWithFormat(0, 16, 16, 32, SDL_PIXELFORMAT_ARGB8888);
+   SDLTest_AssertCheck(copy != NULL && target != NULL, "Verify copy and target are not NULL");
+   if (copy == NULL || target == NULL) return TEST_ABORTED;
+   SDL_SetColorKey(original, SDL_TRUE, red);
+   SDL_SetSurfaceRLE(original, 1);
+   ret = SDL_BlitSurface(original, NULL, target, NULL);
+   SDLTest_AssertCheck(ret == 0, "Validate result from SDL_BlitSurface, expected: 0, got: %i", ret);
+   SDLTest_AssertCheck((original->flags & SDL_RLEACCEL) != 0, "Verify the original was RLE encoded");
+   SDLTest_AssertCheck(_surfaceHasColor(target, green), "Verify the RLE encoded original blits correctly");
+   SDLTest_AssertCheck(_surfaceHasColor(copy, green), "Verify the copy is intact after RLE encoding the original");
+
+   SDL_FreeSurface(target);
+   SDL_FreeSurface(copy);
+   SDL_FreeSurface(original);
+   SDL_SetHint(SDL_HINT_SURFACE_COPY_ON_WRITE, "0");
+
+   return TEST_COMPLETED;
+}
+
+/* The largest difference in any channel between two same-sized surfaces,
+   in the units of the destination format's channels */
+static int
+_surfaceMaxDifference(SDL_Surface *a, SDL_Surface *b)
+{
+   const SDL_PixelFormat *fmt = a->format;
+   const int bpp = fmt->BytesPerPixel;
+   int x, y, worst = 0;
+
+   for (y = 0; y < a->h; y++) {
+      for (x = 0; x < a->w; x++) {
+         Uint32 pa = 0, pb = 0;
+         SDL_memcpy(&pa, (Uint8 *)a->pixels + y * a->pitch + x * bpp, bpp);
+         SDL_memcpy(&pb, (Uint8 *)b->pixels + y * b->pitch + x * bpp, bpp);
+         worst = SDL_max(worst, SDL_abs((int)((pa & fmt->Rmask) >> fmt->Rshift) - (int)((pb & fmt->Rmask) >> fmt->Rshift)));
+         worst = SDL_max(worst, SDL_abs((int)((pa & fmt->Gmask) >> fmt->Gshift) - (int)((pb & fmt->Gmask) >> fmt->Gshift)));
+         worst = SDL_max(worst, SDL_abs((int)((pa & fmt->Bmask) >> fmt->Bshift) - (int)((pb & fmt->Bmask) >> fmt->Bshift)));
+      }
+   }
+   return worst;
+}
+
+/* Fills an ARGB8888 surface with runs of transparent (or colorkey magenta),
+   opaque and, if translucent, partly transparent pixels */
+static void
+_surfaceFillRuns(SDL_Surface *surface, SDL_bool translucent)
+{
+   int x, y;
+
+   for (y = 0; y < surface->h; y++) {
+      Uint32 *row = (Uint32 *)((Uint8 *)surface->pixels + y * surface->pitch);
+      for (x = 0; x < surface->w; x++) {
+         const Uint32 rgb = ((x * 7) << 16) | ((y * 5) << 8) | ((x + y) * 3);
+         switch (((x + y * 3) / 5) % 4) {
+         case 0:
+            row[x] = translucent ? 0x00000000 : 0xFFFF00FF;
+            break;
+         case 2:
+            row[x] = translucent ? ((Uint32)(0x40 + ((x * 9) & 0x7F)) << 24) | rgb : 0xFF000000 | rgb;
+            break;
+         default:
+            row[x] = 0xFF000000 | rgb;
+            break;
+         }
+      }
+   }
+}
+
+/* Makes the source for an RLE test: a colorkeyed copy of the runs in
+   format, or the runs with alpha blending */
+static SDL_Surface *
+_surfaceCreateRunsSource(Uint32 format, SDL_bool translucent)
+{
+   SDL_Surface *runs = SDL_CreateRGBSurfaceWithFormat(0, 37, 29, 32, SDL_PIXELFORMAT_ARGB8888);
+   SDL_Surface *surface;
+
+   if (runs == NULL) {
+      return NULL;
+   }
+   _surfaceFillRuns(runs, translucent);
+   if (translucent) {
+      SDL_SetSurfaceBlendMode(runs, SDL_BLENDMODE_BLEND);
+      return runs;
+   }
+
+   /* Colorkey RLE needs the source in the destination's format */
+   surface = SDL_ConvertSurfaceFormat(runs, format, 0);
+   SDL_FreeSurface(runs);
+   if (surface != NULL) {
+      SDL_SetSurfaceBlendMode(surface, SDL_BLENDMODE_NONE);
+      SDL_SetColorKey(surface, SDL_TRUE, SDL_MapRGB(surface->format, 0xFF, 0x00, 0xFF));
+   }
+   return surface;
+}
+
+/**
+ * @brief Tests scaled blits of RLE surfaces come out the same as without RLE.
+ */
+int
+surface_testBlitScaledRLE(void *arg)
+{
+   const Uint32 dstFormats[] = { SDL_PIXELFORMAT_RGB888, SDL_PIXELFORMAT_ARGB8888, SDL_PIXELFORMAT_RGB565 };
+   /* Scaled up, down, clipped on every side and not at all */
+   const SDL_Rect dstRects[] = {
+      { -10, -7, 80, 70 }, { 5, 30, 20, 13 }, { 50, 40, 30, 25 }, { -20, 3, 37, 29 }
+   };
+   const SDL_Rect srcRect = { 3, 2, 25, 20 };
+   int i, j, k, l, ret;
+
+   for (i = 0; i < SDL_arraysize(dstFormats); i++) {
+      for (j = 0; j < 2; j++) {
+         const SDL_bool translucent = (j == 1);
+         SDL_Surface *plain = _surfaceCreateRunsSource(dstFormats[i], translucent);
+         SDL_Surface *rle = _surfaceCreateRunsSource(dstFormats[i], translucent);
+         SDLTest_AssertCheck(plain != NULL && rle != NULL, "Verify source surfaces are not NULL");
+         if (plain == NULL || rle == NULL) return TEST_ABORTED;
+         SDL_SetSurfaceRLE(rle, 1);
+
+         for (k = 0; k < SDL_arraysize(dstRects); k++) {
+            for (l = 0; l < 2; l++) {
+               /* RLE blends translucent pixels with its own rounding, unscaled
+                  too, which can be a couple of steps off the generic blitters */
+               const int tolerance = translucent ? 2 : 0;
+               SDL_Surface *expected = SDL_CreateRGBSurfaceWithFormat(0, 64, 48, 32, dstFormats[i]);
+               SDL_Surface *actual = SDL_CreateRGBSurfaceWithFormat(0, 64, 48, 32, dstFormats[i]);
+               SDL_Rect rect;
+               int worst;
+
+               SDLTest_AssertCheck(expected != NULL && actual != NULL, "Verify destination surfaces are not NULL");
+               if (expected == NULL || actual == NULL) return TEST_ABORTED;
+               SDL_FillRect(expected, NULL, SDL_MapRGB(expected->format, 0x20, 0x60, 0xA0));
+               SDL_FillRect(actual, NULL, SDL_MapRGB(actual->format, 0x20, 0x60, 0xA0));
+
+               rect = dstRects[k];
+               ret = SDL_BlitScaled(plain, l ? &srcRect : NULL, expected, &rect);
+               SDLTest_AssertCheck(ret == 0, "Validate result from SDL_BlitScaled without RLE, expected: 0, got: %i", ret);
+               rect = dstRects[k];
+               ret = SDL_BlitScaled(rle, l ? &srcRect : NULL, actual, &rect);
+               SDLTest_AssertCheck(ret == 0, "Validate result from SDL_BlitScaled with RLE, expected: 0, got: %i", ret);
+               SDLTest_AssertCheck((rle->flags & SDL_RLEACCEL) != 0, "Verify the source was RLE encoded");
+
+               worst = _surfaceMaxDifference(expected, actual);
+               SDLTest_AssertCheck(worst <= tolerance,
+                  "Verify %s %s blit scaled to %d,%d %dx%d%s matches without RLE to within %d; worst: %d",
+                  translucent ? "alpha" : "colorkey", SDL_GetPixelFormatName(dstFormats[i]),
+                  dstRects[k].x, dstRects[k].y, dstRects[k].w, dstRects[k].h,
+                  l ? " from part of the source" : "", tolerance, worst);
+
+               SDL_FreeSurface(actual);
+               SDL_FreeSurface(expected);
+            }
+         }
+         SDL_FreeSurface(rle);
+         SDL_FreeSurface(plain);
+      }
+   }
+
+   return TEST_COMPLETED;
+}
+
+/* Fills an ARGB8888 surface with runs of every length up to 17 and a few
+   longer ones, so they start and end everywhere within groups of 4 pixels.
+   The runs cycle through transparent (or colorkey magenta), opaque and,
+   if translucent, partly transparent pixels. */
+static void
+_surfaceFillRunLengths(SDL_Surface *surface, SDL_bool translucent)
+{
+   const int lengths[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 31, 32, 33, 64 };
+   int x, y, run = 0, left = 0, kind = 0;
+
+   for (y = 0; y < surface->h; y++) {
+      Uint32 *row = (Uint32 *)((Uint8 *)surface->pixels + y * surface->pitch);
+      for (x = 0; x < surface->w; x++) {
+         const Uint32 rgb = ((x * 5) << 16) | ((y * 11) << 8) | ((x * y) & 0xFF);
+         if (left == 0) {
+            left = lengths[run++ % SDL_arraysize(lengths)];
+            kind = (kind + 1) % 3;
+         }
+         left--;
+         if (kind == 0) {
+            row[x] = translucent ? (rgb & 0x00FFFFFF) : 0xFFFF00FF;
+         } else if (kind == 2 && translucent) {
+            row[x] = ((Uint32)(1 + ((x * 37 + y) % 254)) << 24) | rgb;
+         } else {
+            row[x] = 0xFF000000 | rgb;
+         }
+      }
+   }
+}
+
+/* Blits plain and rle to fresh surfaces of format and checks they match */
+static void
+_surfaceCompareRLEBlit(SDL_Surface *plain, SDL_Surface *rle, Uint32 format, int tolerance, SDL_bool encoded, const char *what)
+{
+   SDL_Surface *expected = SDL_CreateRGBSurfaceWithFormat(0, plain->w + 8, plain->h + 8, 32, format);
+   SDL_Surface *actual = SDL_CreateRGBSurfaceWithFormat(0, plain->w + 8, plain->h + 8, 32, format);
+   SDL_Rect rect;
+   int ret, worst;
+
+   SDLTest_AssertCheck(expected != NULL && actual != NULL, "Verify destination surfaces are not NULL");
+   if (expected == NULL || actual == NULL) {
+      SDL_FreeSurface(expected);
+      SDL_FreeSurface(actual);
+      return;
+   }
+   SDL_FillRect(expected, NULL, SDL_MapRGB(expected->format, 0x20, 0x60, 0xA0));
+   SDL_FillRect(actual, NULL, SDL_MapRGB(actual->format, 0x20, 0x60, 0xA0));
+
+   rect.x = 3; rect.y = 5; rect.w = 0; rect.h = 0;
+   ret = SDL_BlitSurface(plain, NULL, expected, &rect);
+   SDLTest_AssertCheck(ret == 0, "Validate result from SDL_BlitSurface without RLE, expected: 0, got: %i", ret);
+   rect.x = 3; rect.y = 5; rect.w = 0; rect.h = 0;
+   ret = SDL_BlitSurface(rle, NULL, actual, &rect);
+   SDLTest_AssertCheck(ret == 0, "Validate result from SDL_BlitSurface with RLE, expected: 0, got: %i", ret);
+   SDLTest_AssertCheck(((rle->flags & SDL_RLEACCEL) != 0) == encoded,
+      "Verify the source is %sRLE encoded %s", encoded ? "" : "not ", what);
+
+   worst = _surfaceMaxDifference(expected, actual);
+   SDLTest_AssertCheck(worst <= tolerance, "Verify the blit to %s %s matches without RLE to within %d; worst: %d",
+      SDL_GetPixelFormatName(format), what, tolerance, worst);
+
+   SDL_FreeSurface(actual);
+   SDL_FreeSurface(expected);
+}
+
+/**
+ * @brief Tests RLE encoding runs of every alignment, and keeping or redoing
+ *        the encoding as the surface and its destination change.
+ */
+int
+surface_testRLEEncoding(void *arg)
+{
+   const Uint32 magenta = 0xFFFF00FF;
+   SDL_Surface *plain, *rle;
+   int i;
+
+   /* Colorkey runs, in XRGB8888 */
+   plain = SDL_CreateRGBSurfaceWithFormat(0, 211, 13, 32, SDL_PIXELFORMAT_RGB888);
+   rle = SDL_CreateRGBSurfaceWithFormat(0, 211, 13, 32, SDL_PIXELFORMAT_RGB888);
+   SDLTest_AssertCheck(plain != NULL && rle != NULL, "Verify source surfaces are not NULL");
+   if (plain == NULL || rle == NULL) return TEST_ABORTED;
+   _surfaceFillRunLengths(plain, SDL_FALSE);
+   _surfaceFillRunLengths(rle, SDL_FALSE);
+   SDL_SetColorKey(plain, SDL_TRUE, magenta);
+   SDL_SetColorKey(rle, SDL_TRUE, magenta);
+   SDL_SetSurfaceRLE(rle, 1);
+   _surfaceCompareRLEBlit(plain, rle, SDL_PIXELFORMAT_RGB888, 0, SDL_TRUE, "with a colorkey");
+
+   /* Turning RLE off and back on */
+   SDL_SetSurfaceRLE(rle, 0);
+   _surfaceCompareRLEBlit(plain, rle, SDL_PIXELFORMAT_RGB888, 0, SDL_FALSE, "with RLE turned off");
+   SDL_SetSurfaceRLE(rle, 1);
+   _surfaceCompareRLEBlit(plain, rle, SDL_PIXELFORMAT_RGB888, 0, SDL_TRUE, "with RLE turned back on");
+
+   /* A new colorkey has to be encoded again, and an opaque pixel makes runs
+      that line up differently. The RLE surface may have dropped its pixels. */
+   SDL_SetColorKey(plain, SDL_TRUE, ((Uint32 *)plain->pixels)[1]);
+   SDL_SetColorKey(rle, SDL_TRUE, ((Uint32 *)plain->pixels)[1]);
+   _surfaceCompareRLEBlit(plain, rle, SDL_PIXELFORMAT_RGB888, 0, SDL_TRUE, "after changing the colorkey");
+   SDL_SetColorKey(plain, SDL_TRUE, magenta);
+   SDL_SetColorKey(rle, SDL_TRUE, magenta);
+   _surfaceCompareRLEBlit(plain, rle, SDL_PIXELFORMAT_RGB888, 0, SDL_TRUE, "after changing the colorkey back");
+
+   /* Colorkey RLE needs the destination in the same format, so it's dropped
+      and brought back when going to another destination and back */
+   _surfaceCompareRLEBlit(plain, rle, SDL_PIXELFORMAT_RGB565, 0, SDL_FALSE, "with a colorkey to another format");
+   _surfaceCompareRLEBlit(plain, rle, SDL_PIXELFORMAT_RGB888, 0, SDL_TRUE, "with a colorkey back in its own format");
+   SDL_FreeSurface(rle);
+   SDL_FreeSurface(plain);
+
+   /* Alpha runs, in ARGB8888. RLE rounds blending a little differently. */
+   plain = SDL_CreateRGBSurfaceWithFormat(0, 211, 13, 32, SDL_PIXELFORMAT_ARGB8888);
+   rle = SDL_CreateRGBSurfaceWithFormat(0, 211, 13, 32, SDL_PIXELFORMAT_ARGB8888);
+   SDLTest_AssertCheck(plain != NULL && rle != NULL, "Verify source surfaces are not NULL");
+   if (plain == NULL || rle == NULL) return TEST_ABORTED;
+   _surfaceFillRunLengths(plain, SDL_TRUE);
+   _surfaceFillRunLengths(rle, SDL_TRUE);
+   SDL_SetSurfaceBlendMode(plain, SDL_BLENDMODE_BLEND);
+   SDL_SetSurfaceBlendMode(rle, SDL_BLENDMODE_BLEND);
+   SDL_SetSurfaceRLE(rle, 1);
+   _surfaceCompareRLEBlit(plain, rle, SDL_PIXELFORMAT_RGB888, 2, SDL_TRUE, "with alpha");
+
+   SDL_SetSurfaceRLE(rle, 0);
+   _surfaceCompareRLEBlit(plain, rle, SDL_PIXELFORMAT_RGB888, 0, SDL_FALSE, "with alpha and RLE turned off");
+   SDL_SetSurfaceRLE(rle, 1);
+   _surfaceCompareRLEBlit(plain, rle, SDL_PIXELFORMAT_RGB888, 2, SDL_TRUE, "with alpha and RLE turned back on");
+
+   /* Alpha RLE is encoded for the destination format, so switching has to
+      encode again, while going between formats with the same layout needn't */
+   for (i = 0; i < 2; i++) {
+      _surfaceCompareRLEBlit(plain, rle, SDL_PIXELFORMAT_RGB565, 2, SDL_TRUE, "with alpha after switching destination format");
+      _surfaceCompareRLEBlit(plain, rle, SDL_PIXELFORMAT_ARGB8888, 2, SDL_TRUE, "with alpha after switching destination format");
+      _surfaceCompareRLEBlit(plain, rle, SDL_PIXELFORMAT_RGB888, 2, SDL_TRUE, "with alpha after switching destination format");
+   }
+   SDL_FreeSurface(rle);
+   SDL_FreeSurface(plain);
+
+   return TEST_COMPLETED;
+}
+
+/* Blits a gradient to a new surface of the given format with the dither hint set */
+static SDL_Surface *
+_surfaceBlitGradient(SDL_Surface *gradient, Uint32 format, const char *dither)
+{
+   SDL_Surface *src, *dst;
+   int ret;
+
+   SDL_SetHint(SDL_HINT_BLIT_DITHER, dither);
+
+   /* A new source, so it doesn't keep a blit chosen under another hint */
+   src = SDL_DuplicateSurface(gradient);
+   dst = SDL_CreateRGBSurfaceWithFormat(0, gradient->w, gradient->h, 0, format);
+   SDLTest_AssertCheck(src != NULL && dst != NULL, "Verify surfaces are not NULL");
+   if (src == NULL || dst == NULL) {
+      SDL_FreeSurface(src);
+      SDL_FreeSurface(dst);
+      return NULL;
+   }
+   ret = SDL_BlitSurface(src, NULL, dst, NULL);
+   SDLTest_AssertCheck(ret == 0, "Validate result from SDL_BlitSurface with %s dithering to %s, expected: 0, got: %i",
+      dither, SDL_GetPixelFormatName(format), ret);
+   SDL_FreeSurface(src);
+   return dst;
+}
+
+/**
+ * @brief Tests blits with SDL_HINT_BLIT_DITHER against the Bayer matrix for
+ *        ordered dithering, and the mean error of error diffusion.
+ */
+int
+surface_testBlitDither(void *arg)
+{
+   static const int bayer[4][4] = {
+      {  0,  8,  2, 10 },
+      { 12,  4, 14,  6 },
+      {  3, 11,  1,  9 },
+      { 15,  7, 13,  5 }
+   };
+   const Uint32 formats[] = { SDL_PIXELFORMAT_RGB565, SDL_PIXELFORMAT_RGB332 };
+   SDL_Surface *gradient, *dst;
+   Uint32 *pixels;
+   int i, x, y, c;
+
+   /* Odd width, so the vectorized rows have a tail */
+   gradient = SDL_CreateRGBSurfaceWithFormat(0, 259, 64, 32, SDL_PIXELFORMAT_RGB888);
+   SDLTest_AssertCheck(gradient != NULL, "Verify gradient surface is not NULL");
+   if (gradient == NULL) return TEST_ABORTED;
+   pixels = (Uint32 *)gradient->pixels;
+   for (y = 0; y < gradient->h; y++) {
+      for (x = 0; x < gradient->w; x++) {
+         const Uint32 r = (x * 255) / (gradient->w - 1);
+         const Uint32 b = (y * 255) / (gradient->h - 1);
+         pixels[y * gradient->pitch / 4 + x] = (r << 16) | ((255 - r) << 8) | ((r + b) / 2);
+      }
+   }
+
+   for (i = 0; i < SDL_arraysize(formats); i++) {
+      const SDL_PixelFormat *fmt;
+      int wrong = 0, blocks = 0, step;
+      double error[3] = { 0.0, 0.0, 0.0 };
+      double worstBlock = 0.0;
+
+      /* Ordered: level (c * levels + (2m + 1) * 255 / 32) / 255 for Bayer entry m */
+      dst = _surfaceBlitGradient(gradient, formats[i], "ordered");
+      if (dst == NULL) break;
+      fmt = dst->format;
+      for (y = 0; y < dst->h; y++) {
+         for (x = 0; x < dst->w; x++) {
+            const Uint32 p = pixels[y * gradient->pitch / 4 + x];
+            const int t = ((2 * bayer[y & 3][x & 3] + 1) * 255) / 32;
+            const Uint32 masks[3] = { fmt->Rmask, fmt->Gmask, fmt->Bmask };
+            const int shifts[3] = { fmt->Rshift, fmt->Gshift, fmt->Bshift };
+            const int source[3] = { (p >> 16) & 0xFF, (p >> 8) & 0xFF, p & 0xFF };
+            Uint32 d = 0;
+
+            SDL_memcpy(&d, (Uint8 *)dst->pixels + y * dst->pitch + x * fmt->BytesPerPixel, fmt->BytesPerPixel);
+            for (c = 0; c < 3; c++) {
+               const int levels = (int)(masks[c] >> shifts[c]);
+               if ((int)((d & masks[c]) >> shifts[c]) != (source[c] * levels + t) / 255) {
+                  wrong++;
+               }
+            }
+         }
+      }
+      SDLTest_AssertCheck(wrong == 0, "Verify ordered dithering to %s follows the Bayer matrix; wrong channels: %d",
+         SDL_GetPixelFormatName(formats[i]), wrong);
+      SDL_FreeSurface(dst);
+
+      /* Diffusion: the errors are carried along, so they average out over
+         the whole image and over each 8x8 block of it */
+      dst = _surfaceBlitGradient(gradient, formats[i], "diffusion");
+      if (dst == NULL) break;
+      fmt = dst->format;
+      for (y = 0; y + 8 <= dst->h; y += 8) {
+         for (x = 0; x + 8 <= dst->w; x += 8) {
+            int block[3] = { 0, 0, 0 };
+            int bx, by;
+
+            for (by = y; by < y + 8; by++) {
+               for (bx = x; bx < x + 8; bx++) {
+                  const Uint32 p = pixels[by * gradient->pitch / 4 + bx];
+                  Uint32 d = 0;
+                  Uint8 r, g, b;
+
+                  SDL_memcpy(&d, (Uint8 *)dst->pixels + by * dst->pitch + bx * fmt->BytesPerPixel, fmt->BytesPerPixel);
+                  SDL_GetRGB(d, fmt, &r, &g, &b);
+                  block[0] += (int)r - (int)((p >> 16) & 0xFF);
+                  block[1] += (int)g - (int)((p >> 8) & 0xFF);
+                  block[2] += (int)b - (int)(p & 0xFF);
+               }
+            }
+            for (c = 0; c < 3; c++) {
+               error[c] += block[c];
+               worstBlock = SDL_max(worstBlock, SDL_abs(block[c]) / 64.0);
+            }
+            blocks++;
+         }
+      }
+      for (c = 0; c < 3; c++) {
+         error[c] /= (blocks * 64);
+         SDLTest_AssertCheck(SDL_fabs(error[c]) < 0.25, "Verify the mean error of diffusion dithering to %s in channel %d is under 0.25; got: %f",
+            SDL_GetPixelFormatName(formats[i]), c, error[c]);
+      }
+      /* Without dithering, blocks are off by up to half the coarsest step */
+      step = 1 << SDL_max(SDL_max(fmt->Rloss, fmt->Gloss), fmt->Bloss);
+      SDLTest_AssertCheck(worstBlock < step / 4, "Verify the mean error of diffusion dithering to %s in 8x8 blocks is under %d; worst: %f",
+         SDL_GetPixelFormatName(formats[i]), step / 4, worstBlock);
+      SDL_FreeSurface(dst);
+   }
+
+   SDL_SetHint(SDL_HINT_BLIT_DITHER, "0");
+   SDL_FreeSurface(gradient);
+
+   return TEST_COMPLETED;
+}
+
+/**
+ * @brief Tests SDL_HINT_SURFACE_POOL hands the pixels of freed surfaces to
+ *        new surfaces of the same size, and only while SDL is initialized.
+ */
+int
+surface_testPixelPool(void *arg)
+{
+   SDL_Surface *surface;
+   void *pixels;
+   int allocations, allocated, freed, perSurface;
+
+   SDL_Init(0);
+   SDL_SetHint(SDL_HINT_SURFACE_POOL, "0");
+
+   /* The harness's timeout thread can allocate while the test runs, so
+      only count across single calls. What a surface takes without the pool: */
+   allocations = SDL_GetNumAllocations();
+   surface = SDL_CreateRGBSurfaceWithFormat(0, 64, 64, 32, SDL_PIXELFORMAT_ARGB8888);
+   perSurface = SDL_GetNumAllocations() - allocations;
+   SDLTest_AssertCheck(surface != NULL, "Verify surface is not NULL");
+   if (surface == NULL) return TEST_ABORTED;
+   allocations = SDL_GetNumAllocations();
+   SDL_FreeSurface(surface);
+   SDLTest_AssertCheck(allocations - SDL_GetNumAllocations() == perSurface, "Verify freeing a surface frees everything without the pool");
+
+   /* The pixels are kept, and the next surface of that size gets them, cleared */
+   SDL_SetHint(SDL_HINT_SURFACE_POOL, "1024");
+   surface = SDL_CreateRGBSurfaceWithFormat(0, 64, 64, 32, SDL_PIXELFORMAT_ARGB8888);
+   SDLTest_AssertCheck(surface != NULL, "Verify surface is not NULL");
+   if (surface == NULL) return TEST_ABORTED;
+   pixels = surface->pixels;
+   SDL_FillRect(surface, NULL, 0xFFFF0000);
+   allocations = SDL_GetNumAllocations();
+   SDL_FreeSurface(surface);
+   freed = allocations - SDL_GetNumAllocations();
+   SDLTest_AssertCheck(freed == perSurface - 1, "Verify the pixels are kept; expected: %d freed, got: %d", perSurface - 1, freed);
+   allocations = SDL_GetNumAllocations();
+   surface = SDL_CreateRGBSurfaceWithFormat(0, 64, 64, 32, SDL_PIXELFORMAT_ARGB8888);
+   allocated = SDL_GetNumAllocations() - allocations;
+   SDLTest_AssertCheck(surface != NULL, "Verify surface is not NULL");
+   if (surface == NULL) return TEST_ABORTED;
+   SDLTest_AssertCheck(surface->pixels == pixels, "Verify the new surface reuses the pixels");
+   SDLTest_AssertCheck(allocated == perSurface - 1, "Verify the new surface doesn't allocate pixels; expected: %d allocations, got: %d",
+      perSurface - 1, allocated);
+   SDLTest_AssertCheck(_surfaceHasColor(surface, 0), "Verify the reused pixels are cleared");
+   SDL_FreeSurface(surface);
+
+   /* Turning the pool off lets go of what it kept */
+   allocations = SDL_GetNumAllocations();
+   SDL_SetHint(SDL_HINT_SURFACE_POOL, "0");
+   SDLTest_AssertCheck(allocations - SDL_GetNumAllocations() == 1, "Verify turning the pool off frees the pixels");
+
+   /* Nothing is kept after SDL_Quit(), until SDL_Init() */
+   SDL_Quit();
+   SDL_SetHint(SDL_HINT_SURFACE_POOL, "1024");
+   surface = SDL_CreateRGBSurfaceWithFormat(0, 64, 64, 32, SDL_PIXELFORMAT_ARGB8888);
+   SDLTest_AssertCheck(surface != NULL, "Verify surface is not NULL");
+   if (surface == NULL) return TEST_ABORTED;
+   allocations = SDL_GetNumAllocations();
+   SDL_FreeSurface(surface);
+   SDLTest_AssertCheck(allocations - SDL_GetNumAllocations() == perSurface, "Verify the pixels aren't kept after SDL_Quit()");
+
+   SDL_Init(0);
+   surface = SDL_CreateRGBSurfaceWithFormat(0, 64, 64, 32, SDL_PIXELFORMAT_ARGB8888);
+   SDLTest_AssertCheck(surface != NULL, "Verify surface is not NULL");
+   if (surface == NULL) return TEST_ABORTED;
+   allocations = SDL_GetNumAllocations();
+   SDL_FreeSurface(surface);
+   SDLTest_AssertCheck(allocations - SDL_GetNumAllocations() == perSurface - 1, "Verify the pixels are kept again after SDL_Init()");
+   SDL_SetHint(SDL_HINT_SURFACE_POOL, "0");
+
+   return TEST_COMPLETED;
+}
+
 /* ================= Test References ================== */
 
 /* Surface test cases */
@@ -630,11 +1209,27 @@ static const SDLTest_TestCaseReference surfaceTest11 =
 static const SDLTest_TestCaseReference surfaceTest12 =
         { (SDLTest_TestCaseFp)surface_testBlitBlendMod, "surface_testBlitBlendMod", "Tests blitting routines with mod blending mode.", TEST_ENABLED};
 
+static const SDLTest_TestCaseReference surfaceTest13 =
+        { (SDLTest_TestCaseFp)surface_testCopyOnWrite, "surface_testCopyOnWrite", "Tests writes to surfaces that share pixels.", TEST_ENABLED};
+
+static const SDLTest_TestCaseReference surfaceTest14 =
+        { (SDLTest_TestCaseFp)surface_testBlitScaledRLE, "surface_testBlitScaledRLE", "Tests scaled blits of RLE surfaces against blits without RLE.", TEST_ENABLED};
+
+static const SDLTest_TestCaseReference surfaceTest15 =
+        { (SDLTest_TestCaseFp)surface_testRLEEncoding, "surface_testRLEEncoding", "Tests RLE encoding and reusing the encoding.", TEST_ENABLED};
+
+static const SDLTest_TestCaseReference surfaceTest16 =
+        { (SDLTest_TestCaseFp)surface_testBlitDither, "surface_testBlitDither", "Tests dithered blits to 16 and 8 bit formats.", TEST_ENABLED};
+
+static const SDLTest_TestCaseReference surfaceTest17 =
+        { (SDLTest_TestCaseFp)surface_testPixelPool, "surface_testPixelPool", "Tests reusing the pixels of freed surfaces.", TEST_ENABLED};
+
 /* Sequence of Surface test cases */
 static const SDLTest_TestCaseReference *surfaceTests[] =  {
     &surfaceTest1, &surfaceTest2, &surfaceTest3, &surfaceTest4, &surfaceTest5,
     &surfaceTest6, &surfaceTest7, &surfaceTest8, &surfaceTest9, &surfaceTest10,
-    &surfaceTest11, &surfaceTest12, NULL
+    &surfaceTest11, &surfaceTest12, &surfaceTest13, &surfaceTest14, &surfaceTest15,
+    &surfaceTest16, &surfaceTest17, NULL
 };
 
 /* Surface test suite (global) */
@@ -0,0 +1,195 @@
+/*
+  Copyright (C) 1997-2019 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely.
+*/
+
+
+/* Measures how the job system scales, running the same work with one
+   thread and then with every worker count up to the number of CPUs.
+   Pass a worker count to only try that many. */
+
+#include "SDL.h"
+
+#define ITERATIONS 5
+#define PIXELS (512 * 512)
+#define SMALL_JOBS 20000
+#define CHAIN_LENGTH 1000
+
+static Uint32 *pixels;
+static SDL_atomic_t small_jobs_run;
+static SDL_atomic_t chain_position;
+static SDL_atomic_t chain_errors;
+
+/* Iterations before a point escapes the Mandelbrot set: it's uneven work,
+   which is what stealing is for. */
+static void SDLCALL
+mandelbrot(void *data, int start, int end)
+{
+    int i;
+
+    for (i = start; i < end; ++i) {
+        const double cx = ((i % 512) / 256.0) - 1.5;
+        const double cy = ((i / 512) / 256.0) - 1.0;
+        double x = 0.0, y = 0.0;
+        Uint32 n = 0;
+
+        while ((n < 256) && ((x * x + y * y) < 4.0)) {
+            const double t = x * x - y * y + cx;
+            y = 2.0 * x * y + cy;
+            x = t;
+            ++n;
+        }
+        pixels[i] = n;
+    }
+}
+
+static void SDLCALL
+small_job(void *data)
+{
+    SDL_AtomicAdd(&small_jobs_run, 1);
+}
+
+static void SDLCALL
+chain_job(void *data)
+{
+    const int expected = (int) (size_t) data;
+    if (SDL_AtomicAdd(&chain_position, 1) != expected) {
+        SDL_AtomicAdd(&chain_errors, 1);
+    }
+}
+
+static Uint32
+checksum(void)
+{
+    Uint32 sum = 0;
+    int i;
+
+    for (i = 0; i < PIXELS; ++i) {
+        sum = (sum * 31) + pixels[i];
+    }
+    return sum;
+}
+
+static double
+elapsed_ms(Uint64 start)
+{
+    return ((SDL_GetPerformanceCounter() - start) * 1000.0) / (double) SDL_GetPerformanceFrequency();
+}
+
+/* Returns the Mandelbrot time, so the caller can work out the speedup */
+static double
+run(int workers, Uint32 *sum)
+{
+    char hint[16];
+    SDL_JobCounter *counters[CHAIN_LENGTH];
+    SDL_JobCounter *counter;
+    double parallel_ms, small_ms, chain_ms;
+    Uint64 start;
+    int i;
+
+    /* The pool reads the hint when it starts, and SDL_Quit() stops it */
+    SDL_Quit();
+    SDL_snprintf(hint, sizeof (hint), "%d", workers);
+    SDL_SetHint(SDL_HINT_JOB_WORKERS, hint);
+    workers = SDL_GetNumJobWorkers();
+
+    start = SDL_GetPerformanceCounter();
+    for (i = 0; i < ITERATIONS; ++i) {
+        SDL_ParallelFor(PIXELS, 512, mandelbrot, NULL);
+    }
+    parallel_ms = elapsed_ms(start) / ITERATIONS;
+    *sum = checksum();
+
+    counter = SDL_CreateJobCounter();
+    if (!counter) {
+        SDL_Log("Couldn't create job counter: %s", SDL_GetError());
+        return -1.0;
+    }
+    SDL_AtomicSet(&small_jobs_run, 0);
+    start = SDL_GetPerformanceCounter();
+    for (i = 0; i < SMALL_JOBS; ++i) {
+        SDL_RunJob(small_job, NULL, counter);
+    }
+    SDL_WaitJobCounter(counter);
+    small_ms = elapsed_ms(start);
+    SDL_DestroyJobCounter(counter);
+
+    /* Each link runs after the one before it, whichever thread gets it */
+    SDL_AtomicSet(&chain_position, 0);
+    SDL_AtomicSet(&chain_errors, 0);
+    start = SDL_GetPerformanceCounter();
+    for (i = 0; i < CHAIN_LENGTH; ++i) {
+        counters[i] = SDL_CreateJobCounter();
+        if (!counters[i]) {
+            SDL_Log("Couldn't create job counter: %s", SDL_GetError());
+            return -1.0;
+        }
+        SDL_RunJobAfter(i ? counters[i - 1] : NULL, chain_job, (void *) (size_t) i, counters[i]);
+    }
+    SDL_WaitJobCounter(counters[CHAIN_LENGTH - 1]);
+    chain_ms = elapsed_ms(start);
+    for (i = 0; i < CHAIN_LENGTH; ++i) {
+        SDL_WaitJobCounter(counters[i]);
+        SDL_DestroyJobCounter(counters[i]);
+    }
+
+    SDL_Log("%2d workers: parallel for %8.2f ms, %d small jobs %8.2f ms, chain of %d %8.2f ms",
+            workers, parallel_ms, SMALL_JOBS, small_ms, CHAIN_LENGTH, chain_ms);
+    if (SDL_AtomicGet(&small_jobs_run) != SMALL_JOBS) {
+        SDL_Log("    ran %d small jobs, expected %d!", SDL_AtomicGet(&small_jobs_run), SMALL_JOBS);
+    }
+    if (SDL_AtomicGet(&chain_errors) || (SDL_AtomicGet(&chain_position) != CHAIN_LENGTH)) {
+        SDL_Log("    chain ran out of order!");
+    }
+    return parallel_ms;
+}
+
+int
+main(int argc, char *argv[])
+{
+    const int cpus = SDL_GetCPUCount();
+    double base_ms, ms;
+    Uint32 base_sum, sum;
+    int workers, max_workers;
+
+    /* Enable standard application logging */
+    SDL_LogSetPriority(SDL_LOG_CATEGORY_APPLICATION, SDL_LOG_PRIORITY_INFO);
+
+    pixels = (Uint32 *) SDL_malloc(PIXELS * sizeof (Uint32));
+    if (!pixels) {
+        SDL_Log("Out of memory!");
+        return 1;
+    }
+
+    SDL_Log("%d CPUs", cpus);
+    base_ms = run(0, &base_sum);
+    if (base_ms < 0.0) {
+        return 1;
+    }
+
+    /* The calling thread helps out, so N CPUs want N-1 workers */
+    max_workers = (argc > 1) ? SDL_atoi(argv[1]) : SDL_max(cpus - 1, 1);
+    for (workers = (argc > 1) ? max_workers : 1; workers <= max_workers; ++workers) {
+        ms = run(workers, &sum);
+        if (ms < 0.0) {
+            return 1;
+        }
+        SDL_Log("    %.2fx the speed of one thread", base_ms / ms);
+        if (sum != base_sum) {
+            SDL_Log("    parallel for got the wrong answer!");
+        }
+    }
+
+    SDL_free(pixels);
+    SDL_Quit();
+    return 0;
+}
+
+/* vi: set ts=4 sw=4 expandtab: */
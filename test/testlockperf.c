@@ -0,0 +1,213 @@
+/*
+  Copyright (C) 1997-2019 Sam Lantinga <slouken@libsdl.org>
+
+  This software is provided 'as-is', without any express or implied
+  warranty.  In no event will the authors be held liable for any damages
+  arising from the use of this software.
+
+  Permission is granted to anyone to use this software for any purpose,
+  including commercial applications, and to alter it and redistribute it
+  freely.
+*/
+
+
+/* Measures how fast mutexes, semaphores and condition variables are, both
+   with one thread and with several fighting over them. The correctness
+   tests are testlock and testsem; this is just for comparing backends.
+   Pass a thread count for the contended tests, the default is 4. */
+
+#include "SDL.h"
+
+#define UNCONTENDED_OPS 10000000
+#define CONTENDED_OPS 1000000
+#define ROUND_TRIPS 100000
+
+static SDL_mutex *mutex;
+static SDL_cond *cond;
+static SDL_sem *sems[2];
+static int counter;
+static int turn;
+static int num_threads = 4;
+
+static double
+elapsed_ns(Uint64 start, int ops)
+{
+    const double ns = ((SDL_GetPerformanceCounter() - start) * 1000000000.0) / (double) SDL_GetPerformanceFrequency();
+    return ns / ops;
+}
+
+static int SDLCALL
+IdleThread(void *data)
+{
+    SDL_SemWait((SDL_sem *) data);
+    return 0;
+}
+
+static int SDLCALL
+MutexThread(void *data)
+{
+    const int ops = CONTENDED_OPS / num_threads;
+    int i;
+
+    for (i = 0; i < ops; ++i) {
+        SDL_LockMutex(mutex);
+        ++counter;
+        SDL_UnlockMutex(mutex);
+    }
+    return 0;
+}
+
+static int SDLCALL
+SemThread(void *data)
+{
+    int i;
+
+    for (i = 0; i < ROUND_TRIPS; ++i) {
+        SDL_SemWait(sems[0]);
+        SDL_SemPost(sems[1]);
+    }
+    return 0;
+}
+
+static int SDLCALL
+CondThread(void *data)
+{
+    int i;
+
+    SDL_LockMutex(mutex);
+    for (i = 0; i < ROUND_TRIPS; ++i) {
+        while (turn != 1) {
+            SDL_CondWait(cond, mutex);
+        }
+        turn = 0;
+        SDL_CondSignal(cond);
+    }
+    SDL_UnlockMutex(mutex);
+    return 0;
+}
+
+static void
+TestMutex(void)
+{
+    SDL_Thread *threads[64];
+    Uint64 start;
+    int i;
+
+    start = SDL_GetPerformanceCounter();
+    for (i = 0; i < UNCONTENDED_OPS; ++i) {
+        SDL_LockMutex(mutex);
+        SDL_UnlockMutex(mutex);
+    }
+    SDL_Log("Mutex, uncontended:     %8.1f ns per lock and unlock", elapsed_ns(start, UNCONTENDED_OPS));
+
+    counter = 0;
+    start = SDL_GetPerformanceCounter();
+    for (i = 0; i < num_threads; ++i) {
+        threads[i] = SDL_CreateThread(MutexThread, "MutexThread", NULL);
+    }
+    for (i = 0; i < num_threads; ++i) {
+        SDL_WaitThread(threads[i], NULL);
+    }
+    SDL_Log("Mutex, %2d threads:      %8.1f ns per lock and unlock", num_threads,
+            elapsed_ns(start, (CONTENDED_OPS / num_threads) * num_threads));
+    if (counter != (CONTENDED_OPS / num_threads) * num_threads) {
+        SDL_Log("    counted to %d, expected %d!", counter, (CONTENDED_OPS / num_threads) * num_threads);
+    }
+}
+
+static void
+TestSemaphore(void)
+{
+    SDL_Thread *thread;
+    Uint64 start;
+    int i;
+
+    start = SDL_GetPerformanceCounter();
+    for (i = 0; i < UNCONTENDED_OPS; ++i) {
+        SDL_SemPost(sems[0]);
+        SDL_SemWait(sems[0]);
+    }
+    SDL_Log("Semaphore, uncontended: %8.1f ns per post and wait", elapsed_ns(start, UNCONTENDED_OPS));
+
+    start = SDL_GetPerformanceCounter();
+    thread = SDL_CreateThread(SemThread, "SemThread", NULL);
+    for (i = 0; i < ROUND_TRIPS; ++i) {
+        SDL_SemPost(sems[0]);
+        SDL_SemWait(sems[1]);
+    }
+    SDL_WaitThread(thread, NULL);
+    SDL_Log("Semaphore, ping-pong:   %8.1f ns per round trip", elapsed_ns(start, ROUND_TRIPS));
+}
+
+static void
+TestCondition(void)
+{
+    SDL_Thread *thread;
+    Uint64 start;
+    int i;
+
+    start = SDL_GetPerformanceCounter();
+    for (i = 0; i < UNCONTENDED_OPS; ++i) {
+        SDL_CondSignal(cond);
+    }
+    SDL_Log("Condition, no waiters:  %8.1f ns per signal", elapsed_ns(start, UNCONTENDED_OPS));
+
+    turn = 0;
+    start = SDL_GetPerformanceCounter();
+    thread = SDL_CreateThread(CondThread, "CondThread", NULL);
+    SDL_LockMutex(mutex);
+    for (i = 0; i < ROUND_TRIPS; ++i) {
+        turn = 1;
+        SDL_CondSignal(cond);
+        while (turn != 0) {
+            SDL_CondWait(cond, mutex);
+        }
+    }
+    SDL_UnlockMutex(mutex);
+    SDL_WaitThread(thread, NULL);
+    SDL_Log("Condition, ping-pong:   %8.1f ns per round trip", elapsed_ns(start, ROUND_TRIPS));
+}
+
+int
+main(int argc, char *argv[])
+{
+    SDL_Thread *idle;
+    SDL_sem *idle_sem;
+
+    /* Enable standard application logging */
+    SDL_LogSetPriority(SDL_LOG_CATEGORY_APPLICATION, SDL_LOG_PRIORITY_INFO);
+
+    if (argc > 1) {
+        num_threads = SDL_max(SDL_min(SDL_atoi(argv[1]), 64), 1);
+    }
+
+    mutex = SDL_CreateMutex();
+    cond = SDL_CreateCond();
+    sems[0] = SDL_CreateSemaphore(0);
+    sems[1] = SDL_CreateSemaphore(0);
+    if (!mutex || !cond || !sems[0] || !sems[1]) {
+        SDL_Log("Couldn't create synchronization objects: %s", SDL_GetError());
+        return 1;
+    }
+
+    /* Some C libraries skip atomic instructions while a process only has
+       one thread, which isn't what we want to measure. */
+    idle_sem = SDL_CreateSemaphore(0);
+    idle = SDL_CreateThread(IdleThread, "IdleThread", idle_sem);
+
+    TestMutex();
+    TestSemaphore();
+    TestCondition();
+
+    SDL_SemPost(idle_sem);
+    SDL_WaitThread(idle, NULL);
+    SDL_DestroySemaphore(idle_sem);
+
+    SDL_DestroySemaphore(sems[1]);
+    SDL_DestroySemaphore(sems[0]);
+    SDL_DestroyCond(cond);
+    SDL_DestroyMutex(mutex);
+    return 0;
+}
+
+/* vi: set ts=4 sw=4 expandtab: */
@@ -265,6 +265,9 @@ loop()
     }
 #endif
 
+    /* For the allocation profile with --trackmem */
+    SDLTest_MarkAllocationFrame();
+
     frames++;
     now = SDL_GetTicks();
     if (SDL_TICKS_PASSED(now, next_fps_check)) {
@@ -20,8 +20,10 @@
 #include "SDL.h"
 
 #define DEFAULT_RESOLUTION  1
+#define BENCHMARK_TIMERS    100000
 
 static int ticks = 0;
+static SDL_atomic_t fired;
 
 static Uint32 SDLCALL
 ticktock(Uint32 interval, void *param)
@@ -30,6 +32,13 @@ ticktock(Uint32 interval, void *param)
     return (interval);
 }
 
+static Uint32 SDLCALL
+oneshot(Uint32 interval, void *param)
+{
+    SDL_AtomicIncRef(&fired);
+    return 0;
+}
+
 static Uint32 SDLCALL
 callback(Uint32 interval, void *param)
 {
@@ -42,6 +51,7 @@ main(int argc, char *argv[])
 {
     int i, desired;
     SDL_TimerID t1, t2, t3;
+    SDL_TimerID *ids;
     Uint32 start32, now32;
     Uint64 start, now;
 
@@ -107,6 +117,37 @@ main(int argc, char *argv[])
     now = SDL_GetPerformanceCounter();
     SDL_Log("1 million iterations of ticktock took %f ms\n", (double)((now - start)*1000) / SDL_GetPerformanceFrequency());
 
+    /* Add, fire and cancel lots of timers */
+    SDL_Log("Adding %d one-shot timers, 1 to 100 ms apart...\n", BENCHMARK_TIMERS);
+    start = SDL_GetPerformanceCounter();
+    for (i = 0; i < BENCHMARK_TIMERS; ++i) {
+        SDL_AddTimer(1 + (i % 100), oneshot, NULL);
+    }
+    now = SDL_GetPerformanceCounter();
+    SDL_Log("Adding them took %f ms\n", (double)((now - start)*1000) / SDL_GetPerformanceFrequency());
+    start32 = SDL_GetTicks();
+    while ((SDL_AtomicGet(&fired) < BENCHMARK_TIMERS) && ((SDL_GetTicks() - start32) < 10 * 1000)) {
+        SDL_Delay(1);
+    }
+    SDL_Log("%d of them fired, the last %d ms after they were added\n", SDL_AtomicGet(&fired), SDL_GetTicks() - start32);
+
+    ids = (SDL_TimerID *) SDL_malloc(BENCHMARK_TIMERS * sizeof (*ids));
+    if (ids) {
+        start = SDL_GetPerformanceCounter();
+        for (i = 0; i < BENCHMARK_TIMERS; ++i) {
+            ids[i] = SDL_AddTimer(60 * 1000, oneshot, NULL);
+        }
+        now = SDL_GetPerformanceCounter();
+        SDL_Log("Adding %d long timers took %f ms\n", BENCHMARK_TIMERS, (double)((now - start)*1000) / SDL_GetPerformanceFrequency());
+        start = SDL_GetPerformanceCounter();
+        for (i = 0; i < BENCHMARK_TIMERS; ++i) {
+            SDL_RemoveTimer(ids[i]);
+        }
+        now = SDL_GetPerformanceCounter();
+        SDL_Log("Canceling them took %f ms\n", (double)((now - start)*1000) / SDL_GetPerformanceFrequency());
+        SDL_free(ids);
+    }
+
     SDL_Log("Performance counter frequency: %"SDL_PRIu64"\n", (unsigned long long) SDL_GetPerformanceFrequency());
     start32 = SDL_GetTicks();
     start = SDL_GetPerformanceCounter();